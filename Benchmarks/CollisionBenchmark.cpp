@@ -0,0 +1,165 @@
+//***************************************************************************************
+// CollisionBenchmark.cpp
+//
+// Times the collision pipeline of the game (swept box broadphase, batched test of the swept
+// bounds, sweep of the pairs left) against sweeping every pair, for shells against enemies
+// from 5 x 5 up to 10000 x 10000, with every narrowphase path the CPU has.
+//   CollisionBenchmark [-frames <count>]
+//***************************************************************************************
+
+#include "Helpers/SphereOverlap.h"
+#include "Helpers/RandomStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace SphereOverlap;
+
+namespace
+{
+    struct SphereArrays
+    {
+        std::vector<float> PrevX, PrevY, PrevZ, X, Y, Z, Radius;
+
+        MovingSpheres Get()const
+        {
+            MovingSpheres s = { PrevX.data(), PrevY.data(), PrevZ.data(), X.data(), Y.data(), Z.data(), Radius.data() };
+            return s;
+        }
+    };
+
+    SphereArrays MakeSpheres(RandomStream& random, std::uint32_t count, float extent, float radius, float travel)
+    {
+        SphereArrays s;
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            s.PrevX.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.PrevY.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.PrevZ.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.X.push_back(s.PrevX.back() + random.NextFloat(-travel, travel));
+            s.Y.push_back(s.PrevY.back() + random.NextFloat(-travel, travel));
+            s.Z.push_back(s.PrevZ.back() + random.NextFloat(-travel, travel));
+            s.Radius.push_back(radius);
+        }
+        return s;
+    }
+
+    // the buffers are reused from frame to frame, as the game does.
+    struct Pipeline
+    {
+        SpatialHashGrid Grid{ 15.0f };
+        std::vector<SpatialHashGrid::Box> SphereBoxes, QueryBoxes;
+        SweptBounds SphereBounds, QueryBounds;
+        std::vector<Pair> Candidates, Overlaps;
+        std::vector<Impact> Impacts;
+
+        size_t Run(const SphereArrays& queries, const SphereArrays& spheres)
+        {
+            const std::uint32_t queryCount = (std::uint32_t)queries.X.size();
+            const std::uint32_t sphereCount = (std::uint32_t)spheres.X.size();
+
+            GetSweptBoxes(spheres.Get(), sphereCount, SphereBoxes);
+            Grid.BuildBoxes(SphereBoxes.data(), sphereCount);
+            GetSweptBoxes(queries.Get(), queryCount, QueryBoxes);
+            Candidates.clear();
+            Grid.QueryBoxPairs(QueryBoxes.data(), queryCount, Candidates);
+
+            GetSweptBounds(spheres.Get(), sphereCount, SphereBounds);
+            GetSweptBounds(queries.Get(), queryCount, QueryBounds);
+            Overlaps.clear();
+            TestPairs(QueryBounds.GetSpheres(), SphereBounds.GetSpheres(), Candidates.data(), (std::uint32_t)Candidates.size(),
+                Overlaps);
+
+            Impacts.clear();
+            SweepPairs(queries.Get(), spheres.Get(), Overlaps.data(), (std::uint32_t)Overlaps.size(), Impacts);
+            return Impacts.size();
+        }
+    };
+
+    size_t BruteForce(const SphereArrays& queries, const SphereArrays& spheres, std::vector<Pair>& row,
+        std::vector<Impact>& impacts)
+    {
+        const std::uint32_t sphereCount = (std::uint32_t)spheres.X.size();
+        row.resize(sphereCount);
+        impacts.clear();
+        for(std::uint32_t i = 0; i < (std::uint32_t)queries.X.size(); ++i)
+        {
+            for(std::uint32_t j = 0; j < sphereCount; ++j)
+            {
+                row[j].Query = i;
+                row[j].Point = j;
+            }
+            SweepPairs(queries.Get(), spheres.Get(), row.data(), sphereCount, impacts);
+        }
+        return impacts.size();
+    }
+
+    // average milliseconds of a call over enough frames to run for a while.
+    template<typename Function>
+    double TimeMs(int frames, Function function)
+    {
+        function();     // warm up, and grow the buffers
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < frames; ++i)
+            function();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = 20;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+            frames = std::max(1, atoi(argv[++i]));
+    }
+
+    const std::uint32_t sizes[][2] = { { 5, 5 }, { 100, 100 }, { 1000, 1000 }, { 10000, 10000 } };
+
+    std::vector<Path> paths = { Path::Scalar };
+    if(GetSupportedPath() >= Path::Sse)
+        paths.push_back(Path::Sse);
+    if(GetSupportedPath() >= Path::Avx2)
+        paths.push_back(Path::Avx2);
+
+    printf("%-17s %-7s %10s %12s %12s %14s %8s\n", "shells x enemies", "path", "impacts", "candidates", "overlaps",
+        "pipeline ms", "brute ms");
+
+    for(const auto& size : sizes)
+    {
+        // shells are fast, enemies slow, both spread so the density stays the same.
+        RandomStream random(size[0] * 31 + size[1]);
+        const float extent = 30.0f * std::cbrt((float)std::max(size[0], size[1]));
+        SphereArrays shells = MakeSpheres(random, size[0], extent, 5.0f, 15.0f);
+        SphereArrays enemies = MakeSpheres(random, size[1], extent, 5.0f, 1.0f);
+
+        // the brute force sweep has no batched path, and takes seconds at the largest size.
+        std::vector<Pair> row;
+        std::vector<Impact> bruteImpacts;
+        size_t bruteCount = 0;
+        const int bruteFrames = size[0] * (std::uint64_t)size[1] > 10000000 ? 1 : frames;
+        const double bruteMs = TimeMs(bruteFrames, [&] { bruteCount = BruteForce(shells, enemies, row, bruteImpacts); });
+
+        for(Path path : paths)
+        {
+            SetPath(path);
+            Pipeline pipeline;
+            size_t count = 0;
+            const double ms = TimeMs(frames, [&] { count = pipeline.Run(shells, enemies); });
+
+            char label[32];
+            snprintf(label, sizeof(label), "%u x %u", size[0], size[1]);
+            printf("%-17s %-7s %10zu %12zu %12zu %14.3f %8.3f%s\n", label, GetPathName(path), count,
+                pipeline.Candidates.size(), pipeline.Overlaps.size(), ms, bruteMs,
+                count == bruteCount ? "" : "  MISMATCH");
+        }
+    }
+
+    SetPath(GetSupportedPath());
+    return 0;
+}
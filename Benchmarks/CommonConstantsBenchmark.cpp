@@ -0,0 +1,206 @@
+//***************************************************************************************
+// CommonConstantsBenchmark.cpp
+//
+// Times the per frame camera and common constant buffer update of FlyingCrates, as it was
+// and as it is now.  It used to rebuild the view matrix, invert view, projection and
+// view * projection with XMMatrixInverse, and copy the whole CommonConstants every frame.
+// Now FlyingCrates drives a CommonConstantsCache, which is timed here the same way: the
+// camera work only happens when the camera moved (or the window was resized), and only the
+// out of date byte ranges are copied, into each of the frame buffers in turn.
+// Both are run with a camera that stays put, the usual case, and one that moves every frame.
+// The upload buffers are plain memory here, while the game writes to an upload heap.
+//   CommonConstantsBenchmark [-frames <count>]
+//***************************************************************************************
+
+#include "Helpers/CommonConstants.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const int NumFrameBuffers = 3;
+
+    struct Camera
+    {
+        float Theta = 1.5f * XM_PI;
+        float Phi = 0.2f * XM_PI;
+        float Radius = 300.0f;
+    };
+
+    XMMATRIX Projection()
+    {
+        return XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+    }
+
+    const XMFLOAT4 AmbientLight = { 0.25f, 0.25f, 0.25f, 1.0f };
+
+    // the three directional lights of FlyingCrates::SetLights.
+    void SetLights(Light (&lights)[MaxLights])
+    {
+        lights[0].Direction = { 0.57735f, -0.77735f, 0.57735f };
+        lights[0].Strength = { 0.9f, 0.9f, 0.8f };
+        lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
+        lights[1].Strength = { 0.4f, 0.4f, 0.4f };
+        lights[2].Direction = { 0.5f, -0.707f, -0.707f };
+        lights[2].Strength = { 0.25f, 0.25f, 0.25f };
+    }
+
+    XMFLOAT3 Position(const Camera& camera)
+    {
+        XMFLOAT3 pos;
+        pos.x = camera.Radius * sinf(camera.Phi) * cosf(camera.Theta);
+        pos.z = camera.Radius * sinf(camera.Phi) * sinf(camera.Theta);
+        pos.y = camera.Radius * cosf(camera.Phi);
+        return pos;
+    }
+
+    // the per frame buffers the constants are copied to.
+    struct UploadBuffers
+    {
+        std::vector<CommonConstants> Buffers = std::vector<CommonConstants>(NumFrameBuffers);
+
+        void CopyData(int frame, const CommonConstants& cb, size_t offset, size_t size)
+        {
+            memcpy((std::uint8_t*)&Buffers[frame] + offset, (const std::uint8_t*)&cb + offset, size);
+        }
+    };
+
+    // UpdateCamera and UpdateCommonCB before the change.
+    struct EveryFrame
+    {
+        CommonConstants CB;
+        XMFLOAT4X4 View = MathHelper::Identity4x4();
+        XMFLOAT4X4 Proj = MathHelper::Identity4x4();
+        XMFLOAT3 CameraPos = { 0.0f, 0.0f, 0.0f };
+        UploadBuffers Upload;
+
+        EveryFrame()
+        {
+            XMStoreFloat4x4(&Proj, Projection());
+            CB.RenderTargetSize = XMFLOAT2(1920.0f, 1080.0f);
+            CB.InvRenderTargetSize = XMFLOAT2(1.0f / 1920.0f, 1.0f / 1080.0f);
+            CB.NearZ = 1.0f;
+            CB.FarZ = 1000.0f;
+        }
+
+        void Update(const Camera& camera, int frame, float totalTime, float deltaTime)
+        {
+            CameraPos = Position(camera);
+
+            XMVECTOR pos = XMVectorSet(CameraPos.x, CameraPos.y, CameraPos.z, 1.0f);
+            XMStoreFloat4x4(&View, XMMatrixLookAtLH(pos, XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f)));
+
+            XMMATRIX view = XMLoadFloat4x4(&View);
+            XMMATRIX proj = XMLoadFloat4x4(&Proj);
+
+            XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+            XMVECTOR viewDet = XMMatrixDeterminant(view);
+            XMVECTOR projDet = XMMatrixDeterminant(proj);
+            XMVECTOR viewProjDet = XMMatrixDeterminant(viewProj);
+            XMMATRIX invView = XMMatrixInverse(&viewDet, view);
+            XMMATRIX invProj = XMMatrixInverse(&projDet, proj);
+            XMMATRIX invViewProj = XMMatrixInverse(&viewProjDet, viewProj);
+
+            XMStoreFloat4x4(&CB.View, XMMatrixTranspose(view));
+            XMStoreFloat4x4(&CB.InvView, XMMatrixTranspose(invView));
+            XMStoreFloat4x4(&CB.Proj, XMMatrixTranspose(proj));
+            XMStoreFloat4x4(&CB.InvProj, XMMatrixTranspose(invProj));
+            XMStoreFloat4x4(&CB.ViewProj, XMMatrixTranspose(viewProj));
+            XMStoreFloat4x4(&CB.InvViewProj, XMMatrixTranspose(invViewProj));
+            CB.CameraPosW = CameraPos;
+            CB.TotalTime = totalTime;
+            CB.DeltaTime = deltaTime;
+            CB.AmbientLight = AmbientLight;
+            SetLights(CB.Lights);
+
+            Upload.CopyData(frame, CB, 0, sizeof(CommonConstants));
+        }
+    };
+
+    // UpdateCamera and UpdateCommonCB now.
+    struct Cached
+    {
+        CommonConstantsCache Cache = CommonConstantsCache(NumFrameBuffers);
+        UploadBuffers Upload;
+
+        Cached()
+        {
+            Light lights[MaxLights];
+            SetLights(lights);
+            Cache.SetLights(AmbientLight, lights);
+            Cache.SetProjection(Projection(), 1920.0f, 1080.0f, 1.0f, 1000.0f);
+        }
+
+        void Update(const Camera& camera, int frame, float totalTime, float deltaTime)
+        {
+            Cache.LookAt(Position(camera), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+            Cache.Update(totalTime, deltaTime, [&](size_t offset, size_t size)
+            {
+                Upload.CopyData(frame, Cache.GetConstants(), offset, size);
+            });
+        }
+    };
+
+    template<typename Updater>
+    double TimeNsPerFrame(Updater& updater, int frames, bool moving)
+    {
+        Camera camera;
+        const float dt = 1.0f / 60.0f;
+
+        const auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < frames; ++i)
+        {
+            if(moving)
+                camera.Theta += 0.001f;
+            updater.Update(camera, i % NumFrameBuffers, i * dt, dt);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    }
+
+    // largest difference between the constants of the two versions in the last frame buffer,
+    // relative to the magnitude of the constant (the inverse projection holds values near 1000).
+    float MaxDifference(const CommonConstants& a, const CommonConstants& b)
+    {
+        const float* x = (const float*)&a;
+        const float* y = (const float*)&b;
+        float difference = 0.0f;
+        for(size_t i = 0; i < sizeof(CommonConstants) / sizeof(float); ++i)
+            difference = std::max(difference, std::abs(x[i] - y[i]) / std::max(1.0f, std::abs(x[i])));
+        return difference;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = 1000000;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+            frames = std::max(NumFrameBuffers, atoi(argv[++i]));
+    }
+
+    printf("%8s %18s %18s %10s %14s\n", "camera", "before ns/frame", "after ns/frame", "speedup", "max rel diff");
+
+    for(bool moving : { false, true })
+    {
+        EveryFrame before;
+        Cached after;
+        const double beforeNs = TimeNsPerFrame(before, frames, moving);
+        const double afterNs = TimeNsPerFrame(after, frames, moving);
+
+        const int last = (frames - 1) % NumFrameBuffers;
+        const float difference = MaxDifference(before.Upload.Buffers[last], after.Upload.Buffers[last]);
+
+        printf("%8s %18.1f %18.1f %9.1fx %14.2e\n", moving ? "moving" : "static", beforeNs, afterNs,
+            afterNs > 0.0 ? beforeNs / afterNs : 0.0, difference);
+    }
+    return 0;
+}
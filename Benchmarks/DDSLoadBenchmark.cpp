@@ -0,0 +1,332 @@
+//***************************************************************************************
+// DDSLoadBenchmark.cpp
+//
+// Peak memory of loading the textures in Textures/ as LoadDDSTextureData12 used to, reading
+// each file into a heap buffer, against loading them through a MappedFile as it does now.
+// Either way the texel data of every subresource is copied into a staging buffer, as the
+// upload does, and the loaded textures are kept until all of them are in, as the async
+// load queue keeps them until the frame that records their upload.  Each way runs in a
+// process of its own, so its peak resident set (VmHWM) is its own.  File pages of the
+// mappings count as resident too, but they are shared with the file cache and can be
+// dropped under pressure, the private (anonymous) memory is what the change removes.
+// A second table shows what prefetching the texel range on the loading threads buys: the
+// files are loaded on an AsyncLoadQueue with a cold file cache while the main thread does
+// -work milliseconds of other work, as the game builds its geometry, and then the main thread
+// copies every texture to staging.  Without the prefetch that copy faults the pages in, which
+// the page faults counted on the main thread show.
+//   DDSLoadBenchmark [-copies <count>] [-work <ms>]
+//***************************************************************************************
+
+#include "Helpers/AsyncLoadQueue.h"
+#include "Helpers/DDSLayout.h"
+#include "Helpers/MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace DirectX;
+
+namespace
+{
+    const char* TextureNames[] =
+    {
+        "Textures/checkboard.dds",
+        "Textures/energyShell.dds",
+        "Textures/stone.dds",
+        "Textures/water3.dds",
+        "Textures/woodcrate1.dds",
+    };
+
+    struct Result
+    {
+        long PeakKB;
+        long AnonKB;
+        long FileKB;
+        double Ms;
+        bool Ok;
+    };
+
+    // a field of /proc/self/status, in kB.
+    long ReadStatusKB(const char* key)
+    {
+        FILE* file = fopen("/proc/self/status", "r");
+        if(!file)
+            return -1;
+
+        char line[256];
+        long value = -1;
+        const size_t keyLength = strlen(key);
+        while(fgets(line, sizeof(line), file))
+        {
+            if(strncmp(line, key, keyLength) == 0 && line[keyLength] == ':')
+            {
+                value = atol(line + keyLength + 1);
+                break;
+            }
+        }
+        fclose(file);
+        return value;
+    }
+
+    // Lays out the subresources of a DDS file held in memory, returns false if it isn't a 2D
+    // texture this loader handles.
+    bool LayoutSubresources(const uint8_t* data, size_t size, std::vector<DDSSubresourceData>& initData)
+    {
+        const DDS_HEADER* header = nullptr;
+        const uint8_t* bitData = nullptr;
+        size_t bitSize = 0;
+        if(FAILED(ParseDDSHeader(data, size, &header, &bitData, &bitSize)))
+            return false;
+
+        const DXGI_FORMAT format = GetDXGIFormat(header->ddspf);
+        const size_t mipCount = std::max<size_t>(1, header->mipMapCount);
+
+        initData.resize(mipCount);
+        size_t twidth = 0, theight = 0, tdepth = 0, skipMip = 0;
+        return SUCCEEDED(FillInitData12(header->width, header->height, 1, mipCount, 1, format, 0, bitSize, bitData,
+            twidth, theight, tdepth, skipMip, initData.data()));
+    }
+
+    // Copies the texel data of every subresource to staging, as the upload does.
+    void CopyToStaging(const std::vector<DDSSubresourceData>& initData, std::vector<uint8_t>& staging)
+    {
+        size_t offset = 0;
+        for(const DDSSubresourceData& subresource : initData)
+        {
+            if(offset + subresource.SlicePitch > staging.size())
+                staging.resize(offset + subresource.SlicePitch);
+            memcpy(staging.data() + offset, subresource.pData, subresource.SlicePitch);
+            offset += subresource.SlicePitch;
+        }
+    }
+
+    bool CopySubresources(const uint8_t* data, size_t size, std::vector<uint8_t>& staging)
+    {
+        std::vector<DDSSubresourceData> initData;
+        if(!LayoutSubresources(data, size, initData))
+            return false;
+
+        CopyToStaging(initData, staging);
+        return true;
+    }
+
+    // the way LoadTextureDataFromFile read files before the change.
+    bool LoadRead(const char* path, std::vector<std::unique_ptr<uint8_t[]>>& loaded, std::vector<uint8_t>& staging)
+    {
+        int fd = open(path, O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        const off_t size = lseek(fd, 0, SEEK_END);
+        lseek(fd, 0, SEEK_SET);
+
+        std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+        const bool ok = read(fd, data.get(), size) == size && CopySubresources(data.get(), size, staging);
+        close(fd);
+
+        loaded.push_back(std::move(data));
+        return ok;
+    }
+
+    bool LoadMapped(const char* path, std::vector<std::unique_ptr<MappedFile>>& loaded, std::vector<uint8_t>& staging)
+    {
+        std::unique_ptr<MappedFile> file(new MappedFile());
+        const bool ok = file->Open(path) && CopySubresources(file->Data(), file->Size(), staging);
+
+        loaded.push_back(std::move(file));
+        return ok;
+    }
+
+    Result Run(bool mapped, int copies)
+    {
+        Result result = {};
+        result.Ok = true;
+
+        std::vector<uint8_t> staging;
+        std::vector<std::unique_ptr<uint8_t[]>> readFiles;
+        std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+
+        const auto start = std::chrono::steady_clock::now();
+        for(int copy = 0; copy < copies; ++copy)
+        {
+            for(const char* name : TextureNames)
+                result.Ok &= mapped ? LoadMapped(name, mappedFiles, staging) : LoadRead(name, readFiles, staging);
+        }
+        result.Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        result.PeakKB = ReadStatusKB("VmHWM");
+        result.AnonKB = ReadStatusKB("RssAnon");
+        result.FileKB = ReadStatusKB("RssFile");
+        return result;
+    }
+
+    // A texture as a loading thread hands it over: the mapped file and its layout.
+    struct LoadedTexture
+    {
+        MappedFile File;
+        std::vector<DDSSubresourceData> InitData;
+        bool Ok = false;
+    };
+
+    // Asks the OS to drop the textures from the file cache, so the next load reads the disk.
+    void EvictFromFileCache()
+    {
+        for(const char* name : TextureNames)
+        {
+            int fd = open(name, O_RDONLY);
+            if(fd < 0)
+                continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+
+    struct OverlapResult
+    {
+        double MainMs;
+        double TotalMs;
+        long MinorFaults;
+        long MajorFaults;
+        bool Ok;
+    };
+
+    // Loads the textures on an AsyncLoadQueue while the main thread works for workMs, then
+    // copies them to staging on the main thread.  MainMs is the time from the end of the work
+    // to the end of the copies, what the frame that records the uploads waits for.
+    OverlapResult RunOverlap(bool prefetch, int copies, int workMs)
+    {
+        OverlapResult result = {};
+        result.Ok = true;
+        EvictFromFileCache();
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            AsyncLoadQueue<std::unique_ptr<LoadedTexture>> loads;
+            for(int copy = 0; copy < copies; ++copy)
+            {
+                for(const char* name : TextureNames)
+                {
+                    loads.Submit([name, prefetch]()
+                        {
+                            std::unique_ptr<LoadedTexture> texture(new LoadedTexture());
+                            texture->Ok = texture->File.Open(name) &&
+                                LayoutSubresources(texture->File.Data(), texture->File.Size(), texture->InitData);
+
+                            // what LoadDDSTextureData12 does.
+                            if(texture->Ok && prefetch)
+                            {
+                                const uint8_t* texels = static_cast<const uint8_t*>(texture->InitData.front().pData);
+                                texture->File.Prefetch(texels, texture->File.Data() + texture->File.Size() - texels);
+                            }
+                            return texture;
+                        });
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(workMs));
+
+            struct rusage before, after;
+            getrusage(RUSAGE_THREAD, &before);
+            const auto mainStart = std::chrono::steady_clock::now();
+            std::vector<uint8_t> staging;
+            loads.WaitAll([&](AsyncLoadQueue<std::unique_ptr<LoadedTexture>>::Ticket, std::unique_ptr<LoadedTexture>& texture)
+                {
+                    result.Ok &= texture->Ok;
+                    if(texture->Ok)
+                        CopyToStaging(texture->InitData, staging);
+                });
+            const auto end = std::chrono::steady_clock::now();
+            getrusage(RUSAGE_THREAD, &after);
+
+            result.MinorFaults = after.ru_minflt - before.ru_minflt;
+            result.MajorFaults = after.ru_majflt - before.ru_majflt;
+            result.MainMs = std::chrono::duration<double, std::milli>(end - mainStart).count();
+            result.TotalMs = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        return result;
+    }
+
+    // Runs one way in a child process and returns what it measured.
+    Result RunInChild(bool mapped, int copies)
+    {
+        Result result = {};
+
+        int fds[2];
+        if(pipe(fds) != 0)
+            return result;
+
+        const pid_t pid = fork();
+        if(pid == 0)
+        {
+            close(fds[0]);
+            Result child = Run(mapped, copies);
+            const bool written = write(fds[1], &child, sizeof(child)) == (ssize_t)sizeof(child);
+            _exit(written ? 0 : 1);
+        }
+
+        close(fds[1]);
+        if(pid < 0 || read(fds[0], &result, sizeof(result)) != (ssize_t)sizeof(result))
+            result.Ok = false;
+        close(fds[0]);
+
+        if(pid > 0)
+            waitpid(pid, nullptr, 0);
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int copies = 200;
+    int workMs = 20;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-copies") == 0 && i + 1 < argc)
+            copies = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "-work") == 0 && i + 1 < argc)
+            workMs = std::max(0, atoi(argv[++i]));
+    }
+
+    // the process before loading anything, for reference.
+    const Result none = RunInChild(false, 0);
+
+    printf("%d copies of %d textures\n", copies, (int)(sizeof(TextureNames) / sizeof(TextureNames[0])));
+    printf("%8s %12s %12s %12s %10s\n", "load", "peak kB", "anon kB", "file kB", "ms");
+    printf("%8s %12ld %12ld %12ld %10s\n", "none", none.PeakKB, none.AnonKB, none.FileKB, "");
+
+    for(bool mapped : { false, true })
+    {
+        const Result result = RunInChild(mapped, copies);
+        if(!result.Ok)
+        {
+            fprintf(stderr, "failed to load the textures, run from the repository root\n");
+            return 1;
+        }
+        printf("%8s %12ld %12ld %12ld %10.1f\n", mapped ? "mapped" : "read", result.PeakKB, result.AnonKB, result.FileKB, result.Ms);
+    }
+
+    printf("\nasync load, cold file cache, %d ms of main thread work\n", workMs);
+    printf("%8s %12s %12s %12s %12s\n", "load", "main ms", "total ms", "main minflt", "main majflt");
+    for(bool prefetch : { false, true })
+    {
+        const OverlapResult result = RunOverlap(prefetch, copies, workMs);
+        if(!result.Ok)
+        {
+            fprintf(stderr, "failed to load the textures, run from the repository root\n");
+            return 1;
+        }
+        printf("%8s %12.2f %12.2f %12ld %12ld\n", prefetch ? "prefetch" : "mapped", result.MainMs, result.TotalMs,
+            result.MinorFaults, result.MajorFaults);
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+//***************************************************************************************
+// EntityStoreBenchmark.cpp
+//
+// Times a frame of moving entities kept in an EntityStore against the same work on render
+// items allocated one by one, as the enemies were kept before the store: each item holds its
+// world matrix, is moved by multiplying it with a translation, and is switched off once it
+// passes the end of the field.  Entities past the end are respawned, so the count stays the
+// same from frame to frame.
+//   EntityStoreBenchmark [-frames <count>]
+//***************************************************************************************
+
+#include "EntityStore.h"
+#include "Helpers/RandomStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const float FieldStart = 300.0f;
+    const float FieldEnd = -230.0f;
+    const float StepSeconds = 1.0f / 60.0f;
+
+    // the RenderItem of FlyingCrates.cpp as the enemies used it before the store, member for
+    // member, with the Direct3D types replaced by types of the same size.
+    struct RenderItem
+    {
+        XMFLOAT4X4 World;
+        XMFLOAT4X4 TexTransform;
+        int numFrameBufferFilled;
+        unsigned ObjCBIndex;
+        void* Mat;
+        void* Geo;
+        int PrimitiveType;
+        bool isItemStatic;
+        bool isItemActivated;
+        unsigned IndexCount;
+        unsigned StartIndexLocation;
+        int BaseVertexLocation;
+    };
+
+    struct ItemWorld
+    {
+        std::vector<std::unique_ptr<RenderItem>> Items;
+        std::vector<float> Speed;
+
+        void Step(float dt)
+        {
+            for(size_t i = 0; i < Items.size(); ++i)
+            {
+                RenderItem& item = *Items[i];
+                if(item.isItemActivated && item.World._43 < FieldEnd)
+                {
+                    item.isItemActivated = false;
+                }
+                else if(item.isItemActivated)
+                {
+                    XMMATRIX world = XMLoadFloat4x4(&item.World);
+                    world = world * XMMatrixTranslation(0.0f, 0.0f, -Speed[i] * dt);
+                    XMStoreFloat4x4(&item.World, world);
+                    item.numFrameBufferFilled = 3;
+                }
+                else
+                {
+                    XMStoreFloat4x4(&item.World, XMMatrixScaling(15.0f, 15.0f, 15.0f) *
+                        XMMatrixTranslation(item.World._41, 50.0f, FieldStart));
+                    item.isItemActivated = true;
+                }
+            }
+        }
+    };
+
+    struct StoreWorld
+    {
+        EntityStore Entities;
+        std::vector<float> RespawnX;
+
+        void Step(float dt)
+        {
+            Entities.Integrate(dt);
+
+            // flag the entities past the end, remove them, and create them again at the start.
+            const float* z = Entities.PositionZ();
+            const float* x = Entities.PositionX();
+            const float* vz = Entities.VelocityZ();
+            std::uint32_t* flags = Entities.Flags();
+            RespawnX.clear();
+            for(std::uint32_t i = 0; i < Entities.Size(); ++i)
+            {
+                if(z[i] < FieldEnd)
+                {
+                    flags[i] |= 1;
+                    RespawnX.push_back(x[i]);
+                    RespawnX.push_back(vz[i]);
+                }
+            }
+            Entities.DestroyFlagged(1);
+
+            for(size_t i = 0; i < RespawnX.size(); i += 2)
+            {
+                Entities.Create(XMFLOAT3(RespawnX[i], 50.0f, FieldStart), XMFLOAT3(0.0f, 0.0f, RespawnX[i + 1]), 15.0f,
+                    5.0f, 0);
+            }
+        }
+    };
+
+    template<typename Function>
+    double TimeUsPerFrame(int frames, Function function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < frames; ++i)
+            function();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = 200;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+            frames = std::max(1, atoi(argv[++i]));
+    }
+
+    printf("%10s %16s %16s %10s\n", "entities", "items us/frame", "store us/frame", "speedup");
+
+    for(std::uint32_t count : { 10000u, 100000u, 1000000u })
+    {
+        RandomStream random(count);
+
+        ItemWorld items;
+        StoreWorld store;
+        store.Entities.Reserve(count);
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            const float x = random.NextFloat(-200.0f, 200.0f);
+            const float z = random.NextFloat(FieldEnd, FieldStart);
+            const float speed = random.NextFloat(15.0f, 40.0f);
+
+            std::unique_ptr<RenderItem> item(new RenderItem());
+            XMStoreFloat4x4(&item->World, XMMatrixScaling(15.0f, 15.0f, 15.0f) * XMMatrixTranslation(x, 50.0f, z));
+            item->isItemActivated = true;
+            items.Items.push_back(std::move(item));
+            items.Speed.push_back(speed);
+
+            store.Entities.Create(XMFLOAT3(x, 50.0f, z), XMFLOAT3(0.0f, 0.0f, -speed), 15.0f, 5.0f, i);
+        }
+
+        // fewer frames at the larger counts keep the run short.
+        const int countFrames = std::max(1, (int)(frames * 10000ull / count));
+        items.Step(StepSeconds);
+        store.Step(StepSeconds);
+        const double itemUs = TimeUsPerFrame(countFrames, [&] { items.Step(StepSeconds); });
+        const double storeUs = TimeUsPerFrame(countFrames, [&] { store.Step(StepSeconds); });
+
+        printf("%10u %16.1f %16.1f %9.1fx\n", count, itemUs, storeUs, storeUs > 0.0 ? itemUs / storeUs : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+//***************************************************************************************
+// GeosphereBenchmark.cpp
+//
+// Times CreateGeosphere and CreateBox at each subdivision level, the fastest of a number of
+// runs, into fresh arrays and into arrays reserved with the Get*Size functions.
+//   GeosphereBenchmark [-runs <count>]
+//***************************************************************************************
+
+#include "Helpers/GeometryGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    template<typename Build>
+    double FastestMs(int runs, Build build)
+    {
+        double best = 1e30;
+        for(int run = 0; run < runs; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            build();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 20;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "-runs") == 0 && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+    }
+
+    GeometryGenerator geoGen;
+    std::printf("level  geosphere verts        ms   reserved ms    box verts        ms\n");
+    for(std::uint32_t n = 0; n <= 6; ++n)
+    {
+        std::size_t sphereVertices = 0, boxVertices = 0;
+        double sphereMs = FastestMs(runs, [&]()
+        {
+            sphereVertices = geoGen.CreateGeosphere(1.0f, n).Vertices.size();
+        });
+
+        // the way the game builds its meshes into shared arrays.
+        const GeometryGenerator::MeshSize size = GeometryGenerator::GetGeosphereSize(n);
+        std::vector<GeometryGenerator::Vertex> vertices;
+        std::vector<std::uint32_t> indices;
+        double reservedMs = FastestMs(runs, [&]()
+        {
+            vertices.clear();
+            indices.clear();
+            vertices.reserve(size.Vertices);
+            indices.reserve(size.Indices);
+            geoGen.CreateGeosphere(1.0f, n, vertices, indices);
+        });
+
+        double boxMs = FastestMs(runs, [&]()
+        {
+            boxVertices = geoGen.CreateBox(1.0f, 1.0f, 1.0f, n).Vertices.size();
+        });
+
+        std::printf("%5u  %15zu  %8.3f  %12.3f  %11zu  %8.3f\n", n, sphereVertices, sphereMs, reservedMs,
+            boxVertices, boxMs);
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+// EntityStore.cpp
+
+#include "EntityStore.h"
+#include <cassert>
+
+using namespace DirectX;
+
+EntityStore::EntityStore(std::uint32_t capacity)
+{
+	Reserve(capacity);
+}
+
+EntityStore::~EntityStore()
+{
+
+}
+
+void EntityStore::Reserve(std::uint32_t capacity)
+{
+	mPosX.reserve(capacity);
+	mPosY.reserve(capacity);
+	mPosZ.reserve(capacity);
+	mPrevX.reserve(capacity);
+	mPrevY.reserve(capacity);
+	mPrevZ.reserve(capacity);
+	mVelX.reserve(capacity);
+	mVelY.reserve(capacity);
+	mVelZ.reserve(capacity);
+	mScale.reserve(capacity);
+	mRadius.reserve(capacity);
+	mFlags.reserve(capacity);
+	mRenderHandle.reserve(capacity);
+	mSlotOf.reserve(capacity);
+	mSlotIndex.reserve(capacity);
+	mSlotGeneration.reserve(capacity);
+}
+
+EntityHandle EntityStore::Create(const XMFLOAT3& position, const XMFLOAT3& velocity, float scale,
+	float radius, std::uint32_t renderHandle, std::uint32_t flags)
+{
+	std::uint32_t slot;
+	if (!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		slot = (std::uint32_t)mSlotIndex.size();
+		mSlotIndex.push_back(0);
+		mSlotGeneration.push_back(0);
+	}
+
+	mSlotIndex[slot] = Size();
+	mSlotOf.push_back(slot);
+
+	mPosX.push_back(position.x);
+	mPosY.push_back(position.y);
+	mPosZ.push_back(position.z);
+	mPrevX.push_back(position.x);
+	mPrevY.push_back(position.y);
+	mPrevZ.push_back(position.z);
+	mVelX.push_back(velocity.x);
+	mVelY.push_back(velocity.y);
+	mVelZ.push_back(velocity.z);
+	mScale.push_back(scale);
+	mRadius.push_back(radius);
+	mFlags.push_back(flags);
+	mRenderHandle.push_back(renderHandle);
+
+	EntityHandle handle;
+	handle.Slot = slot;
+	handle.Generation = mSlotGeneration[slot];
+	return handle;
+}
+
+void EntityStore::Destroy(EntityHandle handle)
+{
+	assert(IsAlive(handle));
+	DestroyAt(mSlotIndex[handle.Slot]);
+}
+
+void EntityStore::DestroyAt(std::uint32_t index)
+{
+	assert(index < Size());
+
+	// the last entity fills the hole, its slot follows it.
+	std::uint32_t last = Size() - 1;
+	std::uint32_t slot = mSlotOf[index];
+	if (index != last)
+	{
+		mPosX[index] = mPosX[last];
+		mPosY[index] = mPosY[last];
+		mPosZ[index] = mPosZ[last];
+		mPrevX[index] = mPrevX[last];
+		mPrevY[index] = mPrevY[last];
+		mPrevZ[index] = mPrevZ[last];
+		mVelX[index] = mVelX[last];
+		mVelY[index] = mVelY[last];
+		mVelZ[index] = mVelZ[last];
+		mScale[index] = mScale[last];
+		mRadius[index] = mRadius[last];
+		mFlags[index] = mFlags[last];
+		mRenderHandle[index] = mRenderHandle[last];
+		mSlotOf[index] = mSlotOf[last];
+		mSlotIndex[mSlotOf[index]] = index;
+	}
+
+	mPosX.pop_back();
+	mPosY.pop_back();
+	mPosZ.pop_back();
+	mPrevX.pop_back();
+	mPrevY.pop_back();
+	mPrevZ.pop_back();
+	mVelX.pop_back();
+	mVelY.pop_back();
+	mVelZ.pop_back();
+	mScale.pop_back();
+	mRadius.pop_back();
+	mFlags.pop_back();
+	mRenderHandle.pop_back();
+	mSlotOf.pop_back();
+
+	// handles of the destroyed entity no longer match the slot.
+	mSlotGeneration[slot]++;
+	mFreeSlots.push_back(slot);
+}
+
+std::uint32_t EntityStore::DestroyFlagged(std::uint32_t flags)
+{
+	// walk backwards, an entity swapped in from the end has been checked already.
+	std::uint32_t removed = 0;
+	for (std::uint32_t i = Size(); i-- > 0; )
+	{
+		if (mFlags[i] & flags)
+		{
+			DestroyAt(i);
+			removed++;
+		}
+	}
+	return removed;
+}
+
+void EntityStore::Clear()
+{
+	while (!Empty())
+	{
+		DestroyAt(Size() - 1);
+	}
+}
+
+bool EntityStore::IsAlive(EntityHandle handle) const
+{
+	return handle.Slot < mSlotGeneration.size() && mSlotGeneration[handle.Slot] == handle.Generation;
+}
+
+std::uint32_t EntityStore::IndexOf(EntityHandle handle) const
+{
+	assert(IsAlive(handle));
+	return mSlotIndex[handle.Slot];
+}
+
+EntityHandle EntityStore::HandleAt(std::uint32_t index) const
+{
+	assert(index < Size());
+
+	EntityHandle handle;
+	handle.Slot = mSlotOf[index];
+	handle.Generation = mSlotGeneration[handle.Slot];
+	return handle;
+}
+
+void EntityStore::Integrate(float dt)
+{
+	// plain loops over separate columns, the compiler vectorizes them.
+	const std::uint32_t count = Size();
+	float* px = mPosX.data();
+	float* py = mPosY.data();
+	float* pz = mPosZ.data();
+	const float* vx = mVelX.data();
+	const float* vy = mVelY.data();
+	const float* vz = mVelZ.data();
+
+	mPrevX.assign(mPosX.begin(), mPosX.end());
+	mPrevY.assign(mPosY.begin(), mPosY.end());
+	mPrevZ.assign(mPosZ.begin(), mPosZ.end());
+
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		px[i] += vx[i] * dt;
+	}
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		py[i] += vy[i] * dt;
+	}
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		pz[i] += vz[i] * dt;
+	}
+}
+
+XMFLOAT3 EntityStore::GetPosition(std::uint32_t index) const
+{
+	assert(index < Size());
+	return XMFLOAT3(mPosX[index], mPosY[index], mPosZ[index]);
+}
+
+void EntityStore::SetPosition(std::uint32_t index, const XMFLOAT3& position)
+{
+	assert(index < Size());
+	mPosX[index] = position.x;
+	mPosY[index] = position.y;
+	mPosZ[index] = position.z;
+}
@@ -0,0 +1,109 @@
+#pragma once
+// structure-of-arrays storage of the moving entities of the game (shells, enemies).
+// every column is a dense array indexed by the entity index, so gameplay systems walk
+// contiguous memory and only touch the columns they need.
+// entities are referred to by handles that survive the removal of other entities: a handle
+// names a slot, which remembers the current dense index of its entity and a generation that
+// changes when the entity is destroyed, so stale handles are detected.
+// destroying an entity moves the last one into its place (swap-remove): the columns stay dense
+// but the order of the entities is not kept.
+// the position before the last Integrate() is kept as well, so collisions can be tested along
+// the whole step.
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+struct EntityHandle
+{
+	std::uint32_t Slot = ~0u;
+	std::uint32_t Generation = 0;
+};
+
+class EntityStore
+{
+public:
+	EntityStore() = default;
+	explicit EntityStore(std::uint32_t capacity);
+	EntityStore(const EntityStore& rhs) = delete;
+	EntityStore& operator=(const EntityStore& rhs) = delete;
+	~EntityStore();
+
+	void Reserve(std::uint32_t capacity);
+
+	// radius is the collision radius. flags and renderHandle are the caller's, the store only keeps
+	// them next to the entity.
+	EntityHandle Create(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& velocity, float scale,
+		float radius, std::uint32_t renderHandle, std::uint32_t flags = 0);
+
+	void Destroy(EntityHandle handle);
+	void DestroyAt(std::uint32_t index);
+
+	// removes every entity that has one of flags set, returns how many were removed.
+	std::uint32_t DestroyFlagged(std::uint32_t flags);
+
+	void Clear();
+
+	bool IsAlive(EntityHandle handle) const;
+	std::uint32_t IndexOf(EntityHandle handle) const;
+	EntityHandle HandleAt(std::uint32_t index) const;
+
+	std::uint32_t Size() const { return (std::uint32_t)mPosX.size(); }
+	bool Empty() const { return mPosX.empty(); }
+
+	// previous position = position, then position += velocity * dt for every entity.
+	void Integrate(float dt);
+
+	DirectX::XMFLOAT3 GetPosition(std::uint32_t index) const;
+	void SetPosition(std::uint32_t index, const DirectX::XMFLOAT3& position);
+
+	// columns, Size() entries each.
+	float* PositionX() { return mPosX.data(); }
+	float* PositionY() { return mPosY.data(); }
+	float* PositionZ() { return mPosZ.data(); }
+	float* PrevPositionX() { return mPrevX.data(); }
+	float* PrevPositionY() { return mPrevY.data(); }
+	float* PrevPositionZ() { return mPrevZ.data(); }
+	float* VelocityX() { return mVelX.data(); }
+	float* VelocityY() { return mVelY.data(); }
+	float* VelocityZ() { return mVelZ.data(); }
+	float* Scale() { return mScale.data(); }
+	float* Radius() { return mRadius.data(); }
+	std::uint32_t* Flags() { return mFlags.data(); }
+	std::uint32_t* RenderHandle() { return mRenderHandle.data(); }
+
+	const float* PositionX() const { return mPosX.data(); }
+	const float* PositionY() const { return mPosY.data(); }
+	const float* PositionZ() const { return mPosZ.data(); }
+	const float* PrevPositionX() const { return mPrevX.data(); }
+	const float* PrevPositionY() const { return mPrevY.data(); }
+	const float* PrevPositionZ() const { return mPrevZ.data(); }
+	const float* VelocityX() const { return mVelX.data(); }
+	const float* VelocityY() const { return mVelY.data(); }
+	const float* VelocityZ() const { return mVelZ.data(); }
+	const float* Scale() const { return mScale.data(); }
+	const float* Radius() const { return mRadius.data(); }
+	const std::uint32_t* Flags() const { return mFlags.data(); }
+	const std::uint32_t* RenderHandle() const { return mRenderHandle.data(); }
+
+private:
+	std::vector<float> mPosX;
+	std::vector<float> mPosY;
+	std::vector<float> mPosZ;
+	std::vector<float> mPrevX;
+	std::vector<float> mPrevY;
+	std::vector<float> mPrevZ;
+	std::vector<float> mVelX;
+	std::vector<float> mVelY;
+	std::vector<float> mVelZ;
+	std::vector<float> mScale;
+	std::vector<float> mRadius;
+	std::vector<std::uint32_t> mFlags;
+	std::vector<std::uint32_t> mRenderHandle;
+
+	// dense index -> slot, and slot -> dense index and generation.
+	std::vector<std::uint32_t> mSlotOf;
+	std::vector<std::uint32_t> mSlotIndex;
+	std::vector<std::uint32_t> mSlotGeneration;
+	std::vector<std::uint32_t> mFreeSlots;
+};
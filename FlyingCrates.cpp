@@ -10,8 +10,20 @@
 #include "Helpers/MathHelper.h"
 #include "Helpers/UploadBuffer.h"
 #include "Helpers/GeometryGenerator.h"
+#include "Helpers/FrustumCuller.h"
+#include "Helpers/PipelineStateCache.h"
+#include "Helpers/ShaderCache.h"
+#include "Helpers/ShaderPermutations.h"
+#include "Helpers/AsyncLoadQueue.h"
+#include "Helpers/UploadManager.h"
+#include "Helpers/PlacedResourceAllocator.h"
+#include "Helpers/GeometryRegistry.h"
+#include "Helpers/VertexCompression.h"
+#include "Helpers/MeshOptimizer.h"
+#include "Helpers/Transform.h"
 #include "FrameBuffer.h"
-#include "WaterSurface.h"
+#include "GameWorld.h"
+#include "InputRecording.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -29,9 +41,14 @@ struct RenderItem
 
 	XMFLOAT4X4 World = MathHelper::Identity4x4();
 
+	// for moving object, World is composed from it once it changes (see FlyingCrates::MoveRitem).
+	Transform Placement;
+	bool isTransformDirty = false;
+
 	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 
-	// for static object. static object doesn't need continuous buffer update 
+	// frame buffers whose object constants are out of date. static object doesn't need continuous buffer update,
+	// moving object is uploaded again whenever its transform changes.
 	int numFrameBufferFilled = gNumFrameBuffers;	
 
 	//  object constant buffer index
@@ -43,7 +60,13 @@ struct RenderItem
 	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
 	bool isItemStatic = false;
-	bool isItemActivated;
+	bool isItemActivated = true;
+
+	// local space bounding box copied from the submesh, used for frustum culling.
+	BoundingBox Bounds;
+
+	// rebuilds the positions of compact vertices, identity for full float vertices.
+	PositionDecode PosDecode;
 
 	// ID3D12GraphicsCommandList::DrawIndexedInstanced parameters.
 	UINT IndexCount = 0;
@@ -62,43 +85,12 @@ enum class RenderLayer : int
 	Count		// the total count of elements
 };
 
-
-struct WPosition			// for storing position vector out of a world matrix
-{
-	float x;
-	float y;
-	float z;
-};
-
-struct EnergyShell
-{
-	RenderItem* rpShell[5];					// RenderItem pointer Shell
-	float speed;
-};
-
-
-struct Player
-{
-	RenderItem* objPlayer;
-	EnergyShell myShell;
-	float playerScale;
-	WPosition plPosition;
-	size_t killCount;
-};
-
-struct Enemy
-{
-	RenderItem* rpEnemy[5];					// RenderItem pointer Enemy
-	float speed[5];
-	XMFLOAT4X4 refPosition;
-};
-
-bool CloseEnough(WPosition pt1, WPosition pt2, float dist);
+void ReportMeshOptimization(const char* name, const MeshOptimizer::Report& report);
 
 class FlyingCrates : public D3DApp
 {
 public:
-	FlyingCrates(HINSTANCE hInstance);
+	FlyingCrates(HINSTANCE hInstance, const GameSettings& settings, unique_ptr<InputReplay> replay, const string& recordPath);
 	FlyingCrates(const FlyingCrates& rhs) = delete;
 	FlyingCrates& operator=(const FlyingCrates& rhs) = delete;
 	~FlyingCrates();
@@ -108,35 +100,45 @@ public:
 private:
 	virtual void OnResize() override;
 	virtual void Update(const GameTimer& gt) override;
+	virtual void UpdateStep(float dt) override;
 	virtual void Draw(const GameTimer& gt) override;
 
 	virtual void OnMouseDown(WPARAM btnState, int x, int y) override;
 	virtual void OnMouseUp(WPARAM btnState, int x, int y) override;
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) override;
 
-	void OnKeyboardInput(const GameTimer& gt);
+	GameInput ReadKeyboardInput() const;
+	void FinishReplay();
 	void UpdateCamera(const GameTimer& gt);
 	void AnimateTextures(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateCommonCB(const GameTimer& gt);
 	void UpdateWaterSurface(const GameTimer& gt);
-	void UpdateEnemies(const GameTimer& gt);
+	void UpdatePlayerRitem(float alpha);
+	void MoveRitem(RenderItem* ri, const XMFLOAT3& position, float scale);
+	void ComposeWorldMatrices();
+	void UpdateEntityRitems(const EntityStore& entities, const vector<RenderItem*>& ritems, RenderLayer layer, float alpha);
+	void CullRenderingItems();
 	void WriteCaption();
 
 	void PrepareTextures();
+	void CreateTextures();
 	void SetRootSignature();
 	void SetDescriptorHeaps();
 	void SetShadersAndInputLayout();
 	void SetTerrainGeometry();
 	void SetWaterGeometry();
 	void SetFiguresGeometry();
-	void CollisionProcessing(RenderItem* player, RenderItem** shells, RenderItem** enemies, const int& shellCount, const int& enemyCount);
+	void AddStaticMesh(const string& name, const vector<Vertex>& vertices, const uint16_t* indices, UINT indexCount);
+	void BuildStaticGeometry();
 	void SetPSOs();
 	void SetFrameBuffers();
 	void SetMaterials();
+	void SetLights();
 	void SetRenderingItems();
 
+	void BindGeometry(ID3D12GraphicsCommandList* cmdList, const RenderItem* ri);
 	void DrawRenderingItems(ID3D12GraphicsCommandList* cmdList, const vector<RenderItem*>& ritems);
 	void DrawGroupItems(ID3D12GraphicsCommandList* cmdList, const vector<RenderItem*>& ritems);
 
@@ -155,13 +157,32 @@ private:
 	ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 
+	// default heap buffers and textures are placed in a few shared heaps, declared first since the heaps must outlive them.
+	unique_ptr<PlacedResourceAllocator> mResourceAllocator;
+
 	unordered_map<string, unique_ptr<MeshGeometry>> mGeometries;				// categorize different mesh geometries by name(std::string).
+	unique_ptr<GeometryRegistry> mGeometryRegistry;								// static meshes packed into the shared "staticGeo" buffers.
+	bool mCompactVertices = true;												// static meshes use the 16 byte CompactVertex instead of Vertex.
+	const MeshGeometry* mBoundGeo = nullptr;									// geometry whose buffers are bound to IA in the current frame.
+	D3D12_PRIMITIVE_TOPOLOGY mBoundTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
 	unordered_map<string, unique_ptr<Material>> mMaterials;						// categorize different materials by name.
 	unordered_map<string, unique_ptr<Texture>> mTextures;						// categorize different textures by name.
+
+	// texture files are parsed on worker threads during initialization, the resources are created on the main thread.
+	unique_ptr<AsyncLoadQueue<unique_ptr<DirectX::DDSTextureData12>>> mTextureLoads;
+	vector<Texture*> mLoadingTextures;											// texture being loaded by each ticket of mTextureLoads.
+
+	// static buffers and textures are uploaded through a copy queue, the direct queue waits for them on the GPU.
+	unique_ptr<UploadManager> mUploadManager;
 	unordered_map<string, ComPtr<ID3DBlob>> mShaders;							// categorize compiled shader source by name.
-	unordered_map<string, ComPtr<ID3D12PipelineState>> mPSOs;					// categorize differently defined pipeline state objects by name.
+	unique_ptr<ShaderCache> mShaderCache;										// compiled bytecode kept on disk between runs.
+	unique_ptr<ShaderPermutations> mShaderPermutations;						// pixel shader variants specialized on the light counts.
+
+	unique_ptr<PipelineStateCache> mPsoCache;									// shares one pipeline state object among identical descriptions.
+	PipelineStateCache::Handle mLayerPSO[(int)RenderLayer::Count];				// pipeline state object handle used to draw each render layer.
 
 	vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;								// layout of data supplied to IA(Input Assembler) of the rendering pipeline.
+	vector<D3D12_INPUT_ELEMENT_DESC> mStaticInputLayout;						// layout of the static meshes, compact or the same as mInputLayout.
 
 	RenderItem* mWaterRitem = nullptr;											// for applying vertices of water object dynamically
 
@@ -171,21 +192,40 @@ private:
 	// Render items divided by PSO.
 	vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
 
-	unique_ptr<WaterSurface> mWaterSurface;
+	// Render items of each layer that survived frustum culling in the current frame.
+	vector<RenderItem*> mVisibleRitems[(int)RenderLayer::Count];
+
+	FrustumCuller mFrustumCuller;
+	vector<uint8_t> mVisibility;
+
+	// camera-derived constants are recomputed only when the view(UpdateCamera) or projection(OnResize) changes,
+	// and only the parts that are out of date in the current frame buffer are uploaded.
+	CommonConstantsCache mCommonCB{ gNumFrameBuffers };
+
+	// lights of the scene by type, packed into the common constants in the order the selected shader permutation expects.
+	vector<Light> mDirLights;
+	vector<Light> mPointLights;
+	vector<Light> mSpotLights;
+	ShaderPermutations::Key mLightingKey;
 
-	CommonConstants mCommonCB;
-	
 	UINT mSkyCubeTexHeapIndex = 0;
 
-	Player mPlayer;
-	Enemy mEnemy;
+	// the simulation, the render items below draw its state.
+	GameWorld mWorld;
 
-	float mLastFireTime = 0.0f;
-	float maneuverSpeed = 50.0f;
+	// input of the steps comes from mReplay when a recorded session is replayed, mRecorder records it.
+	unique_ptr<InputReplay> mReplay;
+	unique_ptr<InputRecorder> mRecorder;
+	UINT mReplayFrames = 0;				// frames drawn during the replay, for the frame time of the benchmark.
 
-	XMFLOAT3 mCameraPos = { 0.0f, 0.0f, 0.0f };
-	XMFLOAT4X4 mView = MathHelper::Identity4x4();
-	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
+	RenderItem* mPlayerRitem = nullptr;
+
+	// render items of the shell and enemy slots of the world, indexed by slot.
+	vector<RenderItem*> mShellRitems;
+	vector<RenderItem*> mEnemyRitems;
+
+	// moving items whose transform changed since their world matrix was composed.
+	vector<RenderItem*> mMovedRitems;
 
 	float mTheta = 0.0f;
 	float mPhi = 0.0f;
@@ -204,9 +244,25 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	GameSettings settings = ParseSettings(cmdLine);
+	RecordingOptions recording = ParseRecordingOptions(cmdLine, settings);
+
+	// a replay plays the session it recorded, with its settings.
+	unique_ptr<InputReplay> replay;
+	if (!recording.ReplayPath.empty())
+	{
+		replay = make_unique<InputReplay>();
+		if (!replay->Open(recording.ReplayPath))
+		{
+			MessageBox(nullptr, L"The input recording can't be read.", L"Replay Failed...", MB_OK);
+			return 0;
+		}
+		settings = replay->GetSettings();
+	}
+
 	try
 	{
-		FlyingCrates thisApp(hInstance);
+		FlyingCrates thisApp(hInstance, settings, move(replay), recording.RecordPath);
 		if (!thisApp.Initialize())
 		{
 			return 0;
@@ -220,32 +276,34 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
 	}
 }
 
-FlyingCrates::FlyingCrates(HINSTANCE hInstance) : D3DApp(hInstance)
+FlyingCrates::FlyingCrates(HINSTANCE hInstance, const GameSettings& settings, unique_ptr<InputReplay> replay, const string& recordPath)
+	: D3DApp(hInstance), mWorld(settings), mReplay(move(replay))
 {
 	this->mRadius = 350.0f;
 	this->mPhi = MathHelper::Pi / 2.8f;
 	this->mTheta = -XM_PIDIV2;
 
-	// set initial position of the player appeared in the scene.
-	mPlayer.playerScale = 15.0f;
-	mPlayer.plPosition.x = 0.0f;
-	mPlayer.plPosition.y = 50.0f;
-	mPlayer.plPosition.z = -200.0f;
-
-	mPlayer.myShell.speed = 250.0f;
-	mPlayer.killCount = 0;
+	mStepLoop.SetStepRate(settings.TickRate);
 
-	for (int i = 0; i < 5; ++i)
+	if (!recordPath.empty())
 	{
-		mEnemy.speed[i] = 30.0f;
+		mRecorder = make_unique<InputRecorder>();
+		if (!mRecorder->Open(recordPath, settings))
+		{
+			OutputDebugStringA(("the input can't be recorded to " + recordPath + "\n").c_str());
+			mRecorder.reset();
+		}
 	}
-	mEnemy.refPosition = MathHelper::Identity4x4();
-
-	mLastFireTime = D3DApp::mTimer.TotalTime();
 }
 
 FlyingCrates::~FlyingCrates()
 {
+	// the recording ends with the state it played to.
+	if (mRecorder != nullptr)
+	{
+		mRecorder->Close(mWorld.GetStateHash());
+	}
+
 	if (md3dDevice != nullptr)
 	{
 		FlushCommandQueue();
@@ -264,28 +322,34 @@ bool FlyingCrates::Initialize()
 
 	mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	mWaterSurface = make_unique<WaterSurface>(200, 200, 2.0f, 0.03f, 5.0f, 0.1f);
+	mResourceAllocator = make_unique<PlacedResourceAllocator>(md3dDevice.Get());
+	mUploadManager = make_unique<UploadManager>(md3dDevice.Get(), mResourceAllocator.get());
+	mGeometryRegistry = make_unique<GeometryRegistry>(mCompactVertices ? (UINT)sizeof(CompactVertex) : (UINT)sizeof(Vertex));
 
-	PrepareTextures();
+	PrepareTextures();						// start loading texture files in the background.
 	SetRootSignature();
-	SetDescriptorHeaps();					// set descriptor heaps inside which shader resources descriptors are recorded.
+	SetLights();							// set up the light array and the ambient light once, this decides the pixel shader permutation.
 	SetShadersAndInputLayout();				// compile shaders and set input layout to IA(Input Assembler)
 	SetTerrainGeometry();					// set mesh geometries for the terrain.
 	SetWaterGeometry();						// set water mesh geometry
 	SetFiguresGeometry();
+	BuildStaticGeometry();					// upload the terrain and the figures in one shared vertex and index buffer.
+	CreateTextures();						// wait for the texture files and record their uploads.
+	SetDescriptorHeaps();					// set descriptor heaps inside which shader resources descriptors are recorded.
 	SetMaterials();
 	SetRenderingItems();					// prepare rendering items: their geometries, material properties, and textures are set.
 	SetFrameBuffers();
 	SetPSOs();								// set rendering pipeline state objects.
 
+	// send the uploads to the copy queue, the direct queue waits for them on the GPU instead of the CPU blocking here.
+	UploadManager::Ticket uploadTicket = mUploadManager->Submit();
+	mUploadManager->WaitOnQueue(mCommandQueue.Get(), uploadTicket);
+
 	// execute the initialization commands.
 	ThrowIfFailed(mCommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
 	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 
-	// wait until initialization is done.
-	FlushCommandQueue();
-
 	return true;
 }
 
@@ -293,15 +357,47 @@ void FlyingCrates::OnResize()
 {
 	D3DApp::OnResize();
 	XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
-	XMStoreFloat4x4(&mProj, P);
+	mCommonCB.SetProjection(P, (float)mClientWidth, (float)mClientHeight, 1.0f, 1000.0f);
+}
+
+void FlyingCrates::UpdateStep(float dt)
+{
+	// the replay has ended, the window is closing.
+	if (mReplay != nullptr && mReplay->IsOver())
+	{
+		return;
+	}
+
+	// input is sampled once per step, a replay plays the input recorded for the step instead.
+	GameInput input = mReplay != nullptr ? mReplay->Next() : ReadKeyboardInput();
+	if (mRecorder != nullptr)
+	{
+		mRecorder->Record(input);
+	}
+	mWorld.Step(dt, input);
+
+	if (mReplay != nullptr && mReplay->IsOver())
+	{
+		FinishReplay();
+	}
 }
 
 void FlyingCrates::Update(const GameTimer& gt)
 {
-	OnKeyboardInput(gt);
+	// moving things are drawn between their states before and after the last step.
+	const float alpha = mStepLoop.GetAlpha();
+
+	if (mReplay != nullptr)
+	{
+		mReplayFrames++;
+	}
+
 	UpdateCamera(gt);
-	UpdateEnemies(gt);
-	CollisionProcessing(mPlayer.objPlayer, mPlayer.myShell.rpShell, mEnemy.rpEnemy, 5, 5);
+	UpdatePlayerRitem(alpha);
+	UpdateEntityRitems(mWorld.GetShells(), mShellRitems, RenderLayer::Shell, alpha);
+	UpdateEntityRitems(mWorld.GetEnemies(), mEnemyRitems, RenderLayer::Enemy, alpha);
+	ComposeWorldMatrices();		// culling and the object constants read the world matrices of the moved items.
+	CullRenderingItems();		// only items inside the view frustum go to the draw lists.
 	WriteCaption();
 
 	// cycle through the circular frame buffer array.
@@ -318,6 +414,8 @@ void FlyingCrates::Update(const GameTimer& gt)
 		CloseHandle(eventHandle);
 	}
 
+	mUploadManager->Retire();	// release staging memory of the uploads that have completed.
+
 	AnimateTextures(gt);		// it implements visual effect of flowing water surface.
 	UpdateObjectCBs(gt);
 	UpdateMaterialCBs(gt);
@@ -331,7 +429,8 @@ void FlyingCrates::Draw(const GameTimer& gt)
 
 	ThrowIfFailed(cmdListAlloc->Reset());
 
-	ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));		// set pipeline state object mPSOs["opaque"] for a default PSO.
+	PipelineStateCache::Handle currPso = mLayerPSO[(int)RenderLayer::Opaque];
+	ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPsoCache->Get(currPso)));		// set the opaque pipeline state object for a default PSO.
 
 	mCommandList->RSSetViewports(1, &mScreenViewport);
 	mCommandList->RSSetScissorRects(1, &mScissorRect);
@@ -341,7 +440,7 @@ void FlyingCrates::Draw(const GameTimer& gt)
 		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
 
 	// clear the back buffer and depth buffer.
-	mCommandList->ClearRenderTargetView(CurrentBackBufferView(), (float*)&mCommonCB.FogEffectColor, 0, nullptr);
+	mCommandList->ClearRenderTargetView(CurrentBackBufferView(), (float*)&mCommonCB.GetConstants().FogEffectColor, 0, nullptr);
 	mCommandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
 	// specify the buffers we are going to render to.
@@ -352,6 +451,10 @@ void FlyingCrates::Draw(const GameTimer& gt)
 
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
+	// a new command list starts with nothing bound to IA.
+	mBoundGeo = nullptr;
+	mBoundTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
 	auto commonCB = mCurrFrameBuffer->CommonCB->Resource();
 	mCommandList->SetGraphicsRootConstantBufferView(2, commonCB->GetGPUVirtualAddress());
 
@@ -359,29 +462,33 @@ void FlyingCrates::Draw(const GameTimer& gt)
 	skyTexDescriptor.Offset(mSkyCubeTexHeapIndex, mCbvSrvDescriptorSize);
 	mCommandList->SetGraphicsRootDescriptorTable(4, skyTexDescriptor);
 
-	// draw a opaque object : terrain
-	DrawRenderingItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
-
-	// draw a transparent object : water surface
-	mCommandList->SetPipelineState(mPSOs["transparent"].Get());
-	DrawRenderingItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Transparent]);
-
-	// draw a player object : a crate
-	mCommandList->SetPipelineState(mPSOs["player"].Get());
-	DrawRenderingItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Player]);
-
-	// draw shells getting fired from the player
-	mCommandList->SetPipelineState(mPSOs["shell"].Get());
-	DrawGroupItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Shell]);
-
-	// draw enemy cubes
-	mCommandList->SetPipelineState(mPSOs["enemy"].Get());
-	DrawGroupItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Enemy]);
-
-	// draw a far-sighted sky
-	mCommandList->SetPipelineState(mPSOs["sky"].Get());
-	DrawRenderingItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Sky]);
-
+	// draw order: the opaque terrain, the player's crate, the shells and the enemy crates share one PSO,
+	// so they are submitted back to back. the transparent water surface follows and the sky comes last.
+	const RenderLayer drawOrder[] =
+	{
+		RenderLayer::Opaque, RenderLayer::Player, RenderLayer::Shell, RenderLayer::Enemy,
+		RenderLayer::Transparent, RenderLayer::Sky
+	};
+
+	for (RenderLayer layer : drawOrder)
+	{
+		// switch pipeline state only when the layer actually uses a different one.
+		if (mLayerPSO[(int)layer] != currPso)
+		{
+			currPso = mLayerPSO[(int)layer];
+			mCommandList->SetPipelineState(mPsoCache->Get(currPso));
+		}
+
+		if (layer == RenderLayer::Shell || layer == RenderLayer::Enemy)
+		{
+			DrawGroupItems(mCommandList.Get(), mVisibleRitems[(int)layer]);
+		}
+		else
+		{
+			DrawRenderingItems(mCommandList.Get(), mVisibleRitems[(int)layer]);
+		}
+	}
+
 	// Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
@@ -445,157 +552,132 @@ void FlyingCrates::OnMouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.y = y;
 }
 
-void FlyingCrates::OnKeyboardInput(const GameTimer& gt)
+GameInput FlyingCrates::ReadKeyboardInput() const
 {
-	const float dt = gt.DeltaTime();
+	// cursor keys move the player, the space bar fires.
+	const pair<int, GameButton> keys[] = { { VK_LEFT, ButtonLeft }, { VK_RIGHT, ButtonRight },
+		{ VK_UP, ButtonUp }, { VK_DOWN, ButtonDown }, { VK_SPACE, ButtonFire } };
 
-	XMFLOAT4X4 checkMat;
-	if (GetAsyncKeyState(VK_LEFT) & 0x8000)
+	GameInput input;
+	for (const auto& key : keys)
 	{
-		XMMATRIX worldRes = XMLoadFloat4x4(&mPlayer.objPlayer->World);
-		XMStoreFloat4x4(&checkMat, worldRes);
-		if (checkMat._41 > -120.0f)
+		if (GetAsyncKeyState(key.first) & 0x8000)
 		{
-			worldRes = worldRes * XMMatrixTranslation(-maneuverSpeed * dt, 0.0f, 0.0f);
-			mPlayer.plPosition.x = checkMat._41 - maneuverSpeed * dt;			// player's position update
+			input.Press(key.second);
 		}
-		XMStoreFloat4x4(&mPlayer.objPlayer->World, worldRes);
 	}
+	return input;
+}
 
-	if (GetAsyncKeyState(VK_RIGHT) & 0x8000)
+void FlyingCrates::FinishReplay()
+{
+	// report how long the frames of the replay took and whether it played the recorded game, then quit.
+	const uint64_t stateHash = mWorld.GetStateHash();
+	const float seconds = mTimer.TotalTime();
+
+	ostringstream outStr;
+	outStr << "replayed " << mReplay->GetStepCount() << " steps in " << mReplayFrames << " frames, " << seconds << " s, ";
+	outStr << (mReplayFrames > 0 ? 1000.0f * seconds / (float)mReplayFrames : 0.0f) << " ms per frame. ";
+	if (mReplay->GetStateHash() == 0)
 	{
-		XMMATRIX worldRes = XMLoadFloat4x4(&mPlayer.objPlayer->World);
-		XMStoreFloat4x4(&checkMat, worldRes);
-		if (checkMat._41 < 120.0f)
-		{
-			worldRes = worldRes * XMMatrixTranslation(+maneuverSpeed * dt, 0.0f, 0.0f);
-			mPlayer.plPosition.x = checkMat._41 + maneuverSpeed * dt;			// player's position update
-		}
-		XMStoreFloat4x4(&mPlayer.objPlayer->World, worldRes);
+		outStr << "the recording has no final state to compare with.\n";
 	}
-
-	if (GetAsyncKeyState(VK_UP) & 0x8000)
+	else if (mReplay->GetStateHash() == stateHash)
 	{
-		XMMATRIX worldRes = XMLoadFloat4x4(&mPlayer.objPlayer->World);
-		XMStoreFloat4x4(&checkMat, worldRes);
-		if (checkMat._43 < 150.0f)
-		{
-			worldRes = worldRes * XMMatrixTranslation(0.0f, 0.0f, +maneuverSpeed * dt);
-			mPlayer.plPosition.z = checkMat._43 + maneuverSpeed * dt;			// player's position update
-		}
-		XMStoreFloat4x4(&mPlayer.objPlayer->World, worldRes);
+		outStr << "the replay matches the recording.\n";
 	}
-
-	if (GetAsyncKeyState(VK_DOWN) & 0x8000)
+	else
 	{
-		XMMATRIX worldRes = XMLoadFloat4x4(&mPlayer.objPlayer->World);
-		XMStoreFloat4x4(&checkMat, worldRes);
-		if (checkMat._43 > -210.0f)
-		{
-			worldRes = worldRes * XMMatrixTranslation(0.0f, 0.0f, -maneuverSpeed * dt);
-			mPlayer.plPosition.z = checkMat._43 - maneuverSpeed * dt;			// player's position update
-		}
-		XMStoreFloat4x4(&mPlayer.objPlayer->World, worldRes);
+		outStr << "the replay differs from the recording.\n";
 	}
+	OutputDebugStringA(outStr.str().c_str());
+
+	PostMessage(mhMainWnd, WM_CLOSE, 0, 0);
+}
+
+void FlyingCrates::UpdatePlayerRitem(float alpha)
+{
+	const Player& player = mWorld.GetPlayer();
+	const WPosition& prevPos = player.plPrevPosition;
+	const WPosition& pos = player.plPosition;
 
-	// renew shells' world matrix with player's crate world matrix
-	for (int i = 0; i < 5; ++i)
+	MoveRitem(mPlayerRitem, XMFLOAT3(prevPos.x + (pos.x - prevPos.x) * alpha, prevPos.y + (pos.y - prevPos.y) * alpha,
+		prevPos.z + (pos.z - prevPos.z) * alpha), player.playerScale);
+}
+
+void FlyingCrates::MoveRitem(RenderItem* ri, const XMFLOAT3& position, float scale)
+{
+	Transform& placement = ri->Placement;
+	if (placement.Position.x == position.x && placement.Position.y == position.y && placement.Position.z == position.z &&
+		placement.Scale == scale)
 	{
-		// if a shell is out of range, deactivate it.
-		float distance = mPlayer.myShell.rpShell[i]->World._43;
-		if (distance >= 200.0f)
-		{
-			mPlayer.myShell.rpShell[i]->isItemActivated = false;
-		}
-		if (mPlayer.myShell.rpShell[i]->isItemActivated == false)
-		{
-			XMMATRIX worldRes = XMLoadFloat4x4(&mPlayer.myShell.rpShell[i]->World);
-			worldRes = XMMatrixTranslation(mPlayer.plPosition.x, 50.0f, mPlayer.plPosition.z);
-			XMStoreFloat4x4(&mPlayer.myShell.rpShell[i]->World, worldRes);
-		}
+		return;
 	}
 
-	if (GetAsyncKeyState(VK_SPACE) & 0x8000)
-	{
-		float temp = gt.TotalTime();
-		if (temp - mLastFireTime >= 0.3f)
-		{
-			mLastFireTime = temp;
+	placement.Position = position;
+	placement.Scale = scale;
 
-			for (int i = 0; i < 5; ++i)
-			{
-				if (mPlayer.myShell.rpShell[i]->isItemActivated == false)
-				{
-					mPlayer.myShell.rpShell[i]->isItemActivated = true;
-					break;
-				}
-			}
-		}
+	if (ri->isTransformDirty == false)
+	{
+		ri->isTransformDirty = true;
+		mMovedRitems.push_back(ri);
 	}
+}
 
-	// flying shell update
-	for (int i = 0; i < 5; ++i)
+void FlyingCrates::ComposeWorldMatrices()
+{
+	// one pass over the items that moved, the world matrices are built from their transforms without matrix products.
+	for (auto ri : mMovedRitems)
 	{
-		if (mPlayer.myShell.rpShell[i]->isItemActivated == true)
-		{
-			XMMATRIX worldShell = XMLoadFloat4x4(&mPlayer.myShell.rpShell[i]->World);
-			worldShell = worldShell * XMMatrixTranslation(0.0f, 0.0f, mPlayer.myShell.speed * dt);
-			XMStoreFloat4x4(&mPlayer.myShell.rpShell[i]->World, worldShell);
-		}
+		XMStoreFloat4x4(&ri->World, ComposeWorldMatrix(ri->Placement));
+		ri->isTransformDirty = false;
+		ri->numFrameBufferFilled = gNumFrameBuffers;
 	}
+	mMovedRitems.clear();
 }
 
-void FlyingCrates::UpdateEnemies(const GameTimer& gt)
+void FlyingCrates::UpdateEntityRitems(const EntityStore& entities, const vector<RenderItem*>& ritems, RenderLayer layer, float alpha)
 {
-	// update enemies position.
-	const float dt = gt.DeltaTime();
-
-	for (int i = 0; i < 5; ++i)
+	// the items of the entities drawn last frame are put away, the layer gets the ones of the entities alive now.
+	vector<RenderItem*>& layerRitems = mRitemLayer[(int)layer];
+	for (auto ri : layerRitems)
 	{
-		if (mEnemy.rpEnemy[i]->isItemActivated == false)
-		{
-			float xFluc = MathHelper::RandF(-20.0f, 20.0f);
-			float zFluc = MathHelper::RandF(-20.0f, 20.0f);
-			float spd = MathHelper::RandF(+15.0f, 40.0f);
-			XMMATRIX setupWorld = XMLoadFloat4x4(&mEnemy.refPosition);
-			XMMATRIX worldTemp = XMLoadFloat4x4(&mEnemy.rpEnemy[i]->World);
-			worldTemp = setupWorld * XMMatrixScaling(15.0f, 15.0f, 15.0f) *
-				XMMatrixTranslation(-100.0f + (float)i * 50.0f, 50.0f, 300.0f) * XMMatrixTranslation(xFluc, 0.0f, zFluc);
-			XMStoreFloat4x4(&mEnemy.rpEnemy[i]->World, worldTemp);
-			mEnemy.speed[i] = spd;
-			mEnemy.rpEnemy[i]->isItemActivated = true;
-		}
+		ri->isItemActivated = false;
 	}
-
-	for (int i = 0; i < 5; ++i)
+	layerRitems.clear();
+
+	// entities are uniformly scaled and never rotate.
+	const float* prevX = entities.PrevPositionX();
+	const float* prevY = entities.PrevPositionY();
+	const float* prevZ = entities.PrevPositionZ();
+	const float* posX = entities.PositionX();
+	const float* posY = entities.PositionY();
+	const float* posZ = entities.PositionZ();
+	const float* scale = entities.Scale();
+	const uint32_t* renderHandle = entities.RenderHandle();
+
+	for (UINT i = 0; i < entities.Size(); ++i)
 	{
-		XMFLOAT4X4 worldTemp = mEnemy.rpEnemy[i]->World;
-		if (mEnemy.rpEnemy[i]->isItemActivated == true && worldTemp._43 < -230.0f)
-		{
-			mEnemy.rpEnemy[i]->isItemActivated = false;
-		}
-		else if (mEnemy.rpEnemy[i]->isItemActivated == true && worldTemp._43 >= -230.0f)
-		{
-			XMMATRIX worldRes = XMLoadFloat4x4(&mEnemy.rpEnemy[i]->World);
-			worldRes = worldRes * XMMatrixTranslation(0.0f, 0.0f, -mEnemy.speed[i] * dt);
-			XMStoreFloat4x4(&mEnemy.rpEnemy[i]->World, worldRes);
-		}
+		float x = prevX[i] + (posX[i] - prevX[i]) * alpha;
+		float y = prevY[i] + (posY[i] - prevY[i]) * alpha;
+		float z = prevZ[i] + (posZ[i] - prevZ[i]) * alpha;
+
+		RenderItem* ri = ritems[GameWorld::SlotOf(renderHandle[i])];
+		MoveRitem(ri, XMFLOAT3(x, y, z), scale[i]);
+		ri->isItemActivated = true;
+		layerRitems.push_back(ri);
 	}
 }
 
 void FlyingCrates::UpdateCamera(const GameTimer& gt)
 {
-	mCameraPos.x = mRadius * sinf(mPhi) * cosf(mTheta);
-	mCameraPos.z = mRadius * sinf(mPhi) * sinf(mTheta);
-	mCameraPos.y = mRadius * cosf(mPhi);
-
-	// set the view matrix.
-	XMVECTOR pos = XMVectorSet(mCameraPos.x, mCameraPos.y, mCameraPos.z, 1.0f);
-	XMVECTOR target = XMVectorZero();
-	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f);
+	XMFLOAT3 camPos;
+	camPos.x = mRadius * sinf(mPhi) * cosf(mTheta);
+	camPos.z = mRadius * sinf(mPhi) * sinf(mTheta);
+	camPos.y = mRadius * cosf(mPhi);
 
-	XMMATRIX view = XMMatrixLookAtLH(pos, target, up);
-	XMStoreFloat4x4(&mView, view);
+	// the camera always looks at the origin, so the view matrix only changes when its position does.
+	mCommonCB.LookAt(camPos, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
 }
 
 void FlyingCrates::AnimateTextures(const GameTimer& gt)
@@ -629,6 +711,12 @@ void FlyingCrates::UpdateObjectCBs(const GameTimer& gt)
 
 	for (auto& elem : mAllRitems)
 	{
+		// free shells and enemies are not drawn, they are uploaded again once in use.
+		if (elem->isItemActivated == false)
+		{
+			continue;
+		}
+
 		if (elem->numFrameBufferFilled > 0)
 		{
 			XMMATRIX world = XMLoadFloat4x4(&elem->World);
@@ -637,13 +725,12 @@ void FlyingCrates::UpdateObjectCBs(const GameTimer& gt)
 			ObjectConstants objConstants;
 			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
 			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+			objConstants.PosDecodeScale = elem->PosDecode.Scale;
+			objConstants.PosDecodeOffset = elem->PosDecode.Offset;
 
 			currObjectCB->CopyData(elem->ObjCBIndex, objConstants);
 
-			if (elem->isItemStatic == true)
-			{
-				elem->numFrameBufferFilled--;
-			}
+			elem->numFrameBufferFilled--;
 		}
 	}
 }
@@ -672,74 +759,54 @@ void FlyingCrates::UpdateMaterialCBs(const GameTimer& gt)
 
 void FlyingCrates::UpdateCommonCB(const GameTimer& gt)
 {
-	XMMATRIX view = XMLoadFloat4x4(&mView);
-	XMMATRIX proj = XMLoadFloat4x4(&mProj);
-
-	XMMATRIX viewProj = XMMatrixMultiply(view, proj);
-	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
-	XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
-	XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
-
-	XMStoreFloat4x4(&mCommonCB.View, XMMatrixTranspose(view));
-	XMStoreFloat4x4(&mCommonCB.InvView, XMMatrixTranspose(invView));
-	XMStoreFloat4x4(&mCommonCB.Proj, XMMatrixTranspose(proj));
-	XMStoreFloat4x4(&mCommonCB.InvProj, XMMatrixTranspose(invProj));
-	XMStoreFloat4x4(&mCommonCB.ViewProj, XMMatrixTranspose(viewProj));
-	XMStoreFloat4x4(&mCommonCB.InvViewProj, XMMatrixTranspose(invViewProj));
-	mCommonCB.CameraPosW = mCameraPos;
-
-	mCommonCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
-	mCommonCB.InvRenderTargetSize = XMFLOAT2(1.0f / (float)mClientWidth, 1.0f / (float)mClientHeight);
-	mCommonCB.NearZ = 1.0f;
-	mCommonCB.FarZ = 1000.0f;
-	mCommonCB.TotalTime = gt.TotalTime();
-	mCommonCB.DeltaTime = gt.DeltaTime();
-	mCommonCB.AmbientLight = { 0.25f, 0.25f, 0.25f, 1.0f };
-	mCommonCB.Lights[0].Direction = { 0.57735f, -0.77735f, 0.57735f };
-	mCommonCB.Lights[0].Strength = { 0.9f, 0.9f, 0.8f };
-	mCommonCB.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
-	mCommonCB.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
-	mCommonCB.Lights[2].Direction = { 0.5f, -0.707f, -0.707f };
-	mCommonCB.Lights[2].Strength = { 0.25f, 0.25f, 0.25f };
-
+	// upload only the parts of the common constants that are out of date in the current frame buffer.
 	auto currCommonCB = mCurrFrameBuffer->CommonCB.get();
-	currCommonCB->CopyData(0, mCommonCB);
+	const CommonConstants& constants = mCommonCB.GetConstants();
+	mCommonCB.Update(gt.TotalTime(), gt.DeltaTime(), [&](size_t offset, size_t size)
+	{
+		currCommonCB->CopyData(0, constants, (UINT)offset, (UINT)size);
+	});
 }
 
 void FlyingCrates::UpdateWaterSurface(const GameTimer& gt)
 {
-	// random wave is generated in every quarter second.
-	static float t_base = 0.0f;
-	if ((mTimer.TotalTime() - t_base) >= 0.10f)
-	{
-		t_base += 0.25f;
-
-		int i = MathHelper::Rand(4, mWaterSurface->GetRowCount() - 5);
-		int j = MathHelper::Rand(4, mWaterSurface->GetColumnCount() - 5);
-		float r = MathHelper::RandF(0.3f, 1.0f);
-
-		mWaterSurface->AddFluctuationsAt(i, j, r);
-	}
-
-	// update the wave equation,
-	mWaterSurface->UpdateModelEquation(gt.DeltaTime());
-
-	// upload the newly calculated vertices to the vertex buffer
+	// the world steps the wave equation, upload the newly calculated vertices to the vertex buffer
+	const WaterSurface& waterSurface = mWorld.GetWaterSurface();
 	auto currWaterVB = mCurrFrameBuffer->WaterSurfaceVB.get();
-	for (int i = 0; i < mWaterSurface->GetVertexCount(); ++i)
+	for (int i = 0; i < waterSurface.GetVertexCount(); ++i)
 	{
 		Vertex v;
 		
-		v.Pos = mWaterSurface->Position(i);
-		v.Normal = mWaterSurface->Normal(i);
+		v.Pos = waterSurface.Position(i);
+		v.Normal = waterSurface.Normal(i);
 
 		// derive tex-coord from position by mapping [-w/2, w/2] ->[0,1]
-		v.TexC.x = 0.5f + v.Pos.x / mWaterSurface->GetsurfWidth();
-		v.TexC.y = 0.5f - v.Pos.z / mWaterSurface->GetsurfDepth();
+		v.TexC.x = 0.5f + v.Pos.x / waterSurface.GetsurfWidth();
+		v.TexC.y = 0.5f - v.Pos.z / waterSurface.GetsurfDepth();
 
 		currWaterVB->CopyData(i, v);
 	}
 	mWaterRitem->Geo->VertexBufferGPU = currWaterVB->Resource();
+
+	// the waves move the vertices vertically only, the bounds follow the highest crest or deepest trough.
+	mWaterRitem->Bounds.Extents.y = waterSurface.GetMaxAmplitude();
+}
+
+void FlyingCrates::BindGeometry(ID3D12GraphicsCommandList* cmdList, const RenderItem* ri)
+{
+	// static items all live in the shared buffers, so IA is only rebound around the water surface.
+	if (ri->Geo != mBoundGeo)
+	{
+		mBoundGeo = ri->Geo;
+		cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
+		cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
+	}
+
+	if (ri->PrimitiveType != mBoundTopology)
+	{
+		mBoundTopology = ri->PrimitiveType;
+		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+	}
 }
 
 void FlyingCrates::DrawRenderingItems(ID3D12GraphicsCommandList* cmdList, const vector<RenderItem*>& ritems)
@@ -755,9 +822,7 @@ void FlyingCrates::DrawRenderingItems(ID3D12GraphicsCommandList* cmdList, const
 	{
 		RenderItem* ri = ritems[i];
 
-		cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-		cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
-		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+		BindGeometry(cmdList, ri);
 
 		CD3DX12_GPU_DESCRIPTOR_HANDLE texHandle(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 		texHandle.Offset(ri->Mat->DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
@@ -788,9 +853,7 @@ void FlyingCrates::DrawGroupItems(ID3D12GraphicsCommandList* cmdList, const vect
 
 		if (ri->isItemActivated == true)
 		{
-			cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-			cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
-			cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+			BindGeometry(cmdList, ri);
 
 			CD3DX12_GPU_DESCRIPTOR_HANDLE texHandle(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 			texHandle.Offset(ri->Mat->DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
@@ -807,54 +870,50 @@ void FlyingCrates::DrawGroupItems(ID3D12GraphicsCommandList* cmdList, const vect
 	}
 }
 
-void FlyingCrates::CollisionProcessing(RenderItem* player, RenderItem** shells, RenderItem** enemies, const int& shellCount, const int& enemyCount)
+void FlyingCrates::CullRenderingItems()
 {
-	XMFLOAT4X4 pl1 = player->World;
-
-	// check collision between player and enemies.
-	WPosition wPos;
-	wPos.x = pl1._41;
-	wPos.y = pl1._42;
-	wPos.z = pl1._43;
+	mFrustumCuller.SetFrustum(XMLoadFloat4x4(&mCommonCB.GetView()), XMLoadFloat4x4(&mCommonCB.GetProj()));
+	mFrustumCuller.Clear();
 
-	for (int i = 0; i < enemyCount; ++i)
+	// gather world space bounds of every candidate item in layer order.
+	// the sky is centered on the camera in the vertex shader, so it is never culled.
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
 	{
-		WPosition currEnemyPos;
-		XMFLOAT4X4 enWorld = enemies[i]->World;
-		currEnemyPos.x = enWorld._41;
-		currEnemyPos.y = enWorld._42;
-		currEnemyPos.z = enWorld._43;
-
-		if (CloseEnough(wPos, currEnemyPos, 15.0f))
+		if (layer == (int)RenderLayer::Sky)
 		{
-			enemies[i]->isItemActivated = false;
-			mPlayer.killCount++;
+			continue;
+		}
+		for (auto ri : mRitemLayer[layer])
+		{
+			if (ri->isItemActivated == false)
+			{
+				continue;		// shells in the magazine and destroyed enemies are not drawn anyway.
+			}
+			mFrustumCuller.AddBox(ri->Bounds, XMLoadFloat4x4(&ri->World));
 		}
 	}
 
-	// check collision between shells that the player fires and incoming enemies.
-	for (int i = 0; i < enemyCount; ++i)
+	mFrustumCuller.Cull(mVisibility);
+
+	// walk the layers again in the same order and keep the visible items.
+	UINT boxIndex = 0;
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
 	{
-		for (int j = 0; j < shellCount; ++j)
+		mVisibleRitems[layer].clear();
+		for (auto ri : mRitemLayer[layer])
 		{
-			WPosition currEnemyPos;
-			WPosition currShellPos;
-			XMFLOAT4X4 enWorld = enemies[i]->World;
-			XMFLOAT4X4 shWorld = shells[j]->World;
-
-			currEnemyPos.x = enWorld._41;
-			currEnemyPos.y = enWorld._42;
-			currEnemyPos.z = enWorld._43;
-
-			currShellPos.x = shWorld._41;
-			currShellPos.y = shWorld._42;
-			currShellPos.z = shWorld._43;
-
-			if (CloseEnough(currEnemyPos, currShellPos, 10.0f))
+			if (layer == (int)RenderLayer::Sky)
 			{
-				enemies[i]->isItemActivated = false;
-				shells[j]->isItemActivated = false;
-				mPlayer.killCount++;
+				mVisibleRitems[layer].push_back(ri);
+				continue;
+			}
+			if (ri->isItemActivated == false)
+			{
+				continue;
+			}
+			if (mVisibility[boxIndex++] != 0)
+			{
+				mVisibleRitems[layer].push_back(ri);
 			}
 		}
 	}
@@ -864,7 +923,13 @@ void FlyingCrates::WriteCaption()
 {
 	wostringstream outStr;
 	outStr.precision(6);
-	outStr << mPlayer.killCount << L" enemies are destroyed so far.";
+	outStr << mWorld.GetKillCount() << L" enemies are destroyed so far.";
+	outStr << L"    (visible: " << mFrustumCuller.GetStats().Visible << L", culled: " << mFrustumCuller.GetStats().Culled << L")";
+	outStr << L"    (staging: " << mUploadManager->GetLiveStagingBytes() / 1024 << L" KB live, " << mUploadManager->GetReservedStagingBytes() / 1024 << L" KB reserved)";
+
+	PlacedResourceAllocator::Stats heapStats = mResourceAllocator->GetStats();
+	outStr.precision(3);
+	outStr << L"    (heaps: " << heapStats.HeapCount << L", occupancy: " << heapStats.Occupancy * 100.0f << L"%, fragmentation: " << heapStats.Fragmentation * 100.0f << L"%)";
 
 	D3DApp::mMainWndCaption = outStr.str();
 }
@@ -873,48 +938,57 @@ void FlyingCrates::WriteCaption()
 
 void FlyingCrates::PrepareTextures()
 {
-	auto stoneTex = make_unique<Texture>();
-	stoneTex->Name = "stoneTex";
-	stoneTex->Filename = L"Textures/stone.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		stoneTex->Filename.c_str(), stoneTex->Resource, stoneTex->UploadHeap));
-
-	auto waterTex = make_unique<Texture>();
-	waterTex->Name = "waterTex";
-	waterTex->Filename = L"Textures/water3.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		waterTex->Filename.c_str(), waterTex->Resource, waterTex->UploadHeap));
-
-	auto myCubeTex = make_unique<Texture>();
-	myCubeTex->Name = "myCubeTex";
-	myCubeTex->Filename = L"Textures/woodcrate1.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		myCubeTex->Filename.c_str(), myCubeTex->Resource, myCubeTex->UploadHeap));
-
-	auto enemyCubeTex = make_unique<Texture>();
-	enemyCubeTex->Name = "enemyCubeTex";
-	enemyCubeTex->Filename = L"Textures/checkboard.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		enemyCubeTex->Filename.c_str(), enemyCubeTex->Resource, enemyCubeTex->UploadHeap));
-
-	auto myShellTex = make_unique<Texture>();
-	myShellTex->Name = "myShellTex";
-	myShellTex->Filename = L"Textures/energyShell.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		myShellTex->Filename.c_str(), myShellTex->Resource, myShellTex->UploadHeap));
-
-	auto skyCubeTex = make_unique<Texture>();
-	skyCubeTex->Name = "skyTex";
-	skyCubeTex->Filename = L"Textures/grasscube1024.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(),
-		skyCubeTex->Filename.c_str(), skyCubeTex->Resource, skyCubeTex->UploadHeap));
-
-	mTextures[stoneTex->Name] = move(stoneTex);
-	mTextures[waterTex->Name] = move(waterTex);
-	mTextures[myCubeTex->Name] = move(myCubeTex);
-	mTextures[enemyCubeTex->Name] = move(enemyCubeTex);
-	mTextures[myShellTex->Name] = move(myShellTex);
-	mTextures[skyCubeTex->Name] = move(skyCubeTex);
+	struct TextureFile
+	{
+		const char* Name;
+		const wchar_t* Filename;
+	};
+
+	const TextureFile files[] =
+	{
+		{ "stoneTex", L"Textures/stone.dds" },
+		{ "waterTex", L"Textures/water3.dds" },
+		{ "myCubeTex", L"Textures/woodcrate1.dds" },
+		{ "enemyCubeTex", L"Textures/checkboard.dds" },
+		{ "myShellTex", L"Textures/energyShell.dds" },
+		{ "skyTex", L"Textures/grasscube1024.dds" },
+	};
+
+	// each file is mapped, parsed and paged in on a worker thread, so the whole set takes about as long as the slowest
+	// file, the geometry is built meanwhile, and CreateTextures copies texels that are already in memory.
+	mTextureLoads = make_unique<AsyncLoadQueue<unique_ptr<DirectX::DDSTextureData12>>>();
+
+	for (const TextureFile& file : files)
+	{
+		auto tex = make_unique<Texture>();
+		tex->Name = file.Name;
+		tex->Filename = file.Filename;
+
+		wstring filename = tex->Filename;
+		auto ticket = mTextureLoads->Submit([filename]()
+			{
+				auto data = make_unique<DirectX::DDSTextureData12>();
+				ThrowIfFailed(DirectX::LoadDDSTextureData12(filename.c_str(), 0, *data));
+				return data;
+			});
+
+		assert(ticket == mLoadingTextures.size());
+		mLoadingTextures.push_back(tex.get());
+		mTextures[tex->Name] = move(tex);
+	}
+}
+
+void FlyingCrates::CreateTextures()
+{
+	// the device and the upload command list are only touched here, on the main thread.
+	mTextureLoads->WaitAll([this](UINT ticket, unique_ptr<DirectX::DDSTextureData12>& data)
+		{
+			Texture* tex = mLoadingTextures[ticket];
+			tex->Resource = mUploadManager->CreateTexture(*data);
+		});
+
+	mTextureLoads = nullptr;
+	mLoadingTextures.clear();
 }
 
 void FlyingCrates::SetRootSignature()
@@ -1025,11 +1099,22 @@ void FlyingCrates::SetDescriptorHeaps()
 
 void FlyingCrates::SetShadersAndInputLayout()
 {
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders\\BasicShader.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders\\BasicShader.hlsl", nullptr, "PS", "ps_5_0");
+	// shaders are compiled only when their sources or compile parameters have changed since the last run,
+	// otherwise the bytecode is read from the cache directory.
+	mShaderCache = make_unique<ShaderCache>("ShaderCache", d3dUtil::ShaderCompilerId());
+	mShaderPermutations = make_unique<ShaderPermutations>(*mShaderCache);
 
-	mShaders["skyVS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["skyPS"] = d3dUtil::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
+	// the water surface is rewritten every frame and keeps full float vertices, static meshes may be compact.
+	const D3D_SHADER_MACRO compactDefines[] = { "COMPACT_VERTEX", "1", NULL, NULL };
+	const D3D_SHADER_MACRO* staticDefines = mCompactVertices ? compactDefines : nullptr;
+
+	mShaders["standardVS"] = d3dUtil::CompileShaderCached(*mShaderCache, L"Shaders\\BasicShader.hlsl", nullptr, "VS", "vs_5_0");
+	mShaders["staticVS"] = d3dUtil::CompileShaderCached(*mShaderCache, L"Shaders\\BasicShader.hlsl", staticDefines, "VS", "vs_5_0");
+	// the pixel shader loops over exactly as many lights as the selected permutation holds.
+	mShaders["opaquePS"] = mShaderPermutations->Get(L"Shaders\\BasicShader.hlsl", "PS", "ps_5_0", mLightingKey);
+
+	mShaders["skyVS"] = d3dUtil::CompileShaderCached(*mShaderCache, L"Shaders\\Sky.hlsl", staticDefines, "VS", "vs_5_1");
+	mShaders["skyPS"] = d3dUtil::CompileShaderCached(*mShaderCache, L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
 
 	mInputLayout =
 	{
@@ -1037,85 +1122,97 @@ void FlyingCrates::SetShadersAndInputLayout()
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
 	};
+
+	if (mCompactVertices)
+	{
+		// see CompactVertex.
+		mStaticInputLayout =
+		{
+			{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+			{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+			{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
+		};
+	}
+	else
+	{
+		mStaticInputLayout = mInputLayout;
+	}
 }
 
 void FlyingCrates::SetTerrainGeometry()
 {
 	// first create a flat grid where a vertex lies at each intersecting point.
 	// then add change in the y-component of each vertex to obtain the terrain mesh geometry. 
+	const UINT gridRows = 50;
+	const UINT gridColumns = 50;
+	static_assert(GeometryGenerator::GetGridSize(gridRows, gridColumns).Vertices <= GeometryGenerator::MaxVertexCount<uint16_t>(),
+		"the terrain grid must fit 16-bit indices");
+
 	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(400.0f, 400.0f, 50, 50);
+	vector<GeometryGenerator::Vertex> gridVertices;
+	vector<uint16_t> indices;
+	GeometryGenerator::MeshRange grid = geoGen.CreateGrid(400.0f, 400.0f, gridRows, gridColumns, gridVertices, indices);
+	// a height field hardly overdraws itself, only reorder for the vertex cache and fetch.
+	ReportMeshOptimization("terrain", MeshOptimizer::Optimize(gridVertices, indices, grid, false));
 
-	vector<Vertex> vertices(grid.Vertices.size());
-	for (size_t i = 0; i < grid.Vertices.size(); ++i)
+	// roughness of the ground, the same for the same seed so replays draw the same terrain.
+	vector<float> roughness(gridVertices.size());
+	RandomStream(mWorld.GetSettings().Seed, "terrain").FillFloats(roughness.data(), roughness.size(), -2.0f, 2.0f);
+
+	vector<Vertex> vertices(gridVertices.size());
+	for (size_t i = 0; i < gridVertices.size(); ++i)
 	{
-		auto& p = grid.Vertices[i].Position;
+		auto& p = gridVertices[i].Position;
 		vertices[i].Pos = p;
-		vertices[i].Pos.y = GetHillsHeight(p.x, p.z) + MathHelper::RandF(-2.0f, 2.0f);
+		vertices[i].Pos.y = GetHillsHeight(p.x, p.z) + roughness[i];
 		vertices[i].Normal = GetHillsNormal(p.x, p.z);
-		vertices[i].TexC = grid.Vertices[i].TexC;
+		vertices[i].TexC = gridVertices[i].TexC;
 	}
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-
-	vector<uint16_t> indices = grid.GetIndices16();
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
-
-	auto geo = make_unique<MeshGeometry>();
-	geo->Name = "terrainGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
-
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
-
-	geo->DrawArgs["grid"] = submesh;
-
-	mGeometries["terrainGeo"] = move(geo);
+	AddStaticMesh("terrain", vertices, indices.data(), (UINT)indices.size());
 }
 
 void FlyingCrates::SetWaterGeometry()
 {
+	const WaterSurface& waterSurface = mWorld.GetWaterSurface();
+
 	// set up index buffer first, vertices are not fixed. they changes dynamically
-	vector<uint16_t> indices(3 * mWaterSurface->GetTriangleCount());		// 3 indices per face
-	assert(mWaterSurface->GetVertexCount() < 0x0000ffff);
+	vector<uint32_t> indices32(3 * waterSurface.GetTriangleCount());		// 3 indices per face
+	assert(waterSurface.GetVertexCount() < 0x0000ffff);
 
 	// iterate over each quad.
-	int row = mWaterSurface->GetRowCount();
-	int col = mWaterSurface->GetColumnCount();
+	int row = waterSurface.GetRowCount();
+	int col = waterSurface.GetColumnCount();
 	int k = 0;
 	for (int i = 0; i < row - 1; ++i)
 	{
 		for (int j = 0; j < col - 1; ++j, k += 6)
 		{
-			indices[k] = i * col + j;
-			indices[k + 1] = i * col + j + 1;
-			indices[k + 2] = (i + 1) * col + j;
+			indices32[k] = i * col + j;
+			indices32[k + 1] = i * col + j + 1;
+			indices32[k + 2] = (i + 1) * col + j;
 
-			indices[k + 3] = (i + 1) * col + j;
-			indices[k + 4] = i * col + j + 1;
-			indices[k + 5] = (i + 1) * col + j + 1;
+			indices32[k + 3] = (i + 1) * col + j;
+			indices32[k + 4] = i * col + j + 1;
+			indices32[k + 5] = (i + 1) * col + j + 1;
 		}
 	}
 
-	UINT vbByteSize = mWaterSurface->GetVertexCount() * sizeof(Vertex);
+	// reorder the triangles for the vertex cache. the vertices keep the order of the simulation lattice
+	// since the water vertex buffer is rewritten from it every frame.
+	MeshOptimizer::Report report;
+	report.Before = MeshOptimizer::SimulateVertexCache(indices32.data(), indices32.size(), waterSurface.GetVertexCount());
+	MeshOptimizer::OptimizeVertexCache(indices32.data(), indices32.size(), waterSurface.GetVertexCount());
+	report.After = MeshOptimizer::SimulateVertexCache(indices32.data(), indices32.size(), waterSurface.GetVertexCount());
+	ReportMeshOptimization("water", report);
+
+	vector<uint16_t> indices(indices32.size());
+	for (size_t i = 0; i < indices32.size(); ++i)
+	{
+		indices[i] = (uint16_t)indices32[i];
+	}
+
+	UINT vbByteSize = waterSurface.GetVertexCount() * sizeof(Vertex);
 	UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
 
 	auto geo = make_unique<MeshGeometry>();
@@ -1127,8 +1224,7 @@ void FlyingCrates::SetWaterGeometry()
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
+	geo->IndexBufferGPU = mUploadManager->CreateDefaultBuffer(indices.data(), ibByteSize);
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
@@ -1140,6 +1236,10 @@ void FlyingCrates::SetWaterGeometry()
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 
+	// the lattice is centered on the origin, its vertical extent is updated with the waves every frame.
+	submesh.Bounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	submesh.Bounds.Extents = XMFLOAT3(0.5f * waterSurface.GetsurfWidth(), waterSurface.GetMaxAmplitude(), 0.5f * waterSurface.GetsurfDepth());
+
 	geo->DrawArgs["grid"] = submesh;
 
 	mGeometries["waterGeo"] = move(geo);
@@ -1147,90 +1247,90 @@ void FlyingCrates::SetWaterGeometry()
 
 void FlyingCrates::SetFiguresGeometry()
 {
-	// two figures: box, sphere
-	// concatenate their separate vertices and indices buffer into one vertices and indices buffer. 
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3);
-	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(3.0f, 20, 20);
+	// two figures: box, sphere. both are generated with 16-bit indices into one pair of arrays,
+	// then appended to the shared static buffers.
+	const UINT boxSubdivisions = 3;
+	const UINT sphereSlices = 20;
+	const UINT sphereStacks = 20;
+	const GeometryGenerator::MeshSize boxSize = GeometryGenerator::GetBoxSize(boxSubdivisions);
+	const GeometryGenerator::MeshSize sphereSize = GeometryGenerator::GetSphereSize(sphereSlices, sphereStacks);
+	static_assert(GeometryGenerator::GetBoxSize(boxSubdivisions).Vertices <= GeometryGenerator::MaxVertexCount<uint16_t>() &&
+		GeometryGenerator::GetSphereSize(sphereSlices, sphereStacks).Vertices <= GeometryGenerator::MaxVertexCount<uint16_t>(),
+		"the figures must fit 16-bit indices");
 
-	UINT boxVertexStart = 0;
-	UINT sphereVertexStart = (UINT)box.Vertices.size();
-
-	UINT boxIndexStart = 0;
-	UINT sphereIndexStart = (UINT)sphere.Indices32.size();
-
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
-	boxSubmesh.StartIndexLocation = boxIndexStart;
-	boxSubmesh.BaseVertexLocation = boxVertexStart;
+	GeometryGenerator geoGen;
+	vector<GeometryGenerator::Vertex> meshVertices;
+	vector<uint16_t> indices;
+	meshVertices.reserve(boxSize.Vertices + sphereSize.Vertices);
+	indices.reserve(boxSize.Indices + sphereSize.Indices);
 
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIndexStart;
-	sphereSubmesh.BaseVertexLocation = sphereVertexStart;
+	const pair<const char*, GeometryGenerator::MeshRange> figures[] =
+	{
+		{ "box", geoGen.CreateBox(1.0f, 1.0f, 1.0f, boxSubdivisions, meshVertices, indices) },
+		{ "sphere", geoGen.CreateSphere(3.0f, sphereSlices, sphereStacks, meshVertices, indices) }
+	};
 
-	auto totalVertexCount = box.Vertices.size() + sphere.Vertices.size();
+	vector<Vertex> vertices;
+	for (const auto& figure : figures)
+	{
+		const GeometryGenerator::MeshRange& mesh = figure.second;
+		ReportMeshOptimization(figure.first, MeshOptimizer::Optimize(meshVertices, indices, mesh, true));
 
-	vector<Vertex> vertices(totalVertexCount);
+		vertices.resize(mesh.VertexCount);
+		for (UINT i = 0; i < mesh.VertexCount; ++i)
+		{
+			const GeometryGenerator::Vertex& v = meshVertices[mesh.BaseVertex + i];
+			vertices[i].Pos = v.Position;
+			vertices[i].Normal = v.Normal;
+			vertices[i].TexC = v.TexC;
+		}
 
-	UINT k = 0;
-	for (size_t i = 0; i < box.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = box.Vertices[i].Position;
-		vertices[k].Normal = box.Vertices[i].Normal;
-		vertices[k].TexC = box.Vertices[i].TexC;
+		AddStaticMesh(figure.first, vertices, &indices[mesh.StartIndex], mesh.IndexCount);
 	}
-	for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
+}
+
+void FlyingCrates::AddStaticMesh(const string& name, const vector<Vertex>& vertices, const uint16_t* indices, UINT indexCount)
+{
+	if (!mCompactVertices)
 	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
-		vertices[k].Normal = sphere.Vertices[i].Normal;
-		vertices[k].TexC = sphere.Vertices[i].TexC;
+		mGeometryRegistry->Add(name, vertices.data(), (UINT)vertices.size(), indices, indexCount);
+		return;
 	}
 
-	vector<uint16_t> indices;
-	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-	indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
-
-	auto geo = make_unique<MeshGeometry>();
-	geo->Name = "figureGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	// positions are quantized inside the bounds of the mesh, the render items get the matching decode.
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, vertices.size(), &vertices[0].Pos, sizeof(Vertex));
+	PositionDecode decode = VertexCompression::GetPositionDecode(bounds);
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	vector<CompactVertex> compact(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		compact[i] = VertexCompression::Encode(vertices[i].Pos, vertices[i].Normal, vertices[i].TexC, decode);
+		assert(VertexCompression::IsWithinErrorBounds(compact[i], decode, vertices[i].Pos, vertices[i].Normal, vertices[i].TexC));
+	}
 
-	geo->DrawArgs["box"] = boxSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
+	mGeometryRegistry->Add(name, compact.data(), (UINT)compact.size(), indices, indexCount, bounds);
+}
 
-	mGeometries[geo->Name] = std::move(geo);
+void FlyingCrates::BuildStaticGeometry()
+{
+	auto geo = mGeometryRegistry->Build("staticGeo", *mUploadManager);
+	mGeometries[geo->Name] = move(geo);
 }
 
 void FlyingCrates::SetPSOs()
 {
+	mPsoCache = make_unique<PipelineStateCache>(md3dDevice.Get());
+
 	// pipeline state object for opaque objects.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC opaquePsoDesc;
 	ZeroMemory(&opaquePsoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
-	opaquePsoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
+	opaquePsoDesc.InputLayout = { mStaticInputLayout.data(), (UINT)mStaticInputLayout.size() };
 	opaquePsoDesc.pRootSignature = mRootSignature.Get();
 	opaquePsoDesc.VS =
 	{
-		reinterpret_cast<BYTE*>(mShaders["standardVS"]->GetBufferPointer()),
-		mShaders["standardVS"]->GetBufferSize()
+		reinterpret_cast<BYTE*>(mShaders["staticVS"]->GetBufferPointer()),
+		mShaders["staticVS"]->GetBufferSize()
 	};
 	opaquePsoDesc.PS =
 	{
@@ -1247,22 +1347,22 @@ void FlyingCrates::SetPSOs()
 	opaquePsoDesc.SampleDesc.Count = m4xMsaaState ? 4 : 1;
 	opaquePsoDesc.SampleDesc.Quality = m4xMsaaState ? (m4xMsaaQuality - 1) : 0;
 	opaquePsoDesc.DSVFormat = mDepthStencilFormat;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs["opaque"])));
-
-	// PSO for player object
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC playerPsoDesc = opaquePsoDesc;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&playerPsoDesc, IID_PPV_ARGS(&mPSOs["player"])));
-
-	// PSO for shell fired
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC shellPsoDesc = opaquePsoDesc;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&shellPsoDesc, IID_PPV_ARGS(&mPSOs["shell"])));
+	mLayerPSO[(int)RenderLayer::Opaque] = mPsoCache->GetOrCreate(opaquePsoDesc);
 
-	// PSO for enemy object
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC enemyPsoDesc = opaquePsoDesc;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&enemyPsoDesc, IID_PPV_ARGS(&mPSOs["enemy"])));
+	// the player, shell and enemy objects are drawn in the same way as the opaque ones.
+	// the cache hands back the opaque PSO for them instead of compiling three more copies.
+	mLayerPSO[(int)RenderLayer::Player] = mPsoCache->GetOrCreate(opaquePsoDesc);
+	mLayerPSO[(int)RenderLayer::Shell] = mPsoCache->GetOrCreate(opaquePsoDesc);
+	mLayerPSO[(int)RenderLayer::Enemy] = mPsoCache->GetOrCreate(opaquePsoDesc);
 
-	// pipeline state object for transparent objects
+	// pipeline state object for transparent objects, the water surface is made of full float vertices.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC transparentPsoDesc = opaquePsoDesc;
+	transparentPsoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
+	transparentPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(mShaders["standardVS"]->GetBufferPointer()),
+		mShaders["standardVS"]->GetBufferSize()
+	};
 
 	D3D12_RENDER_TARGET_BLEND_DESC transparencyBlendDesc;
 	transparencyBlendDesc.BlendEnable = true;
@@ -1277,7 +1377,7 @@ void FlyingCrates::SetPSOs()
 	transparencyBlendDesc.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
 
 	transparentPsoDesc.BlendState.RenderTarget[0] = transparencyBlendDesc;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&transparentPsoDesc, IID_PPV_ARGS(&mPSOs["transparent"])));
+	mLayerPSO[(int)RenderLayer::Transparent] = mPsoCache->GetOrCreate(transparentPsoDesc);
 
 	// pipeline state object for sky
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC skyPsoDesc = opaquePsoDesc;
@@ -1297,7 +1397,7 @@ void FlyingCrates::SetPSOs()
 		mShaders["skyPS"]->GetBufferSize()
 	};
 
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&skyPsoDesc, IID_PPV_ARGS(&mPSOs["sky"])));
+	mLayerPSO[(int)RenderLayer::Sky] = mPsoCache->GetOrCreate(skyPsoDesc);
 }
 
 
@@ -1306,7 +1406,7 @@ void FlyingCrates::SetFrameBuffers()
 	for (int i = 0; i < gNumFrameBuffers; ++i)
 	{
 		mFrameBuffers.push_back(make_unique<FrameBuffer>(md3dDevice.Get(), 1,
-			(UINT)mAllRitems.size(), (UINT)mMaterials.size(), mWaterSurface->GetVertexCount()));
+			(UINT)mAllRitems.size(), (UINT)mMaterials.size(), mWorld.GetWaterSurface().GetVertexCount()));
 	}
 }
 
@@ -1368,6 +1468,28 @@ void FlyingCrates::SetMaterials()
 	mMaterials["sky"] = move(sky);
 }
 
+void FlyingCrates::SetLights()
+{
+	// three directional lights, they never change during the game.
+	Light light;
+	light.Direction = { 0.57735f, -0.77735f, 0.57735f };
+	light.Strength = { 0.9f, 0.9f, 0.8f };
+	mDirLights.push_back(light);
+	light.Direction = { -0.57735f, -0.57735f, 0.57735f };
+	light.Strength = { 0.4f, 0.4f, 0.4f };
+	mDirLights.push_back(light);
+	light.Direction = { 0.5f, -0.707f, -0.707f };
+	light.Strength = { 0.25f, 0.25f, 0.25f };
+	mDirLights.push_back(light);
+
+	// pick the smallest shader permutation covering the lights and lay them out for it.
+	mLightingKey = ShaderPermutations::Select((UINT)mDirLights.size(), (UINT)mPointLights.size(), (UINT)mSpotLights.size(), 0);
+	Light lights[MaxLights];
+	ShaderPermutations::PackLights(mLightingKey, mDirLights, mPointLights, mSpotLights, lights);
+
+	mCommonCB.SetLights({ 0.25f, 0.25f, 0.25f, 1.0f }, lights);
+}
+
 void FlyingCrates::SetRenderingItems()
 {
 	// water surface
@@ -1383,6 +1505,7 @@ void FlyingCrates::SetRenderingItems()
 	waterRitem->IndexCount = waterRitem->Geo->DrawArgs["grid"].IndexCount;
 	waterRitem->StartIndexLocation = waterRitem->Geo->DrawArgs["grid"].StartIndexLocation;
 	waterRitem->BaseVertexLocation = waterRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+	waterRitem->Bounds = waterRitem->Geo->DrawArgs["grid"].Bounds;
 
 	mWaterRitem = waterRitem.get();
 	mRitemLayer[(int)RenderLayer::Transparent].push_back(waterRitem.get());
@@ -1396,11 +1519,12 @@ void FlyingCrates::SetRenderingItems()
 	terrainRitem->isItemStatic = true;
 	terrainRitem->ObjCBIndex = itemIndex;
 	terrainRitem->Mat = mMaterials["stone"].get();
-	terrainRitem->Geo = mGeometries["terrainGeo"].get();
+	terrainRitem->Geo = mGeometries["staticGeo"].get();
 	terrainRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	terrainRitem->IndexCount = terrainRitem->Geo->DrawArgs["grid"].IndexCount;
-	terrainRitem->StartIndexLocation = terrainRitem->Geo->DrawArgs["grid"].StartIndexLocation;
-	terrainRitem->BaseVertexLocation = terrainRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+	terrainRitem->IndexCount = terrainRitem->Geo->DrawArgs["terrain"].IndexCount;
+	terrainRitem->StartIndexLocation = terrainRitem->Geo->DrawArgs["terrain"].StartIndexLocation;
+	terrainRitem->BaseVertexLocation = terrainRitem->Geo->DrawArgs["terrain"].BaseVertexLocation;
+	terrainRitem->Bounds = terrainRitem->Geo->DrawArgs["terrain"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(terrainRitem.get());
 	mAllRitems.push_back(move(terrainRitem));
@@ -1408,65 +1532,65 @@ void FlyingCrates::SetRenderingItems()
 	
 	// player's crate
 	auto playerRitem = make_unique<RenderItem>();
-	XMStoreFloat4x4(&playerRitem->World,
-		XMMatrixScaling(mPlayer.playerScale, mPlayer.playerScale, mPlayer.playerScale)
-		* XMMatrixTranslation(mPlayer.plPosition.x, mPlayer.plPosition.y, mPlayer.plPosition.z));		// initial position of the player: (0, 50, -200)
+	const Player& player = mWorld.GetPlayer();
+	MoveRitem(playerRitem.get(), XMFLOAT3(player.plPosition.x, player.plPosition.y, player.plPosition.z),
+		player.playerScale);		// initial position of the player: (0, 50, -200)
 	XMStoreFloat4x4(&playerRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 	playerRitem->isItemStatic = false;
 	playerRitem->ObjCBIndex = itemIndex;
 	playerRitem->Mat = mMaterials["mycube"].get();
-	playerRitem->Geo = mGeometries["figureGeo"].get();
+	playerRitem->Geo = mGeometries["staticGeo"].get();
 	playerRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	playerRitem->IndexCount = playerRitem->Geo->DrawArgs["box"].IndexCount;
 	playerRitem->StartIndexLocation = playerRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	playerRitem->BaseVertexLocation = playerRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	playerRitem->Bounds = playerRitem->Geo->DrawArgs["box"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Player].push_back(playerRitem.get());
-	mPlayer.objPlayer = playerRitem.get();
+	mPlayerRitem = playerRitem.get();
 	mAllRitems.push_back(move(playerRitem));
 	itemIndex++;
 
-	// player's shells
-	for (size_t i = 0; i < 5; ++i)
+	// player's shells, one for each shell slot of the world.
+	mShellRitems.assign(mWorld.GetSettings().ShellCapacity, nullptr);
+	for (UINT i = 0; i < mWorld.GetSettings().ShellCapacity; ++i)
 	{
 		auto shellRitem = make_unique<RenderItem>();
-		XMStoreFloat4x4(&shellRitem->World, XMMatrixScaling(1.0f, 1.0f, 1.0f) *
-			XMMatrixTranslation(mPlayer.plPosition.x, mPlayer.plPosition.y, mPlayer.plPosition.z));
 		XMStoreFloat4x4(&shellRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 		shellRitem->isItemStatic = false;
-		shellRitem->isItemActivated = false;	// all 5 shells in the magazine are initially inactive.
+		shellRitem->isItemActivated = false;
 		shellRitem->ObjCBIndex = itemIndex;
 		shellRitem->Mat = mMaterials["myshell"].get();
-		shellRitem->Geo = mGeometries["figureGeo"].get();
+		shellRitem->Geo = mGeometries["staticGeo"].get();
 		shellRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		shellRitem->IndexCount = shellRitem->Geo->DrawArgs["sphere"].IndexCount;
 		shellRitem->StartIndexLocation = shellRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		shellRitem->BaseVertexLocation = shellRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		shellRitem->Bounds = shellRitem->Geo->DrawArgs["sphere"].Bounds;
 
-		mRitemLayer[(int)RenderLayer::Shell].push_back(shellRitem.get());
-		mPlayer.myShell.rpShell[i] = shellRitem.get();
+		mShellRitems[i] = shellRitem.get();
 		mAllRitems.push_back(move(shellRitem));
 		itemIndex++;
 	}
 
-	// enemy cubes
-	for (size_t i = 0; i < 5; ++i)
+	// enemy cubes, one for each lane of the world.
+	mEnemyRitems.assign(mWorld.GetSettings().EnemyCapacity, nullptr);
+	for (UINT i = 0; i < mWorld.GetSettings().EnemyCapacity; ++i)
 	{
 		auto enemyRitem = make_unique<RenderItem>();
-		XMStoreFloat4x4(&enemyRitem->World, XMMatrixScaling(15.0f, 15.0f, 15.0f) * XMMatrixTranslation(-100.0f + (float)i * 50.0f, 50.0f, +300.0f));
 		XMStoreFloat4x4(&enemyRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 		enemyRitem->isItemStatic = false;
 		enemyRitem->isItemActivated = false;
 		enemyRitem->ObjCBIndex = itemIndex;
 		enemyRitem->Mat = mMaterials["enemycube"].get();
-		enemyRitem->Geo = mGeometries["figureGeo"].get();
+		enemyRitem->Geo = mGeometries["staticGeo"].get();
 		enemyRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		enemyRitem->IndexCount = enemyRitem->Geo->DrawArgs["box"].IndexCount;
 		enemyRitem->StartIndexLocation = enemyRitem->Geo->DrawArgs["box"].StartIndexLocation;
 		enemyRitem->BaseVertexLocation = enemyRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+		enemyRitem->Bounds = enemyRitem->Geo->DrawArgs["box"].Bounds;
 
-		mRitemLayer[(int)RenderLayer::Enemy].push_back(enemyRitem.get());
-		mEnemy.rpEnemy[i] = enemyRitem.get();
+		mEnemyRitems[i] = enemyRitem.get();
 		mAllRitems.push_back(move(enemyRitem));
 		itemIndex++;
 	}
@@ -1477,14 +1601,27 @@ void FlyingCrates::SetRenderingItems()
 	skyRitem->isItemStatic = true;
 	skyRitem->ObjCBIndex = itemIndex;
 	skyRitem->Mat = mMaterials["sky"].get();
-	skyRitem->Geo = mGeometries["figureGeo"].get();
+	skyRitem->Geo = mGeometries["staticGeo"].get();
 	skyRitem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	skyRitem->IndexCount = skyRitem->Geo->DrawArgs["sphere"].IndexCount;
 	skyRitem->StartIndexLocation = skyRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 	skyRitem->BaseVertexLocation = skyRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+	skyRitem->Bounds = skyRitem->Geo->DrawArgs["sphere"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Sky].push_back(skyRitem.get());
 	mAllRitems.push_back(move(skyRitem));
+
+	// compact static meshes are quantized inside their submesh bounds, which each item copied.
+	if (mCompactVertices)
+	{
+		for (auto& ri : mAllRitems)
+		{
+			if (ri->Geo == mGeometries["staticGeo"].get())
+			{
+				ri->PosDecode = VertexCompression::GetPositionDecode(ri->Bounds);
+			}
+		}
+	}
 }
 
 array<const CD3DX12_STATIC_SAMPLER_DESC, 6> FlyingCrates::GetStaticSamplers()
@@ -1561,13 +1698,14 @@ XMFLOAT3 FlyingCrates::GetHillsNormal(float x, float z) const
 	return n;
 }
 
-bool CloseEnough(WPosition pt1, WPosition pt2, float dist)
+void ReportMeshOptimization(const char* name, const MeshOptimizer::Report& report)
 {
-	float distCheckSq = (pt1.x - pt2.x) * (pt1.x - pt2.x) +
-		(pt1.y - pt2.y) * (pt1.y - pt2.y) + (pt1.z - pt2.z) * (pt1.z - pt2.z);
-
-	float distSq = dist * dist;
-
-	return distCheckSq < distSq ? true : false;
+	// ACMR: vertices transformed per triangle, ATVR: vertices transformed per vertex, on a simulated FIFO cache.
+	ostringstream outStr;
+	outStr.precision(3);
+	outStr << std::fixed << "mesh optimization " << name << ": " << report.After.Triangles << " triangles, "
+		<< "ACMR " << report.Before.Acmr << " -> " << report.After.Acmr << ", "
+		<< "ATVR " << report.Before.Atvr << " -> " << report.After.Atvr << "\n";
+	::OutputDebugStringA(outStr.str().c_str());
 }
 
@@ -0,0 +1,233 @@
+// Flying Crates headless simulation
+// steps the GameWorld as fast as it can with scripted input, without a window or a device,
+// for soak tests and profiling of the game logic. it builds wherever DirectXMath does, with the
+// CMakeLists.txt next to it, together with the unit tests and the benchmarks.
+// options: -steps <count> -script <file> -report <steps>, the game options of ParseSettings() and
+// -record <file>, -replay <file> of ParseRecordingOptions().
+// a script has one command per line, "<steps> <buttons>": the buttons (L, R, U, D for the cursor
+// keys, F for fire, - for none) are held for that many steps. '#' starts a comment. the script
+// starts over when it ends.
+// a replay plays the whole recording instead of the script, and fails unless it ends with the state
+// the recording ended with.
+
+#include "GameWorld.h"
+#include "InputRecording.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// the buttons held for a number of steps.
+struct ScriptCommand
+{
+	uint32_t Steps;
+	GameInput Input;
+};
+
+// sweeps the field from side to side while firing.
+const char* gDefaultScript =
+	"120 L F\n"
+	"240 R F\n"
+	"120 L F\n"
+	"60 U F\n"
+	"60 D F\n";
+
+bool ParseScript(istream& script, vector<ScriptCommand>& commands)
+{
+	string line;
+	int lineNumber = 0;
+	while (getline(script, line))
+	{
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		istringstream words(line);
+		ScriptCommand command = {};
+		if (!(words >> command.Steps))
+		{
+			if (line.find_first_not_of(" \t\r") == string::npos)
+			{
+				continue;		// blank line or comment
+			}
+			cerr << "script line " << lineNumber << ": expected a step count" << endl;
+			return false;
+		}
+
+		string buttons;
+		while (words >> buttons)
+		{
+			for (char button : buttons)
+			{
+				switch (button)
+				{
+				case 'L': command.Input.Press(ButtonLeft); break;
+				case 'R': command.Input.Press(ButtonRight); break;
+				case 'U': command.Input.Press(ButtonUp); break;
+				case 'D': command.Input.Press(ButtonDown); break;
+				case 'F': command.Input.Press(ButtonFire); break;
+				case '-': break;
+				default:
+					cerr << "script line " << lineNumber << ": unknown button '" << button << "'" << endl;
+					return false;
+				}
+			}
+		}
+
+		if (command.Steps > 0)
+		{
+			commands.push_back(command);
+		}
+	}
+
+	if (commands.empty())
+	{
+		cerr << "the script has no steps" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t stepCount = 100000;
+	uint64_t reportInterval = 0;
+	const char* scriptPath = nullptr;
+
+	// the game options are parsed from the whole command line, like the game's.
+	string cmdLine;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+		{
+			stepCount = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "-report") == 0 && i + 1 < argc)
+		{
+			reportInterval = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "-script") == 0 && i + 1 < argc)
+		{
+			scriptPath = argv[++i];
+		}
+		else
+		{
+			cmdLine += argv[i];
+			cmdLine += ' ';
+		}
+	}
+
+	vector<ScriptCommand> commands;
+	if (scriptPath != nullptr)
+	{
+		ifstream script(scriptPath);
+		if (!script)
+		{
+			cerr << "can't open " << scriptPath << endl;
+			return 1;
+		}
+		if (!ParseScript(script, commands))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		istringstream script(gDefaultScript);
+		ParseScript(script, commands);
+	}
+
+	GameSettings settings = ParseSettings(cmdLine.c_str());
+	RecordingOptions recording = ParseRecordingOptions(cmdLine.c_str(), settings);
+
+	// a replay plays the session it recorded, with its settings.
+	InputReplay replay;
+	const bool replaying = !recording.ReplayPath.empty();
+	if (replaying)
+	{
+		if (!replay.Open(recording.ReplayPath))
+		{
+			cerr << "can't read the recording " << recording.ReplayPath << endl;
+			return 1;
+		}
+		settings = replay.GetSettings();
+		stepCount = replay.GetStepCount();
+	}
+
+	InputRecorder recorder;
+	if (!recording.RecordPath.empty() && !recorder.Open(recording.RecordPath, settings))
+	{
+		cerr << "can't create the recording " << recording.RecordPath << endl;
+		return 1;
+	}
+
+	GameWorld world(settings);
+
+	// the steps are as long as the game's, once per frame of a 60 Hz display without a tick rate.
+	const float dt = (float)(settings.TickRate > 0.0 ? 1.0 / settings.TickRate : 1.0 / 60.0);
+
+	printf("%llu steps of %.4f s, %u shells, %u enemies, seed %llu, narrowphase: %s\n", (unsigned long long)stepCount, dt,
+		settings.ShellCapacity, settings.EnemyCapacity, (unsigned long long)settings.Seed,
+		SphereOverlap::GetPathName(SphereOverlap::GetPath()));
+
+	auto start = chrono::steady_clock::now();
+
+	size_t command = 0;
+	uint32_t commandStep = 0;
+	for (uint64_t step = 0; step < stepCount; ++step)
+	{
+		if (commandStep == commands[command].Steps)
+		{
+			command = (command + 1) % commands.size();
+			commandStep = 0;
+		}
+		commandStep++;
+
+		GameInput input = replaying ? replay.Next() : commands[command].Input;
+		if (recorder.IsOpen())
+		{
+			recorder.Record(input);
+		}
+		world.Step(dt, input);
+
+		if (reportInterval > 0 && world.GetStepCount() % reportInterval == 0)
+		{
+			const Player& player = world.GetPlayer();
+			printf("step %llu: %.2f s, %zu kills, player (%.1f, %.1f), %u shells, %u enemies\n",
+				(unsigned long long)world.GetStepCount(), world.GetTime(), world.GetKillCount(),
+				player.plPosition.x, player.plPosition.z, world.GetShells().Size(), world.GetEnemies().Size());
+		}
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printf("simulated %.1f s in %.3f s, %.0f steps/s\n", world.GetTime(), seconds,
+		seconds > 0.0 ? (double)world.GetStepCount() / seconds : 0.0);
+	printf("%zu enemies are destroyed\n", world.GetKillCount());
+
+	const uint64_t stateHash = world.GetStateHash();
+	printf("state hash %016llx\n", (unsigned long long)stateHash);
+
+	if (recorder.IsOpen())
+	{
+		recorder.Close(stateHash);
+		printf("recorded %llu steps to %s\n", (unsigned long long)recorder.GetStepCount(), recording.RecordPath.c_str());
+	}
+
+	if (replaying && replay.GetStateHash() != 0)
+	{
+		if (replay.GetStateHash() != stateHash)
+		{
+			printf("the replay differs from the recording, which ended with %016llx\n", (unsigned long long)replay.GetStateHash());
+			return 1;
+		}
+		printf("the replay matches the recording\n");
+	}
+	return 0;
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Helpers/d3dUtil.h"
+#include "Helpers/CommonConstants.h"
 #include "Helpers/MathHelper.h"
 #include "Helpers/UploadBuffer.h"
 
@@ -11,34 +12,14 @@ struct ObjectConstants
 {
 	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-};
-
-// common constant, supposed to paired to common cbuffer in hlsl source
-struct CommonConstants
-{
-	DirectX::XMFLOAT4X4 View = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 InvView = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 Proj = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 InvProj = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 InvViewProj = MathHelper::Identity4x4();
-	DirectX::XMFLOAT3 CameraPosW = { 0.0f, 0.0f, 0.0f };
-	float cbCommonPad0 = 0.0f;
-	DirectX::XMFLOAT2 RenderTargetSize = { 0.0f, 0.0f };
-	DirectX::XMFLOAT2 InvRenderTargetSize = { 0.0f, 0.0f };
-	float NearZ = 0.0f;
-	float FarZ = 0.0f;
-	float TotalTime = 0.0f;
-	float DeltaTime = 0.0f;
 
-	DirectX::XMFLOAT4 AmbientLight = { 0.1f, 0.1f, 0.1f, 1.0f };
-
-	DirectX::XMFLOAT4 FogEffectColor = { 0.9f, 0.9f, 0.9f, 1.0f };
-
-	Light Lights[MaxLights];
+	// rebuilds positions of compact vertices: pos = q * PosDecodeScale + PosDecodeOffset.
+	DirectX::XMFLOAT3 PosDecodeScale = { 1.0f, 1.0f, 1.0f };
+	float cbObjectPad1 = 0.0f;
+	DirectX::XMFLOAT3 PosDecodeOffset = { 0.0f, 0.0f, 0.0f };
+	float cbObjectPad2 = 0.0f;
 };
 
-
 struct Vertex
 {
 	DirectX::XMFLOAT3 Pos;
@@ -0,0 +1,354 @@
+// GameWorld.cpp
+
+#include "GameWorld.h"
+#include "Helpers/HashUtil.h"
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <string>
+
+using namespace DirectX;
+using namespace std;
+
+const float gPlayerRadius = 10.0f;		// collision radii, things collide when their spheres overlap.
+const float gShellRadius = 5.0f;
+const float gEnemyRadius = 5.0f;
+
+WorldRandom::WorldRandom(uint64_t seed, const char* name, uint32_t legacyStream, bool legacy) : mLegacy(legacy), mStream(seed, name)
+{
+	if (mLegacy)
+	{
+		// each legacy stream is seeded with the seed and its own number.
+		seed_seq sequence = { (uint32_t)seed, (uint32_t)(seed >> 32), legacyStream };
+		mLegacyStream.seed(sequence);
+	}
+}
+
+float WorldRandom::NextFloat(float a, float b)
+{
+	if (mLegacy)
+	{
+		return a + (float)mLegacyStream() / 4294967295.0f * (b - a);
+	}
+	return mStream.NextFloat(a, b);
+}
+
+int WorldRandom::NextInt(int a, int b)
+{
+	if (mLegacy)
+	{
+		return a + (int)(mLegacyStream() % (uint32_t)((b - a) + 1));
+	}
+	return mStream.NextInt(a, b);
+}
+
+GameSettings ParseSettings(const char* cmdLine)
+{
+	GameSettings settings;
+
+	istringstream args(cmdLine != nullptr ? cmdLine : "");
+	string option;
+	while (args >> option)
+	{
+		uint32_t value = 0;
+		double rate = 0.0;
+		uint64_t seed = 0;
+		if (option == "-shells" && args >> value && value > 0)
+		{
+			settings.ShellCapacity = value;
+		}
+		else if (option == "-enemies" && args >> value && value > 0)
+		{
+			settings.EnemyCapacity = value;
+		}
+		else if (option == "-tickrate" && args >> rate && rate >= 0.0)
+		{
+			settings.TickRate = rate;
+		}
+		else if (option == "-seed" && args >> seed)
+		{
+			settings.Seed = seed;
+		}
+	}
+
+	return settings;
+}
+
+GameWorld::GameWorld(const GameSettings& settings) : mSettings(settings), mWaterSurface(200, 200, 2.0f, 0.03f, 5.0f, 0.1f),
+	mEnemyRandom(settings.Seed, "enemies", 0, settings.LegacyRandom), mWaveRandom(settings.Seed, "waves", 1, settings.LegacyRandom)
+{
+	// set initial position of the player appeared in the scene.
+	mPlayer.playerScale = 15.0f;
+	mPlayer.plPosition.x = 0.0f;
+	mPlayer.plPosition.y = 50.0f;
+	mPlayer.plPosition.z = -200.0f;
+	mPlayer.plPrevPosition = mPlayer.plPosition;
+
+	mPlayer.shellSpeed = 250.0f;
+	mPlayer.killCount = 0;
+
+	// all the shells in the magazine are initially free.
+	mShells.Reserve(mSettings.ShellCapacity);
+	mEnemies.Reserve(mSettings.EnemyCapacity);
+	mShellSlots.Reset(mSettings.ShellCapacity);
+	mEnemySlots.Reset(mSettings.EnemyCapacity);
+}
+
+GameWorld::~GameWorld()
+{
+
+}
+
+void GameWorld::Step(float dt, const GameInput& input)
+{
+	mGameTime += dt;
+	mStepCount++;
+
+	MovePlayer(dt, input);
+	UpdateShells(dt);
+	UpdateEnemies(dt);
+	CollisionProcessing();
+	UpdateWaterSurface(dt);
+}
+
+void GameWorld::MovePlayer(float dt, const GameInput& input)
+{
+	mPlayer.plPrevPosition = mPlayer.plPosition;
+
+	// player's position update, within the bounds of the field.
+	if (input.IsDown(ButtonLeft))
+	{
+		if (mPlayer.plPosition.x > -120.0f)
+		{
+			mPlayer.plPosition.x -= maneuverSpeed * dt;
+		}
+	}
+
+	if (input.IsDown(ButtonRight))
+	{
+		if (mPlayer.plPosition.x < 120.0f)
+		{
+			mPlayer.plPosition.x += maneuverSpeed * dt;
+		}
+	}
+
+	if (input.IsDown(ButtonUp))
+	{
+		if (mPlayer.plPosition.z < 150.0f)
+		{
+			mPlayer.plPosition.z += maneuverSpeed * dt;
+		}
+	}
+
+	if (input.IsDown(ButtonDown))
+	{
+		if (mPlayer.plPosition.z > -210.0f)
+		{
+			mPlayer.plPosition.z -= maneuverSpeed * dt;
+		}
+	}
+
+	// fire a shell from the player's position if the magazine has one left.
+	if (input.IsDown(ButtonFire))
+	{
+		if (mGameTime - mLastFireTime >= 0.3 && !mShellSlots.Full())
+		{
+			mLastFireTime = mGameTime;
+
+			SlotPool::Handle slot = mShellSlots.Acquire();
+			mShellSlots.Get(slot) = mShells.Create(XMFLOAT3(mPlayer.plPosition.x, 50.0f, mPlayer.plPosition.z),
+				XMFLOAT3(0.0f, 0.0f, mPlayer.shellSpeed), 1.0f, gShellRadius, slot);
+		}
+	}
+}
+
+void GameWorld::UpdateShells(float dt)
+{
+	mShells.Integrate(dt);
+
+	// a shell out of range goes back to the magazine once collisions are processed.
+	const float* posZ = mShells.PositionZ();
+	uint32_t* flags = mShells.Flags();
+	for (uint32_t i = 0; i < mShells.Size(); ++i)
+	{
+		if (posZ[i] >= 200.0f)
+		{
+			flags[i] |= EntityExpired;
+		}
+	}
+}
+
+void GameWorld::UpdateEnemies(float dt)
+{
+	// a new enemy enters every free lane. the lane is the slot of the enemy,
+	// lanes are 50 units apart around the middle of the field.
+	while (!mEnemySlots.Full())
+	{
+		SlotPool::Handle slot = mEnemySlots.Acquire();
+		float laneX = ((float)SlotOf(slot) - (float)(mSettings.EnemyCapacity - 1) * 0.5f) * 50.0f;
+
+		float xFluc = mEnemyRandom.NextFloat(-20.0f, 20.0f);
+		float zFluc = mEnemyRandom.NextFloat(-20.0f, 20.0f);
+		float spd = mEnemyRandom.NextFloat(+15.0f, 40.0f);
+		mEnemySlots.Get(slot) = mEnemies.Create(XMFLOAT3(laneX + xFluc, 50.0f, 300.0f + zFluc),
+			XMFLOAT3(0.0f, 0.0f, -spd), 15.0f, gEnemyRadius, slot);
+	}
+
+	// update enemies position, the ones past the player leave the field.
+	mEnemies.Integrate(dt);
+
+	const float* posZ = mEnemies.PositionZ();
+	uint32_t* flags = mEnemies.Flags();
+	for (uint32_t i = 0; i < mEnemies.Size(); ++i)
+	{
+		if (posZ[i] < -230.0f)
+		{
+			flags[i] |= EntityExpired;
+		}
+	}
+}
+
+void GameWorld::UpdateWaterSurface(float dt)
+{
+	// random wave is generated in every quarter second.
+	if ((mGameTime - mWaveTime) >= 0.10)
+	{
+		mWaveTime += 0.25;
+
+		int i = mWaveRandom.NextInt(4, mWaterSurface.GetRowCount() - 5);
+		int j = mWaveRandom.NextInt(4, mWaterSurface.GetColumnCount() - 5);
+		float r = mWaveRandom.NextFloat(0.3f, 1.0f);
+
+		mWaterSurface.AddFluctuationsAt(i, j, r);
+	}
+
+	// update the wave equation,
+	mWaterSurface.UpdateModelEquation(dt);
+}
+
+void GameWorld::CollisionProcessing()
+{
+	// everything moves in a straight line during the step, so the spheres are swept from their
+	// previous positions and hits don't depend on the step length.
+	const SphereOverlap::MovingSpheres enemies = { mEnemies.PrevPositionX(), mEnemies.PrevPositionY(), mEnemies.PrevPositionZ(),
+		mEnemies.PositionX(), mEnemies.PositionY(), mEnemies.PositionZ(), mEnemies.Radius() };
+	const SphereOverlap::MovingSpheres shells = { mShells.PrevPositionX(), mShells.PrevPositionY(), mShells.PrevPositionZ(),
+		mShells.PositionX(), mShells.PositionY(), mShells.PositionZ(), mShells.Radius() };
+	uint32_t* enemyFlags = mEnemies.Flags();
+	uint32_t* shellFlags = mShells.Flags();
+
+	float playerRadius = gPlayerRadius;
+	const WPosition& prevPos = mPlayer.plPrevPosition;
+	const WPosition& wPos = mPlayer.plPosition;
+	const SphereOverlap::MovingSpheres player = { &prevPos.x, &prevPos.y, &prevPos.z, &wPos.x, &wPos.y, &wPos.z, &playerRadius };
+
+	// only the pairs whose swept bounding spheres overlap are swept, those are tested in batches.
+	SphereOverlap::GetSweptBounds(enemies, mEnemies.Size(), mEnemyBounds);
+	const SphereOverlap::Spheres enemyBounds = mEnemyBounds.GetSpheres();
+
+	// check collision between player and enemies, one query against all of them.
+	SphereOverlap::GetSweptBounds(player, 1, mQueryBounds);
+	mHitMask.resize(SphereOverlap::GetMaskWordCount(mEnemies.Size()));
+	SphereOverlap::Test(mQueryBounds.X[0], mQueryBounds.Y[0], mQueryBounds.Z[0], mQueryBounds.Radius[0],
+		enemyBounds, mEnemies.Size(), mHitMask.data());
+	mOverlapPairs.clear();
+	mPlayerImpacts.clear();
+	SphereOverlap::AppendHits(mHitMask.data(), mEnemies.Size(), 0, mOverlapPairs);
+	SphereOverlap::SweepPairs(player, enemies, mOverlapPairs.data(), (uint32_t)mOverlapPairs.size(), mPlayerImpacts);
+
+	// check collision between shells that the player fires and incoming enemies. the broadphase
+	// pairs the shells with the enemies whose swept boxes overlap theirs first.
+	SphereOverlap::GetSweptBoxes(enemies, mEnemies.Size(), mEnemyBoxes);
+	mEnemyGrid.BuildBoxes(mEnemyBoxes.data(), mEnemies.Size());
+	SphereOverlap::GetSweptBoxes(shells, mShells.Size(), mQueryBoxes);
+	mCandidatePairs.clear();
+	mEnemyGrid.QueryBoxPairs(mQueryBoxes.data(), mShells.Size(), mCandidatePairs);
+
+	SphereOverlap::GetSweptBounds(shells, mShells.Size(), mQueryBounds);
+	mOverlapPairs.clear();
+	mShellImpacts.clear();
+	SphereOverlap::TestPairs(mQueryBounds.GetSpheres(), enemyBounds, mCandidatePairs.data(), (uint32_t)mCandidatePairs.size(),
+		mOverlapPairs);
+	SphereOverlap::SweepPairs(shells, enemies, mOverlapPairs.data(), (uint32_t)mOverlapPairs.size(), mShellImpacts);
+
+	// resolve the hits in the order they happen during the step.
+	// an enemy or a shell is destroyed by its first hit.
+	auto earlier = [](const SphereOverlap::Impact& a, const SphereOverlap::Impact& b) { return a.Time < b.Time; };
+	stable_sort(mPlayerImpacts.begin(), mPlayerImpacts.end(), earlier);
+	stable_sort(mShellImpacts.begin(), mShellImpacts.end(), earlier);
+
+	size_t p = 0;
+	size_t s = 0;
+	while (p < mPlayerImpacts.size() || s < mShellImpacts.size())
+	{
+		if (s == mShellImpacts.size() || (p < mPlayerImpacts.size() && !earlier(mShellImpacts[s], mPlayerImpacts[p])))
+		{
+			const SphereOverlap::Impact& hit = mPlayerImpacts[p++];
+			if (!(enemyFlags[hit.Point] & EntityDestroyed))
+			{
+				enemyFlags[hit.Point] |= EntityDestroyed;
+				mPlayer.killCount++;
+			}
+			continue;
+		}
+
+		const SphereOverlap::Impact& hit = mShellImpacts[s++];
+		if ((enemyFlags[hit.Point] & EntityDestroyed) || (shellFlags[hit.Query] & EntityDestroyed))
+		{
+			continue;
+		}
+
+		enemyFlags[hit.Point] |= EntityDestroyed;
+		shellFlags[hit.Query] |= EntityDestroyed;
+		mPlayer.killCount++;
+	}
+
+	DestroyEntities(mEnemies, mEnemySlots, EntityDestroyed | EntityExpired);
+	DestroyEntities(mShells, mShellSlots, EntityDestroyed | EntityExpired);
+}
+
+void GameWorld::DestroyEntities(EntityStore& entities, SlotPool& slots, uint32_t flags)
+{
+	// give the slots of the flagged entities back before the store removes them.
+	const uint32_t* entityFlags = entities.Flags();
+	const uint32_t* renderHandle = entities.RenderHandle();
+	for (uint32_t i = 0; i < entities.Size(); ++i)
+	{
+		if (entityFlags[i] & flags)
+		{
+			slots.Release(renderHandle[i]);
+		}
+	}
+	entities.DestroyFlagged(flags);
+}
+
+uint64_t GameWorld::GetStateHash() const
+{
+	uint64_t hash = HashUtil::Value(mStepCount);
+	hash = HashUtil::Value(mGameTime, hash);
+	hash = HashUtil::Value(mLastFireTime, hash);
+	hash = HashUtil::Value(mWaveTime, hash);
+
+	hash = HashUtil::Value(mPlayer.plPosition, hash);
+	hash = HashUtil::Value(mPlayer.plPrevPosition, hash);
+	hash = HashUtil::Value((uint64_t)mPlayer.killCount, hash);
+
+	// the order of the entities is part of the state, it decides the order of later hits.
+	for (const EntityStore* entities : { &mShells, &mEnemies })
+	{
+		const size_t columnSize = entities->Size() * sizeof(float);
+		hash = HashUtil::Value(entities->Size(), hash);
+		hash = HashUtil::Bytes(entities->PositionX(), columnSize, hash);
+		hash = HashUtil::Bytes(entities->PositionY(), columnSize, hash);
+		hash = HashUtil::Bytes(entities->PositionZ(), columnSize, hash);
+		hash = HashUtil::Bytes(entities->VelocityZ(), columnSize, hash);
+		hash = HashUtil::Bytes(entities->RenderHandle(), entities->Size() * sizeof(uint32_t), hash);
+	}
+
+	for (int i = 0; i < mWaterSurface.GetVertexCount(); ++i)
+	{
+		hash = HashUtil::Value(mWaterSurface.Position(i).y, hash);
+	}
+
+	return hash;
+}
@@ -0,0 +1,170 @@
+#pragma once
+// the simulation of the game: the player, the shells and enemies in flight, the water surface and
+// the kill count, stepped with the buttons the player holds.
+// it knows nothing about windows, devices or render items, so the game draws it and
+// FlyingCratesHeadless steps it as fast as it can on any platform with DirectXMath.
+// shells and enemies occupy slots, as many as the settings allow for each kind. the slot of an
+// entity doesn't change while it lives, a renderer draws one item per slot.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <DirectXMath.h>
+#include "EntityStore.h"
+#include "WaterSurface.h"
+#include "Helpers/SpatialHashGrid.h"
+#include "Helpers/SphereOverlap.h"
+#include "Helpers/ObjectPool.h"
+#include "Helpers/RandomStream.h"
+
+// game options given on the command line, e.g. "-shells 10 -enemies 20 -tickrate 30 -seed 7".
+struct GameSettings
+{
+	std::uint32_t ShellCapacity = 5;	// shells the player's magazine holds, the render items drawn for them.
+	std::uint32_t EnemyCapacity = 5;	// enemies on the field at once, one per lane.
+	double TickRate = 60.0;				// gameplay steps per second, 0 steps once per frame.
+	std::uint64_t Seed = 1;				// seeds the random streams, the same seed and input play the same game.
+	bool LegacyRandom = false;			// draws from std::mt19937 as the world did before RandomStream, for version 1 recordings.
+};
+
+// reads the options in cmdLine, the missing ones keep their defaults and unknown ones are skipped.
+GameSettings ParseSettings(const char* cmdLine);
+
+enum GameButton : std::uint8_t
+{
+	ButtonLeft = 1 << 0,
+	ButtonRight = 1 << 1,
+	ButtonUp = 1 << 2,
+	ButtonDown = 1 << 3,
+	ButtonFire = 1 << 4,
+};
+
+// buttons held during a step, a byte so a recording of the input takes a byte per step.
+struct GameInput
+{
+	std::uint8_t Buttons = 0;		// GameButton bits
+
+	bool IsDown(GameButton button) const { return (Buttons & button) != 0; }
+	void Press(GameButton button) { Buttons |= button; }
+};
+
+struct WPosition			// for storing position vector out of a world matrix
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Player
+{
+	float shellSpeed;
+	float playerScale;
+	WPosition plPosition;
+	WPosition plPrevPosition;		// position before the last move, collisions sweep from here.
+	size_t killCount;
+};
+
+// bits of the EntityStore flags column.
+enum EntityFlags : std::uint32_t
+{
+	EntityDestroyed = 1 << 0,		// hit in the current step, removed once collisions are processed.
+	EntityExpired = 1 << 1,			// left the field in the current step, it can still be hit until removed.
+};
+
+// a random stream of the world. it is a RandomStream, or with legacy a std::mt19937 seeded and
+// mapped the way the world used it before, so recordings made back then still replay exactly.
+// mt19937 and seed_seq are specified by the standard and the ranges are mapped here, so both give
+// the same numbers with every compiler and library.
+class WorldRandom
+{
+public:
+	WorldRandom(std::uint64_t seed, const char* name, std::uint32_t legacyStream, bool legacy);
+
+	// uniform in [a, b).
+	float NextFloat(float a, float b);
+
+	// uniform in [a, b], both included.
+	int NextInt(int a, int b);
+
+private:
+	bool mLegacy;
+	RandomStream mStream;
+	std::mt19937 mLegacyStream;
+};
+
+class GameWorld
+{
+public:
+	// slots of one kind of entity, each remembers the entity in it. the render handle of an entity
+	// is the handle of its slot.
+	using SlotPool = ObjectPool<EntityHandle>;
+
+	explicit GameWorld(const GameSettings& settings);
+	GameWorld(const GameWorld& rhs) = delete;
+	GameWorld& operator=(const GameWorld& rhs) = delete;
+	~GameWorld();
+
+	// advances the simulation by dt seconds.
+	void Step(float dt, const GameInput& input);
+
+	const GameSettings& GetSettings() const { return mSettings; }
+	const Player& GetPlayer() const { return mPlayer; }
+	const EntityStore& GetShells() const { return mShells; }
+	const EntityStore& GetEnemies() const { return mEnemies; }
+	const WaterSurface& GetWaterSurface() const { return mWaterSurface; }
+
+	size_t GetKillCount() const { return mPlayer.killCount; }
+	double GetTime() const { return mGameTime; }
+	std::uint64_t GetStepCount() const { return mStepCount; }
+
+	// hash of the whole simulation state, two worlds that played the same game have the same hash.
+	std::uint64_t GetStateHash() const;
+
+	// slot in [0, capacity) of an entity, from its render handle.
+	static std::uint32_t SlotOf(std::uint32_t renderHandle) { return SlotPool::IndexOf(renderHandle); }
+
+private:
+	void MovePlayer(float dt, const GameInput& input);
+	void UpdateShells(float dt);
+	void UpdateEnemies(float dt);
+	void UpdateWaterSurface(float dt);
+	void CollisionProcessing();
+	void DestroyEntities(EntityStore& entities, SlotPool& slots, std::uint32_t flags);
+
+private:
+	GameSettings mSettings;
+
+	Player mPlayer;
+
+	// shells and enemies in flight.
+	EntityStore mShells;
+	EntityStore mEnemies;
+	SlotPool mShellSlots;
+	SlotPool mEnemySlots;
+
+	// collision broadphase over the bounds enemies sweep in a step, its cells are about their size.
+	SpatialHashGrid mEnemyGrid{ 15.0f };
+	std::vector<SpatialHashGrid::Box> mEnemyBoxes;
+	std::vector<SpatialHashGrid::Box> mQueryBoxes;
+	std::vector<SpatialHashGrid::Pair> mCandidatePairs;
+
+	// the spheres bounding each sweep, tested in batches before the pairs left are swept.
+	SphereOverlap::SweptBounds mEnemyBounds;
+	SphereOverlap::SweptBounds mQueryBounds;
+	std::vector<uint32_t> mHitMask;
+	std::vector<SpatialHashGrid::Pair> mOverlapPairs;
+	std::vector<SphereOverlap::Impact> mPlayerImpacts;
+	std::vector<SphereOverlap::Impact> mShellImpacts;
+
+	WaterSurface mWaterSurface;
+	double mWaveTime = 0.0;			// random waves are timed from it.
+
+	// random streams of the enemies and of the waves, named so the numbers of one don't shift the other.
+	WorldRandom mEnemyRandom;
+	WorldRandom mWaveRandom;
+
+	double mGameTime = 0.0;			// seconds simulated by Step().
+	std::uint64_t mStepCount = 0;
+	double mLastFireTime = 0.0;
+	float maneuverSpeed = 50.0f;
+};
@@ -0,0 +1,186 @@
+//***************************************************************************************
+// AsyncLoadQueue.h
+//
+// Runs load jobs (file parsing, decoding, ...) on a few worker threads and hands their
+// results back to the thread polling the queue, which is where device work such as creating
+// resources and recording uploads belongs.  Results are delivered in completion order,
+// tagged with the ticket Submit returned.  An exception thrown by a job is rethrown when its
+// result would have been delivered.
+//
+// It only depends on the standard library, so the scheduling can be driven without a device.
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template<typename Result>
+class AsyncLoadQueue
+{
+public:
+    using Ticket = std::uint32_t;
+    using Job = std::function<Result()>;
+    using ConsumeFunc = std::function<void(Ticket ticket, Result& result)>;
+
+    // workerCount 0 picks one worker per hardware thread, at most 8.
+    AsyncLoadQueue(unsigned int workerCount = 0)
+    {
+        if(workerCount == 0)
+            workerCount = std::min<unsigned int>(std::max<unsigned int>(std::thread::hardware_concurrency(), 1u), 8u);
+
+        for(unsigned int i = 0; i < workerCount; ++i)
+            mWorkers.emplace_back([this] { WorkerMain(); });
+    }
+
+    AsyncLoadQueue(const AsyncLoadQueue& rhs) = delete;
+    AsyncLoadQueue& operator=(const AsyncLoadQueue& rhs) = delete;
+
+    // Jobs not started yet are dropped, running ones are waited for.
+    ~AsyncLoadQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+            mJobs.clear();
+        }
+        mWorkAvailable.notify_all();
+
+        for(std::thread& worker : mWorkers)
+            worker.join();
+    }
+
+    Ticket Submit(Job job)
+    {
+        Ticket ticket;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ticket = mNextTicket++;
+            mJobs.emplace_back(ticket, std::move(job));
+            mPendingCount++;
+        }
+        mWorkAvailable.notify_one();
+
+        return ticket;
+    }
+
+    // Delivers every result finished so far without blocking, returns how many.
+    std::size_t Poll(const ConsumeFunc& consume)
+    {
+        std::size_t count = 0;
+
+        Finished finished;
+        while(PopFinished(finished, false))
+        {
+            Deliver(finished, consume);
+            count++;
+        }
+
+        return count;
+    }
+
+    // Delivers results as they finish until every submitted job has been delivered.
+    void WaitAll(const ConsumeFunc& consume)
+    {
+        Finished finished;
+        while(PopFinished(finished, true))
+            Deliver(finished, consume);
+    }
+
+    // Jobs submitted but not delivered yet.
+    std::size_t GetPendingCount()const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPendingCount;
+    }
+
+    std::size_t GetWorkerCount()const { return mWorkers.size(); }
+
+private:
+    struct Finished
+    {
+        Ticket JobTicket = 0;
+        Result JobResult;
+        std::exception_ptr Error;
+    };
+
+    void WorkerMain()
+    {
+        for(;;)
+        {
+            std::pair<Ticket, Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWorkAvailable.wait(lock, [this] { return mShutdown || !mJobs.empty(); });
+                if(mShutdown)
+                    return;
+
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+
+            Finished finished;
+            finished.JobTicket = job.first;
+            try
+            {
+                finished.JobResult = job.second();
+            }
+            catch(...)
+            {
+                finished.Error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFinished.push_back(std::move(finished));
+            }
+            mWorkFinished.notify_all();
+        }
+    }
+
+    // Takes one finished job off the list.  With wait set, blocks while jobs are still running
+    // and returns false only once nothing is left to deliver.
+    bool PopFinished(Finished& finished, bool wait)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(wait)
+            mWorkFinished.wait(lock, [this] { return !mFinished.empty() || mPendingCount == 0; });
+
+        if(mFinished.empty())
+            return false;
+
+        finished = std::move(mFinished.front());
+        mFinished.pop_front();
+        mPendingCount--;
+        return true;
+    }
+
+    void Deliver(Finished& finished, const ConsumeFunc& consume)
+    {
+        if(finished.Error)
+            std::rethrow_exception(finished.Error);
+
+        consume(finished.JobTicket, finished.JobResult);
+    }
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkFinished;
+
+    std::deque<std::pair<Ticket, Job>> mJobs;
+    std::deque<Finished> mFinished;
+    std::vector<std::thread> mWorkers;
+
+    Ticket mNextTicket = 0;
+    std::size_t mPendingCount = 0;
+    bool mShutdown = false;
+};
@@ -0,0 +1,138 @@
+//***************************************************************************************
+// BuddyAllocator.cpp
+//***************************************************************************************
+
+#include "BuddyAllocator.h"
+#include <cassert>
+
+#ifndef NDEBUG
+namespace
+{
+    bool IsPowerOfTwo(std::uint64_t x)
+    {
+        return x != 0 && (x & (x - 1)) == 0;
+    }
+}
+#endif
+
+const std::uint64_t BuddyAllocator::InvalidOffset;
+
+BuddyAllocator::BuddyAllocator(std::uint64_t totalSize, std::uint64_t minBlockSize) :
+    mTotalSize(totalSize), mMinBlockSize(minBlockSize)
+{
+    assert(IsPowerOfTwo(totalSize) && IsPowerOfTwo(minBlockSize) && totalSize >= minBlockSize);
+
+    mMaxOrder = OrderOf(totalSize);
+    mFreeBlocks.resize(mMaxOrder + 1);
+    mFreeBlocks[mMaxOrder].insert(0);
+
+    std::size_t minBlockCount = (std::size_t)(totalSize / minBlockSize);
+    mAllocatedOrder.assign(minBlockCount, 0);
+    mRequestedSize.assign(minBlockCount, 0);
+}
+
+std::uint32_t BuddyAllocator::OrderOf(std::uint64_t blockSize)const
+{
+    std::uint32_t order = 0;
+    while(BlockSize(order) < blockSize)
+        order++;
+    return order;
+}
+
+std::uint64_t BuddyAllocator::Allocate(std::uint64_t size, std::uint64_t alignment)
+{
+    assert(IsPowerOfTwo(alignment));
+
+    if(size == 0 || size > mTotalSize || alignment > mTotalSize)
+        return InvalidOffset;
+
+    // blocks are aligned to their size, so a block at least as large as the alignment is aligned.
+    std::uint32_t order = OrderOf(size > alignment ? size : alignment);
+
+    // smallest order with a free block.
+    std::uint32_t found = order;
+    while(found <= mMaxOrder && mFreeBlocks[found].empty())
+        found++;
+    if(found > mMaxOrder)
+        return InvalidOffset;
+
+    std::uint64_t offset = *mFreeBlocks[found].begin();
+    mFreeBlocks[found].erase(mFreeBlocks[found].begin());
+
+    // split down to the requested order, the upper halves become free buddies.
+    while(found > order)
+    {
+        found--;
+        mFreeBlocks[found].insert(offset + BlockSize(found));
+    }
+
+    std::size_t index = (std::size_t)(offset / mMinBlockSize);
+    mAllocatedOrder[index] = (std::uint8_t)(order + 1);
+    mRequestedSize[index] = size;
+
+    mAllocatedBytes += BlockSize(order);
+    mRequestedBytes += size;
+    mAllocationCount++;
+
+    return offset;
+}
+
+void BuddyAllocator::Free(std::uint64_t offset)
+{
+    std::size_t index = (std::size_t)(offset / mMinBlockSize);
+    assert(offset % mMinBlockSize == 0 && index < mAllocatedOrder.size() && mAllocatedOrder[index] != 0);
+
+    std::uint32_t order = mAllocatedOrder[index] - 1u;
+    mAllocatedBytes -= BlockSize(order);
+    mRequestedBytes -= mRequestedSize[index];
+    mAllocationCount--;
+    mAllocatedOrder[index] = 0;
+    mRequestedSize[index] = 0;
+
+    // merge with the buddy as long as it is free.
+    while(order < mMaxOrder)
+    {
+        std::uint64_t buddy = offset ^ BlockSize(order);
+        auto it = mFreeBlocks[order].find(buddy);
+        if(it == mFreeBlocks[order].end())
+            break;
+
+        mFreeBlocks[order].erase(it);
+        offset = offset < buddy ? offset : buddy;
+        order++;
+    }
+
+    mFreeBlocks[order].insert(offset);
+}
+
+BuddyAllocator::Stats BuddyAllocator::GetStats()const
+{
+    Stats stats;
+    stats.TotalBytes = mTotalSize;
+    stats.AllocatedBytes = mAllocatedBytes;
+    stats.RequestedBytes = mRequestedBytes;
+    stats.AllocationCount = mAllocationCount;
+
+    for(std::uint32_t order = 0; order <= mMaxOrder; ++order)
+    {
+        stats.FreeBlockCount += (std::uint32_t)mFreeBlocks[order].size();
+        if(!mFreeBlocks[order].empty())
+            stats.LargestFreeBlock = BlockSize(order);
+    }
+
+    return stats;
+}
+
+float BuddyAllocator::GetOccupancy()const
+{
+    return (float)((double)mAllocatedBytes / (double)mTotalSize);
+}
+
+float BuddyAllocator::GetFragmentation()const
+{
+    std::uint64_t freeBytes = mTotalSize - mAllocatedBytes;
+    if(freeBytes == 0)
+        return 0.0f;
+
+    return 1.0f - (float)((double)GetStats().LargestFreeBlock / (double)freeBytes);
+}
@@ -0,0 +1,72 @@
+//***************************************************************************************
+// BuddyAllocator.h
+//
+// Binary buddy allocation of offsets inside a range of bytes, e.g. a GPU heap.
+// The range is split into power of two blocks, every block is aligned to its own size, so an
+// allocation is aligned to any power of two up to its block size for free.  Freed blocks are
+// merged with their buddy whenever it is free too.
+// It only hands out offsets and never touches the memory, so it needs no device.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+class BuddyAllocator
+{
+public:
+    static const std::uint64_t InvalidOffset = ~std::uint64_t(0);
+
+    struct Stats
+    {
+        std::uint64_t TotalBytes = 0;
+        std::uint64_t AllocatedBytes = 0;      // size of the blocks handed out
+        std::uint64_t RequestedBytes = 0;      // size asked for, the rest is internal fragmentation
+        std::uint64_t LargestFreeBlock = 0;
+        std::uint32_t AllocationCount = 0;
+        std::uint32_t FreeBlockCount = 0;
+    };
+
+    // totalSize and minBlockSize must be powers of two, totalSize >= minBlockSize.
+    BuddyAllocator(std::uint64_t totalSize, std::uint64_t minBlockSize);
+
+    // Returns the offset of a block of at least size bytes aligned to alignment (a power of
+    // two), or InvalidOffset if no block is large enough.
+    std::uint64_t Allocate(std::uint64_t size, std::uint64_t alignment = 1);
+
+    void Free(std::uint64_t offset);
+
+    std::uint64_t GetTotalSize()const { return mTotalSize; }
+    bool IsEmpty()const { return mAllocationCount == 0; }
+
+    Stats GetStats()const;
+
+    // Share of the allocated bytes in the total, in [0, 1].
+    float GetOccupancy()const;
+
+    // 1 - largest free block / free bytes: 0 when all free memory is one block, close to 1
+    // when it is scattered in small blocks.
+    float GetFragmentation()const;
+
+private:
+    std::uint32_t OrderOf(std::uint64_t blockSize)const;
+    std::uint64_t BlockSize(std::uint32_t order)const { return mMinBlockSize << order; }
+
+    std::uint64_t mTotalSize;
+    std::uint64_t mMinBlockSize;
+    std::uint32_t mMaxOrder;
+
+    // free block offsets of every order, ordered so the lowest address is reused first.
+    std::vector<std::set<std::uint64_t>> mFreeBlocks;
+
+    // order + 1 of the allocation starting at each min block, 0 if none starts there.
+    std::vector<std::uint8_t> mAllocatedOrder;
+    std::vector<std::uint64_t> mRequestedSize;
+
+    std::uint64_t mAllocatedBytes = 0;
+    std::uint64_t mRequestedBytes = 0;
+    std::uint32_t mAllocationCount = 0;
+};
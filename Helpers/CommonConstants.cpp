@@ -0,0 +1,88 @@
+//***************************************************************************************
+// CommonConstants.cpp
+//***************************************************************************************
+
+#include "CommonConstants.h"
+
+using namespace DirectX;
+
+namespace
+{
+    bool Equal(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+}
+
+CommonConstantsCache::CommonConstantsCache(int frameBufferCount)
+    : mFrameBufferCount(frameBufferCount),
+      mCameraFramesDirty(frameBufferCount),
+      mStaticFramesDirty(frameBufferCount)
+{
+}
+
+void CommonConstantsCache::LookAt(const XMFLOAT3& position, const XMFLOAT3& target, const XMFLOAT3& up)
+{
+    if(!mViewDirty && Equal(position, mPosition) && Equal(target, mTarget) && Equal(up, mUp))
+        return;
+
+    mPosition = position;
+    mTarget = target;
+    mUp = up;
+    mViewDirty = true;
+
+    XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&mPosition), XMLoadFloat3(&mTarget), XMLoadFloat3(&mUp));
+    XMStoreFloat4x4(&mView, view);
+}
+
+void CommonConstantsCache::SetProjection(FXMMATRIX proj, float width, float height, float nearZ, float farZ)
+{
+    XMStoreFloat4x4(&mProj, proj);
+
+    mConstants.RenderTargetSize = XMFLOAT2(width, height);
+    mConstants.InvRenderTargetSize = XMFLOAT2(1.0f / width, 1.0f / height);
+    mConstants.NearZ = nearZ;
+    mConstants.FarZ = farZ;
+
+    mProjDirty = true;
+}
+
+void CommonConstantsCache::SetLights(const XMFLOAT4& ambientLight, const Light (&lights)[MaxLights])
+{
+    mConstants.AmbientLight = ambientLight;
+    for(int i = 0; i < MaxLights; ++i)
+        mConstants.Lights[i] = lights[i];
+
+    mStaticFramesDirty = mFrameBufferCount;
+}
+
+void CommonConstantsCache::UpdateCamera()
+{
+    XMMATRIX view = XMLoadFloat4x4(&mView);
+    XMMATRIX proj = XMLoadFloat4x4(&mProj);
+
+    // the projection only changes on resize, so its general inverse is computed just then.
+    if(mProjDirty)
+    {
+        XMVECTOR projDet = XMMatrixDeterminant(proj);
+        XMStoreFloat4x4(&mInvProj, XMMatrixInverse(&projDet, proj));
+    }
+
+    // the view matrix is a rigid transform, it can be inverted by transposing its rotation part.
+    XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+    XMMATRIX invView = MathHelper::InverseRigid(view);
+    XMMATRIX invProj = XMLoadFloat4x4(&mInvProj);
+    XMMATRIX invViewProj = XMMatrixMultiply(invProj, invView);     // (V*P)^-1 = P^-1 * V^-1
+
+    XMStoreFloat4x4(&mConstants.View, XMMatrixTranspose(view));
+    XMStoreFloat4x4(&mConstants.InvView, XMMatrixTranspose(invView));
+    XMStoreFloat4x4(&mConstants.Proj, XMMatrixTranspose(proj));
+    XMStoreFloat4x4(&mConstants.InvProj, XMMatrixTranspose(invProj));
+    XMStoreFloat4x4(&mConstants.ViewProj, XMMatrixTranspose(viewProj));
+    XMStoreFloat4x4(&mConstants.InvViewProj, XMMatrixTranspose(invViewProj));
+    mConstants.CameraPosW = mPosition;
+
+    mViewDirty = false;
+    mProjDirty = false;
+    mCameraFramesDirty = mFrameBufferCount;
+}
@@ -0,0 +1,124 @@
+//***************************************************************************************
+// CommonConstants.h
+//
+// The common constants of the shaders, and the CPU side copy of them the frame buffers are
+// updated from.  Each frame buffer owns a copy of the common cbuffer, so a change has to be
+// uploaded to every one of them.  CommonConstantsCache recomputes the camera-derived
+// matrices only when the view or the projection changed, and hands the byte ranges that are
+// out of date in the current frame buffer to a copy function.
+// It only depends on DirectXMath, thus it can be driven without a window or a device.
+//***************************************************************************************
+
+#pragma once
+
+#include "MathHelper.h"
+#include <DirectXMath.h>
+#include <cstddef>
+
+struct Light
+{
+    DirectX::XMFLOAT3 Strength = { 0.5f, 0.5f, 0.5f };
+    float FalloffStart = 1.0f;                          // point/spot light only
+    DirectX::XMFLOAT3 Direction = { 0.0f, -1.0f, 0.0f };// directional/spot light only
+    float FalloffEnd = 10.0f;                           // point/spot light only
+    DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };  // point/spot light only
+    float SpotPower = 64.0f;                            // spot light only
+};
+
+#define MaxLights   16
+
+// common constant, supposed to paired to common cbuffer in hlsl source
+struct CommonConstants
+{
+    DirectX::XMFLOAT4X4 View = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvView = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 Proj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvProj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 InvViewProj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT3 CameraPosW = { 0.0f, 0.0f, 0.0f };
+    float cbCommonPad0 = 0.0f;
+    DirectX::XMFLOAT2 RenderTargetSize = { 0.0f, 0.0f };
+    DirectX::XMFLOAT2 InvRenderTargetSize = { 0.0f, 0.0f };
+    float NearZ = 0.0f;
+    float FarZ = 0.0f;
+    float TotalTime = 0.0f;
+    float DeltaTime = 0.0f;
+
+    DirectX::XMFLOAT4 AmbientLight = { 0.1f, 0.1f, 0.1f, 1.0f };
+
+    DirectX::XMFLOAT4 FogEffectColor = { 0.9f, 0.9f, 0.9f, 1.0f };
+
+    Light Lights[MaxLights];
+};
+
+class CommonConstantsCache
+{
+public:
+    // frameBufferCount is the number of copies of the cbuffer a change has to reach.
+    explicit CommonConstantsCache(int frameBufferCount);
+
+    // Places the camera.  The view matrix is only rebuilt when one of the arguments changed.
+    void LookAt(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& target, const DirectX::XMFLOAT3& up);
+
+    // Sets the projection and the render target it belongs to, e.g. after a resize.
+    void SetProjection(DirectX::FXMMATRIX proj, float width, float height, float nearZ, float farZ);
+
+    // Sets the ambient light and the lights, they stay until they are set again.
+    void SetLights(const DirectX::XMFLOAT4& ambientLight, const Light (&lights)[MaxLights]);
+
+    // Brings the constants up to date for the next frame buffer and calls copy(offset, size)
+    // for every byte range of CommonConstants that is out of date in it.  Members [View, FarZ]
+    // follow the camera, [TotalTime, DeltaTime] change every frame and [AmbientLight, Lights]
+    // only change with SetLights().
+    template<typename CopyFunc>
+    void Update(float totalTime, float deltaTime, CopyFunc copy);
+
+    const CommonConstants& GetConstants() const { return mConstants; }
+    const DirectX::XMFLOAT4X4& GetView() const { return mView; }
+    const DirectX::XMFLOAT4X4& GetProj() const { return mProj; }
+
+private:
+    // recomputes the camera-derived constants after the view or the projection changed.
+    void UpdateCamera();
+
+    CommonConstants mConstants;
+
+    DirectX::XMFLOAT3 mPosition = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 mTarget = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 mUp = { 0.0f, 1.0f, 0.0f };
+    DirectX::XMFLOAT4X4 mView = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 mProj = MathHelper::Identity4x4();
+    DirectX::XMFLOAT4X4 mInvProj = MathHelper::Identity4x4();
+
+    bool mViewDirty = true;
+    bool mProjDirty = true;
+    int mFrameBufferCount = 0;
+    int mCameraFramesDirty = 0;     // frame buffers whose view/projection part is stale
+    int mStaticFramesDirty = 0;     // frame buffers whose ambient light and light array are stale
+};
+
+template<typename CopyFunc>
+void CommonConstantsCache::Update(float totalTime, float deltaTime, CopyFunc copy)
+{
+    if(mViewDirty || mProjDirty)
+        UpdateCamera();
+
+    mConstants.TotalTime = totalTime;
+    mConstants.DeltaTime = deltaTime;
+
+    if(mCameraFramesDirty > 0)
+    {
+        copy(offsetof(CommonConstants, View), offsetof(CommonConstants, TotalTime) - offsetof(CommonConstants, View));
+        mCameraFramesDirty--;
+    }
+
+    copy(offsetof(CommonConstants, TotalTime),
+        offsetof(CommonConstants, AmbientLight) - offsetof(CommonConstants, TotalTime));
+
+    if(mStaticFramesDirty > 0)
+    {
+        copy(offsetof(CommonConstants, AmbientLight), sizeof(CommonConstants) - offsetof(CommonConstants, AmbientLight));
+        mStaticFramesDirty--;
+    }
+}
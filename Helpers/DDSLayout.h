@@ -0,0 +1,176 @@
+//--------------------------------------------------------------------------------------
+// File: DDSLayout.h
+//
+// The DDS file structures, header parsing and subresource layout used by
+// DDSTextureLoader.  None of it needs a device or the Direct3D runtime, so it also
+// builds outside Windows, where only dxgiformat.h (DirectX-Headers) is required.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <d3d12.h>
+#else
+#include <dxgiformat.h>
+#include <sal.h>
+#include <winerror.h>
+#endif
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+namespace DirectX
+{
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+
+#if defined(_WIN32)
+typedef D3D12_SUBRESOURCE_DATA DDSSubresourceData;
+#else
+// Same layout as D3D12_SUBRESOURCE_DATA.
+struct DDSSubresourceData
+{
+    const void* pData;
+    intptr_t    RowPitch;
+    intptr_t    SlicePitch;
+};
+#endif
+
+// Validates a DDS file held in memory and locates its texel data.  The headers are
+// only read in place, so this works directly on a mapped view of the file.
+HRESULT ParseDDSHeader( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                        _In_ size_t ddsDataSize,
+                        const DDS_HEADER** header,
+                        const uint8_t** bitData,
+                        size_t* bitSize
+                      );
+
+// Bits per pixel of a format, 0 for formats DDS files can't hold.
+size_t BitsPerPixel( _In_ DXGI_FORMAT fmt );
+
+// Size in bytes, row pitch and row count of one surface of a format.
+void GetSurfaceInfo( _In_ size_t width,
+                     _In_ size_t height,
+                     _In_ DXGI_FORMAT fmt,
+                     _Out_opt_ size_t* outNumBytes,
+                     _Out_opt_ size_t* outRowBytes,
+                     _Out_opt_ size_t* outNumRows );
+
+// Format of a DDS file without the DX10 header, DXGI_FORMAT_UNKNOWN if there is none.
+DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf );
+
+// Points one subresource per mip and array slice into bitData, skipping mips larger than
+// maxsize.  Returns the size of the first mip kept and the number of mips skipped.
+HRESULT FillInitData12( _In_ size_t width,
+                        _In_ size_t height,
+                        _In_ size_t depth,
+                        _In_ size_t mipCount,
+                        _In_ size_t arraySize,
+                        _In_ DXGI_FORMAT format,
+                        _In_ size_t maxsize,
+                        _In_ size_t bitSize,
+                        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                        _Out_ size_t& twidth,
+                        _Out_ size_t& theight,
+                        _Out_ size_t& tdepth,
+                        _Out_ size_t& skipMip,
+                        _Out_writes_(mipCount*arraySize) DDSSubresourceData* initData
+                      );
+
+} // namespace DirectX
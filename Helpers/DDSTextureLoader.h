@@ -24,7 +24,9 @@
 
 #include <wrl.h>
 #include <d3d11_1.h>
+#include <vector>
 #include "d3dx12.h"
+#include "MappedFile.h"
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -92,6 +94,50 @@ namespace DirectX
 		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                               );
 
+	// A DDS texture parsed and laid out on the CPU, ready to be turned into a resource.
+	// InitData points into the mapped File, which has to stay open until the upload is recorded.
+	struct DDSTextureData12
+	{
+		MappedFile File;
+		uint32_t ResDim = 0;
+		size_t Width = 0;
+		size_t Height = 0;
+		size_t Depth = 0;
+		size_t MipCount = 0;
+		size_t ArraySize = 0;
+		DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+		bool IsCubeMap = false;
+		DDS_ALPHA_MODE AlphaMode = DDS_ALPHA_MODE_UNKNOWN;
+		std::vector<D3D12_SUBRESOURCE_DATA> InitData;
+	};
+
+	// Split version of CreateDDSTextureFromFile12: loading needs no device and is safe to run on
+	// a worker thread, creating the resource and recording the upload has to happen on the thread
+	// owning cmdList.  Loading returns once the texel data is resident, not just mapped.
+	HRESULT LoadDDSTextureData12(_In_z_ const wchar_t* szFileName,
+		                         _In_ size_t maxsize,
+		                         _Out_ DDSTextureData12& data
+		                         );
+
+	HRESULT CreateDDSTextureFromData12(_In_ ID3D12Device* device,
+		                               _In_ ID3D12GraphicsCommandList* cmdList,
+		                               _In_ DDSTextureData12& data,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap
+		                               );
+
+	// Only creates the texture of a loaded DDS file, in the COMMON state, for callers that
+	// upload data.InitData from staging memory of their own.
+	HRESULT CreateDDSTextureResource12(_In_ ID3D12Device* device,
+		                               _In_ const DDSTextureData12& data,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture
+		                               );
+
+	// Description of the texture of a loaded DDS file, for callers creating the resource themselves.
+	HRESULT GetDDSTextureDesc12(_In_ const DDSTextureData12& data,
+		                        _Out_ D3D12_RESOURCE_DESC& texDesc
+		                        );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
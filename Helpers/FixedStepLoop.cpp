@@ -0,0 +1,75 @@
+//***************************************************************************************
+// FixedStepLoop.cpp
+//***************************************************************************************
+
+#include "FixedStepLoop.h"
+#include <cassert>
+#include <cmath>
+
+FixedStepLoop::FixedStepLoop(double stepRate, std::uint32_t maxStepsPerFrame)
+{
+    SetStepRate(stepRate);
+    SetMaxStepsPerFrame(maxStepsPerFrame);
+}
+
+void FixedStepLoop::SetStepRate(double stepRate)
+{
+    assert(stepRate >= 0.0);
+    mStepRate = stepRate;
+    mStepSeconds = stepRate > 0.0 ? 1.0 / stepRate : 0.0;
+    Reset();
+}
+
+void FixedStepLoop::SetMaxStepsPerFrame(std::uint32_t maxSteps)
+{
+    assert(maxSteps > 0);
+    mMaxStepsPerFrame = maxSteps;
+}
+
+std::uint32_t FixedStepLoop::Advance(double frameSeconds)
+{
+    // the first tick of a timer, or a clock going backwards.
+    if(frameSeconds < 0.0)
+        frameSeconds = 0.0;
+
+    if(!IsFixed())
+    {
+        mStepSeconds = frameSeconds;
+        mStepCount++;
+        return 1;
+    }
+
+    mAccumulator += frameSeconds;
+
+    std::uint32_t steps = 0;
+    while(mAccumulator >= mStepSeconds && steps < mMaxStepsPerFrame)
+    {
+        mAccumulator -= mStepSeconds;
+        steps++;
+    }
+
+    // keep less than a step, the rest is time the simulation can't catch up on.
+    if(mAccumulator >= mStepSeconds)
+    {
+        double kept = std::fmod(mAccumulator, mStepSeconds);
+        mDroppedSeconds += mAccumulator - kept;
+        mAccumulator = kept;
+    }
+
+    mStepCount += steps;
+    return steps;
+}
+
+float FixedStepLoop::GetAlpha()const
+{
+    if(!IsFixed())
+        return 1.0f;
+
+    float alpha = (float)(mAccumulator / mStepSeconds);
+    return alpha < 1.0f ? alpha : 0.99999994f;
+}
+
+void FixedStepLoop::Reset()
+{
+    mAccumulator = 0.0;
+}
@@ -0,0 +1,58 @@
+//***************************************************************************************
+// FixedStepLoop.h
+//
+// Decides how many simulation steps a frame runs.  With a fixed step rate the time of each
+// frame goes into an accumulator, and every whole step in it is simulated, so the simulation
+// advances by the same dt whatever the frame rate.  The time left over, less than a step, is
+// the interpolation alpha: the frame renders alpha of the way from the state before the last
+// step to the state after it.
+// A frame that would need more than MaxStepsPerFrame steps only runs that many and drops the
+// rest of its time, otherwise a slow step makes the next frame slower, which needs even more
+// steps (the spiral of death); the simulation slows down instead.
+// Without a step rate every frame runs one step of the frame time.
+// It only does arithmetic on the frame times it is given, so any clock can drive it.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+
+class FixedStepLoop
+{
+public:
+    // stepRate in steps per second, 0 runs one step per frame.
+    explicit FixedStepLoop(double stepRate = 0.0, std::uint32_t maxStepsPerFrame = 8);
+
+    void SetStepRate(double stepRate);
+    double GetStepRate()const { return mStepRate; }
+    bool IsFixed()const { return mStepRate > 0.0; }
+
+    void SetMaxStepsPerFrame(std::uint32_t maxSteps);
+    std::uint32_t GetMaxStepsPerFrame()const { return mMaxStepsPerFrame; }
+
+    // Adds the time of a frame and returns the number of steps to run for it.
+    std::uint32_t Advance(double frameSeconds);
+
+    // dt of every step, or of the step of the last frame without a step rate.
+    float GetStepSeconds()const { return (float)mStepSeconds; }
+
+    // How far the frame is between the last two states, in [0, 1), 1 without a step rate.
+    float GetAlpha()const;
+
+    std::uint64_t GetStepCount()const { return mStepCount; }
+
+    // frame time dropped by the MaxStepsPerFrame clamp so far.
+    double GetDroppedSeconds()const { return mDroppedSeconds; }
+
+    // Empties the accumulator, e.g. after a pause.
+    void Reset();
+
+private:
+    double mStepRate = 0.0;
+    double mStepSeconds = 0.0;
+    std::uint32_t mMaxStepsPerFrame = 8;
+
+    double mAccumulator = 0.0;
+    std::uint64_t mStepCount = 0;
+    double mDroppedSeconds = 0.0;
+};
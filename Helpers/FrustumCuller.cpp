@@ -0,0 +1,140 @@
+//***************************************************************************************
+// FrustumCuller.cpp
+//***************************************************************************************
+
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+void FrustumCuller::SetFrustum(FXMMATRIX view, CXMMATRIX proj)
+{
+    // Gribb-Hartmann plane extraction.  With row vectors, clip = p * M, so every plane is
+    // a combination of the columns of M = view * proj.
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, XMMatrixMultiply(view, proj));
+
+    XMVECTOR c0 = XMVectorSet(m._11, m._21, m._31, m._41);
+    XMVECTOR c1 = XMVectorSet(m._12, m._22, m._32, m._42);
+    XMVECTOR c2 = XMVectorSet(m._13, m._23, m._33, m._43);
+    XMVECTOR c3 = XMVectorSet(m._14, m._24, m._34, m._44);
+
+    XMVECTOR planes[6] =
+    {
+        XMVectorAdd(c3, c0),        // left
+        XMVectorSubtract(c3, c0),   // right
+        XMVectorAdd(c3, c1),        // bottom
+        XMVectorSubtract(c3, c1),   // top
+        c2,                         // near (z >= 0)
+        XMVectorSubtract(c3, c2)    // far
+    };
+
+    for(int i = 0; i < 6; ++i)
+        XMStoreFloat4(&mPlanes[i], XMPlaneNormalize(planes[i]));
+}
+
+void FrustumCuller::Clear()
+{
+    mCenterX.clear();
+    mCenterY.clear();
+    mCenterZ.clear();
+    mExtentX.clear();
+    mExtentY.clear();
+    mExtentZ.clear();
+
+    mBoxCount = 0;
+}
+
+std::uint32_t FrustumCuller::AddBox(const BoundingBox& localBounds, CXMMATRIX world)
+{
+    // Transform the center as a point, and bound the rotated/scaled box by
+    // summing the absolute values of the scaled basis vectors.
+    XMVECTOR c = XMVector3Transform(XMLoadFloat3(&localBounds.Center), world);
+
+    XMVECTOR e = XMVectorMultiply(XMVectorReplicate(localBounds.Extents.x), XMVectorAbs(world.r[0]));
+    e = XMVectorMultiplyAdd(XMVectorReplicate(localBounds.Extents.y), XMVectorAbs(world.r[1]), e);
+    e = XMVectorMultiplyAdd(XMVectorReplicate(localBounds.Extents.z), XMVectorAbs(world.r[2]), e);
+
+    XMFLOAT3 center, extents;
+    XMStoreFloat3(&center, c);
+    XMStoreFloat3(&extents, e);
+
+    mCenterX.push_back(center.x);
+    mCenterY.push_back(center.y);
+    mCenterZ.push_back(center.z);
+    mExtentX.push_back(extents.x);
+    mExtentY.push_back(extents.y);
+    mExtentZ.push_back(extents.z);
+
+    return mBoxCount++;
+}
+
+void FrustumCuller::Cull(std::vector<std::uint8_t>& visible)
+{
+    visible.resize(mBoxCount);
+
+    // Pad the columns so the loop below always reads whole groups of four.
+    size_t paddedCount = (mBoxCount + 3) & ~size_t(3);
+    mCenterX.resize(paddedCount, 0.0f);
+    mCenterY.resize(paddedCount, 0.0f);
+    mCenterZ.resize(paddedCount, 0.0f);
+    mExtentX.resize(paddedCount, 0.0f);
+    mExtentY.resize(paddedCount, 0.0f);
+    mExtentZ.resize(paddedCount, 0.0f);
+
+    // Splat every plane coefficient across a register once.
+    XMVECTOR a[6], b[6], c[6], d[6];
+    XMVECTOR absA[6], absB[6], absC[6];
+    for(int p = 0; p < 6; ++p)
+    {
+        a[p] = XMVectorReplicate(mPlanes[p].x);
+        b[p] = XMVectorReplicate(mPlanes[p].y);
+        c[p] = XMVectorReplicate(mPlanes[p].z);
+        d[p] = XMVectorReplicate(mPlanes[p].w);
+        absA[p] = XMVectorAbs(a[p]);
+        absB[p] = XMVectorAbs(b[p]);
+        absC[p] = XMVectorAbs(c[p]);
+    }
+
+    mStats = Stats();
+
+    XMVECTOR zero = XMVectorZero();
+    for(size_t i = 0; i < paddedCount; i += 4)
+    {
+        XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterX[i]));
+        XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterY[i]));
+        XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterZ[i]));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentX[i]));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentY[i]));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentZ[i]));
+
+        // A box is outside if it lies entirely behind any plane, i.e. the signed distance of
+        // its center plus its projected radius onto the plane normal is negative.
+        XMVECTOR inside = XMVectorTrueInt();
+        for(int p = 0; p < 6; ++p)
+        {
+            XMVECTOR dist = XMVectorMultiplyAdd(cx, a[p], XMVectorMultiplyAdd(cy, b[p], XMVectorMultiplyAdd(cz, c[p], d[p])));
+            XMVECTOR radius = XMVectorMultiplyAdd(ex, absA[p], XMVectorMultiplyAdd(ey, absB[p], XMVectorMultiply(ez, absC[p])));
+            inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorAdd(dist, radius), zero));
+        }
+
+        std::uint32_t lanes[4];
+        XMStoreInt4(lanes, inside);
+
+        for(size_t k = 0; k < 4 && i + k < mBoxCount; ++k)
+        {
+            visible[i + k] = lanes[k] != 0 ? 1 : 0;
+            if(lanes[k] != 0)
+                mStats.Visible++;
+            else
+                mStats.Culled++;
+        }
+    }
+
+    // Drop the padding so that boxes added after this call keep their indices.
+    mCenterX.resize(mBoxCount);
+    mCenterY.resize(mBoxCount);
+    mCenterZ.resize(mBoxCount);
+    mExtentX.resize(mBoxCount);
+    mExtentY.resize(mBoxCount);
+    mExtentZ.resize(mBoxCount);
+}
@@ -0,0 +1,60 @@
+//***************************************************************************************
+// FrustumCuller.h
+//
+// CPU view frustum culling of axis aligned bounding boxes.
+// Boxes are transformed into world space as they are added and stored in structure-of-arrays
+// form, so that Cull() can test four boxes against a frustum plane per SIMD instruction.
+// It only depends on DirectXMath, thus it can be driven without a window or a device.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class FrustumCuller
+{
+public:
+    struct Stats
+    {
+        std::uint32_t Visible = 0;
+        std::uint32_t Culled = 0;
+    };
+
+    FrustumCuller() = default;
+    FrustumCuller(const FrustumCuller& rhs) = delete;
+    FrustumCuller& operator=(const FrustumCuller& rhs) = delete;
+
+    // Extracts the six world space planes from view * projection (left-handed, z in [0, 1]).
+    void SetFrustum(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj);
+
+    // Removes all boxes, call once per frame before adding the current ones.
+    void Clear();
+
+    // Transforms a local space box by the world matrix and appends the resulting world space AABB.
+    // Returns the index of the box, which is also its index in the visibility array of Cull().
+    std::uint32_t AddBox(const DirectX::BoundingBox& localBounds, DirectX::CXMMATRIX world);
+
+    // Tests every box added since Clear().  visible[i] is set to 1 if box i intersects the frustum.
+    void Cull(std::vector<std::uint8_t>& visible);
+
+    std::uint32_t GetBoxCount() const { return mBoxCount; }
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    // plane i is stored as (a, b, c, d) with ax + by + cz + d >= 0 on the inner side.
+    DirectX::XMFLOAT4 mPlanes[6];
+
+    // box centers and extents in world space, padded to a multiple of 4 entries.
+    std::vector<float> mCenterX;
+    std::vector<float> mCenterY;
+    std::vector<float> mCenterZ;
+    std::vector<float> mExtentX;
+    std::vector<float> mExtentY;
+    std::vector<float> mExtentZ;
+
+    std::uint32_t mBoxCount = 0;
+    Stats mStats;
+};
@@ -4,12 +4,115 @@
 
 #include "GeometryGenerator.h"
 #include <algorithm>
+#include <cassert>
 
 using namespace DirectX;
 
+namespace
+{
+	const std::uint32_t NoEdge = ~0u;
+
+	// Maps an edge to the index of its midpoint.  Edges are hashed on their lower vertex index:
+	// every vertex heads a short chain of the edges to its higher neighbours, a handful of
+	// entries on a typical mesh, so lookups stay close to the vertices just visited.
+	class EdgeMidpointMap
+	{
+	public:
+		EdgeMidpointMap(std::size_t numVertices, std::size_t maxEdges) :
+			mFirstEdge(numVertices, NoEdge)
+		{
+			mEdges.reserve(maxEdges);
+		}
+
+		// Returns the midpoint of edge a-b, a < b, inserting newMidpoint if it has none yet.
+		std::uint32_t FindOrInsert(std::uint32_t a, std::uint32_t b, std::uint32_t newMidpoint, bool& inserted)
+		{
+			for(std::uint32_t e = mFirstEdge[a]; e != NoEdge; e = mEdges[e].Next)
+			{
+				if(mEdges[e].B == b)
+				{
+					inserted = false;
+					return mEdges[e].Midpoint;
+				}
+			}
+
+			Edge edge = { b, newMidpoint, mFirstEdge[a] };
+			mFirstEdge[a] = (std::uint32_t)mEdges.size();
+			mEdges.push_back(edge);
+
+			inserted = true;
+			return newMidpoint;
+		}
+
+	private:
+		struct Edge
+		{
+			std::uint32_t B;
+			std::uint32_t Midpoint;
+			std::uint32_t Next;
+		};
+
+		std::vector<std::uint32_t> mFirstEdge;
+		std::vector<Edge> mEdges;
+	};
+
+	// Grows v to hold count more elements.  Geometric growth, so appending several meshes
+	// to arrays the caller didn't reserve doesn't reallocate for every one of them.
+	template<typename T>
+	void ReserveAppend(std::vector<T>& v, std::size_t count)
+	{
+		std::size_t needed = v.size() + count;
+		if(needed > v.capacity())
+			v.reserve(std::max<std::size_t>(needed, 2*v.capacity()));
+	}
+}
+
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::BeginMesh(std::vector<Vertex>& vertices, std::vector<IndexT>& indices, const MeshSize& size)
+{
+	// a larger mesh would wrap its indices around when they are narrowed to IndexT.
+	assert(size.Vertices <= MaxVertexCount<IndexT>());
+
+	ReserveAppend(vertices, size.Vertices);
+	ReserveAppend(indices, size.Indices);
+
+	MeshRange range;
+	range.BaseVertex = (uint32)vertices.size();
+	range.StartIndex = (uint32)indices.size();
+	return range;
+}
+
+template<typename IndexT>
+void GeometryGenerator::EndMesh(const std::vector<Vertex>& vertices, const std::vector<IndexT>& indices, MeshRange& range)
+{
+	range.VertexCount = (uint32)vertices.size() - range.BaseVertex;
+	range.IndexCount = (uint32)indices.size() - range.StartIndex;
+}
+
+template<typename IndexT>
+void GeometryGenerator::AddTriangle(std::vector<IndexT>& indices, uint32 i0, uint32 i1, uint32 i2)
+{
+	indices.push_back(static_cast<IndexT>(i0));
+	indices.push_back(static_cast<IndexT>(i1));
+	indices.push_back(static_cast<IndexT>(i2));
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
+	CreateBox(width, height, depth, numSubdivisions, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
+
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
+    // Put a cap on the number of subdivisions.
+    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+
+	const MeshSize size = GetBoxSize(numSubdivisions);
+	MeshRange range = BeginMesh(vertices, indices, size);
 
     //
 	// Create the vertices.
@@ -57,52 +160,42 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
 	v[22] = Vertex(+w2, +h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
 	v[23] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
 
-	meshData.Vertices.assign(&v[0], &v[24]);
+	vertices.insert(vertices.end(), &v[0], &v[24]);
  
 	//
 	// Create the indices.
 	//
 
-	uint32 i[36];
-
-	// Fill in the front face index data
-	i[0] = 0; i[1] = 1; i[2] = 2;
-	i[3] = 0; i[4] = 2; i[5] = 3;
-
-	// Fill in the back face index data
-	i[6] = 4; i[7]  = 5; i[8]  = 6;
-	i[9] = 4; i[10] = 6; i[11] = 7;
-
-	// Fill in the top face index data
-	i[12] = 8; i[13] =  9; i[14] = 10;
-	i[15] = 8; i[16] = 10; i[17] = 11;
-
-	// Fill in the bottom face index data
-	i[18] = 12; i[19] = 13; i[20] = 14;
-	i[21] = 12; i[22] = 14; i[23] = 15;
-
-	// Fill in the left face index data
-	i[24] = 16; i[25] = 17; i[26] = 18;
-	i[27] = 16; i[28] = 18; i[29] = 19;
-
-	// Fill in the right face index data
-	i[30] = 20; i[31] = 21; i[32] = 22;
-	i[33] = 20; i[34] = 22; i[35] = 23;
-
-	meshData.Indices32.assign(&i[0], &i[36]);
+	// Every face is the quad of its four vertices: front, back, top, bottom, left, right.
+	for(uint32 face = 0; face < 6; ++face)
+	{
+		uint32 i = face*4;
+		AddTriangle(indices, i, i+1, i+2);
+		AddTriangle(indices, i, i+2, i+3);
+	}
 
-    // Put a cap on the number of subdivisions.
-    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	EndMesh(vertices, indices, range);
 
-    for(uint32 i = 0; i < numSubdivisions; ++i)
-        Subdivide(meshData);
+	for(uint32 i = 0; i < numSubdivisions; ++i)
+		Subdivide(vertices, indices, range);
 
-    return meshData;
+	assert(range.VertexCount == size.Vertices && range.IndexCount == size.Indices);
+    return range;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
+	CreateSphere(radius, sliceCount, stackCount, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
+
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
+	const MeshSize size = GetSphereSize(sliceCount, stackCount);
+	MeshRange range = BeginMesh(vertices, indices, size);
 
 	//
 	// Compute the vertices stating at the top pole and moving down the stacks.
@@ -114,7 +207,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-	meshData.Vertices.push_back( topVertex );
+	vertices.push_back( topVertex );
 
 	float phiStep   = XM_PI/stackCount;
 	float thetaStep = 2.0f*XM_PI/sliceCount;
@@ -150,11 +243,11 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 			v.TexC.x = theta / XM_2PI;
 			v.TexC.y = phi / XM_PI;
 
-			meshData.Vertices.push_back( v );
+			vertices.push_back( v );
 		}
 	}
 
-	meshData.Vertices.push_back( bottomVertex );
+	vertices.push_back( bottomVertex );
 
 	//
 	// Compute indices for top stack.  The top stack was written first to the vertex buffer
@@ -163,9 +256,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 
     for(uint32 i = 1; i <= sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(0);
-		meshData.Indices32.push_back(i+1);
-		meshData.Indices32.push_back(i);
+		AddTriangle(indices, 0, i+1, i);
 	}
 	
 	//
@@ -180,13 +271,15 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	{
 		for(uint32 j = 0; j < sliceCount; ++j)
 		{
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j+1);
+			AddTriangle(indices,
+				baseIndex + i*ringVertexCount + j,
+				baseIndex + i*ringVertexCount + j+1,
+				baseIndex + (i+1)*ringVertexCount + j);
+
+			AddTriangle(indices,
+				baseIndex + (i+1)*ringVertexCount + j,
+				baseIndex + i*ringVertexCount + j+1,
+				baseIndex + (i+1)*ringVertexCount + j+1);
 		}
 	}
 
@@ -196,30 +289,24 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	//
 
 	// South pole vertex was added last.
-	uint32 southPoleIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 southPoleIndex = (uint32)vertices.size()-1 - range.BaseVertex;
 
 	// Offset the indices to the index of the first vertex in the last ring.
 	baseIndex = southPoleIndex - ringVertexCount;
 	
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(southPoleIndex);
-		meshData.Indices32.push_back(baseIndex+i);
-		meshData.Indices32.push_back(baseIndex+i+1);
+		AddTriangle(indices, southPoleIndex, baseIndex+i, baseIndex+i+1);
 	}
 
-    return meshData;
+	EndMesh(vertices, indices, range);
+	assert(range.VertexCount == size.Vertices && range.IndexCount == size.Indices);
+    return range;
 }
  
-void GeometryGenerator::Subdivide(MeshData& meshData)
+template<typename IndexT>
+void GeometryGenerator::Subdivide(std::vector<Vertex>& vertices, std::vector<IndexT>& indices, MeshRange& range)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
-
-
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
-
 	//       v1
 	//       *
 	//      / \
@@ -230,48 +317,73 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
+	// The input vertices stay where they are and every edge gets one midpoint appended after
+	// them, shared by the triangles on both sides of the edge.  Edges are keyed by their two
+	// vertex indices, so seams that duplicate vertices (e.g. box corners) stay split.
+	// The mesh is the last one in both arrays, so it can grow in place.
+	assert(range.BaseVertex + range.VertexCount == vertices.size());
+	assert(range.StartIndex + range.IndexCount == indices.size());
+
+	const uint32 numVertices = range.VertexCount;
+	const uint32 numTris = range.IndexCount/3;
+
+	EdgeMidpointMap edgeMidpoints(numVertices, 3*(std::size_t)numTris);
+
+	// midpoint index of the edges v0-v1, v1-v2 and v0-v2 of each triangle.
+	std::vector<uint32> triMidpoints(3*numTris);
+	std::vector<std::pair<uint32, uint32>> midpointEdges;
+	midpointEdges.reserve(3*numTris);
+
 	for(uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
-
-		//
-		// Generate the midpoints.
-		//
-
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
-
-		//
-		// Add new geometry.
-		//
-
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
+		const IndexT* tri = &indices[range.StartIndex + i*3];
+		const uint32 edges[3][2] = { { tri[0], tri[1] }, { tri[1], tri[2] }, { tri[0], tri[2] } };
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
+		for(uint32 e = 0; e < 3; ++e)
+		{
+			uint32 a = std::min<uint32>(edges[e][0], edges[e][1]);
+			uint32 b = std::max<uint32>(edges[e][0], edges[e][1]);
+
+			bool inserted;
+			triMidpoints[i*3 + e] = edgeMidpoints.FindOrInsert(a, b, numVertices + (uint32)midpointEdges.size(), inserted);
+			if(inserted)
+				midpointEdges.emplace_back(a, b);
+		}
+	}
+
+	assert(numVertices + midpointEdges.size() <= MaxVertexCount<IndexT>());
 
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
+	ReserveAppend(vertices, midpointEdges.size());
+	for(const auto& edge : midpointEdges)
+	{
+		// copy the endpoints first, push_back may reallocate the storage they live in.
+		Vertex v0 = vertices[range.BaseVertex + edge.first];
+		Vertex v1 = vertices[range.BaseVertex + edge.second];
+		vertices.push_back(MidPoint(v0, v1));
+	}
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+	// Every triangle becomes four.  Going from the last triangle to the first, the four never
+	// overwrite a triangle that is still to be split.
+	indices.resize(range.StartIndex + 12*(std::size_t)numTris);
+	IndexT* tris = &indices[range.StartIndex];
+	for(uint32 i = numTris; i-- > 0; )
+	{
+		const IndexT v0 = tris[i*3+0];
+		const IndexT v1 = tris[i*3+1];
+		const IndexT v2 = tris[i*3+2];
+		const IndexT m0 = static_cast<IndexT>(triMidpoints[i*3+0]);
+		const IndexT m1 = static_cast<IndexT>(triMidpoints[i*3+1]);
+		const IndexT m2 = static_cast<IndexT>(triMidpoints[i*3+2]);
+
+		IndexT* out = &tris[i*12];
+
+		out[0] = v0;  out[1] = m0;  out[2] = m2;
+		out[3] = m0;  out[4] = m1;  out[5] = m2;
+		out[6] = m2;  out[7] = m1;  out[8] = v2;
+		out[9] = m0;  out[10] = v1; out[11] = m1;
 	}
+
+	EndMesh(vertices, indices, range);
 }
 
 GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1)
@@ -307,10 +419,20 @@ GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Ve
 GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions)
 {
     MeshData meshData;
+	CreateGeosphere(radius, numSubdivisions, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
 
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
 	// Put a cap on the number of subdivisions.
     numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
 
+	const MeshSize size = GetGeosphereSize(numSubdivisions);
+	MeshRange range = BeginMesh(vertices, indices, size);
+
 	// Approximate a sphere by tessellating an icosahedron.
 
 	const float X = 0.525731f; 
@@ -334,54 +456,73 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7 
 	};
 
-    meshData.Vertices.resize(12);
-    meshData.Indices32.assign(&k[0], &k[60]);
-
 	for(uint32 i = 0; i < 12; ++i)
-		meshData.Vertices[i].Position = pos[i];
+	{
+		Vertex v;
+		v.Position = pos[i];
+		vertices.push_back(v);
+	}
+
+	for(uint32 i = 0; i < 60; i += 3)
+		AddTriangle(indices, k[i], k[i+1], k[i+2]);
+
+	EndMesh(vertices, indices, range);
 
 	for(uint32 i = 0; i < numSubdivisions; ++i)
-		Subdivide(meshData);
+		Subdivide(vertices, indices, range);
+
+	// shared midpoints give the closed mesh its minimal 10*4^n + 2 vertices.
+	assert(range.VertexCount == size.Vertices && range.IndexCount == size.Indices);
 
 	// Project vertices onto sphere and scale.
-	for(uint32 i = 0; i < meshData.Vertices.size(); ++i)
+	for(uint32 i = range.BaseVertex; i < vertices.size(); ++i)
 	{
 		// Project onto unit sphere.
-		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&meshData.Vertices[i].Position));
+		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&vertices[i].Position));
 
 		// Project onto sphere.
 		XMVECTOR p = radius*n;
 
-		XMStoreFloat3(&meshData.Vertices[i].Position, p);
-		XMStoreFloat3(&meshData.Vertices[i].Normal, n);
+		XMStoreFloat3(&vertices[i].Position, p);
+		XMStoreFloat3(&vertices[i].Normal, n);
 
 		// Derive texture coordinates from spherical coordinates.
-        float theta = atan2f(meshData.Vertices[i].Position.z, meshData.Vertices[i].Position.x);
+        float theta = atan2f(vertices[i].Position.z, vertices[i].Position.x);
 
         // Put in [0, 2pi].
         if(theta < 0.0f)
             theta += XM_2PI;
 
-		float phi = acosf(meshData.Vertices[i].Position.y / radius);
+		float phi = acosf(vertices[i].Position.y / radius);
 
-		meshData.Vertices[i].TexC.x = theta/XM_2PI;
-		meshData.Vertices[i].TexC.y = phi/XM_PI;
+		vertices[i].TexC.x = theta/XM_2PI;
+		vertices[i].TexC.y = phi/XM_PI;
 
 		// Partial derivative of P with respect to theta
-		meshData.Vertices[i].TangentU.x = -radius*sinf(phi)*sinf(theta);
-		meshData.Vertices[i].TangentU.y = 0.0f;
-		meshData.Vertices[i].TangentU.z = +radius*sinf(phi)*cosf(theta);
+		vertices[i].TangentU.x = -radius*sinf(phi)*sinf(theta);
+		vertices[i].TangentU.y = 0.0f;
+		vertices[i].TangentU.z = +radius*sinf(phi)*cosf(theta);
 
-		XMVECTOR T = XMLoadFloat3(&meshData.Vertices[i].TangentU);
-		XMStoreFloat3(&meshData.Vertices[i].TangentU, XMVector3Normalize(T));
+		XMVECTOR T = XMLoadFloat3(&vertices[i].TangentU);
+		XMStoreFloat3(&vertices[i].TangentU, XMVector3Normalize(T));
 	}
 
-    return meshData;
+    return range;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
+	CreateCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
+
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
+	const MeshSize size = GetCylinderSize(sliceCount, stackCount);
+	MeshRange range = BeginMesh(vertices, indices, size);
 
 	//
 	// Build Stacks.
@@ -444,7 +585,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
 			XMStoreFloat3(&vertex.Normal, N);
 
-			meshData.Vertices.push_back(vertex);
+			vertices.push_back(vertex);
 		}
 	}
 
@@ -457,26 +598,31 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 	{
 		for(uint32 j = 0; j < sliceCount; ++j)
 		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-			meshData.Indices32.push_back(i*ringVertexCount + j+1);
+			AddTriangle(indices,
+				i*ringVertexCount + j,
+				(i+1)*ringVertexCount + j,
+				(i+1)*ringVertexCount + j+1);
+
+			AddTriangle(indices,
+				i*ringVertexCount + j,
+				(i+1)*ringVertexCount + j+1,
+				i*ringVertexCount + j+1);
 		}
 	}
 
-	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
+	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, range.BaseVertex, vertices, indices);
+	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, range.BaseVertex, vertices, indices);
 
-    return meshData;
+	EndMesh(vertices, indices, range);
+	assert(range.VertexCount == size.Vertices && range.IndexCount == size.Indices);
+    return range;
 }
 
-void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius, float height,
-											uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+template<typename IndexT>
+void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 baseVertex,
+											std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
 {
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
+	uint32 baseIndex = (uint32)vertices.size() - baseVertex;
 
 	float y = 0.5f*height;
 	float dTheta = 2.0f*XM_PI/sliceCount;
@@ -492,31 +638,30 @@ void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius,
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		vertices.push_back( Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
 	}
 
 	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
+	vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
 
 	// Index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = (uint32)vertices.size()-1 - baseVertex;
 
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i+1);
-		meshData.Indices32.push_back(baseIndex + i);
+		AddTriangle(indices, centerIndex, baseIndex + i+1, baseIndex + i);
 	}
 }
 
-void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadius, float height,
-											   uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+template<typename IndexT>
+void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 baseVertex,
+											   std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
 {
 	// 
 	// Build bottom cap.
 	//
 
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
+	uint32 baseIndex = (uint32)vertices.size() - baseVertex;
 	float y = -0.5f*height;
 
 	// vertices of ring
@@ -531,29 +676,34 @@ void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadi
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		vertices.push_back( Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
 	}
 
 	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
+	vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
 
 	// Cache the index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = (uint32)vertices.size()-1 - baseVertex;
 
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i);
-		meshData.Indices32.push_back(baseIndex + i+1);
+		AddTriangle(indices, centerIndex, baseIndex + i, baseIndex + i+1);
 	}
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n)
 {
     MeshData meshData;
+	CreateGrid(width, depth, m, n, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
 
-	uint32 vertexCount = m*n;
-	uint32 faceCount   = (m-1)*(n-1)*2;
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
+	const MeshSize size = GetGridSize(m, n);
+	MeshRange range = BeginMesh(vertices, indices, size);
 
 	//
 	// Create the vertices.
@@ -568,7 +718,8 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	float du = 1.0f / (n-1);
 	float dv = 1.0f / (m-1);
 
-	meshData.Vertices.resize(vertexCount);
+	vertices.resize(range.BaseVertex + size.Vertices);
+	Vertex* gridVertices = &vertices[range.BaseVertex];
 	for(uint32 i = 0; i < m; ++i)
 	{
 		float z = halfDepth - i*dz;
@@ -576,13 +727,13 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 		{
 			float x = -halfWidth + j*dx;
 
-			meshData.Vertices[i*n+j].Position = XMFLOAT3(x, 0.0f, z);
-			meshData.Vertices[i*n+j].Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.Vertices[i*n+j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+			gridVertices[i*n+j].Position = XMFLOAT3(x, 0.0f, z);
+			gridVertices[i*n+j].Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
+			gridVertices[i*n+j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
 
 			// Stretch texture over grid.
-			meshData.Vertices[i*n+j].TexC.x = j*du;
-			meshData.Vertices[i*n+j].TexC.y = i*dv;
+			gridVertices[i*n+j].TexC.x = j*du;
+			gridVertices[i*n+j].TexC.y = i*dv;
 		}
 	}
  
@@ -590,7 +741,8 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	// Create the indices.
 	//
 
-	meshData.Indices32.resize(faceCount*3); // 3 indices per face
+	indices.resize(range.StartIndex + size.Indices); // 3 indices per face
+	IndexT* gridIndices = &indices[range.StartIndex];
 
 	// Iterate over each quad and compute indices.
 	uint32 k = 0;
@@ -598,60 +750,83 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	{
 		for(uint32 j = 0; j < n-1; ++j)
 		{
-			meshData.Indices32[k]   = i*n+j;
-			meshData.Indices32[k+1] = i*n+j+1;
-			meshData.Indices32[k+2] = (i+1)*n+j;
+			gridIndices[k]   = static_cast<IndexT>(i*n+j);
+			gridIndices[k+1] = static_cast<IndexT>(i*n+j+1);
+			gridIndices[k+2] = static_cast<IndexT>((i+1)*n+j);
 
-			meshData.Indices32[k+3] = (i+1)*n+j;
-			meshData.Indices32[k+4] = i*n+j+1;
-			meshData.Indices32[k+5] = (i+1)*n+j+1;
+			gridIndices[k+3] = static_cast<IndexT>((i+1)*n+j);
+			gridIndices[k+4] = static_cast<IndexT>(i*n+j+1);
+			gridIndices[k+5] = static_cast<IndexT>((i+1)*n+j+1);
 
 			k += 6; // next quad
 		}
 	}
 
-    return meshData;
+	EndMesh(vertices, indices, range);
+    return range;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
 {
     MeshData meshData;
+	CreateQuad(x, y, w, h, depth, meshData.Vertices, meshData.Indices32);
+    return meshData;
+}
 
-	meshData.Vertices.resize(4);
-	meshData.Indices32.resize(6);
+template<typename IndexT>
+GeometryGenerator::MeshRange GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth,
+	std::vector<Vertex>& vertices, std::vector<IndexT>& indices)
+{
+	MeshRange range = BeginMesh(vertices, indices, GetQuadSize());
 
 	// Position coordinates specified in NDC space.
-	meshData.Vertices[0] = Vertex(
+	vertices.push_back(Vertex(
         x, y - h, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		0.0f, 1.0f);
+		0.0f, 1.0f));
 
-	meshData.Vertices[1] = Vertex(
+	vertices.push_back(Vertex(
 		x, y, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		0.0f, 0.0f);
+		0.0f, 0.0f));
 
-	meshData.Vertices[2] = Vertex(
+	vertices.push_back(Vertex(
 		x+w, y, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f);
+		1.0f, 0.0f));
 
-	meshData.Vertices[3] = Vertex(
+	vertices.push_back(Vertex(
 		x+w, y-h, depth,
 		0.0f, 0.0f, -1.0f,
 		1.0f, 0.0f, 0.0f,
-		1.0f, 1.0f);
+		1.0f, 1.0f));
 
-	meshData.Indices32[0] = 0;
-	meshData.Indices32[1] = 1;
-	meshData.Indices32[2] = 2;
+	AddTriangle(indices, 0, 1, 2);
+	AddTriangle(indices, 0, 2, 3);
 
-	meshData.Indices32[3] = 0;
-	meshData.Indices32[4] = 2;
-	meshData.Indices32[5] = 3;
-
-    return meshData;
+	EndMesh(vertices, indices, range);
+    return range;
 }
+
+// The generators are only built for the two index formats Direct3D reads.
+#define INSTANTIATE_GENERATORS(IndexT) \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateBox(float, float, float, uint32, \
+		std::vector<Vertex>&, std::vector<IndexT>&); \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateSphere(float, uint32, uint32, \
+		std::vector<Vertex>&, std::vector<IndexT>&); \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateGeosphere(float, uint32, \
+		std::vector<Vertex>&, std::vector<IndexT>&); \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateCylinder(float, float, float, uint32, uint32, \
+		std::vector<Vertex>&, std::vector<IndexT>&); \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateGrid(float, float, uint32, uint32, \
+		std::vector<Vertex>&, std::vector<IndexT>&); \
+	template GeometryGenerator::MeshRange GeometryGenerator::CreateQuad(float, float, float, float, float, \
+		std::vector<Vertex>&, std::vector<IndexT>&);
+
+INSTANTIATE_GENERATORS(GeometryGenerator::uint16)
+INSTANTIATE_GENERATORS(GeometryGenerator::uint32)
+
+#undef INSTANTIATE_GENERATORS
@@ -14,8 +14,12 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <DirectXMath.h>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 class GeometryGenerator
@@ -58,8 +62,11 @@ public:
 		std::vector<Vertex> Vertices;
         std::vector<uint32> Indices32;
 
+        // Narrowing copy of Indices32.  Prefer generating uint16 indices directly with the
+        // templated generators, this copies every index.
         std::vector<uint16>& GetIndices16()
         {
+			assert(Vertices.size() <= MaxVertexCount<uint16>());
 			if(mIndices16.empty())
 			{
 				mIndices16.resize(Indices32.size());
@@ -74,6 +81,74 @@ public:
 		std::vector<uint16> mIndices16;
 	};
 
+	///<summary>
+	/// Number of vertices and indices a generator emits for given parameters.
+	///</summary>
+	struct MeshSize
+	{
+		uint32 Vertices;
+		uint32 Indices;
+	};
+
+	///<summary>
+	/// Where a generated mesh landed in the vertex and index arrays it was appended to.  Its
+	/// indices are relative to BaseVertex, which is the base vertex location to draw it with.
+	///</summary>
+	struct MeshRange
+	{
+		uint32 BaseVertex = 0;
+		uint32 VertexCount = 0;
+		uint32 StartIndex = 0;
+		uint32 IndexCount = 0;
+	};
+
+	///<summary>
+	/// Largest vertex count a mesh indexed with IndexT can have.  Together with the Get*Size
+	/// functions it checks at compile time that a mesh fits 16-bit indices.
+	///</summary>
+	template<typename IndexT>
+	static constexpr std::size_t MaxVertexCount()
+	{
+		static_assert(std::is_same<IndexT, uint16>::value || std::is_same<IndexT, uint32>::value,
+			"meshes are indexed with uint16 or uint32");
+		return (std::size_t)std::numeric_limits<IndexT>::max() + 1;
+	}
+
+	static constexpr MeshSize GetBoxSize(uint32 numSubdivisions)
+	{
+		// every face is a quad subdivided into a (2^n+1)x(2^n+1) vertex grid.
+		uint32 n = numSubdivisions < 6u ? numSubdivisions : 6u;
+		uint32 side = (1u << n) + 1;
+		return MeshSize{ 6*side*side, 36u << (2*n) };
+	}
+
+	static constexpr MeshSize GetSphereSize(uint32 sliceCount, uint32 stackCount)
+	{
+		return MeshSize{ (stackCount-1)*(sliceCount+1) + 2, 6*sliceCount*(stackCount-1) };
+	}
+
+	static constexpr MeshSize GetGeosphereSize(uint32 numSubdivisions)
+	{
+		uint32 n = numSubdivisions < 6u ? numSubdivisions : 6u;
+		return MeshSize{ (10u << (2*n)) + 2, 60u << (2*n) };
+	}
+
+	static constexpr MeshSize GetCylinderSize(uint32 sliceCount, uint32 stackCount)
+	{
+		// side rings plus two caps of a ring and a center vertex each.
+		return MeshSize{ (stackCount+1)*(sliceCount+1) + 2*(sliceCount+2), 6*sliceCount*stackCount + 6*sliceCount };
+	}
+
+	static constexpr MeshSize GetGridSize(uint32 m, uint32 n)
+	{
+		return MeshSize{ m*n, 6*(m-1)*(n-1) };
+	}
+
+	static constexpr MeshSize GetQuadSize()
+	{
+		return MeshSize{ 4, 6 };
+	}
+
 	///<summary>
 	/// Creates a box centered at the origin with the given dimensions, where each
     /// face has m rows and n columns of vertices.
@@ -110,10 +185,48 @@ public:
 	///</summary>
     MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	///<summary>
+	/// Index type generic versions of the generators above.  They append the mesh to vertices
+	/// and indices, which may already hold other meshes, and emit IndexT (uint16 or uint32)
+	/// indices directly.  The vertex count of the mesh must fit IndexT, see MaxVertexCount.
+	/// Reserve the arrays for all meshes up front, with the Get*Size functions, to combine
+	/// several meshes without reallocating.
+	///</summary>
+	template<typename IndexT>
+	MeshRange CreateBox(float width, float height, float depth, uint32 numSubdivisions,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+	MeshRange CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+	MeshRange CreateGeosphere(float radius, uint32 numSubdivisions,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+	MeshRange CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+	MeshRange CreateGrid(float width, float depth, uint32 m, uint32 n,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+	MeshRange CreateQuad(float x, float y, float w, float h, float depth,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+
 private:
-	void Subdivide(MeshData& meshData);
+	template<typename IndexT>
+	static MeshRange BeginMesh(std::vector<Vertex>& vertices, std::vector<IndexT>& indices, const MeshSize& size);
+	template<typename IndexT>
+	static void EndMesh(const std::vector<Vertex>& vertices, const std::vector<IndexT>& indices, MeshRange& range);
+	template<typename IndexT>
+	static void AddTriangle(std::vector<IndexT>& indices, uint32 i0, uint32 i1, uint32 i2);
+
+	template<typename IndexT>
+	void Subdivide(std::vector<Vertex>& vertices, std::vector<IndexT>& indices, MeshRange& range);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-    void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
-    void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
+	template<typename IndexT>
+    void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 baseVertex,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
+	template<typename IndexT>
+    void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 baseVertex,
+		std::vector<Vertex>& vertices, std::vector<IndexT>& indices);
 };
 
@@ -0,0 +1,57 @@
+//***************************************************************************************
+// GeometryPacker.cpp
+//***************************************************************************************
+
+#include "GeometryPacker.h"
+#include <cassert>
+
+const std::uint32_t GeometryPacker::IndexAlignment;
+const std::uint32_t GeometryPacker::MinCapacity;
+
+GeometryPacker::GeometryPacker(std::uint32_t vertexByteStride) : mVertexByteStride(vertexByteStride)
+{
+    assert(vertexByteStride > 0);
+}
+
+std::uint32_t GeometryPacker::GrowCapacity(std::uint32_t capacity, std::uint32_t required)
+{
+    if(required <= capacity)
+        return capacity;
+
+    std::uint32_t grown = capacity < MinCapacity ? MinCapacity : capacity;
+    while(grown < required)
+        grown *= 2;
+    return grown;
+}
+
+void GeometryPacker::Reserve(std::uint32_t vertexCount, std::uint32_t indexCount)
+{
+    mVertices.reserve((std::size_t)GrowCapacity(GetVertexCapacity(), vertexCount) * mVertexByteStride);
+    mIndices.reserve(GrowCapacity(GetIndexCapacity(), indexCount));
+}
+
+GeometryPacker::Range GeometryPacker::Add(const void* vertices, std::uint32_t vertexCount,
+    const std::uint16_t* indices, std::uint32_t indexCount)
+{
+    assert(vertexCount > 0 && vertexCount <= 0x10000);
+
+    std::uint32_t startIndex = GetIndexCount();
+    if(startIndex % IndexAlignment != 0)
+        startIndex += IndexAlignment - startIndex % IndexAlignment;
+
+    Reserve(mVertexCount + vertexCount, startIndex + indexCount);
+
+    Range range;
+    range.IndexCount = indexCount;
+    range.StartIndexLocation = startIndex;
+    range.BaseVertexLocation = (std::int32_t)mVertexCount;
+
+    const std::uint8_t* vertexBytes = (const std::uint8_t*)vertices;
+    mVertices.insert(mVertices.end(), vertexBytes, vertexBytes + (std::size_t)vertexCount * mVertexByteStride);
+    mVertexCount += vertexCount;
+
+    mIndices.resize(startIndex, 0);
+    mIndices.insert(mIndices.end(), indices, indices + indexCount);
+
+    return range;
+}
@@ -0,0 +1,61 @@
+//***************************************************************************************
+// GeometryPacker.h
+//
+// CPU side of GeometryRegistry: appends meshes to one vertex array and one 16-bit index
+// array, and returns where each one landed.  Each mesh gets its own BaseVertexLocation, so its
+// indices stay local and 16 bits wide whatever the total vertex count.  Index ranges are
+// aligned, and both arrays grow geometrically, so adding many small meshes copies each byte a
+// bounded number of times.
+// It only touches CPU memory, so it needs no device.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GeometryPacker
+{
+public:
+    // index ranges start on a 4 byte boundary, so each range can also be read as raw 32-bit
+    // words (e.g. by a ByteAddressBuffer), the gap is padded with a zero index never drawn.
+    static const std::uint32_t IndexAlignment = 2;
+
+    // capacities grow to at least twice their size, starting from this many elements.
+    static const std::uint32_t MinCapacity = 1024;
+
+    // where a mesh was appended, as in SubmeshGeometry.
+    struct Range
+    {
+        std::uint32_t IndexCount = 0;
+        std::uint32_t StartIndexLocation = 0;
+        std::int32_t BaseVertexLocation = 0;
+    };
+
+    explicit GeometryPacker(std::uint32_t vertexByteStride);
+
+    void Reserve(std::uint32_t vertexCount, std::uint32_t indexCount);
+
+    // Appends a mesh of at most 65536 vertices.
+    Range Add(const void* vertices, std::uint32_t vertexCount, const std::uint16_t* indices, std::uint32_t indexCount);
+
+    std::uint32_t GetVertexByteStride()const { return mVertexByteStride; }
+    std::uint32_t GetVertexCount()const { return mVertexCount; }
+    std::uint32_t GetIndexCount()const { return (std::uint32_t)mIndices.size(); }
+    std::uint32_t GetVertexCapacity()const { return (std::uint32_t)(mVertices.capacity() / mVertexByteStride); }
+    std::uint32_t GetIndexCapacity()const { return (std::uint32_t)mIndices.capacity(); }
+
+    const std::uint8_t* GetVertexData()const { return mVertices.data(); }
+    const std::uint16_t* GetIndexData()const { return mIndices.data(); }
+
+    // Capacity to reserve so required elements fit, given the current capacity.
+    static std::uint32_t GrowCapacity(std::uint32_t capacity, std::uint32_t required);
+
+private:
+    std::uint32_t mVertexByteStride;
+    std::uint32_t mVertexCount = 0;
+
+    std::vector<std::uint8_t> mVertices;
+    std::vector<std::uint16_t> mIndices;
+};
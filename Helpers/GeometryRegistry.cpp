@@ -0,0 +1,71 @@
+//***************************************************************************************
+// GeometryRegistry.cpp
+//***************************************************************************************
+
+#include "GeometryRegistry.h"
+
+using namespace DirectX;
+
+GeometryRegistry::GeometryRegistry(UINT vertexByteStride) : mPacker(vertexByteStride)
+{
+}
+
+void GeometryRegistry::Reserve(UINT vertexCount, UINT indexCount)
+{
+    mPacker.Reserve(vertexCount, indexCount);
+}
+
+const SubmeshGeometry& GeometryRegistry::Add(const std::string& name, const void* vertices, UINT vertexCount,
+    const std::uint16_t* indices, UINT indexCount)
+{
+    assert(mPacker.GetVertexByteStride() >= sizeof(XMFLOAT3));
+
+    BoundingBox bounds;
+    BoundingBox::CreateFromPoints(bounds, vertexCount, (const XMFLOAT3*)vertices, mPacker.GetVertexByteStride());
+    return Add(name, vertices, vertexCount, indices, indexCount, bounds);
+}
+
+const SubmeshGeometry& GeometryRegistry::Add(const std::string& name, const void* vertices, UINT vertexCount,
+    const std::uint16_t* indices, UINT indexCount, const BoundingBox& bounds)
+{
+    assert(!Contains(name));
+
+    GeometryPacker::Range range = mPacker.Add(vertices, vertexCount, indices, indexCount);
+
+    SubmeshGeometry& submesh = mSubmeshes[name];
+    submesh.IndexCount = range.IndexCount;
+    submesh.StartIndexLocation = range.StartIndexLocation;
+    submesh.BaseVertexLocation = range.BaseVertexLocation;
+    submesh.Bounds = bounds;
+
+    return submesh;
+}
+
+std::unique_ptr<MeshGeometry> GeometryRegistry::Build(const std::string& name, UploadManager& uploadManager)const
+{
+    assert(mPacker.GetVertexCount() > 0 && mPacker.GetIndexCount() > 0);
+
+    const UINT vbByteSize = mPacker.GetVertexCount() * mPacker.GetVertexByteStride();
+    const UINT ibByteSize = mPacker.GetIndexCount() * sizeof(std::uint16_t);
+
+    auto geo = std::make_unique<MeshGeometry>();
+    geo->Name = name;
+
+    ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+    CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), mPacker.GetVertexData(), vbByteSize);
+
+    ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+    CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), mPacker.GetIndexData(), ibByteSize);
+
+    geo->VertexBufferGPU = uploadManager.CreateDefaultBuffer(mPacker.GetVertexData(), vbByteSize);
+    geo->IndexBufferGPU = uploadManager.CreateDefaultBuffer(mPacker.GetIndexData(), ibByteSize);
+
+    geo->VertexByteStride = mPacker.GetVertexByteStride();
+    geo->VertexBufferByteSize = vbByteSize;
+    geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+    geo->IndexBufferByteSize = ibByteSize;
+
+    geo->DrawArgs = mSubmeshes;
+
+    return geo;
+}
@@ -0,0 +1,48 @@
+//***************************************************************************************
+// GeometryRegistry.h
+//
+// Packs every static mesh into one shared vertex buffer and one shared 16-bit index buffer,
+// so all of them are drawn with the same input assembler bindings.  Each mesh is appended
+// at its own BaseVertexLocation, which keeps its indices local and 16 bits wide even when
+// the shared buffer holds more than 65536 vertices.
+// Meshes are collected on the CPU first, by a GeometryPacker that does the packing,
+// alignment and growth; Build() creates the GPU buffers once everything has been added.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryPacker.h"
+#include "UploadManager.h"
+
+class GeometryRegistry
+{
+public:
+    GeometryRegistry(UINT vertexByteStride);
+    GeometryRegistry(const GeometryRegistry& rhs) = delete;
+    GeometryRegistry& operator=(const GeometryRegistry& rhs) = delete;
+
+    void Reserve(UINT vertexCount, UINT indexCount);
+
+    // Appends a mesh and returns its range in the shared buffers.  Each vertex must start
+    // with its position (3 floats), the bounds of the range are computed from it.
+    const SubmeshGeometry& Add(const std::string& name, const void* vertices, UINT vertexCount,
+        const std::uint16_t* indices, UINT indexCount);
+
+    // Same with the bounds given, for vertex formats whose position isn't 3 floats.
+    const SubmeshGeometry& Add(const std::string& name, const void* vertices, UINT vertexCount,
+        const std::uint16_t* indices, UINT indexCount, const DirectX::BoundingBox& bounds);
+
+    bool Contains(const std::string& name)const { return mSubmeshes.count(name) != 0; }
+    const SubmeshGeometry& Get(const std::string& name)const { return mSubmeshes.at(name); }
+
+    // Creates the shared buffers holding every mesh added so far, records their upload and
+    // returns them with one DrawArgs entry per mesh.
+    std::unique_ptr<MeshGeometry> Build(const std::string& name, UploadManager& uploadManager)const;
+
+    const GeometryPacker& GetPacker()const { return mPacker; }
+
+private:
+    GeometryPacker mPacker;
+    std::unordered_map<std::string, SubmeshGeometry> mSubmeshes;
+};
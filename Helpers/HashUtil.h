@@ -0,0 +1,60 @@
+//***************************************************************************************
+// HashUtil.h
+//
+// Small 64-bit FNV-1a hashing helpers used to build cache keys out of plain data
+// (pipeline descriptions, shader sources, compiled bytecode, ...).
+// No platform dependency, so it can be shared by tools and tests.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class HashUtil
+{
+public:
+    static const std::uint64_t OffsetBasis = 14695981039346656037ull;
+    static const std::uint64_t Prime = 1099511628211ull;
+
+    // Folds a byte range into a running hash.  Start a new hash with OffsetBasis.
+    static std::uint64_t Bytes(const void* data, std::size_t byteSize, std::uint64_t hash = OffsetBasis)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for(std::size_t i = 0; i < byteSize; ++i)
+        {
+            hash ^= p[i];
+            hash *= Prime;
+        }
+        return hash;
+    }
+
+    // Folds a trivially copyable value into a running hash.
+    // The value must not contain padding bytes with undefined contents.
+    template<typename T>
+    static std::uint64_t Value(const T& value, std::uint64_t hash = OffsetBasis)
+    {
+        return Bytes(&value, sizeof(T), hash);
+    }
+
+    // Folds a string, including its length so that ("ab", "c") and ("a", "bc") differ.
+    static std::uint64_t String(const std::string& str, std::uint64_t hash = OffsetBasis)
+    {
+        hash = Value<std::uint64_t>(str.size(), hash);
+        return Bytes(str.data(), str.size(), hash);
+    }
+
+    // 16 lower-case hexadecimal digits, handy as a file name.
+    static std::string ToHex(std::uint64_t hash)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string str(16, '0');
+        for(int i = 15; i >= 0; --i)
+        {
+            str[i] = digits[hash & 0xf];
+            hash >>= 4;
+        }
+        return str;
+    }
+};
@@ -0,0 +1,186 @@
+//***************************************************************************************
+// MappedFile.cpp
+//***************************************************************************************
+
+#include "MappedFile.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+void MappedFile::Prefetch(const std::uint8_t* begin, std::size_t size)const
+{
+    if(mData == nullptr || begin < mData || begin >= mData + mSize)
+        return;
+    size = std::min<std::size_t>(size, (std::size_t)(mData + mSize - begin));
+    if(size == 0)
+        return;
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const std::size_t pageSize = info.dwPageSize;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<std::uint8_t*>(begin);
+    range.NumberOfBytes = size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    const std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+
+    // madvise wants a page aligned start, the view itself is page aligned.
+    const std::size_t pageStart = (std::size_t)(begin - mData) / pageSize * pageSize;
+    madvise(const_cast<std::uint8_t*>(mData) + pageStart, (std::size_t)(begin - mData) - pageStart + size, MADV_WILLNEED);
+#endif
+
+    // the read ahead is only a hint; reading a byte of every page faults the rest in here.
+    const volatile std::uint8_t* bytes = begin;
+    for(std::size_t offset = 0; offset < size; offset += pageSize)
+        (void)bytes[offset];
+    (void)bytes[size - 1];
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    return Map(file);
+}
+
+bool MappedFile::Open(const wchar_t* path)
+{
+    Close();
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    return Map(file);
+}
+
+bool MappedFile::Map(void* file)
+{
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        mLastError = (int)::GetLastError();
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if(!GetFileSizeEx(file, &fileSize))
+    {
+        mLastError = (int)::GetLastError();
+        CloseHandle(file);
+        return false;
+    }
+    if(fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart > (unsigned long long)SIZE_MAX)
+    {
+        mLastError = ERROR_FILE_TOO_LARGE;
+        if(fileSize.QuadPart == 0)
+            mLastError = ERROR_HANDLE_EOF;
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping object keeps the file open, the file handle itself is no longer needed.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    mLastError = mapping == nullptr ? (int)::GetLastError() : 0;
+    CloseHandle(file);
+    if(mapping == nullptr)
+        return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(view == nullptr)
+    {
+        mLastError = (int)::GetLastError();
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mMapping = mapping;
+    mData = static_cast<const std::uint8_t*>(view);
+    mSize = (std::size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(mData != nullptr)
+        UnmapViewOfFile(mData);
+    if(mMapping != nullptr)
+        CloseHandle(mMapping);
+
+    mData = nullptr;
+    mSize = 0;
+    mMapping = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        mLastError = errno;
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        mLastError = errno;
+        close(fd);
+        return false;
+    }
+    if(st.st_size == 0)
+    {
+        mLastError = EINVAL;
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps a reference to the file, the descriptor can be closed right away.
+    void* view = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    mLastError = view == MAP_FAILED ? errno : 0;
+    close(fd);
+    if(view == MAP_FAILED)
+        return false;
+
+    // Loaders walk the file front to back once.
+    madvise(view, (std::size_t)st.st_size, MADV_SEQUENTIAL);
+
+    mData = static_cast<const std::uint8_t*>(view);
+    mSize = (std::size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(mData != nullptr)
+        munmap(const_cast<std::uint8_t*>(mData), mSize);
+
+    mData = nullptr;
+    mSize = 0;
+}
+
+#endif
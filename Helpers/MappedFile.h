@@ -0,0 +1,57 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only memory mapping of a whole file (a file mapping on Windows, mmap elsewhere).
+// The contents are paged in from the file cache on first access instead of being read into
+// a heap buffer, so loaders can parse and copy straight out of the view.  Prefetch() pages a
+// range in ahead of time, so the thread that copies it later doesn't wait for the disk.
+// The view stays valid until Close() or destruction.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+    ~MappedFile();
+
+    // Maps the file, returns false if it can't be opened or mapped (see GetLastError).
+    // An empty file is reported as a failure since it can't be mapped.
+    bool Open(const char* path);
+#if defined(_WIN32)
+    bool Open(const wchar_t* path);
+#endif
+
+    void Close();
+
+    bool IsOpen()const { return mData != nullptr; }
+
+    const std::uint8_t* Data()const { return mData; }
+    std::size_t Size()const { return mSize; }
+
+    // Pages in size bytes of the view from begin, clamped to the view, and blocks until they
+    // are resident: the OS is asked to read the range ahead, then one byte per page is touched.
+    void Prefetch(const std::uint8_t* begin, std::size_t size)const;
+
+    // GetLastError() on Windows, errno elsewhere, of the last failed Open.
+    int GetLastError()const { return mLastError; }
+
+private:
+#if defined(_WIN32)
+    bool Map(void* file);
+#endif
+
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+    int mLastError = 0;
+
+#if defined(_WIN32)
+    void* mMapping = nullptr;
+#endif
+};
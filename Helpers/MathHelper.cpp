@@ -5,12 +5,21 @@
 #include "MathHelper.h"
 #include <float.h>
 #include <cmath>
+#include <atomic>
 
 using namespace DirectX;
 
 const float MathHelper::Infinity = FLT_MAX;
 const float MathHelper::Pi       = 3.1415926535f;
 
+RandomStream& MathHelper::GetRandomStream()
+{
+	// every thread gets a stream of its own, numbered in the order the threads first draw.
+	static std::atomic<std::uint32_t> threadCount(0);
+	thread_local RandomStream stream(threadCount++);
+	return stream;
+}
+
 float MathHelper::AngleFromXY(float x, float y)
 {
 	float theta = 0.0f;
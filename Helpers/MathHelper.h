@@ -6,9 +6,12 @@
 
 #pragma once
 
+#if defined(_WIN32)
 #include <Windows.h>
+#endif
 #include <DirectXMath.h>
 #include <cstdint>
+#include "RandomStream.h"
 
 class MathHelper
 {
@@ -17,21 +20,26 @@ public:
 	
 	static float RandF()
 	{
-		return (float)(rand()) / (float)RAND_MAX;
+		return GetRandomStream().NextFloat();
 	}
 	
 
 	// Returns random float in [a, b).
 	static float RandF(float a, float b)
 	{
-		return a + RandF()*(b-a);
+		return GetRandomStream().NextFloat(a, b);
 	}
 
+    // Returns random int in [a, b].
     static int Rand(int a, int b)
     {
-        return a + rand() % ((b - a) + 1);
+        return GetRandomStream().NextInt(a, b);
     }
 
+    // Stream of the calling thread the functions above draw from.  Code that needs reproducible
+    // numbers should own a RandomStream instead.
+    static RandomStream& GetRandomStream();
+
 	template<typename T>
 	static T Min(const T& a, const T& b)
 	{
@@ -80,6 +88,21 @@ public:
         return DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(&det, A));
 	}
 
+	// Inverse of a rigid transform (orthonormal rotation followed by a translation), e.g. a view
+	// matrix.  The rotation block is simply transposed and the translation rotated back, so no
+	// determinant or cofactor expansion is needed as in XMMatrixInverse.
+	static DirectX::XMMATRIX InverseRigid(DirectX::CXMMATRIX M)
+	{
+		DirectX::XMMATRIX R = M;
+		R.r[3] = DirectX::g_XMIdentityR3;
+		R = DirectX::XMMatrixTranspose(R);
+
+		DirectX::XMVECTOR t = DirectX::XMVector3TransformNormal(DirectX::XMVectorNegate(M.r[3]), R);
+		R.r[3] = DirectX::XMVectorSetW(t, 1.0f);
+
+		return R;
+	}
+
     static DirectX::XMFLOAT4X4 Identity4x4()
     {
         static DirectX::XMFLOAT4X4 I(
@@ -0,0 +1,455 @@
+//***************************************************************************************
+// MeshOptimizer.cpp
+//***************************************************************************************
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using std::size_t;
+using std::uint32_t;
+
+namespace
+{
+    // LRU size the Forsyth scores are tuned for, larger than the simulated FIFO on purpose.
+    const uint32_t ForsythCacheSize = 32;
+
+    float ForsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+        if(remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if(cachePosition >= 0)
+        {
+            // the vertices of the last triangle get a fixed score, so the next triangle doesn't
+            // simply reuse the same edge over and over.
+            if(cachePosition < 3)
+            {
+                score = 0.75f;
+            }
+            else
+            {
+                float scale = 1.0f / (ForsythCacheSize - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scale, 1.5f);
+            }
+        }
+
+        // vertices with few triangles left are finished first, so they leave the cache for good.
+        score += 2.0f * std::pow((float)remainingTriangles, -0.5f);
+
+        return score;
+    }
+
+    // FIFO cache simulation by timestamps: a vertex is cached while fewer than cacheSize
+    // misses happened since it was loaded.
+    struct FifoCache
+    {
+        FifoCache(size_t vertexCount, uint32_t cacheSize) :
+            Timestamps(vertexCount, 0), Time(cacheSize + 1), Size(cacheSize) {}
+
+        bool Access(uint32_t vertex)
+        {
+            if(Time - Timestamps[vertex] > Size)
+            {
+                Timestamps[vertex] = Time++;
+                return false;
+            }
+            return true;
+        }
+
+        template<typename IndexT>
+        uint32_t AccessTriangle(const IndexT* triangle)
+        {
+            return (Access(triangle[0]) ? 0 : 1) + (Access(triangle[1]) ? 0 : 1) + (Access(triangle[2]) ? 0 : 1);
+        }
+
+        void Flush() { Time += Size + 1; }
+
+        std::vector<uint32_t> Timestamps;
+        uint32_t Time;
+        uint32_t Size;
+    };
+
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    Float3 Position(const float* positions, size_t positionStride, uint32_t vertex)
+    {
+        const float* p = (const float*)((const char*)positions + vertex * positionStride);
+        return Float3{ p[0], p[1], p[2] };
+    }
+}
+
+template<typename IndexT>
+MeshOptimizer::CacheStats MeshOptimizer::SimulateVertexCache(const IndexT* indices, size_t indexCount,
+    size_t vertexCount, uint32_t cacheSize)
+{
+    assert(indexCount % 3 == 0);
+
+    CacheStats stats;
+    stats.Triangles = (uint32_t)(indexCount / 3);
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    for(size_t i = 0; i < indexCount; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        if(!cache.Access(indices[i]))
+            stats.Misses++;
+        if(!referenced[indices[i]])
+        {
+            referenced[indices[i]] = true;
+            stats.Vertices++;
+        }
+    }
+
+    if(stats.Triangles > 0)
+        stats.Acmr = (float)stats.Misses / stats.Triangles;
+    if(stats.Vertices > 0)
+        stats.Atvr = (float)stats.Misses / stats.Vertices;
+
+    return stats;
+}
+
+template<typename IndexT>
+void MeshOptimizer::OptimizeVertexCache(IndexT* indices, size_t indexCount, size_t vertexCount)
+{
+    assert(indexCount % 3 == 0);
+    const size_t triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+        return;
+
+    // triangles using each vertex, the live ones are kept at the front of each list.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for(size_t i = 0; i < indexCount; ++i)
+        remaining[indices[i]]++;
+
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+    std::vector<uint32_t> vertexTriangles(indexCount);
+    std::vector<uint32_t> filled(vertexCount, 0);
+    for(size_t t = 0; t < triangleCount; ++t)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            uint32_t v = indices[t * 3 + k];
+            vertexTriangles[firstTriangle[v] + filled[v]++] = (uint32_t)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for(size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = ForsythVertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for(size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+            vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<IndexT> output;
+    output.reserve(indexCount);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(ForsythCacheSize + 3);
+    newCache.reserve(ForsythCacheSize + 3);
+
+    // the best triangle among those touching the cache, or the next unemitted one in input order.
+    size_t inputCursor = 0;
+    size_t best = 0;
+    float bestScore = triangleScore[0];
+    for(size_t t = 1; t < triangleCount; ++t)
+    {
+        if(triangleScore[t] > bestScore)
+        {
+            bestScore = triangleScore[t];
+            best = t;
+        }
+    }
+
+    for(size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if(bestScore < 0.0f)
+        {
+            while(emitted[inputCursor])
+                inputCursor++;
+            best = inputCursor;
+        }
+
+        const IndexT* triangle = indices + best * 3;
+        emitted[best] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        // the triangle's vertices go to the front of the LRU cache, it leaves their live lists.
+        newCache.assign(triangle, triangle + 3);
+        for(int k = 0; k < 3; ++k)
+        {
+            uint32_t v = triangle[k];
+            uint32_t* live = &vertexTriangles[firstTriangle[v]];
+            for(uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                if(live[i] == best)
+                {
+                    std::swap(live[i], live[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+        for(uint32_t v : cache)
+        {
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+        }
+        cache.swap(newCache);
+
+        // rescore what is in the cache, and what just fell out of it.
+        for(size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t v = cache[i];
+            cachePosition[v] = i < ForsythCacheSize ? (int)i : -1;
+
+            float newScore = ForsythVertexScore(cachePosition[v], remaining[v]);
+            float delta = newScore - vertexScore[v];
+            vertexScore[v] = newScore;
+
+            const uint32_t* live = &vertexTriangles[firstTriangle[v]];
+            for(uint32_t j = 0; j < remaining[v]; ++j)
+                triangleScore[live[j]] += delta;
+        }
+        if(cache.size() > ForsythCacheSize)
+            cache.resize(ForsythCacheSize);
+
+        bestScore = -1.0f;
+        for(uint32_t v : cache)
+        {
+            const uint32_t* live = &vertexTriangles[firstTriangle[v]];
+            for(uint32_t j = 0; j < remaining[v]; ++j)
+            {
+                if(triangleScore[live[j]] > bestScore)
+                {
+                    bestScore = triangleScore[live[j]];
+                    best = live[j];
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template<typename IndexT>
+void MeshOptimizer::OptimizeOverdraw(IndexT* indices, size_t indexCount, const float* positions,
+    size_t vertexCount, size_t positionStride, float threshold)
+{
+    assert(indexCount % 3 == 0);
+    const size_t triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+        return;
+
+    // hard boundaries: triangles missing all three vertices start over in the cache anyway.
+    std::vector<size_t> hardClusters;
+    FifoCache cache(vertexCount, DefaultCacheSize);
+    for(size_t t = 0; t < triangleCount; ++t)
+    {
+        if(cache.AccessTriangle(indices + t * 3) == 3)
+            hardClusters.push_back(t);
+    }
+    hardClusters.push_back(triangleCount);
+
+    // soft boundaries: cut a hard cluster wherever the part so far is within threshold of the
+    // ACMR of the whole cluster, smaller clusters sort better.
+    std::vector<size_t> clusters;
+    for(size_t c = 0; c + 1 < hardClusters.size(); ++c)
+    {
+        size_t start = hardClusters[c];
+        size_t end = hardClusters[c + 1];
+
+        cache.Flush();
+        uint32_t clusterMisses = 0;
+        for(size_t t = start; t < end; ++t)
+            clusterMisses += cache.AccessTriangle(indices + t * 3);
+        float clusterThreshold = threshold * clusterMisses / (float)(end - start);
+
+        cache.Flush();
+        clusters.push_back(start);
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for(size_t t = start; t < end; ++t)
+        {
+            runningMisses += cache.AccessTriangle(indices + t * 3);
+            runningTriangles++;
+
+            if(t + 1 < end && runningMisses <= clusterThreshold * runningTriangles)
+            {
+                clusters.push_back(t + 1);
+                runningMisses = 0;
+                runningTriangles = 0;
+                cache.Flush();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // area weighted centroid and normal of every cluster, and of the whole mesh.
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<Float3> clusterCentroid(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+    std::vector<Float3> clusterNormal(clusterCount, Float3{ 0.0f, 0.0f, 0.0f });
+    Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        float clusterArea = 0.0f;
+        Float3& centroid = clusterCentroid[c];
+        Float3& normal = clusterNormal[c];
+
+        for(size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            Float3 p0 = Position(positions, positionStride, indices[t * 3]);
+            Float3 p1 = Position(positions, positionStride, indices[t * 3 + 1]);
+            Float3 p2 = Position(positions, positionStride, indices[t * 3 + 2]);
+
+            Float3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            Float3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+            Float3 n = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+            float area = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            centroid.x += (p0.x + p1.x + p2.x) / 3.0f * area;
+            centroid.y += (p0.y + p1.y + p2.y) / 3.0f * area;
+            centroid.z += (p0.z + p1.z + p2.z) / 3.0f * area;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            clusterArea += area;
+        }
+
+        meshCentroid.x += centroid.x;
+        meshCentroid.y += centroid.y;
+        meshCentroid.z += centroid.z;
+        meshArea += clusterArea;
+
+        float invArea = clusterArea > 0.0f ? 1.0f / clusterArea : 0.0f;
+        centroid.x *= invArea;
+        centroid.y *= invArea;
+        centroid.z *= invArea;
+
+        float normalLength = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        float invLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+        normal.x *= invLength;
+        normal.y *= invLength;
+        normal.z *= invLength;
+    }
+
+    float invMeshArea = meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+    meshCentroid.x *= invMeshArea;
+    meshCentroid.y *= invMeshArea;
+    meshCentroid.z *= invMeshArea;
+
+    // clusters facing away from the centre are in front of the rest from most view directions.
+    std::vector<float> sortKey(clusterCount);
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        const Float3& centroid = clusterCentroid[c];
+        const Float3& normal = clusterNormal[c];
+        sortKey[c] = (centroid.x - meshCentroid.x) * normal.x + (centroid.y - meshCentroid.y) * normal.y +
+            (centroid.z - meshCentroid.z) * normal.z;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for(size_t c = 0; c < clusterCount; ++c)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(),
+        [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<IndexT> output;
+    output.reserve(indexCount);
+    for(size_t c : order)
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template<typename IndexT>
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(IndexT* indices, size_t indexCount, size_t vertexCount)
+{
+    const uint32_t Unused = ~0u;
+    std::vector<uint32_t> remap(vertexCount, Unused);
+
+    uint32_t next = 0;
+    for(size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t& newIndex = remap[indices[i]];
+        if(newIndex == Unused)
+            newIndex = next++;
+        indices[i] = static_cast<IndexT>(newIndex);
+    }
+
+    for(uint32_t& newIndex : remap)
+    {
+        if(newIndex == Unused)
+            newIndex = next++;
+    }
+
+    return remap;
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(GeometryGenerator::MeshData& mesh, bool reduceOverdraw)
+{
+    GeometryGenerator::MeshRange range;
+    range.VertexCount = (uint32_t)mesh.Vertices.size();
+    range.IndexCount = (uint32_t)mesh.Indices32.size();
+    return Optimize(mesh.Vertices, mesh.Indices32, range, reduceOverdraw);
+}
+
+template<typename IndexT>
+MeshOptimizer::Report MeshOptimizer::Optimize(std::vector<GeometryGenerator::Vertex>& vertices,
+    std::vector<IndexT>& indices, const GeometryGenerator::MeshRange& range, bool reduceOverdraw)
+{
+    assert(range.BaseVertex + range.VertexCount <= vertices.size());
+    assert(range.StartIndex + range.IndexCount <= indices.size());
+
+    IndexT* meshIndices = indices.data() + range.StartIndex;
+    GeometryGenerator::Vertex* meshVertices = vertices.data() + range.BaseVertex;
+    const size_t indexCount = range.IndexCount;
+    const size_t vertexCount = range.VertexCount;
+
+    Report report;
+    report.Before = SimulateVertexCache(meshIndices, indexCount, vertexCount);
+
+    OptimizeVertexCache(meshIndices, indexCount, vertexCount);
+    if(reduceOverdraw && vertexCount > 0)
+    {
+        OptimizeOverdraw(meshIndices, indexCount, &meshVertices[0].Position.x, vertexCount,
+            sizeof(GeometryGenerator::Vertex));
+    }
+
+    std::vector<uint32_t> remap = OptimizeVertexFetch(meshIndices, indexCount, vertexCount);
+    RemapVertices(meshVertices, vertexCount, remap);
+
+    report.After = SimulateVertexCache(meshIndices, indexCount, vertexCount);
+    return report;
+}
+
+#define INSTANTIATE_PASSES(IndexT) \
+    template MeshOptimizer::CacheStats MeshOptimizer::SimulateVertexCache(const IndexT*, size_t, size_t, uint32_t); \
+    template void MeshOptimizer::OptimizeVertexCache(IndexT*, size_t, size_t); \
+    template void MeshOptimizer::OptimizeOverdraw(IndexT*, size_t, const float*, size_t, size_t, float); \
+    template std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(IndexT*, size_t, size_t); \
+    template MeshOptimizer::Report MeshOptimizer::Optimize(std::vector<GeometryGenerator::Vertex>&, \
+        std::vector<IndexT>&, const GeometryGenerator::MeshRange&, bool);
+
+INSTANTIATE_PASSES(std::uint16_t)
+INSTANTIATE_PASSES(std::uint32_t)
+
+#undef INSTANTIATE_PASSES
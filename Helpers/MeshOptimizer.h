@@ -0,0 +1,91 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// Build time reordering of triangle meshes for the GPU:
+//  - OptimizeVertexCache: reorders triangles so they reuse recently transformed vertices
+//    (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+//  - OptimizeOverdraw: splits the cache optimized order into clusters and sorts them so
+//    outward facing clusters come first, which lets early depth rejection skip more pixels
+//    of convex meshes (Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality
+//    and Reduced Overdraw").  Only a little vertex cache efficiency is traded for it.
+//  - OptimizeVertexFetch: renumbers vertices in the order the indices first use them, so the
+//    input assembler reads the vertex buffer mostly sequentially.
+// SimulateVertexCache measures an index order on a FIFO post-transform cache, no GPU needed.
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GeometryGenerator.h"
+
+namespace MeshOptimizer
+{
+    // FIFO size of the simulated post-transform cache, a conservative size for current GPUs.
+    const std::uint32_t DefaultCacheSize = 16;
+
+    struct CacheStats
+    {
+        std::uint32_t Triangles = 0;
+        std::uint32_t Vertices = 0;     // distinct vertices referenced
+        std::uint32_t Misses = 0;       // vertices transformed
+
+        float Acmr = 0.0f;              // average cache miss ratio: misses per triangle, 3 at worst
+        float Atvr = 0.0f;              // average transformed vertex ratio: misses per vertex, 1 at best
+    };
+
+    struct Report
+    {
+        CacheStats Before;
+        CacheStats After;
+    };
+
+    // The passes take 16 or 32-bit indices, IndexT is std::uint16_t or std::uint32_t.
+    template<typename IndexT>
+    CacheStats SimulateVertexCache(const IndexT* indices, std::size_t indexCount,
+        std::size_t vertexCount, std::uint32_t cacheSize = DefaultCacheSize);
+
+    template<typename IndexT>
+    void OptimizeVertexCache(IndexT* indices, std::size_t indexCount, std::size_t vertexCount);
+
+    // Expects a vertex cache optimized order.  positions holds vertexCount float3 positions
+    // positionStride bytes apart.  A cluster may be up to threshold times worse in ACMR than
+    // the order it is cut from, 1 keeps the vertex cache efficiency untouched.
+    template<typename IndexT>
+    void OptimizeOverdraw(IndexT* indices, std::size_t indexCount, const float* positions,
+        std::size_t vertexCount, std::size_t positionStride, float threshold = 1.05f);
+
+    // Renumbers the indices in first use order and returns the new index of each vertex,
+    // vertices the indices never use are moved to the end.
+    template<typename IndexT>
+    std::vector<std::uint32_t> OptimizeVertexFetch(IndexT* indices, std::size_t indexCount,
+        std::size_t vertexCount);
+
+    // Moves vertices to the positions remap gives them.
+    template<typename VertexT>
+    void RemapVertices(VertexT* vertices, std::size_t vertexCount, const std::vector<std::uint32_t>& remap)
+    {
+        std::vector<VertexT> remapped(vertexCount);
+        for(std::size_t i = 0; i < vertexCount; ++i)
+            remapped[remap[i]] = vertices[i];
+        std::copy(remapped.begin(), remapped.end(), vertices);
+    }
+
+    template<typename VertexT>
+    void RemapVertices(std::vector<VertexT>& vertices, const std::vector<std::uint32_t>& remap)
+    {
+        RemapVertices(vertices.data(), vertices.size(), remap);
+    }
+
+    // Runs the passes above over a generated mesh.  Must run before MeshData::GetIndices16(),
+    // which caches the 16-bit copy of the indices.
+    Report Optimize(GeometryGenerator::MeshData& mesh, bool reduceOverdraw);
+
+    // Same for one mesh the templated GeometryGenerator functions appended to shared arrays,
+    // only the vertices and indices of range are reordered.
+    template<typename IndexT>
+    Report Optimize(std::vector<GeometryGenerator::Vertex>& vertices, std::vector<IndexT>& indices,
+        const GeometryGenerator::MeshRange& range, bool reduceOverdraw);
+}
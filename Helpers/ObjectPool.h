@@ -0,0 +1,163 @@
+//***************************************************************************************
+// ObjectPool.h
+//
+// Fixed capacity pool of objects, all constructed up front and handed out again and again.
+// Free objects are kept on a stack, so Acquire() and Release() are O(1) and never allocate,
+// and the indices of the live objects are kept packed, so iterating them costs nothing for
+// the free ones.
+// Objects are referred to by 32-bit handles: the index of the object in the low IndexBits
+// bits and, in the others, a generation that changes each time the object is released, so
+// stale handles are detected.  A handle fits in a column of an EntityStore.
+// A released object keeps its state, whoever acquires it sets up what it needs.
+//***************************************************************************************
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+template<typename T>
+class ObjectPool
+{
+public:
+    using Handle = std::uint32_t;
+
+    static constexpr std::uint32_t IndexBits = 20;
+    static constexpr std::uint32_t GenerationBits = 32 - IndexBits;
+    static constexpr std::uint32_t MaxCapacity = (1u << IndexBits) - 1;
+
+    // handle of no object, Acquire() returns it when the pool is full.
+    static constexpr Handle InvalidHandle = ~0u;
+
+    explicit ObjectPool(std::uint32_t capacity = 0)
+    {
+        Reset(capacity);
+    }
+
+    ObjectPool(const ObjectPool& rhs) = delete;
+    ObjectPool& operator=(const ObjectPool& rhs) = delete;
+
+    // Frees every object and default constructs capacity new ones, old handles become stale.
+    void Reset(std::uint32_t capacity)
+    {
+        assert(capacity <= MaxCapacity);
+
+        mObjects.clear();
+        mObjects.resize(capacity);
+        mLive.clear();
+        mLive.reserve(capacity);
+        mDenseIndex.assign(capacity, 0);
+
+        // generations go on from the old ones, so handles of the previous objects stay stale.
+        mGenerations.resize(capacity, 0);
+        for(std::uint32_t& generation : mGenerations)
+            generation = (generation + 1) & GenerationMask;
+
+        // handed out from the back, lowest index first.
+        mFree.resize(capacity);
+        for(std::uint32_t i = 0; i < capacity; ++i)
+            mFree[i] = capacity - 1 - i;
+    }
+
+    // Takes a free object, InvalidHandle if they are all in use.
+    Handle Acquire()
+    {
+        if(mFree.empty())
+            return InvalidHandle;
+
+        std::uint32_t index = mFree.back();
+        mFree.pop_back();
+
+        mDenseIndex[index] = (std::uint32_t)mLive.size();
+        mLive.push_back(index);
+        return (mGenerations[index] << IndexBits) | index;
+    }
+
+    void Release(Handle handle)
+    {
+        assert(IsAlive(handle));
+        std::uint32_t index = IndexOf(handle);
+
+        // the last live index fills the hole.
+        std::uint32_t dense = mDenseIndex[index];
+        std::uint32_t last = mLive.back();
+        mLive[dense] = last;
+        mDenseIndex[last] = dense;
+        mLive.pop_back();
+
+        mGenerations[index] = (mGenerations[index] + 1) & GenerationMask;
+        mFree.push_back(index);
+    }
+
+    // Whether handle refers to a live object.  Generations wrap: once its object has been
+    // released 2^GenerationBits (4096) times, a stale handle looks live again, to whatever
+    // object holds the index then.  At 60 steps per second a slot reused every step wraps in
+    // about a minute, so handles are only kept while their object is known to be live (the
+    // EntityStore entity that owns the slot), never to find out later whether it still is.
+    bool IsAlive(Handle handle)const
+    {
+        std::uint32_t index = IndexOf(handle);
+        return handle != InvalidHandle && index < Capacity() && mGenerations[index] == (handle >> IndexBits) &&
+            mDenseIndex[index] < mLive.size() && mLive[mDenseIndex[index]] == index;
+    }
+
+    // index of the object in [0, Capacity()), it doesn't change while the object is live.
+    static std::uint32_t IndexOf(Handle handle) { return handle & IndexMask; }
+
+    T& Get(Handle handle)
+    {
+        assert(IsAlive(handle));
+        return mObjects[IndexOf(handle)];
+    }
+
+    const T& Get(Handle handle)const
+    {
+        assert(IsAlive(handle));
+        return mObjects[IndexOf(handle)];
+    }
+
+    // Object by index, live or not, e.g. to set up the objects after Reset().
+    T& At(std::uint32_t index) { return mObjects[index]; }
+    const T& At(std::uint32_t index)const { return mObjects[index]; }
+
+    std::uint32_t Capacity()const { return (std::uint32_t)mObjects.size(); }
+    std::uint32_t Size()const { return (std::uint32_t)mLive.size(); }
+    bool Empty()const { return mLive.empty(); }
+    bool Full()const { return mFree.empty(); }
+
+    // Calls visit with every live object, in no particular order.  It must not acquire or
+    // release objects.
+    template<typename Visit>
+    void ForEachLive(Visit visit)
+    {
+        for(std::uint32_t index : mLive)
+            visit(mObjects[index]);
+    }
+
+    template<typename Visit>
+    void ForEachLive(Visit visit)const
+    {
+        for(std::uint32_t index : mLive)
+            visit(mObjects[index]);
+    }
+
+private:
+    static constexpr std::uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr std::uint32_t GenerationMask = (1u << GenerationBits) - 1;
+
+    std::vector<T> mObjects;
+    std::vector<std::uint32_t> mGenerations;
+
+    // indices of the live objects, packed, and where each object is in there.
+    std::vector<std::uint32_t> mLive;
+    std::vector<std::uint32_t> mDenseIndex;
+
+    std::vector<std::uint32_t> mFree;
+};
+
+// definitions of the constants, for when they are bound to references before C++17.
+template<typename T> constexpr std::uint32_t ObjectPool<T>::IndexBits;
+template<typename T> constexpr std::uint32_t ObjectPool<T>::GenerationBits;
+template<typename T> constexpr std::uint32_t ObjectPool<T>::MaxCapacity;
+template<typename T> constexpr typename ObjectPool<T>::Handle ObjectPool<T>::InvalidHandle;
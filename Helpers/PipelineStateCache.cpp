@@ -0,0 +1,192 @@
+//***************************************************************************************
+// PipelineStateCache.cpp
+//***************************************************************************************
+
+#include "PipelineStateCache.h"
+#include "HashUtil.h"
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Appends plain data to a normalized description.
+    class DescWriter
+    {
+    public:
+        explicit DescWriter(std::vector<std::uint8_t>& bytes) : mBytes(bytes) {}
+
+        void Bytes(const void* data, std::size_t byteSize)
+        {
+            const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+            mBytes.insert(mBytes.end(), p, p + byteSize);
+        }
+
+        // The value must not contain padding bytes with undefined contents.
+        template<typename T>
+        void Value(const T& value)
+        {
+            Bytes(&value, sizeof(T));
+        }
+
+        // Written with its length so that ("ab", "c") and ("a", "bc") differ.
+        void String(const char* str)
+        {
+            std::size_t length = str != nullptr ? std::strlen(str) : 0;
+            Value<std::uint64_t>(length);
+            Bytes(str, length);
+        }
+
+    private:
+        std::vector<std::uint8_t>& mBytes;
+    };
+
+    // Shader bytecode is compared by content, not by the address of the blob holding it.
+    void WriteShader(const D3D12_SHADER_BYTECODE& shader, DescWriter& writer)
+    {
+        writer.Value<std::uint64_t>(shader.BytecodeLength);
+        if(shader.pShaderBytecode != nullptr)
+            writer.Bytes(shader.pShaderBytecode, shader.BytecodeLength);
+    }
+
+    // The blend, depth-stencil and input element descriptions contain padding bytes which are
+    // left uninitialized when the structures are filled on the stack, so every member is
+    // written out separately instead of copying the structures as a whole.
+    void WriteRenderTargetBlend(const D3D12_RENDER_TARGET_BLEND_DESC& rt, DescWriter& writer)
+    {
+        writer.Value(rt.BlendEnable);
+        writer.Value(rt.LogicOpEnable);
+        writer.Value(rt.SrcBlend);
+        writer.Value(rt.DestBlend);
+        writer.Value(rt.BlendOp);
+        writer.Value(rt.SrcBlendAlpha);
+        writer.Value(rt.DestBlendAlpha);
+        writer.Value(rt.BlendOpAlpha);
+        writer.Value(rt.LogicOp);
+        writer.Value(rt.RenderTargetWriteMask);
+    }
+
+    void WriteStencilOp(const D3D12_DEPTH_STENCILOP_DESC& op, DescWriter& writer)
+    {
+        writer.Value(op.StencilFailOp);
+        writer.Value(op.StencilDepthFailOp);
+        writer.Value(op.StencilPassOp);
+        writer.Value(op.StencilFunc);
+    }
+}
+
+PipelineStateCache::PipelineStateCache(ID3D12Device* device) : md3dDevice(device)
+{
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+}
+
+PipelineStateCache::Handle PipelineStateCache::GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    mScratch.clear();
+    NormalizeDesc(desc, mScratch);
+    std::uint64_t key = HashUtil::Bytes(mScratch.data(), mScratch.size());
+
+    // the hash only narrows the search, a hit is confirmed on the whole normalized description.
+    std::vector<Handle>& bucket = mHandles[key];
+    for(Handle handle : bucket)
+    {
+        if(mDescs[handle] == mScratch)
+        {
+            mHitCount++;
+            return handle;
+        }
+    }
+
+    ComPtr<ID3D12PipelineState> pso;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso.GetAddressOf())));
+
+    Handle handle = (Handle)mPipelineStates.size();
+    mPipelineStates.push_back(pso);
+    mDescs.push_back(mScratch);
+    bucket.push_back(handle);
+
+    return handle;
+}
+
+void PipelineStateCache::NormalizeDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::vector<std::uint8_t>& bytes)
+{
+    DescWriter writer(bytes);
+
+    // The root signature is an object, its identity is its address.
+    writer.Value(desc.pRootSignature);
+
+    WriteShader(desc.VS, writer);
+    WriteShader(desc.PS, writer);
+    WriteShader(desc.DS, writer);
+    WriteShader(desc.HS, writer);
+    WriteShader(desc.GS, writer);
+
+    writer.Value(desc.StreamOutput.NumEntries);
+    for(UINT i = 0; i < desc.StreamOutput.NumEntries; ++i)
+    {
+        const D3D12_SO_DECLARATION_ENTRY& e = desc.StreamOutput.pSODeclaration[i];
+        writer.Value(e.Stream);
+        writer.String(e.SemanticName);
+        writer.Value(e.SemanticIndex);
+        writer.Value(e.StartComponent);
+        writer.Value(e.ComponentCount);
+        writer.Value(e.OutputSlot);
+    }
+    writer.Value(desc.StreamOutput.NumStrides);
+    for(UINT i = 0; i < desc.StreamOutput.NumStrides; ++i)
+        writer.Value(desc.StreamOutput.pBufferStrides[i]);
+    writer.Value(desc.StreamOutput.RasterizedStream);
+
+    writer.Value(desc.BlendState.AlphaToCoverageEnable);
+    writer.Value(desc.BlendState.IndependentBlendEnable);
+    // Only render target 0 is used unless independent blending is on.
+    UINT blendCount = desc.BlendState.IndependentBlendEnable ? 8 : 1;
+    for(UINT i = 0; i < blendCount; ++i)
+        WriteRenderTargetBlend(desc.BlendState.RenderTarget[i], writer);
+
+    writer.Value(desc.SampleMask);
+
+    // D3D12_RASTERIZER_DESC is made of 4 byte members only, it has no padding.
+    writer.Value(desc.RasterizerState);
+
+    writer.Value(desc.DepthStencilState.DepthEnable);
+    writer.Value(desc.DepthStencilState.DepthWriteMask);
+    writer.Value(desc.DepthStencilState.DepthFunc);
+    writer.Value(desc.DepthStencilState.StencilEnable);
+    if(desc.DepthStencilState.StencilEnable)
+    {
+        writer.Value(desc.DepthStencilState.StencilReadMask);
+        writer.Value(desc.DepthStencilState.StencilWriteMask);
+        WriteStencilOp(desc.DepthStencilState.FrontFace, writer);
+        WriteStencilOp(desc.DepthStencilState.BackFace, writer);
+    }
+
+    writer.Value(desc.InputLayout.NumElements);
+    for(UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& e = desc.InputLayout.pInputElementDescs[i];
+        writer.String(e.SemanticName);
+        writer.Value(e.SemanticIndex);
+        writer.Value(e.Format);
+        writer.Value(e.InputSlot);
+        writer.Value(e.AlignedByteOffset);
+        writer.Value(e.InputSlotClass);
+        writer.Value(e.InstanceDataStepRate);
+    }
+
+    writer.Value(desc.IBStripCutValue);
+    writer.Value(desc.PrimitiveTopologyType);
+
+    writer.Value(desc.NumRenderTargets);
+    for(UINT i = 0; i < desc.NumRenderTargets; ++i)
+        writer.Value(desc.RTVFormats[i]);
+    writer.Value(desc.DSVFormat);
+    writer.Value(desc.SampleDesc);
+    writer.Value(desc.NodeMask);
+    writer.Value(desc.Flags);
+
+    // CachedPSO is an optimization hint, it doesn't change the resulting pipeline.
+}
@@ -0,0 +1,55 @@
+//***************************************************************************************
+// PipelineStateCache.h
+//
+// Creates graphics pipeline state objects on demand and shares them between callers
+// whose descriptions are identical.  A description is normalized by writing out its
+// members one by one, so padding never takes part, with pointers replaced by the data
+// they point to.  Two separately filled D3D12_GRAPHICS_PIPELINE_STATE_DESCs that would
+// produce the same PSO thus map to one ID3D12PipelineState and one integer handle.
+// The normalized bytes are kept next to each PSO: their hash only picks the candidates,
+// a hit is confirmed by comparing the bytes, so a hash collision can't share a PSO.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class PipelineStateCache
+{
+public:
+    using Handle = UINT;
+    static const Handle InvalidHandle = 0xffffffff;
+
+    PipelineStateCache(ID3D12Device* device);
+    PipelineStateCache(const PipelineStateCache& rhs) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache& rhs) = delete;
+    ~PipelineStateCache();
+
+    // Returns the handle of an existing PSO with an equivalent description, or creates one.
+    Handle GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    ID3D12PipelineState* Get(Handle handle)const
+    {
+        return mPipelineStates[handle].Get();
+    }
+
+    // number of distinct PSOs actually created.
+    UINT GetPipelineStateCount()const { return (UINT)mPipelineStates.size(); }
+
+    // number of GetOrCreate calls answered by an existing PSO.
+    UINT GetHitCount()const { return mHitCount; }
+
+    // Appends the normalized contents of desc to bytes.
+    static void NormalizeDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::vector<std::uint8_t>& bytes);
+
+private:
+    ID3D12Device* md3dDevice = nullptr;
+
+    // handles of the PSOs whose normalized descriptions have the same hash.
+    std::unordered_map<std::uint64_t, std::vector<Handle>> mHandles;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPipelineStates;
+    std::vector<std::vector<std::uint8_t>> mDescs;      // normalized description of each handle
+    std::vector<std::uint8_t> mScratch;                 // description being looked up
+
+    UINT mHitCount = 0;
+};
@@ -0,0 +1,214 @@
+//***************************************************************************************
+// PlacedResourceAllocator.cpp
+//***************************************************************************************
+
+#include "PlacedResourceAllocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+PlacedResourceAllocator::PlacedResourceAllocator(ID3D12Device* device, UINT64 heapSize) :
+    md3dDevice(device), mHeapSize(heapSize)
+{
+    // heaps are split in 4KB blocks, the smallest placement alignment, and hold MSAA resources.
+    assert(heapSize >= D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT && (heapSize & (heapSize - 1)) == 0);
+}
+
+PlacedResourceAllocator::~PlacedResourceAllocator()
+{
+}
+
+PlacedResourceAllocator::HeapKind PlacedResourceAllocator::KindOf(const D3D12_RESOURCE_DESC& desc)
+{
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        return HeapKind::Buffers;
+
+    if(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+        return HeapKind::RenderTargets;
+
+    return HeapKind::Textures;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO PlacedResourceAllocator::GetAllocationInfo(D3D12_RESOURCE_DESC& desc)const
+{
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+
+    // a texture may use the small alignment if its whole footprint fits in one large-alignment
+    // block, the device answers with the small alignment in that case and the default otherwise.
+    if(desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER &&
+        !(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)))
+    {
+        desc.Alignment = desc.SampleDesc.Count > 1 ?
+            D3D12_SMALL_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+
+        info = md3dDevice->GetResourceAllocationInfo(0, 1, &desc);
+        if(info.Alignment == desc.Alignment)
+            return info;
+    }
+
+    desc.Alignment = desc.SampleDesc.Count > 1 ?
+        D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    info = md3dDevice->GetResourceAllocationInfo(0, 1, &desc);
+    return info;
+}
+
+UINT PlacedResourceAllocator::CreateHeap(HeapKind kind)
+{
+    static const D3D12_HEAP_FLAGS kindFlags[(int)HeapKind::Count] =
+    {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+    };
+
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = mHeapSize;
+    heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    // the MSAA alignment lets every kind of resource be placed at 4MB boundaries.
+    heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = kindFlags[(int)kind];
+
+    Heap heap;
+    ThrowIfFailed(md3dDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.D3DHeap)));
+    heap.Allocator = std::make_unique<BuddyAllocator>(mHeapSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    mHeaps[(int)kind].push_back(std::move(heap));
+    return (UINT)mHeaps[(int)kind].size() - 1;
+}
+
+ComPtr<ID3D12Resource> PlacedResourceAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue)
+{
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info = GetAllocationInfo(placedDesc);
+
+    ComPtr<ID3D12Resource> resource;
+
+    if(info.SizeInBytes > mHeapSize)
+    {
+        placedDesc.Alignment = 0;
+        ThrowIfFailed(md3dDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &placedDesc,
+            initialState,
+            optimizedClearValue,
+            IID_PPV_ARGS(resource.GetAddressOf())));
+
+        Placement placement;
+        placement.Kind = KindOf(placedDesc);
+        placement.HeapIndex = CommittedHeapIndex;
+        placement.Offset = 0;
+        mPlacements[resource.Get()] = placement;
+
+        mCommittedCount++;
+        return resource;
+    }
+
+    HeapKind kind = KindOf(placedDesc);
+    std::vector<Heap>& heaps = mHeaps[(int)kind];
+
+    // first heap with room, a new heap if none has.
+    UINT heapIndex = 0;
+    UINT64 offset = BuddyAllocator::InvalidOffset;
+    for(; heapIndex < heaps.size(); ++heapIndex)
+    {
+        offset = heaps[heapIndex].Allocator->Allocate(info.SizeInBytes, info.Alignment);
+        if(offset != BuddyAllocator::InvalidOffset)
+            break;
+    }
+
+    if(offset == BuddyAllocator::InvalidOffset)
+    {
+        heapIndex = CreateHeap(kind);
+        offset = heaps[heapIndex].Allocator->Allocate(info.SizeInBytes, info.Alignment);
+        assert(offset != BuddyAllocator::InvalidOffset);
+    }
+
+    HRESULT hr = md3dDevice->CreatePlacedResource(heaps[heapIndex].D3DHeap.Get(), offset, &placedDesc,
+        initialState, optimizedClearValue, IID_PPV_ARGS(resource.GetAddressOf()));
+    if(FAILED(hr))
+    {
+        heaps[heapIndex].Allocator->Free(offset);
+        ThrowIfFailed(hr);
+    }
+
+    Placement placement;
+    placement.Kind = kind;
+    placement.HeapIndex = heapIndex;
+    placement.Offset = offset;
+    mPlacements[resource.Get()] = placement;
+
+    return resource;
+}
+
+void PlacedResourceAllocator::Release(ComPtr<ID3D12Resource>& resource)
+{
+    auto it = mPlacements.find(resource.Get());
+
+    ULONG references = resource.Reset();
+    assert(references == 0);
+    (void)references;
+
+    if(it == mPlacements.end())
+        return;
+
+    // committed fallbacks own their memory.
+    const Placement& placement = it->second;
+    if(placement.HeapIndex == CommittedHeapIndex)
+        mCommittedCount--;
+    else
+        mHeaps[(int)placement.Kind][placement.HeapIndex].Allocator->Free(placement.Offset);
+
+    mPlacements.erase(it);
+}
+
+PlacedResourceAllocator::Stats PlacedResourceAllocator::GetStats(HeapKind kind)const
+{
+    Stats stats;
+
+    for(const Heap& heap : mHeaps[(int)kind])
+    {
+        BuddyAllocator::Stats heapStats = heap.Allocator->GetStats();
+
+        stats.HeapCount++;
+        stats.HeapBytes += heapStats.TotalBytes;
+        stats.AllocatedBytes += heapStats.AllocatedBytes;
+        stats.RequestedBytes += heapStats.RequestedBytes;
+        stats.PlacedCount += heapStats.AllocationCount;
+
+        float fragmentation = heap.Allocator->GetFragmentation();
+        if(fragmentation > stats.Fragmentation)
+            stats.Fragmentation = fragmentation;
+    }
+
+    if(stats.HeapBytes > 0)
+        stats.Occupancy = (float)((double)stats.AllocatedBytes / (double)stats.HeapBytes);
+
+    return stats;
+}
+
+PlacedResourceAllocator::Stats PlacedResourceAllocator::GetStats()const
+{
+    Stats stats;
+
+    for(int i = 0; i < (int)HeapKind::Count; ++i)
+    {
+        Stats kindStats = GetStats((HeapKind)i);
+
+        stats.HeapCount += kindStats.HeapCount;
+        stats.HeapBytes += kindStats.HeapBytes;
+        stats.AllocatedBytes += kindStats.AllocatedBytes;
+        stats.RequestedBytes += kindStats.RequestedBytes;
+        stats.PlacedCount += kindStats.PlacedCount;
+
+        if(kindStats.Fragmentation > stats.Fragmentation)
+            stats.Fragmentation = kindStats.Fragmentation;
+    }
+
+    stats.CommittedCount = mCommittedCount;
+    if(stats.HeapBytes > 0)
+        stats.Occupancy = (float)((double)stats.AllocatedBytes / (double)stats.HeapBytes);
+
+    return stats;
+}
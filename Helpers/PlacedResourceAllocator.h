@@ -0,0 +1,92 @@
+//***************************************************************************************
+// PlacedResourceAllocator.h
+//
+// Creates default heap resources as placed resources inside a few large ID3D12Heap blocks
+// instead of one committed resource (and one implicit heap) each.  Space inside a heap is
+// managed by a BuddyAllocator.
+// Heaps only hold one kind of resource (buffers, textures or render target/depth textures),
+// which is what resource heap tier 1 hardware requires.  Placement follows the alignment
+// rules: 64KB for buffers and textures, 4KB for small textures and 4MB for MSAA textures
+// (64KB for small ones).  Resources too large for a heap fall back to committed resources.
+//
+// The allocator must outlive the resources it created, placed resources don't keep their
+// heap alive.  Placements are looked up by resource address: a resource that is dropped
+// without going through Release() keeps its space until the allocator is destroyed, and its
+// entry is overwritten when a later resource gets the same address.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "BuddyAllocator.h"
+
+class PlacedResourceAllocator
+{
+public:
+    enum class HeapKind
+    {
+        Buffers = 0,
+        Textures,
+        RenderTargets,      // render target and depth stencil textures
+        Count
+    };
+
+    struct Stats
+    {
+        UINT HeapCount = 0;
+        UINT64 HeapBytes = 0;
+        UINT64 AllocatedBytes = 0;
+        UINT64 RequestedBytes = 0;
+        UINT PlacedCount = 0;
+        UINT CommittedCount = 0;
+
+        float Occupancy = 0.0f;        // allocated / heap bytes
+        float Fragmentation = 0.0f;    // worst heap, see BuddyAllocator::GetFragmentation
+    };
+
+    static const UINT64 DefaultHeapSize = 64 * 1024 * 1024;
+
+    PlacedResourceAllocator(ID3D12Device* device, UINT64 heapSize = DefaultHeapSize);
+    PlacedResourceAllocator(const PlacedResourceAllocator& rhs) = delete;
+    PlacedResourceAllocator& operator=(const PlacedResourceAllocator& rhs) = delete;
+    ~PlacedResourceAllocator();
+
+    // desc.Alignment is chosen by the allocator.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue = nullptr);
+
+    // Returns the space of a resource to its heap and drops it.  The GPU must be done with the
+    // resource and resource must hold the last reference, so the address can't be reused while
+    // the placement is still recorded.
+    void Release(Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
+    Stats GetStats()const;
+    Stats GetStats(HeapKind kind)const;
+
+private:
+    struct Heap
+    {
+        Microsoft::WRL::ComPtr<ID3D12Heap> D3DHeap;
+        std::unique_ptr<BuddyAllocator> Allocator;
+    };
+
+    struct Placement
+    {
+        HeapKind Kind;
+        UINT HeapIndex;             // CommittedHeapIndex for committed fallbacks
+        UINT64 Offset;
+    };
+
+    static const UINT CommittedHeapIndex = ~0u;
+
+    static HeapKind KindOf(const D3D12_RESOURCE_DESC& desc);
+    D3D12_RESOURCE_ALLOCATION_INFO GetAllocationInfo(D3D12_RESOURCE_DESC& desc)const;
+    UINT CreateHeap(HeapKind kind);
+
+    ID3D12Device* md3dDevice;
+    UINT64 mHeapSize;
+
+    std::vector<Heap> mHeaps[(int)HeapKind::Count];
+    std::unordered_map<ID3D12Resource*, Placement> mPlacements;
+    UINT mCommittedCount = 0;
+};
@@ -0,0 +1,241 @@
+//***************************************************************************************
+// RandomStream.cpp
+//***************************************************************************************
+
+#include "RandomStream.h"
+#include "HashUtil.h"
+#include <cassert>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RANDOM_STREAM_SSE2
+#endif
+
+namespace
+{
+    inline std::uint64_t Rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    inline std::uint32_t Rotl(std::uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    // spreads a seed over the state words, the state never ends up all zero.
+    inline std::uint64_t SplitMix64(std::uint64_t& x)
+    {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    //
+    // FillFloats() lanes, xoshiro128+.  Only the upper 24 bits of its numbers are used, its
+    // lowest bits are the weak ones.
+    //
+
+    const std::uint32_t LaneCount = 8;
+
+    struct Lanes
+    {
+        std::uint32_t S[4][LaneCount];      // word, lane
+    };
+
+    inline void NextScalar(Lanes& lanes, float a, float range, float* out)
+    {
+        for(std::uint32_t l = 0; l < LaneCount; ++l)
+        {
+            std::uint32_t* s0 = &lanes.S[0][l];
+            std::uint32_t* s1 = &lanes.S[1][l];
+            std::uint32_t* s2 = &lanes.S[2][l];
+            std::uint32_t* s3 = &lanes.S[3][l];
+
+            const std::uint32_t result = *s0 + *s3;
+            const std::uint32_t t = *s1 << 9;
+            *s2 ^= *s0;
+            *s3 ^= *s1;
+            *s1 ^= *s2;
+            *s0 ^= *s3;
+            *s2 ^= t;
+            *s3 = Rotl(*s3, 11);
+
+            out[l] = a + (float)(result >> 8) * (1.0f / 16777216.0f) * range;
+        }
+    }
+
+#if defined(RANDOM_STREAM_SSE2)
+    // the same as NextScalar(), 4 lanes per instruction.
+    inline void NextSse2(Lanes& lanes, float a, float range, float* out)
+    {
+        const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+        const __m128 va = _mm_set1_ps(a);
+        const __m128 vrange = _mm_set1_ps(range);
+
+        for(std::uint32_t l = 0; l < LaneCount; l += 4)
+        {
+            __m128i s0 = _mm_loadu_si128((const __m128i*)&lanes.S[0][l]);
+            __m128i s1 = _mm_loadu_si128((const __m128i*)&lanes.S[1][l]);
+            __m128i s2 = _mm_loadu_si128((const __m128i*)&lanes.S[2][l]);
+            __m128i s3 = _mm_loadu_si128((const __m128i*)&lanes.S[3][l]);
+
+            const __m128i result = _mm_add_epi32(s0, s3);
+            const __m128i t = _mm_slli_epi32(s1, 9);
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+            _mm_storeu_si128((__m128i*)&lanes.S[0][l], s0);
+            _mm_storeu_si128((__m128i*)&lanes.S[1][l], s1);
+            _mm_storeu_si128((__m128i*)&lanes.S[2][l], s2);
+            _mm_storeu_si128((__m128i*)&lanes.S[3][l], s3);
+
+            // 24 bits convert exactly, and the float operations are the ones of the scalar code.
+            __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), scale);
+            _mm_storeu_ps(out + l, _mm_add_ps(va, _mm_mul_ps(f, vrange)));
+        }
+    }
+#endif
+
+    inline void NextLanes(Lanes& lanes, float a, float range, float* out)
+    {
+#if defined(RANDOM_STREAM_SSE2)
+        NextSse2(lanes, a, range, out);
+#else
+        NextScalar(lanes, a, range, out);
+#endif
+    }
+}
+
+RandomStream::RandomStream(std::uint64_t seed)
+{
+    for(std::uint64_t& word : mState)
+        word = SplitMix64(seed);
+}
+
+RandomStream::RandomStream(std::uint64_t seed, const char* name)
+    : RandomStream(HashUtil::String(name, HashUtil::Value(seed)))
+{
+}
+
+std::uint64_t RandomStream::Next()
+{
+    const std::uint64_t result = Rotl(mState[1] * 5, 7) * 9;
+    const std::uint64_t t = mState[1] << 17;
+
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = Rotl(mState[3], 45);
+
+    return result;
+}
+
+std::uint32_t RandomStream::NextBelow(std::uint32_t bound)
+{
+    assert(bound > 0);
+
+    // the high word of a 32x32 bit product is in [0, bound), the low word rejects the few numbers
+    // that would make some results more likely than others (Lemire).
+    std::uint64_t m = (std::uint64_t)NextUInt32() * bound;
+    std::uint32_t low = (std::uint32_t)m;
+    if(low < bound)
+    {
+        const std::uint32_t threshold = (0u - bound) % bound;
+        while(low < threshold)
+        {
+            m = (std::uint64_t)NextUInt32() * bound;
+            low = (std::uint32_t)m;
+        }
+    }
+    return (std::uint32_t)(m >> 32);
+}
+
+int RandomStream::NextInt(int a, int b)
+{
+    assert(a <= b);
+
+    const std::uint32_t range = (std::uint32_t)((std::int64_t)b - a) + 1;
+    if(range == 0)
+        return (int)NextUInt32();       // the whole int range
+    return (int)((std::int64_t)a + NextBelow(range));
+}
+
+template<typename LaneFunc>
+void RandomStream::FillFloatsWith(LaneFunc nextLanes, float* out, std::size_t count, float a, float b)
+{
+    Lanes lanes;
+    for(std::uint32_t l = 0; l < LaneCount; ++l)
+    {
+        const std::uint64_t lo = Next();
+        const std::uint64_t hi = Next();
+        lanes.S[0][l] = (std::uint32_t)lo;
+        lanes.S[1][l] = (std::uint32_t)(lo >> 32);
+        lanes.S[2][l] = (std::uint32_t)hi;
+        lanes.S[3][l] = (std::uint32_t)(hi >> 32) | 1;     // never all zero
+    }
+
+    const float range = b - a;
+
+    std::size_t i = 0;
+    for(; i + LaneCount <= count; i += LaneCount)
+        nextLanes(lanes, a, range, out + i);
+
+    if(i < count)
+    {
+        float last[LaneCount];
+        nextLanes(lanes, a, range, last);
+        for(std::uint32_t l = 0; i < count; ++i, ++l)
+            out[i] = last[l];
+    }
+}
+
+void RandomStream::FillFloats(float* out, std::size_t count, float a, float b)
+{
+    FillFloatsWith(NextLanes, out, count, a, b);
+}
+
+void RandomStream::FillFloatsScalar(float* out, std::size_t count, float a, float b)
+{
+    FillFloatsWith(NextScalar, out, count, a, b);
+}
+
+void RandomStream::Jump()
+{
+    static const std::uint64_t JumpPolynomial[4] =
+    {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+    };
+
+    std::uint64_t jumped[4] = { 0, 0, 0, 0 };
+    for(std::uint64_t word : JumpPolynomial)
+    {
+        for(int bit = 0; bit < 64; ++bit)
+        {
+            if(word & (1ull << bit))
+            {
+                for(int w = 0; w < 4; ++w)
+                    jumped[w] ^= mState[w];
+            }
+            Next();
+        }
+    }
+
+    for(int w = 0; w < 4; ++w)
+        mState[w] = jumped[w];
+}
+
+RandomStream RandomStream::Split()
+{
+    RandomStream split = *this;
+    Jump();
+    return split;
+}
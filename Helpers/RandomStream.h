@@ -0,0 +1,64 @@
+//***************************************************************************************
+// RandomStream.h
+//
+// Small, fast pseudo random number generator (xoshiro256**) owned by whoever draws from it,
+// instead of the global state of rand().  A stream gives the same numbers for the same seed on
+// every platform and compiler: ranges are mapped here, not by the library's distributions, and
+// integer ranges are unbiased.
+// Streams meant to be independent are made from the same seed with different names, e.g. one
+// per system, or split off a stream: Split() returns the stream as it is and moves it 2^128
+// numbers ahead, so the two never overlap.  A worker thread draws from a stream of its own, and
+// parallel work stays reproducible as long as each piece of work gets the same stream.
+// FillFloats() generates uniform floats in bulk, 8 lanes of xoshiro128+ at a time with SSE2.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class RandomStream
+{
+public:
+    explicit RandomStream(std::uint64_t seed = 0);
+
+    // Stream of the given name, independent of the streams of other names of the same seed.
+    RandomStream(std::uint64_t seed, const char* name);
+
+    // 64 random bits.
+    std::uint64_t Next();
+
+    std::uint32_t NextUInt32() { return (std::uint32_t)(Next() >> 32); }
+
+    // Uniform in [0, bound), bound > 0.
+    std::uint32_t NextBelow(std::uint32_t bound);
+
+    // Uniform in [a, b], both included.
+    int NextInt(int a, int b);
+
+    // Uniform in [0, 1), a multiple of 2^-24.
+    float NextFloat() { return (float)(Next() >> 40) * (1.0f / 16777216.0f); }
+
+    // Uniform in [a, b).
+    float NextFloat(float a, float b) { return a + NextFloat() * (b - a); }
+
+    // Writes count floats uniform in [a, b).  The numbers come from lanes seeded off this stream,
+    // which moves on by a few numbers whatever the count.
+    void FillFloats(float* out, std::size_t count, float a, float b);
+
+    // FillFloats() with the portable scalar code whatever the CPU, the SSE2 code gives the same
+    // floats bit for bit.
+    void FillFloatsScalar(float* out, std::size_t count, float a, float b);
+
+    // Moves the stream 2^128 numbers ahead.
+    void Jump();
+
+    // Returns this stream and jumps it, the two give non-overlapping sequences.
+    RandomStream Split();
+
+private:
+    template<typename LaneFunc>
+    void FillFloatsWith(LaneFunc nextLanes, float* out, std::size_t count, float a, float b);
+
+    std::uint64_t mState[4];
+};
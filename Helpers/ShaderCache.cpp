@@ -0,0 +1,245 @@
+//***************************************************************************************
+// ShaderCache.cpp
+//***************************************************************************************
+
+#include "ShaderCache.h"
+#include "HashUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // Bump when the layout of the key changes so stale entries are never picked up.
+    const char* const CacheVersion = "ShaderCache/2";
+
+    // Every entry starts with this header, the payload is only trusted when its size and
+    // checksum match, so a half written or damaged file reads as a miss.
+    struct EntryHeader
+    {
+        char Magic[4];
+        std::uint32_t Reserved;
+        std::uint64_t ByteSize;
+        std::uint64_t Checksum;
+    };
+
+    const char EntryMagic[4] = { 'F', 'C', 'S', 'C' };
+
+    bool ReadFile(const std::string& path, std::string& contents)
+    {
+        std::ifstream fin(path, std::ios::binary);
+        if(!fin)
+            return false;
+
+        std::ostringstream ss;
+        ss << fin.rdbuf();
+        contents = ss.str();
+        return true;
+    }
+
+    std::string DirectoryOf(const std::string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // Collects the file names of every #include "..." directive.  Includes inside inactive
+    // #if blocks are collected as well, which can only make the key more conservative.
+    std::vector<std::string> FindQuotedIncludes(const std::string& source)
+    {
+        std::vector<std::string> includes;
+
+        std::istringstream lines(source);
+        std::string line;
+        while(std::getline(lines, line))
+        {
+            size_t i = line.find_first_not_of(" \t");
+            if(i == std::string::npos || line[i] != '#')
+                continue;
+
+            i = line.find_first_not_of(" \t", i + 1);
+            if(i == std::string::npos || line.compare(i, 7, "include") != 0)
+                continue;
+
+            size_t open = line.find('"', i + 7);
+            if(open == std::string::npos)
+                continue;
+
+            size_t close = line.find('"', open + 1);
+            if(close == std::string::npos)
+                continue;
+
+            includes.push_back(line.substr(open + 1, close - open - 1));
+        }
+
+        return includes;
+    }
+}
+
+ShaderCache::ShaderCache(const std::string& cacheDirectory, const std::string& compilerId) :
+    mDirectory(cacheDirectory),
+    mCompilerId(compilerId)
+{
+    if(!mDirectory.empty() && mDirectory.back() != '/' && mDirectory.back() != '\\')
+        mDirectory += '/';
+
+    // It is fine if the directory already exists.
+#if defined(_WIN32)
+    _mkdir(mDirectory.c_str());
+#else
+    mkdir(mDirectory.c_str(), 0755);
+#endif
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+std::uint64_t ShaderCache::HashSourceTree(const std::string& path, std::vector<std::string>& visited, std::uint64_t hash)const
+{
+    // Every file contributes once, guarded headers included several times hash the same.
+    if(std::find(visited.begin(), visited.end(), path) != visited.end())
+        return hash;
+    visited.push_back(path);
+
+    std::string source;
+    if(!ReadFile(path, source))
+    {
+        // Keep the key well defined, the compiler will report the missing file.
+        return HashUtil::String("<missing>" + path, hash);
+    }
+
+    hash = HashUtil::String(path, hash);
+    hash = HashUtil::String(source, hash);
+
+    // D3D_COMPILE_STANDARD_FILE_INCLUDE resolves quoted includes relative to the including file.
+    std::string dir = DirectoryOf(path);
+    for(const std::string& include : FindQuotedIncludes(source))
+        hash = HashSourceTree(dir + include, visited, hash);
+
+    return hash;
+}
+
+std::uint64_t ShaderCache::ComputeKey(const Request& request)const
+{
+    std::uint64_t hash = HashUtil::String(CacheVersion);
+    hash = HashUtil::String(mCompilerId, hash);
+
+    std::vector<std::string> visited;
+    hash = HashSourceTree(request.SourcePath, visited, hash);
+
+    hash = HashUtil::Value<std::uint64_t>(request.Defines.size(), hash);
+    for(const Define& define : request.Defines)
+    {
+        hash = HashUtil::String(define.Name, hash);
+        hash = HashUtil::String(define.Definition, hash);
+    }
+
+    hash = HashUtil::String(request.EntryPoint, hash);
+    hash = HashUtil::String(request.Target, hash);
+    hash = HashUtil::Value(request.Flags, hash);
+
+    return hash;
+}
+
+std::string ShaderCache::GetEntryPath(std::uint64_t key)const
+{
+    return mDirectory + HashUtil::ToHex(key) + ".cso";
+}
+
+void ShaderCache::Store(std::uint64_t key, const BytecodeView& bytecode)const
+{
+    std::string path = GetEntryPath(key);
+
+    // Precompile can store the same key from two threads, each writes its own temporary.
+    std::string tempPath = path + "." + HashUtil::ToHex(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    EntryHeader header = {};
+    std::copy(EntryMagic, EntryMagic + 4, header.Magic);
+    header.ByteSize = bytecode.Size;
+    header.Checksum = HashUtil::Bytes(bytecode.Data, bytecode.Size);
+
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if(!fout)
+            return;     // caching is an optimization, a read-only directory just means no cache.
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(bytecode.Data, bytecode.Size);
+        if(!fout)
+        {
+            fout.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+
+    // rename() does not replace an existing file on Windows.
+    std::remove(path.c_str());
+    std::rename(tempPath.c_str(), path.c_str());
+}
+
+bool ShaderCache::Load(std::uint64_t key, const AllocateFunc& allocate)const
+{
+    std::ifstream fin(GetEntryPath(key), std::ios::binary | std::ios::ate);
+    if(!fin)
+        return false;
+
+    // the payload has to fill the rest of the file exactly.
+    const std::streamoff fileSize = fin.tellg();
+    fin.seekg(0);
+
+    EntryHeader header;
+    if(!fin.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    if(!std::equal(EntryMagic, EntryMagic + 4, header.Magic))
+        return false;
+    if((std::uint64_t)fileSize - sizeof(header) != header.ByteSize)
+        return false;
+
+    const std::size_t size = (std::size_t)header.ByteSize;
+    char* bytecode = allocate(size);
+    if(size != 0 && !fin.read(bytecode, size))
+        return false;
+
+    return HashUtil::Bytes(bytecode, size) == header.Checksum;
+}
+
+void ShaderCache::GetOrCompileInto(const Request& request, const CompileIntoFunc& compile, const AllocateFunc& allocate)
+{
+    std::uint64_t key = ComputeKey(request);
+
+    if(Load(key, allocate))
+    {
+        mHitCount++;
+        return;
+    }
+
+    mMissCount++;
+    Store(key, compile(request));
+}
+
+ShaderCache::Bytecode ShaderCache::GetOrCompile(const Request& request, const CompileFunc& compile)
+{
+    Bytecode bytecode;
+    GetOrCompileInto(request,
+        [&](const Request& r)
+        {
+            bytecode = compile(r);
+            return BytecodeView{ bytecode.data(), bytecode.size() };
+        },
+        [&](std::size_t size)
+        {
+            bytecode.resize(size);
+            return bytecode.data();
+        });
+
+    return bytecode;
+}
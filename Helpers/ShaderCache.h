@@ -0,0 +1,104 @@
+//***************************************************************************************
+// ShaderCache.h
+//
+// Content addressed on-disk cache of compiled shader bytecode.
+// An entry is keyed by a hash of everything that affects the compiler output: the source
+// text, the text of every file it pulls in through #include "..." (transitively), the
+// macro definitions, the entry point, the target profile, the compile flags and the identity
+// of the compiler itself.  Editing Shared.hlsl therefore invalidates BasicShader.hlsl and Sky.hlsl
+// entries as well, and so does installing a different d3dcompiler.
+//
+// The class only deals with files and bytes, the actual compiler is supplied by the caller
+// (see d3dUtil::CompileShaderCached), so it has no dependency on Windows or Direct3D.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class ShaderCache
+{
+public:
+    struct Define
+    {
+        std::string Name;
+        std::string Definition;
+    };
+
+    struct Request
+    {
+        std::string SourcePath;
+        std::vector<Define> Defines;
+        std::string EntryPoint;
+        std::string Target;
+        std::uint32_t Flags = 0;
+    };
+
+    using Bytecode = std::vector<char>;
+
+    // Compiles a request and returns the bytecode, expected to throw on failure.
+    using CompileFunc = std::function<Bytecode(const Request& request)>;
+
+    // Bytes in a buffer owned by the caller.
+    struct BytecodeView
+    {
+        const char* Data;
+        std::size_t Size;
+    };
+
+    // Compiles a request into a buffer of the caller's and returns its bytes, which have to
+    // stay valid until GetOrCompileInto returns.  Expected to throw on failure.
+    using CompileIntoFunc = std::function<BytecodeView(const Request& request)>;
+
+    // Returns memory for size bytes of bytecode in a buffer of the caller's.
+    using AllocateFunc = std::function<char*(std::size_t size)>;
+
+    // compilerId names the compiler and its version (see d3dUtil::ShaderCompilerId), entries
+    // written by another compiler are never returned.
+    ShaderCache(const std::string& cacheDirectory, const std::string& compilerId);
+    ShaderCache(const ShaderCache& rhs) = delete;
+    ShaderCache& operator=(const ShaderCache& rhs) = delete;
+    ~ShaderCache();
+
+    std::uint64_t ComputeKey(const Request& request)const;
+
+    // Path of the cache file of a key, whether it exists or not.
+    std::string GetEntryPath(std::uint64_t key)const;
+
+    // Returns the cached bytecode of a request, compiling and storing it on a miss.
+    // An entry that cannot be read back intact (missing, truncated, corrupted) is a miss
+    // and gets replaced.  Exceptions thrown by compile propagate, nothing is stored then.
+    Bytecode GetOrCompile(const Request& request, const CompileFunc& compile);
+
+    // GetOrCompile for callers that keep bytecode in a buffer type of their own (ID3DBlob in
+    // d3dUtil::CompileShaderCached): a hit is read from the file straight into the memory
+    // allocate returns, a miss is compiled into the caller's buffer and stored from there.
+    // If a damaged entry turns out to be a miss, allocate has been called already.
+    void GetOrCompileInto(const Request& request, const CompileIntoFunc& compile, const AllocateFunc& allocate);
+
+    std::uint32_t GetHitCount()const { return mHitCount; }
+    std::uint32_t GetMissCount()const { return mMissCount; }
+
+private:
+    std::uint64_t HashSourceTree(const std::string& path, std::vector<std::string>& visited, std::uint64_t hash)const;
+
+    // Writes an entry.  The bytes go to a temporary file first which is then renamed,
+    // so an interrupted write never leaves a truncated entry behind.
+    void Store(std::uint64_t key, const BytecodeView& bytecode)const;
+
+    // Reads an entry into memory from allocate, returns false if there is none or it fails
+    // validation.
+    bool Load(std::uint64_t key, const AllocateFunc& allocate)const;
+
+    std::string mDirectory;
+    std::string mCompilerId;
+
+    // Lookups may come from several threads (ShaderPermutations::Precompile).
+    std::atomic<std::uint32_t> mHitCount{ 0 };
+    std::atomic<std::uint32_t> mMissCount{ 0 };
+};
@@ -0,0 +1,163 @@
+//***************************************************************************************
+// ShaderPermutations.cpp
+//***************************************************************************************
+
+#include "ShaderPermutations.h"
+#include "ShaderCache.h"
+#include <ppl.h>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Light counts permutations are compiled for.  Small counts are exact, larger ones
+    // are bucketed so the number of variants stays small.
+    const UINT LightCountSteps[] = { 0, 1, 2, 3, 4, 6, 8, 12, 16 };
+}
+
+ShaderPermutations::Defines::Defines(const Key& key, const std::vector<std::string>& featureNames)
+{
+    mStrings.push_back(std::to_string(key.DirLights));
+    mStrings.push_back(std::to_string(key.PointLights));
+    mStrings.push_back(std::to_string(key.SpotLights));
+    mStrings.push_back("1");
+
+    mMacros.push_back({ "DIR_LIGHTS", mStrings[0].c_str() });
+    mMacros.push_back({ "POINT_LIGHTS", mStrings[1].c_str() });
+    mMacros.push_back({ "SPOT_LIGHTS", mStrings[2].c_str() });
+
+    for(size_t i = 0; i < featureNames.size(); ++i)
+    {
+        if(key.Features & (1u << i))
+            mMacros.push_back({ featureNames[i].c_str(), mStrings[3].c_str() });
+    }
+
+    // the macro list is terminated by a null entry.
+    mMacros.push_back({ nullptr, nullptr });
+}
+
+ShaderPermutations::ShaderPermutations(ShaderCache& cache) : mCache(cache)
+{
+}
+
+UINT ShaderPermutations::AddFeature(const std::string& macroName)
+{
+    assert(mFeatureNames.size() < 32);
+
+    mFeatureNames.push_back(macroName);
+    return 1u << (UINT)(mFeatureNames.size() - 1);
+}
+
+UINT ShaderPermutations::RoundUpToStep(UINT count)
+{
+    for(UINT step : LightCountSteps)
+    {
+        if(step >= count)
+            return step;
+    }
+    return MaxLights;
+}
+
+ShaderPermutations::Key ShaderPermutations::Select(UINT dirLights, UINT pointLights, UINT spotLights, UINT features)
+{
+    assert(dirLights + pointLights + spotLights <= MaxLights);
+
+    Key key;
+    key.DirLights = RoundUpToStep(dirLights);
+    key.PointLights = RoundUpToStep(pointLights);
+    key.SpotLights = RoundUpToStep(spotLights);
+    key.Features = features;
+
+    // Rounding up must not push the lights beyond the cbuffer array, fall back to exact counts.
+    if(key.DirLights + key.PointLights + key.SpotLights > MaxLights)
+    {
+        key.DirLights = dirLights;
+        key.PointLights = pointLights;
+        key.SpotLights = spotLights;
+    }
+
+    return key;
+}
+
+void ShaderPermutations::PackLights(const Key& key, const std::vector<Light>& dirLights,
+    const std::vector<Light>& pointLights, const std::vector<Light>& spotLights, Light (&lights)[MaxLights])
+{
+    assert(dirLights.size() <= key.DirLights);
+    assert(pointLights.size() <= key.PointLights);
+    assert(spotLights.size() <= key.SpotLights);
+
+    // Padding slots are evaluated by the shader, a zero strength makes them contribute nothing.
+    Light unused;
+    unused.Strength = { 0.0f, 0.0f, 0.0f };
+    for(UINT i = 0; i < MaxLights; ++i)
+        lights[i] = unused;
+
+    for(size_t i = 0; i < dirLights.size(); ++i)
+        lights[i] = dirLights[i];
+    for(size_t i = 0; i < pointLights.size(); ++i)
+        lights[key.DirLights + i] = pointLights[i];
+    for(size_t i = 0; i < spotLights.size(); ++i)
+        lights[key.DirLights + key.PointLights + i] = spotLights[i];
+}
+
+ShaderPermutations::Entry* ShaderPermutations::Find(const std::wstring& filename, const std::string& entrypoint,
+    const std::string& target, const Key& key)
+{
+    for(Entry& e : mEntries)
+    {
+        if(e.PermutationKey == key && e.EntryPoint == entrypoint && e.Target == target && e.Filename == filename)
+            return &e;
+    }
+    return nullptr;
+}
+
+ComPtr<ID3DBlob> ShaderPermutations::Get(const std::wstring& filename, const std::string& entrypoint,
+    const std::string& target, const Key& key)
+{
+    Entry* e = Find(filename, entrypoint, target, key);
+    if(e != nullptr)
+        return e->ByteCode;
+
+    Defines defines(key, mFeatureNames);
+
+    Entry entry;
+    entry.Filename = filename;
+    entry.EntryPoint = entrypoint;
+    entry.Target = target;
+    entry.PermutationKey = key;
+    entry.ByteCode = d3dUtil::CompileShaderCached(mCache, filename, defines.Get(), entrypoint, target);
+
+    mEntries.push_back(entry);
+    return entry.ByteCode;
+}
+
+void ShaderPermutations::Precompile(const std::wstring& filename, const std::string& entrypoint,
+    const std::string& target, const std::vector<Key>& keys)
+{
+    std::vector<Key> missing;
+    for(const Key& key : keys)
+    {
+        if(Find(filename, entrypoint, target, key) == nullptr)
+            missing.push_back(key);
+    }
+
+    // D3DCompileFromFile is thread safe and every permutation has its own cache entry,
+    // so the variants are compiled independently.
+    std::vector<ComPtr<ID3DBlob>> byteCodes(missing.size());
+    concurrency::parallel_for(size_t(0), missing.size(), [&](size_t i)
+        {
+            Defines defines(missing[i], mFeatureNames);
+            byteCodes[i] = d3dUtil::CompileShaderCached(mCache, filename, defines.Get(), entrypoint, target);
+        });
+
+    for(size_t i = 0; i < missing.size(); ++i)
+    {
+        Entry entry;
+        entry.Filename = filename;
+        entry.EntryPoint = entrypoint;
+        entry.Target = target;
+        entry.PermutationKey = missing[i];
+        entry.ByteCode = byteCodes[i];
+        mEntries.push_back(entry);
+    }
+}
@@ -0,0 +1,88 @@
+//***************************************************************************************
+// ShaderPermutations.h
+//
+// Compiles variants of a shader that differ in the number of directional, point and spot
+// lights they evaluate (DIR_LIGHTS, POINT_LIGHTS, SPOT_LIGHTS in Shared.hlsl) and in a set
+// of on/off feature macros.  Light counts are rounded up to a fixed ladder of steps so only
+// a handful of variants exist, and at runtime the smallest variant covering the active
+// lights is picked, so the pixel shader never loops over more lights than needed.
+// Variants are compiled lazily through the shader cache, or up front in parallel.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class ShaderPermutations
+{
+public:
+    struct Key
+    {
+        UINT DirLights = 0;
+        UINT PointLights = 0;
+        UINT SpotLights = 0;
+        UINT Features = 0;      // bit i set: feature macro i is defined
+
+        bool operator==(const Key& rhs)const
+        {
+            return DirLights == rhs.DirLights && PointLights == rhs.PointLights &&
+                SpotLights == rhs.SpotLights && Features == rhs.Features;
+        }
+    };
+
+    // Macro list of a key, D3D_SHADER_MACRO only points into the owned strings.
+    class Defines
+    {
+    public:
+        Defines(const Key& key, const std::vector<std::string>& featureNames);
+        Defines(const Defines& rhs) = delete;
+        Defines& operator=(const Defines& rhs) = delete;
+
+        const D3D_SHADER_MACRO* Get()const { return mMacros.data(); }
+
+    private:
+        std::vector<std::string> mStrings;
+        std::vector<D3D_SHADER_MACRO> mMacros;
+    };
+
+    ShaderPermutations(ShaderCache& cache);
+    ShaderPermutations(const ShaderPermutations& rhs) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations& rhs) = delete;
+
+    // Registers a feature toggle macro and returns its bit for Key::Features.
+    UINT AddFeature(const std::string& macroName);
+
+    // Smallest permutation whose light counts cover the given ones.
+    static Key Select(UINT dirLights, UINT pointLights, UINT spotLights, UINT features);
+
+    // Lays the lights out the way a permutation expects them: directional lights first, then
+    // point lights starting at key.DirLights, then spot lights.  Unused slots get zero strength.
+    static void PackLights(const Key& key, const std::vector<Light>& dirLights,
+        const std::vector<Light>& pointLights, const std::vector<Light>& spotLights, Light (&lights)[MaxLights]);
+
+    // Returns the bytecode of a permutation, compiling it (or reading it from the cache) on first use.
+    Microsoft::WRL::ComPtr<ID3DBlob> Get(const std::wstring& filename, const std::string& entrypoint,
+        const std::string& target, const Key& key);
+
+    // Compiles several permutations of a shader on worker threads, e.g. to warm the cache.
+    void Precompile(const std::wstring& filename, const std::string& entrypoint,
+        const std::string& target, const std::vector<Key>& keys);
+
+private:
+    static UINT RoundUpToStep(UINT count);
+
+    struct Entry
+    {
+        std::wstring Filename;
+        std::string EntryPoint;
+        std::string Target;
+        Key PermutationKey;
+        Microsoft::WRL::ComPtr<ID3DBlob> ByteCode;
+    };
+
+    Entry* Find(const std::wstring& filename, const std::string& entrypoint, const std::string& target, const Key& key);
+
+    ShaderCache& mCache;
+    std::vector<std::string> mFeatureNames;
+    std::vector<Entry> mEntries;
+};
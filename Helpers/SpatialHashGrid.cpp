@@ -0,0 +1,185 @@
+//***************************************************************************************
+// SpatialHashGrid.cpp
+//***************************************************************************************
+
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    // at least two buckets per entry keeps the buckets short.
+    const std::uint32_t MinBucketCount = 16;
+
+    std::uint32_t BucketCountFor(std::uint32_t entryCount)
+    {
+        std::uint32_t count = MinBucketCount;
+        while(count < 2 * entryCount)
+            count <<= 1;
+        return count;
+    }
+
+    // calls visit for every cell of the range [lo, hi].
+    template<typename CellT, typename Visit>
+    void ForEachCell(const CellT& lo, const CellT& hi, Visit visit)
+    {
+        for(std::int32_t z = lo.Z; z <= hi.Z; ++z)
+        {
+            for(std::int32_t y = lo.Y; y <= hi.Y; ++y)
+            {
+                for(std::int32_t x = lo.X; x <= hi.X; ++x)
+                {
+                    CellT cell = { x, y, z };
+                    visit(cell);
+                }
+            }
+        }
+    }
+
+    bool BoxesOverlap(const SpatialHashGrid::Box& a, const SpatialHashGrid::Box& b)
+    {
+        return a.MinX <= b.MaxX && b.MinX <= a.MaxX &&
+            a.MinY <= b.MaxY && b.MinY <= a.MaxY &&
+            a.MinZ <= b.MaxZ && b.MinZ <= a.MaxZ;
+    }
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+{
+    SetCellSize(cellSize);
+    mBucketStart.assign(MinBucketCount + 1, 0);
+    mBucketMask = MinBucketCount - 1;
+}
+
+void SpatialHashGrid::SetCellSize(float cellSize)
+{
+    assert(cellSize > 0.0f);
+    mCellSize = cellSize;
+    mInvCellSize = 1.0f / cellSize;
+}
+
+SpatialHashGrid::Cell SpatialHashGrid::CellOf(float x, float y, float z)const
+{
+    Cell cell;
+    cell.X = (std::int32_t)std::floor(x * mInvCellSize);
+    cell.Y = (std::int32_t)std::floor(y * mInvCellSize);
+    cell.Z = (std::int32_t)std::floor(z * mInvCellSize);
+    return cell;
+}
+
+std::uint32_t SpatialHashGrid::BucketOf(const Cell& cell)const
+{
+    // Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+    std::uint32_t h = ((std::uint32_t)cell.X * 73856093u) ^ ((std::uint32_t)cell.Y * 19349663u) ^
+        ((std::uint32_t)cell.Z * 83492791u);
+    return h & mBucketMask;
+}
+
+void SpatialHashGrid::BuildBuckets(std::uint32_t entryCount)
+{
+    std::uint32_t bucketCount = BucketCountFor(entryCount);
+    mBucketMask = bucketCount - 1;
+    mBucketStart.assign(bucketCount + 1, 0);
+
+    mSortedPoints.resize(entryCount);
+    mSortedCells.resize(entryCount);
+}
+
+void SpatialHashGrid::PrefixSumBuckets()
+{
+    for(std::uint32_t b = 0; b <= mBucketMask; ++b)
+        mBucketStart[b + 1] += mBucketStart[b];
+}
+
+void SpatialHashGrid::RestoreBucketStarts()
+{
+    // mBucketStart[b] is used as the write cursor of bucket b and ends at the start of b + 1,
+    // shifting it back restores the starts.
+    for(std::uint32_t b = mBucketMask + 1; b > 0; --b)
+        mBucketStart[b] = mBucketStart[b - 1];
+    mBucketStart[0] = 0;
+}
+
+void SpatialHashGrid::BuildBoxes(const Box* boxes, std::uint32_t count)
+{
+    mBoxes.assign(boxes, boxes + count);
+    mBoxMinCells.resize(count);
+    mBoxMaxCells.resize(count);
+
+    std::uint32_t entryCount = 0;
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        const Box& box = boxes[i];
+        assert(box.MinX <= box.MaxX && box.MinY <= box.MaxY && box.MinZ <= box.MaxZ);
+
+        mBoxMinCells[i] = CellOf(box.MinX, box.MinY, box.MinZ);
+        mBoxMaxCells[i] = CellOf(box.MaxX, box.MaxY, box.MaxZ);
+        entryCount += (mBoxMaxCells[i].X - mBoxMinCells[i].X + 1) * (mBoxMaxCells[i].Y - mBoxMinCells[i].Y + 1) *
+            (mBoxMaxCells[i].Z - mBoxMinCells[i].Z + 1);
+    }
+
+    BuildBuckets(entryCount);
+
+    // counting sort by bucket of one entry per cell of each box: count, prefix sum, scatter.
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        ForEachCell(mBoxMinCells[i], mBoxMaxCells[i], [this](const Cell& cell)
+        {
+            mBucketStart[BucketOf(cell) + 1]++;
+        });
+    }
+
+    PrefixSumBuckets();
+
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        ForEachCell(mBoxMinCells[i], mBoxMaxCells[i], [this, i](const Cell& cell)
+        {
+            std::uint32_t slot = mBucketStart[BucketOf(cell)]++;
+            mSortedPoints[slot] = i;
+            mSortedCells[slot] = cell;
+        });
+    }
+
+    RestoreBucketStarts();
+}
+
+void SpatialHashGrid::QueryBoxPairs(const Box* boxes, std::uint32_t count, std::vector<Pair>& pairs)const
+{
+    if(mSortedPoints.empty())
+        return;
+
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        const Box& query = boxes[i];
+        const Cell lo = CellOf(query.MinX, query.MinY, query.MinZ);
+        const Cell hi = CellOf(query.MaxX, query.MaxY, query.MaxZ);
+
+        ForEachCell(lo, hi, [this, &pairs, &query, i](const Cell& cell)
+        {
+            std::uint32_t bucket = BucketOf(cell);
+            for(std::uint32_t s = mBucketStart[bucket]; s < mBucketStart[bucket + 1]; ++s)
+            {
+                const Cell& boxCell = mSortedCells[s];
+                if(boxCell.X != cell.X || boxCell.Y != cell.Y || boxCell.Z != cell.Z)
+                    continue;
+
+                std::uint32_t point = mSortedPoints[s];
+                const Box& box = mBoxes[point];
+                if(!BoxesOverlap(query, box))
+                    continue;
+
+                // two boxes meet in every cell they both overlap, the pair is only reported in
+                // the cell of the lowest corner of their intersection.
+                Cell corner = CellOf(std::max<float>(query.MinX, box.MinX), std::max<float>(query.MinY, box.MinY),
+                    std::max<float>(query.MinZ, box.MinZ));
+                if(corner.X == cell.X && corner.Y == cell.Y && corner.Z == cell.Z)
+                {
+                    Pair pair = { i, point };
+                    pairs.push_back(pair);
+                }
+            }
+        });
+    }
+}
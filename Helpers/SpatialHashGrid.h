@@ -0,0 +1,82 @@
+//***************************************************************************************
+// SpatialHashGrid.h
+//
+// Collision broadphase over boxes, e.g. the bounds of spheres swept over a step.  The boxes
+// are binned into a uniform grid: a box goes into every cell it overlaps, so a query only
+// looks at the boxes in the cells it overlaps itself.  Cells are hashed into a power of two
+// table of buckets, and BuildBoxes() groups the entries by bucket with a counting sort:
+// rebuilding every frame is a few linear passes and doesn't allocate once the arrays have
+// grown.  Overlapping boxes still have to go through a narrowphase test.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class SpatialHashGrid
+{
+public:
+    // Query is the index of the queried box, Point the index of a box of the grid.
+    struct Pair
+    {
+        std::uint32_t Query;
+        std::uint32_t Point;
+    };
+
+    struct Box
+    {
+        float MinX, MinY, MinZ;
+        float MaxX, MaxY, MaxZ;
+    };
+
+    // cellSize should be about the size of a typical box.
+    explicit SpatialHashGrid(float cellSize);
+
+    void SetCellSize(float cellSize);
+    float GetCellSize()const { return mCellSize; }
+
+    // Replaces the contents of the grid with count boxes.  Boxes much larger than a cell take
+    // many entries, the cell size should be about the size of a typical box.
+    void BuildBoxes(const Box* boxes, std::uint32_t count);
+
+    // Queries count boxes of another set against the boxes of the grid, and appends a pair for
+    // every two boxes that overlap, each at most once.
+    void QueryBoxPairs(const Box* boxes, std::uint32_t count, std::vector<Pair>& pairs)const;
+
+    // number of box entries, one per cell a box overlaps.
+    std::uint32_t GetPointCount()const { return (std::uint32_t)mSortedPoints.size(); }
+    std::uint32_t GetBucketCount()const { return mBucketMask + 1; }
+
+private:
+    struct Cell
+    {
+        std::int32_t X;
+        std::int32_t Y;
+        std::int32_t Z;
+    };
+
+    Cell CellOf(float x, float y, float z)const;
+    std::uint32_t BucketOf(const Cell& cell)const;
+
+    void BuildBuckets(std::uint32_t entryCount);
+    void PrefixSumBuckets();
+    void RestoreBucketStarts();
+
+    float mCellSize = 1.0f;
+    float mInvCellSize = 1.0f;
+    std::uint32_t mBucketMask = 0;
+
+    // entries of bucket b are mSortedPoints[mBucketStart[b], mBucketStart[b + 1]), each the
+    // index of a box.
+    std::vector<std::uint32_t> mBucketStart;
+    std::vector<std::uint32_t> mSortedPoints;
+
+    // cell of each sorted entry, tells apart cells that hash to the same bucket.
+    std::vector<Cell> mSortedCells;
+
+    // boxes given to BuildBoxes(), and the first and last cell each of them overlaps.
+    std::vector<Box> mBoxes;
+    std::vector<Cell> mBoxMinCells;
+    std::vector<Cell> mBoxMaxCells;
+};
@@ -0,0 +1,490 @@
+//***************************************************************************************
+// SphereOverlap.cpp
+//
+// The AVX2 functions are only called once cpuid reports AVX2, the compiler doesn't need to
+// target it for the whole program.  gcc and clang are told to target it in those functions
+// only (AVX2_FUNCTION).
+// The SSE and AVX2 paths and the CPU detection only exist on x86 (SPHERE_OVERLAP_X86), other
+// targets always run the scalar path.
+//***************************************************************************************
+
+#include "SphereOverlap.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define SPHERE_OVERLAP_X86
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#elif defined(SPHERE_OVERLAP_X86)
+#include <cpuid.h>
+#define AVX2_FUNCTION __attribute__((target("avx2,popcnt")))
+#endif
+
+using namespace SphereOverlap;
+
+namespace
+{
+#if defined(SPHERE_OVERLAP_X86)
+    // cpuid, xgetbv and bit scan of each compiler.
+    inline void CpuId(int info[4], int leaf, int subLeaf)
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, leaf, subLeaf);
+#else
+        __cpuid_count(leaf, subLeaf, info[0], info[1], info[2], info[3]);
+#endif
+    }
+
+    inline std::uint64_t XGetBv(std::uint32_t index)
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(index);
+#else
+        std::uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+        return ((std::uint64_t)edx << 32) | eax;
+#endif
+    }
+#endif
+
+    // index of the lowest bit set, false if there is none.
+    inline bool BitScanForward(std::uint32_t* index, std::uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        bool found = _BitScanForward(&bit, mask) != 0;
+        *index = (std::uint32_t)bit;
+        return found;
+#else
+        if(mask == 0)
+            return false;
+        *index = (std::uint32_t)__builtin_ctz(mask);
+        return true;
+#endif
+    }
+
+    // squared distance summed in the same order by every path, so they round alike.
+    inline bool Overlaps(float qx, float qy, float qz, float qr, float x, float y, float z, float r)
+    {
+        float dx = x - qx;
+        float dy = y - qy;
+        float dz = z - qz;
+        float sumR = qr + r;
+        return dx * dx + dy * dy + dz * dz < sumR * sumR;
+    }
+
+    // appends the pairs of the bits set in mask, pair b of mask is pairs[b].
+    inline std::uint32_t Compact(std::uint32_t mask, const Pair* pairs, Pair* out)
+    {
+        std::uint32_t n = 0;
+        std::uint32_t bit;
+        while(BitScanForward(&bit, mask))
+        {
+            out[n++] = pairs[bit];
+            mask &= mask - 1;
+        }
+        return n;
+    }
+
+    //
+    // Scalar
+    //
+
+    std::uint32_t TestScalar(float qx, float qy, float qz, float qr, const Spheres& s,
+        std::uint32_t begin, std::uint32_t count, std::uint32_t* hitMask)
+    {
+        std::uint32_t hits = 0;
+        for(std::uint32_t i = begin; i < count; ++i)
+        {
+            if(Overlaps(qx, qy, qz, qr, s.X[i], s.Y[i], s.Z[i], s.Radius[i]))
+            {
+                hitMask[i / 32] |= 1u << (i % 32);
+                hits++;
+            }
+        }
+        return hits;
+    }
+
+    std::uint32_t TestPairsScalar(const Spheres& q, const Spheres& s, const Pair* pairs,
+        std::uint32_t begin, std::uint32_t count, Pair* out)
+    {
+        std::uint32_t n = 0;
+        for(std::uint32_t i = begin; i < count; ++i)
+        {
+            std::uint32_t a = pairs[i].Query;
+            std::uint32_t b = pairs[i].Point;
+            if(Overlaps(q.X[a], q.Y[a], q.Z[a], q.Radius[a], s.X[b], s.Y[b], s.Z[b], s.Radius[b]))
+                out[n++] = pairs[i];
+        }
+        return n;
+    }
+
+#if defined(SPHERE_OVERLAP_X86)
+    //
+    // SSE, 4 spheres at a time
+    //
+
+    inline int OverlapMask4(__m128 qx, __m128 qy, __m128 qz, __m128 qr,
+        __m128 x, __m128 y, __m128 z, __m128 r)
+    {
+        __m128 dx = _mm_sub_ps(x, qx);
+        __m128 dy = _mm_sub_ps(y, qy);
+        __m128 dz = _mm_sub_ps(z, qz);
+        __m128 sumR = _mm_add_ps(qr, r);
+
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        return _mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(sumR, sumR)));
+    }
+
+    std::uint32_t TestSse(float x, float y, float z, float radius, const Spheres& s,
+        std::uint32_t count, std::uint32_t* hitMask)
+    {
+        const __m128 qx = _mm_set1_ps(x);
+        const __m128 qy = _mm_set1_ps(y);
+        const __m128 qz = _mm_set1_ps(z);
+        const __m128 qr = _mm_set1_ps(radius);
+
+        std::uint32_t hits = 0;
+        std::uint32_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            int mask = OverlapMask4(qx, qy, qz, qr, _mm_loadu_ps(s.X + i), _mm_loadu_ps(s.Y + i),
+                _mm_loadu_ps(s.Z + i), _mm_loadu_ps(s.Radius + i));
+
+            hitMask[i / 32] |= (std::uint32_t)mask << (i % 32);
+            for(; mask != 0; mask &= mask - 1)
+                hits++;
+        }
+
+        return hits + TestScalar(x, y, z, radius, s, i, count, hitMask);
+    }
+
+    inline __m128 Gather4(const float* base, const Pair* pairs, bool query)
+    {
+        if(query)
+            return _mm_setr_ps(base[pairs[0].Query], base[pairs[1].Query], base[pairs[2].Query], base[pairs[3].Query]);
+        return _mm_setr_ps(base[pairs[0].Point], base[pairs[1].Point], base[pairs[2].Point], base[pairs[3].Point]);
+    }
+
+    std::uint32_t TestPairsSse(const Spheres& q, const Spheres& s, const Pair* pairs,
+        std::uint32_t count, Pair* out)
+    {
+        std::uint32_t n = 0;
+        std::uint32_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            const Pair* p = pairs + i;
+            int mask = OverlapMask4(
+                Gather4(q.X, p, true), Gather4(q.Y, p, true), Gather4(q.Z, p, true), Gather4(q.Radius, p, true),
+                Gather4(s.X, p, false), Gather4(s.Y, p, false), Gather4(s.Z, p, false), Gather4(s.Radius, p, false));
+
+            n += Compact((std::uint32_t)mask, p, out + n);
+        }
+
+        return n + TestPairsScalar(q, s, pairs, i, count, out + n);
+    }
+
+    //
+    // AVX2, 8 spheres at a time
+    //
+
+    AVX2_FUNCTION inline int OverlapMask8(__m256 qx, __m256 qy, __m256 qz, __m256 qr,
+        __m256 x, __m256 y, __m256 z, __m256 r)
+    {
+        __m256 dx = _mm256_sub_ps(x, qx);
+        __m256 dy = _mm256_sub_ps(y, qy);
+        __m256 dz = _mm256_sub_ps(z, qz);
+        __m256 sumR = _mm256_add_ps(qr, r);
+
+        // no FMA, it would round differently from the other paths.
+        __m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+            _mm256_mul_ps(dz, dz));
+        return _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(sumR, sumR), _CMP_LT_OQ));
+    }
+
+    AVX2_FUNCTION std::uint32_t TestAvx2(float x, float y, float z, float radius, const Spheres& s,
+        std::uint32_t count, std::uint32_t* hitMask)
+    {
+        const __m256 qx = _mm256_set1_ps(x);
+        const __m256 qy = _mm256_set1_ps(y);
+        const __m256 qz = _mm256_set1_ps(z);
+        const __m256 qr = _mm256_set1_ps(radius);
+
+        std::uint32_t hits = 0;
+        std::uint32_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            int mask = OverlapMask8(qx, qy, qz, qr, _mm256_loadu_ps(s.X + i), _mm256_loadu_ps(s.Y + i),
+                _mm256_loadu_ps(s.Z + i), _mm256_loadu_ps(s.Radius + i));
+
+            hitMask[i / 32] |= (std::uint32_t)mask << (i % 32);
+            hits += _mm_popcnt_u32((std::uint32_t)mask);
+        }
+
+        // the rest of the program may be built for SSE, avoid the AVX to SSE transition penalty.
+        _mm256_zeroupper();
+        return hits + TestScalar(x, y, z, radius, s, i, count, hitMask);
+    }
+
+    AVX2_FUNCTION std::uint32_t TestPairsAvx2(const Spheres& q, const Spheres& s, const Pair* pairs,
+        std::uint32_t count, Pair* out)
+    {
+        std::uint32_t n = 0;
+        std::uint32_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            // split 8 interleaved { Query, Point } pairs into a vector of each.  The shuffle works
+            // within 128-bit lanes, the permute puts the lanes back in order.
+            __m256 lo = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(pairs + i)));
+            __m256 hi = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(pairs + i + 4)));
+            __m256i queryIndex = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i pointIndex = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+
+            int mask = OverlapMask8(
+                _mm256_i32gather_ps(q.X, queryIndex, 4), _mm256_i32gather_ps(q.Y, queryIndex, 4),
+                _mm256_i32gather_ps(q.Z, queryIndex, 4), _mm256_i32gather_ps(q.Radius, queryIndex, 4),
+                _mm256_i32gather_ps(s.X, pointIndex, 4), _mm256_i32gather_ps(s.Y, pointIndex, 4),
+                _mm256_i32gather_ps(s.Z, pointIndex, 4), _mm256_i32gather_ps(s.Radius, pointIndex, 4));
+
+            n += Compact((std::uint32_t)mask, pairs + i, out + n);
+        }
+
+        _mm256_zeroupper();
+        return n + TestPairsScalar(q, s, pairs, i, count, out + n);
+    }
+
+#endif
+
+    //
+    // Dispatch
+    //
+
+    Path DetectPath()
+    {
+#if defined(SPHERE_OVERLAP_X86)
+        int info[4];
+        CpuId(info, 0, 0);
+        const int maxLeaf = info[0];
+
+        CpuId(info, 1, 0);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool popcnt = (info[2] & (1 << 23)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        if(!sse2)
+            return Path::Scalar;
+
+        // the OS has to save the ymm registers on context switches as well.
+        if(maxLeaf >= 7 && popcnt && osxsave && avx && (XGetBv(0) & 0x6) == 0x6)
+        {
+            CpuId(info, 7, 0);
+            if(info[1] & (1 << 5))
+                return Path::Avx2;
+        }
+
+        return Path::Sse;
+#else
+        return Path::Scalar;
+#endif
+    }
+
+    struct Dispatch
+    {
+        Path Supported = DetectPath();
+        Path Current = Supported;
+    };
+
+    Dispatch& GetDispatch()
+    {
+        static Dispatch dispatch;
+        return dispatch;
+    }
+}
+
+Path SphereOverlap::GetSupportedPath()
+{
+    return GetDispatch().Supported;
+}
+
+Path SphereOverlap::GetPath()
+{
+    return GetDispatch().Current;
+}
+
+void SphereOverlap::SetPath(Path path)
+{
+    assert(path <= GetSupportedPath());
+    GetDispatch().Current = path;
+}
+
+const char* SphereOverlap::GetPathName(Path path)
+{
+    switch(path)
+    {
+    case Path::Avx2:
+        return "AVX2";
+    case Path::Sse:
+        return "SSE";
+    default:
+        return "scalar";
+    }
+}
+
+std::uint32_t SphereOverlap::Test(float x, float y, float z, float radius, const Spheres& spheres,
+    std::uint32_t count, std::uint32_t* hitMask)
+{
+    for(std::uint32_t w = 0; w < GetMaskWordCount(count); ++w)
+        hitMask[w] = 0;
+
+    switch(GetPath())
+    {
+#if defined(SPHERE_OVERLAP_X86)
+    case Path::Avx2:
+        return TestAvx2(x, y, z, radius, spheres, count, hitMask);
+    case Path::Sse:
+        return TestSse(x, y, z, radius, spheres, count, hitMask);
+#endif
+    default:
+        return TestScalar(x, y, z, radius, spheres, 0, count, hitMask);
+    }
+}
+
+void SphereOverlap::AppendHits(const std::uint32_t* hitMask, std::uint32_t count, std::uint32_t query,
+    std::vector<Pair>& hits)
+{
+    for(std::uint32_t w = 0; w < GetMaskWordCount(count); ++w)
+    {
+        std::uint32_t mask = hitMask[w];
+        std::uint32_t bit;
+        while(BitScanForward(&bit, mask))
+        {
+            Pair pair = { query, w * 32 + bit };
+            hits.push_back(pair);
+            mask &= mask - 1;
+        }
+    }
+}
+
+std::uint32_t SphereOverlap::TestPairs(const Spheres& queries, const Spheres& spheres, const Pair* pairs,
+    std::uint32_t count, std::vector<Pair>& hits)
+{
+    // room for every pair to hit, trimmed to the hits afterwards.
+    const size_t base = hits.size();
+    hits.resize(base + count);
+    Pair* out = hits.data() + base;
+
+    std::uint32_t n;
+    switch(GetPath())
+    {
+#if defined(SPHERE_OVERLAP_X86)
+    case Path::Avx2:
+        n = TestPairsAvx2(queries, spheres, pairs, count, out);
+        break;
+    case Path::Sse:
+        n = TestPairsSse(queries, spheres, pairs, count, out);
+        break;
+#endif
+    default:
+        n = TestPairsScalar(queries, spheres, pairs, 0, count, out);
+        break;
+    }
+
+    hits.resize(base + n);
+    return n;
+}
+
+float SphereOverlap::TimeOfImpact(const MovingSpheres& a, std::uint32_t i, const MovingSpheres& b, std::uint32_t j)
+{
+    // in the frame of b, a starts at s and moves by v: solve |s + t v| = ra + rb for the
+    // smaller root t.
+    float sx = a.PrevX[i] - b.PrevX[j];
+    float sy = a.PrevY[i] - b.PrevY[j];
+    float sz = a.PrevZ[i] - b.PrevZ[j];
+    float vx = (a.X[i] - a.PrevX[i]) - (b.X[j] - b.PrevX[j]);
+    float vy = (a.Y[i] - a.PrevY[i]) - (b.Y[j] - b.PrevY[j]);
+    float vz = (a.Z[i] - a.PrevZ[i]) - (b.Z[j] - b.PrevZ[j]);
+    float sumR = a.Radius[i] + b.Radius[j];
+
+    float c = sx * sx + sy * sy + sz * sz - sumR * sumR;
+    if(c < 0.0f)
+        return 0.0f;
+
+    // not getting closer, which includes not moving relative to each other.
+    float bHalf = sx * vx + sy * vy + sz * vz;
+    if(bHalf >= 0.0f)
+        return -1.0f;
+
+    float vv = vx * vx + vy * vy + vz * vz;
+    float discriminant = bHalf * bHalf - vv * c;
+    if(discriminant < 0.0f)
+        return -1.0f;
+
+    float t = (-bHalf - std::sqrt(discriminant)) / vv;
+    return t <= 1.0f ? t : -1.0f;
+}
+
+void SphereOverlap::GetSweptBounds(const MovingSpheres& spheres, std::uint32_t count, SweptBounds& bounds)
+{
+    bounds.X.resize(count);
+    bounds.Y.resize(count);
+    bounds.Z.resize(count);
+    bounds.Radius.resize(count);
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        const float dx = spheres.X[i] - spheres.PrevX[i];
+        const float dy = spheres.Y[i] - spheres.PrevY[i];
+        const float dz = spheres.Z[i] - spheres.PrevZ[i];
+        const float halfTravel = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        // centered halfway along the sweep.  The overlap test is strict and the sweep counts
+        // touching spheres as meeting, the radius is padded so rounding can't drop such a hit.
+        bounds.X[i] = spheres.PrevX[i] + 0.5f * dx;
+        bounds.Y[i] = spheres.PrevY[i] + 0.5f * dy;
+        bounds.Z[i] = spheres.PrevZ[i] + 0.5f * dz;
+        bounds.Radius[i] = (spheres.Radius[i] + halfTravel) * 1.0001f + 1e-4f;
+    }
+}
+
+void SphereOverlap::GetSweptBoxes(const MovingSpheres& spheres, std::uint32_t count,
+    std::vector<SpatialHashGrid::Box>& boxes)
+{
+    boxes.resize(count);
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        const float r = spheres.Radius[i];
+        SpatialHashGrid::Box& box = boxes[i];
+        box.MinX = std::min<float>(spheres.PrevX[i], spheres.X[i]) - r;
+        box.MinY = std::min<float>(spheres.PrevY[i], spheres.Y[i]) - r;
+        box.MinZ = std::min<float>(spheres.PrevZ[i], spheres.Z[i]) - r;
+        box.MaxX = std::max<float>(spheres.PrevX[i], spheres.X[i]) + r;
+        box.MaxY = std::max<float>(spheres.PrevY[i], spheres.Y[i]) + r;
+        box.MaxZ = std::max<float>(spheres.PrevZ[i], spheres.Z[i]) + r;
+    }
+}
+
+std::uint32_t SphereOverlap::SweepPairs(const MovingSpheres& queries, const MovingSpheres& spheres,
+    const Pair* pairs, std::uint32_t count, std::vector<Impact>& impacts)
+{
+    // the broadphase leaves few pairs to sweep, they are tested one at a time.
+    std::uint32_t n = 0;
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        float t = TimeOfImpact(queries, pairs[i].Query, spheres, pairs[i].Point);
+        if(t >= 0.0f)
+        {
+            Impact impact = { pairs[i].Query, pairs[i].Point, t };
+            impacts.push_back(impact);
+            n++;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,124 @@
+//***************************************************************************************
+// SphereOverlap.h
+//
+// Batched sphere overlap tests for the collision narrowphase.  Spheres are given as separate
+// x, y, z, radius arrays, so one query is tested against 8 spheres per AVX2 instruction, or
+// 4 per SSE instruction.  The widest path the CPU supports is picked on first use, with a
+// scalar fallback, the only path on other targets than x86; every path gives the same results
+// as the scalar one.
+// Two spheres overlap when the distance between their centers is less than the sum of their
+// radii.
+// Fast spheres can pass through each other between two steps, SweepPairs() tests spheres
+// moving in straight lines over the step instead, and gives the time at which they meet.
+// Spheres can only meet if the spheres bounding their sweeps overlap (GetSweptBounds()), so
+// the batched tests prune the pairs before the sweep.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "SpatialHashGrid.h"
+
+namespace SphereOverlap
+{
+    enum class Path
+    {
+        Scalar,
+        Sse,
+        Avx2
+    };
+
+    struct Spheres
+    {
+        const float* X;
+        const float* Y;
+        const float* Z;
+        const float* Radius;
+    };
+
+    // Spheres moving in a straight line from (PrevX, PrevY, PrevZ) to (X, Y, Z) over a step.
+    struct MovingSpheres
+    {
+        const float* PrevX;
+        const float* PrevY;
+        const float* PrevZ;
+        const float* X;
+        const float* Y;
+        const float* Z;
+        const float* Radius;
+    };
+
+    // Bounding spheres of moving spheres over their whole step, stored as the arrays of Spheres.
+    struct SweptBounds
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> Radius;
+
+        Spheres GetSpheres()const
+        {
+            Spheres spheres = { X.data(), Y.data(), Z.data(), Radius.data() };
+            return spheres;
+        }
+    };
+
+    // Query indexes the queried spheres, Point the tested ones, as in the broadphase output.
+    using Pair = SpatialHashGrid::Pair;
+
+    struct Impact
+    {
+        std::uint32_t Query;
+        std::uint32_t Point;
+        float Time;             // fraction of the step at which the spheres start to overlap
+    };
+
+    // Widest path the CPU and the OS support.
+    Path GetSupportedPath();
+
+    // Path the tests run with, the supported one unless SetPath() narrowed it.
+    Path GetPath();
+
+    // Forces a path, e.g. to compare them.  It must not be wider than the supported one.
+    void SetPath(Path path);
+
+    const char* GetPathName(Path path);
+
+    // words of a hit mask for count spheres.
+    inline std::uint32_t GetMaskWordCount(std::uint32_t count) { return (count + 31) / 32; }
+
+    // Tests the sphere (x, y, z, radius) against spheres [0, count).  Bit i % 32 of
+    // hitMask[i / 32] is set if it overlaps sphere i, cleared otherwise.  hitMask must hold
+    // GetMaskWordCount(count) words.  Returns the number of overlapping spheres.
+    std::uint32_t Test(float x, float y, float z, float radius, const Spheres& spheres,
+        std::uint32_t count, std::uint32_t* hitMask);
+
+    // Appends { query, i } for every bit i set in a hit mask of count spheres.
+    void AppendHits(const std::uint32_t* hitMask, std::uint32_t count, std::uint32_t query,
+        std::vector<Pair>& hits);
+
+    // Tests sphere Query of queries against sphere Point of spheres for each of the count pairs
+    // and appends the overlapping pairs to hits, in order.  Returns the number appended.
+    std::uint32_t TestPairs(const Spheres& queries, const Spheres& spheres, const Pair* pairs,
+        std::uint32_t count, std::vector<Pair>& hits);
+
+    // Fraction of the step in [0, 1] at which sphere i of a and sphere j of b start to overlap,
+    // 0 if they overlap from the start, negative if they don't meet during the step.
+    float TimeOfImpact(const MovingSpheres& a, std::uint32_t i, const MovingSpheres& b, std::uint32_t j);
+
+    // Replaces bounds with the bounding sphere of each of count spheres over its whole step,
+    // for Test() and TestPairs().  Two moving spheres whose bounds don't overlap don't meet
+    // during the step.
+    void GetSweptBounds(const MovingSpheres& spheres, std::uint32_t count, SweptBounds& bounds);
+
+    // Replaces boxes with the bounds of each of count spheres over its whole step, for the
+    // broadphase (see SpatialHashGrid::BuildBoxes).
+    void GetSweptBoxes(const MovingSpheres& spheres, std::uint32_t count, std::vector<SpatialHashGrid::Box>& boxes);
+
+    // Sweeps sphere Query of queries against sphere Point of spheres for each of the count pairs
+    // and appends the ones that meet during the step to impacts, in order.  Returns the number
+    // appended.
+    std::uint32_t SweepPairs(const MovingSpheres& queries, const MovingSpheres& spheres, const Pair* pairs,
+        std::uint32_t count, std::vector<Impact>& impacts);
+}
@@ -0,0 +1,157 @@
+//***************************************************************************************
+// StagingAllocator.cpp
+//***************************************************************************************
+
+#include "StagingAllocator.h"
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+StagingAllocator::StagingAllocator(ID3D12Device* device, UINT64 pageSize, UINT maxFreePages) :
+    md3dDevice(device), mPageSize(pageSize), mMaxFreePages(maxFreePages)
+{
+}
+
+StagingAllocator::~StagingAllocator()
+{
+    // the owner waits for the copies to complete before destroying the allocator.
+    ReleasePage(mCurrentPage);
+    for(Page& page : mUsedPages)
+        ReleasePage(page);
+    for(Page& page : mFreePages)
+        ReleasePage(page);
+}
+
+StagingAllocator::Page StagingAllocator::CreatePage(UINT64 size)
+{
+    Page page;
+    page.Size = size;
+
+    ThrowIfFailed(md3dDevice->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(size),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&page.Resource)));
+
+    // upload pages stay mapped for their whole life, the CPU never reads from them.
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(page.Resource->Map(0, &readRange, reinterpret_cast<void**>(&page.CpuAddress)));
+
+    mReservedBytes += size;
+    return page;
+}
+
+void StagingAllocator::ReleasePage(Page& page)
+{
+    if(page.Resource == nullptr)
+        return;
+
+    page.Resource->Unmap(0, nullptr);
+    page.Resource = nullptr;
+    page.CpuAddress = nullptr;
+    mReservedBytes -= page.Size;
+}
+
+void StagingAllocator::CloseCurrentPage()
+{
+    if(mCurrentPage.Resource == nullptr)
+        return;
+
+    AddUsedPage(mCurrentPage);
+    mCurrentPage = Page();
+}
+
+void StagingAllocator::AddUsedPage(const Page& page)
+{
+    // Retire() stops at the first page still in flight, so the pages are kept in ticket order.
+    // A dedicated page can come with a later ticket than the current page closed after it.
+    auto position = std::upper_bound(mUsedPages.begin(), mUsedPages.end(), page.LastTicket,
+        [](Ticket ticket, const Page& usedPage) { return ticket < usedPage.LastTicket; });
+    mUsedPages.insert(position, page);
+}
+
+StagingAllocator::Allocation StagingAllocator::Allocate(UINT64 byteSize, UINT64 alignment, Ticket ticket)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    Allocation allocation;
+
+    // oversized requests get a page of their own, it doesn't disturb the current page.
+    if(byteSize > mPageSize)
+    {
+        Page page = CreatePage(byteSize);
+        page.Used = byteSize;
+        page.LastTicket = ticket;
+
+        allocation.Resource = page.Resource.Get();
+        allocation.CpuAddress = page.CpuAddress;
+
+        AddUsedPage(page);
+        mLiveBytes += byteSize;
+        return allocation;
+    }
+
+    UINT64 offset = (mCurrentPage.Used + alignment - 1) & ~(alignment - 1);
+    if(mCurrentPage.Resource == nullptr || offset + byteSize > mCurrentPage.Size)
+    {
+        CloseCurrentPage();
+
+        if(!mFreePages.empty())
+        {
+            mCurrentPage = mFreePages.back();
+            mFreePages.pop_back();
+        }
+        else
+        {
+            mCurrentPage = CreatePage(mPageSize);
+        }
+
+        offset = 0;
+    }
+
+    mLiveBytes += offset + byteSize - mCurrentPage.Used;
+    mCurrentPage.Used = offset + byteSize;
+    mCurrentPage.LastTicket = ticket;
+
+    allocation.Resource = mCurrentPage.Resource.Get();
+    allocation.Offset = offset;
+    allocation.CpuAddress = mCurrentPage.CpuAddress + offset;
+    return allocation;
+}
+
+void StagingAllocator::Retire(Ticket completedTicket)
+{
+    // the current page can only be rewound when nothing in it is still in flight.
+    if(mCurrentPage.Resource != nullptr && mCurrentPage.LastTicket <= completedTicket)
+    {
+        mLiveBytes -= mCurrentPage.Used;
+        mCurrentPage.Used = 0;
+
+        if(mFreePages.size() < mMaxFreePages)
+        {
+            mFreePages.push_back(mCurrentPage);
+            mCurrentPage = Page();
+        }
+        else
+        {
+            ReleasePage(mCurrentPage);
+        }
+    }
+
+    size_t retired = 0;
+    while(retired < mUsedPages.size() && mUsedPages[retired].LastTicket <= completedTicket)
+    {
+        Page& page = mUsedPages[retired++];
+        mLiveBytes -= page.Used;
+        page.Used = 0;
+
+        // dedicated pages don't fit the pool, nor does anything beyond its limit.
+        if(page.Size == mPageSize && mFreePages.size() < mMaxFreePages)
+            mFreePages.push_back(page);
+        else
+            ReleasePage(page);
+    }
+    mUsedPages.erase(mUsedPages.begin(), mUsedPages.begin() + retired);
+}
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// StagingAllocator.h
+//
+// Suballocates staging (upload heap) memory for copies out of a few large, persistently
+// mapped pages instead of one committed upload resource per copy.
+// Allocation is linear within the current page.  A page is tagged with the highest upload
+// ticket that used it, and once the copy fence has passed that ticket the page is recycled.
+// Requests larger than a page get a dedicated page which is released, not pooled, when it
+// retires.  At most MaxFreePages pages are kept for reuse, the rest is released, so after a
+// burst of uploads the staging footprint falls back to a small fixed pool.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class StagingAllocator
+{
+public:
+    using Ticket = UINT64;
+
+    struct Allocation
+    {
+        ID3D12Resource* Resource = nullptr;     // upload buffer the allocation lives in
+        UINT64 Offset = 0;                      // byte offset in Resource
+        BYTE* CpuAddress = nullptr;             // mapped address of the first byte
+    };
+
+    static const UINT64 DefaultPageSize = 4 * 1024 * 1024;
+    static const UINT DefaultMaxFreePages = 2;
+
+    StagingAllocator(ID3D12Device* device, UINT64 pageSize = DefaultPageSize, UINT maxFreePages = DefaultMaxFreePages);
+    StagingAllocator(const StagingAllocator& rhs) = delete;
+    StagingAllocator& operator=(const StagingAllocator& rhs) = delete;
+    ~StagingAllocator();
+
+    // The memory must not be reused before ticket has completed.
+    Allocation Allocate(UINT64 byteSize, UINT64 alignment, Ticket ticket);
+
+    // Recycles the pages whose last ticket is not beyond completedTicket.
+    void Retire(Ticket completedTicket);
+
+    // Bytes handed out and not retired yet.
+    UINT64 GetLiveBytes()const { return mLiveBytes; }
+    // Bytes of all pages currently allocated from the device, in use or pooled.
+    UINT64 GetReservedBytes()const { return mReservedBytes; }
+
+    UINT GetPageCount()const { return (UINT)(mUsedPages.size() + mFreePages.size()) + (mCurrentPage.Resource ? 1 : 0); }
+
+private:
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        BYTE* CpuAddress = nullptr;
+        UINT64 Size = 0;
+        UINT64 Used = 0;
+        Ticket LastTicket = 0;
+    };
+
+    Page CreatePage(UINT64 size);
+    void ReleasePage(Page& page);
+    void CloseCurrentPage();
+    void AddUsedPage(const Page& page);
+
+    ID3D12Device* md3dDevice;
+    UINT64 mPageSize;
+    UINT mMaxFreePages;
+
+    Page mCurrentPage;
+    std::vector<Page> mUsedPages;       // full or dedicated pages waiting for their ticket, in ticket order
+    std::vector<Page> mFreePages;
+
+    UINT64 mLiveBytes = 0;
+    UINT64 mReservedBytes = 0;
+};
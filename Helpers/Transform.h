@@ -0,0 +1,46 @@
+//***************************************************************************************
+// Transform.h
+//
+// Placement of a moving object: position, uniform scale and a rotation quaternion, the identity
+// unless the object turns.  It is half the size of a world matrix and whoever moves the object
+// writes it directly; the world matrix is composed from it only when it is needed, without any
+// matrix product: the rows of the rotation matrix are scaled, and the position is the last row.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+
+struct Transform
+{
+    DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };
+    float Scale = 1.0f;
+    DirectX::XMFLOAT4 Rotation = { 0.0f, 0.0f, 0.0f, 1.0f };   // unit quaternion
+};
+
+// The same matrix as XMMatrixScaling(s, s, s) * XMMatrixRotationQuaternion(q) * XMMatrixTranslation(p).
+inline DirectX::XMMATRIX ComposeWorldMatrix(const Transform& transform)
+{
+    using namespace DirectX;
+
+    const XMVECTOR scale = XMVectorReplicate(transform.Scale);
+
+    XMMATRIX world;
+    if(transform.Rotation.w == 1.0f)
+    {
+        // a unit quaternion with w = 1 is the identity.
+        world.r[0] = XMVectorMultiply(g_XMIdentityR0, scale);
+        world.r[1] = XMVectorMultiply(g_XMIdentityR1, scale);
+        world.r[2] = XMVectorMultiply(g_XMIdentityR2, scale);
+    }
+    else
+    {
+        const XMMATRIX rotation = XMMatrixRotationQuaternion(XMLoadFloat4(&transform.Rotation));
+        world.r[0] = XMVectorMultiply(rotation.r[0], scale);
+        world.r[1] = XMVectorMultiply(rotation.r[1], scale);
+        world.r[2] = XMVectorMultiply(rotation.r[2], scale);
+    }
+    world.r[3] = XMVectorSetW(XMLoadFloat3(&transform.Position), 1.0f);
+
+    return world;
+}
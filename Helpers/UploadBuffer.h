@@ -61,6 +61,15 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Copies only the byte range [byteOffset, byteOffset + byteSize) of an element.  Useful for
+    // constants whose members change at different rates (e.g. per frame vs. on resize).
+    void CopyData(int elementIndex, const T& data, UINT byteOffset, UINT byteSize)
+    {
+        assert(byteOffset + byteSize <= sizeof(T));
+        memcpy(&mMappedData[elementIndex*mElementByteSize + byteOffset],
+            reinterpret_cast<const BYTE*>(&data) + byteOffset, byteSize);
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
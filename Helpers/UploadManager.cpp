@@ -0,0 +1,175 @@
+//***************************************************************************************
+// UploadManager.cpp
+//***************************************************************************************
+
+#include "UploadManager.h"
+
+using Microsoft::WRL::ComPtr;
+
+UploadManager::UploadManager(ID3D12Device* device, PlacedResourceAllocator* resourceAllocator) :
+    md3dDevice(device), mResourceAllocator(resourceAllocator)
+{
+    mStaging = std::make_unique<StagingAllocator>(device);
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    ThrowIfFailed(md3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCopyQueue)));
+
+    // the fence holds the ticket of the last completed batch, tickets start at 1.
+    ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+
+    ThrowIfFailed(md3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+        IID_PPV_ARGS(mBatchAllocator.GetAddressOf())));
+
+    ThrowIfFailed(md3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+        mBatchAllocator.Get(), nullptr, IID_PPV_ARGS(mCommandList.GetAddressOf())));
+}
+
+UploadManager::~UploadManager()
+{
+    // staging memory and allocators must not be released while the copy queue still uses them.
+    if(mCopyQueue != nullptr)
+        WaitIdle();
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateDefaultResource(const D3D12_RESOURCE_DESC& desc)
+{
+    if(mResourceAllocator != nullptr)
+        return mResourceAllocator->CreateResource(desc, D3D12_RESOURCE_STATE_COMMON);
+
+    ComPtr<ID3D12Resource> resource;
+    ThrowIfFailed(md3dDevice->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(resource.GetAddressOf())));
+
+    return resource;
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateDefaultBuffer(const void* initData, UINT64 byteSize)
+{
+    ComPtr<ID3D12Resource> buffer = CreateDefaultResource(CD3DX12_RESOURCE_DESC::Buffer(byteSize));
+
+    // the copy promotes the buffer from COMMON to COPY_DEST implicitly.
+    StagingAllocator::Allocation staging = mStaging->Allocate(byteSize, 16, mTracker.GetBatchTicket());
+    memcpy(staging.CpuAddress, initData, (size_t)byteSize);
+    mCommandList->CopyBufferRegion(buffer.Get(), 0, staging.Resource, staging.Offset, byteSize);
+
+    mTracker.Track(buffer.Get());
+
+    return buffer;
+}
+
+ComPtr<ID3D12Resource> UploadManager::CreateTexture(DirectX::DDSTextureData12& data)
+{
+    D3D12_RESOURCE_DESC texDesc;
+    ThrowIfFailed(DirectX::GetDDSTextureDesc12(data, texDesc));
+    ComPtr<ID3D12Resource> texture = CreateDefaultResource(texDesc);
+
+    // texture data in a buffer has to start at a 512 byte boundary.
+    const UINT numSubresources = (UINT)data.InitData.size();
+    const UINT64 stagingSize = GetRequiredIntermediateSize(texture.Get(), 0, numSubresources);
+    StagingAllocator::Allocation staging = mStaging->Allocate(stagingSize,
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, mTracker.GetBatchTicket());
+
+    if(UpdateSubresources(mCommandList.Get(), texture.Get(), staging.Resource, staging.Offset,
+        0, numSubresources, data.InitData.data()) == 0)
+    {
+        ThrowIfFailed(E_FAIL);
+    }
+
+    mTracker.Track(texture.Get());
+
+    return texture;
+}
+
+UploadManager::Ticket UploadManager::Submit()
+{
+    if(mTracker.IsBatchEmpty())
+        return mTracker.GetLastSubmittedTicket();
+
+    ThrowIfFailed(mCommandList->Close());
+    ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+    mCopyQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+    Ticket ticket = mTracker.Submit();
+    ThrowIfFailed(mCopyQueue->Signal(mFence.Get(), ticket));
+
+    mAllocators.emplace_back(ticket, mBatchAllocator);
+    BeginBatch();
+
+    return ticket;
+}
+
+void UploadManager::BeginBatch()
+{
+    Ticket completed = GetCompletedTicket();
+
+    // reuse the allocator of a completed batch if there is one.
+    mBatchAllocator = nullptr;
+    for(size_t i = 0; i < mAllocators.size(); ++i)
+    {
+        if(mAllocators[i].first <= completed)
+        {
+            mBatchAllocator = mAllocators[i].second;
+            mAllocators.erase(mAllocators.begin() + i);
+            ThrowIfFailed(mBatchAllocator->Reset());
+            break;
+        }
+    }
+
+    if(mBatchAllocator == nullptr)
+    {
+        ThrowIfFailed(md3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+            IID_PPV_ARGS(mBatchAllocator.GetAddressOf())));
+    }
+
+    // a command list may be reset as soon as it has been submitted.
+    ThrowIfFailed(mCommandList->Reset(mBatchAllocator.Get(), nullptr));
+}
+
+bool UploadManager::IsResident(ID3D12Resource* resource)
+{
+    return mTracker.IsResident(resource, GetCompletedTicket());
+}
+
+bool UploadManager::IsComplete(Ticket ticket)
+{
+    return ticket <= GetCompletedTicket();
+}
+
+void UploadManager::WaitOnQueue(ID3D12CommandQueue* queue, Ticket ticket)
+{
+    if(!IsComplete(ticket))
+        ThrowIfFailed(queue->Wait(mFence.Get(), ticket));
+}
+
+void UploadManager::WaitIdle()
+{
+    Ticket lastSubmitted = mTracker.GetLastSubmittedTicket();
+    if(!IsComplete(lastSubmitted))
+    {
+        HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+        ThrowIfFailed(mFence->SetEventOnCompletion(lastSubmitted, eventHandle));
+        WaitForSingleObject(eventHandle, INFINITE);
+        CloseHandle(eventHandle);
+    }
+
+    Retire();
+}
+
+void UploadManager::Retire()
+{
+    Ticket completed = GetCompletedTicket();
+    mTracker.Retire(completed);
+    mStaging->Retire(completed);
+}
+
+UploadManager::Ticket UploadManager::GetCompletedTicket()
+{
+    return mFence->GetCompletedValue();
+}
@@ -0,0 +1,81 @@
+//***************************************************************************************
+// UploadManager.h
+//
+// Uploads static data (vertex/index buffers, textures) through a dedicated copy queue, so
+// the copies run alongside whatever the direct queue is doing.
+// Uploads are recorded into the current batch, Submit() sends it to the copy queue and
+// returns its ticket.  Instead of blocking, callers can ask whether a resource is resident
+// yet, or make another queue wait for a ticket on the GPU.
+// Source data is staged in pooled upload pages (see StagingAllocator).  Destination resources
+// are placed in shared heaps when a PlacedResourceAllocator is given, committed otherwise.
+//
+// Destination resources are left in the COMMON state: a copy queue can't transition them to
+// shader or vertex buffer states, and resources in COMMON are implicitly promoted to the read
+// states the direct queue uses them in.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "PlacedResourceAllocator.h"
+#include "StagingAllocator.h"
+#include "UploadTracker.h"
+
+class UploadManager
+{
+public:
+    using Ticket = UploadTracker<Microsoft::WRL::ComPtr<ID3D12Resource>>::Ticket;
+
+    UploadManager(ID3D12Device* device, PlacedResourceAllocator* resourceAllocator = nullptr);
+    UploadManager(const UploadManager& rhs) = delete;
+    UploadManager& operator=(const UploadManager& rhs) = delete;
+    ~UploadManager();
+
+    // Copy command list of the current batch, open for recording.
+    ID3D12GraphicsCommandList* GetCommandList()const { return mCommandList.Get(); }
+
+    // Creates a default heap buffer and records the upload of its contents into the current batch.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(const void* initData, UINT64 byteSize);
+
+    // Creates a texture and records the upload of a loaded DDS file into the current batch.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateTexture(DirectX::DDSTextureData12& data);
+
+    // Executes the current batch on the copy queue and starts a new one.  Returns the ticket
+    // of the submitted batch, an empty batch is not submitted and returns the last ticket.
+    Ticket Submit();
+
+    bool IsResident(ID3D12Resource* resource);
+    bool IsComplete(Ticket ticket);
+
+    // Makes queue wait on the GPU until the batch of ticket has executed, the CPU doesn't block.
+    void WaitOnQueue(ID3D12CommandQueue* queue, Ticket ticket);
+
+    // Blocks the CPU until everything submitted has executed.
+    void WaitIdle();
+
+    // Releases staging memory and command allocators of completed batches.
+    void Retire();
+
+    Ticket GetCompletedTicket();
+
+    UINT64 GetLiveStagingBytes()const { return mStaging->GetLiveBytes(); }
+    UINT64 GetReservedStagingBytes()const { return mStaging->GetReservedBytes(); }
+
+private:
+    void BeginBatch();
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultResource(const D3D12_RESOURCE_DESC& desc);
+
+    ID3D12Device* md3dDevice;
+    PlacedResourceAllocator* mResourceAllocator;
+
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCopyQueue;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList;
+    Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+
+    // allocators of submitted batches, reused once their ticket has completed.
+    std::vector<std::pair<Ticket, Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>> mAllocators;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mBatchAllocator;
+
+    std::unique_ptr<StagingAllocator> mStaging;
+    UploadTracker<Microsoft::WRL::ComPtr<ID3D12Resource>> mTracker;
+};
@@ -0,0 +1,111 @@
+//***************************************************************************************
+// UploadTracker.h
+//
+// Bookkeeping of uploads done on a separate queue, kept apart from the queue and fence
+// themselves so it can be driven by plain numbers: the completed ticket passed in stands for
+// the value of the fence.
+// Uploads are recorded in batches.  A batch is identified by its ticket, the fence value the
+// upload queue signals once the batch has executed; tickets increase by one per batch.
+// The tracker remembers the ticket of every destination resource until it has completed,
+// and keeps the staging memory of a batch alive until then.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template<typename Staging>
+class UploadTracker
+{
+public:
+    using Ticket = std::uint64_t;
+
+    // Tickets start after firstTicket - 1, which counts as already completed.
+    UploadTracker(Ticket firstTicket = 1) : mBatchTicket(firstTicket)
+    {
+    }
+
+    UploadTracker(const UploadTracker& rhs) = delete;
+    UploadTracker& operator=(const UploadTracker& rhs) = delete;
+
+    // Ticket the batch being recorded will complete with.
+    Ticket GetBatchTicket()const { return mBatchTicket; }
+
+    bool IsBatchEmpty()const { return mBatchEmpty; }
+
+    // Ticket of the last batch submitted, firstTicket - 1 before the first one.
+    Ticket GetLastSubmittedTicket()const { return mBatchTicket - 1; }
+
+    // The data of resource is written by the batch being recorded.
+    Ticket Track(const void* resource)
+    {
+        mTickets[resource] = mBatchTicket;
+        mBatchEmpty = false;
+        return mBatchTicket;
+    }
+
+    // staging has to outlive the batch being recorded.
+    void Hold(Staging staging)
+    {
+        mStaging.emplace_back(mBatchTicket, std::move(staging));
+        mBatchEmpty = false;
+    }
+
+    // Closes the batch being recorded and returns its ticket, the value to signal after it.
+    // An empty batch isn't closed, it uses no ticket and the last submitted one is returned.
+    Ticket Submit()
+    {
+        if(mBatchEmpty)
+            return GetLastSubmittedTicket();
+
+        Ticket ticket = mBatchTicket++;
+        mBatchEmpty = true;
+        return ticket;
+    }
+
+    // Ticket of the last upload into resource, 0 if there is none pending.
+    Ticket GetTicket(const void* resource)const
+    {
+        auto it = mTickets.find(resource);
+        return it == mTickets.end() ? 0 : it->second;
+    }
+
+    // Resources the tracker knows nothing about were either uploaded long ago or never
+    // uploaded through it, both count as resident.
+    bool IsResident(const void* resource, Ticket completedTicket)const
+    {
+        return GetTicket(resource) <= completedTicket;
+    }
+
+    // Forgets everything up to completedTicket and releases the staging memory it held.
+    void Retire(Ticket completedTicket)
+    {
+        for(auto it = mTickets.begin(); it != mTickets.end(); )
+        {
+            if(it->second <= completedTicket)
+                it = mTickets.erase(it);
+            else
+                ++it;
+        }
+
+        // staging memory is held in ticket order.
+        std::size_t retired = 0;
+        while(retired < mStaging.size() && mStaging[retired].first <= completedTicket)
+            retired++;
+        mStaging.erase(mStaging.begin(), mStaging.begin() + retired);
+    }
+
+    std::size_t GetPendingResourceCount()const { return mTickets.size(); }
+    std::size_t GetHeldStagingCount()const { return mStaging.size(); }
+
+private:
+    Ticket mBatchTicket;
+    bool mBatchEmpty = true;
+
+    std::unordered_map<const void*, Ticket> mTickets;
+    std::vector<std::pair<Ticket, Staging>> mStaging;
+};
@@ -0,0 +1,189 @@
+//***************************************************************************************
+// VertexCompression.cpp
+//***************************************************************************************
+
+#include "VertexCompression.h"
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    const float UnormMax = 65535.0f;
+    const float SnormMax = 32767.0f;
+
+    float SignNotZero(float x)
+    {
+        return x >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    float Clamp(float x, float lo, float hi)
+    {
+        return x < lo ? lo : (x > hi ? hi : x);
+    }
+
+    std::int16_t ToSnorm16(float x)
+    {
+        return (std::int16_t)std::floor(Clamp(x, -1.0f, 1.0f) * SnormMax + 0.5f);
+    }
+
+    float FromSnorm16(std::int16_t x)
+    {
+        // -32768 and -32767 both map to -1.
+        return Clamp(x / SnormMax, -1.0f, 1.0f);
+    }
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // angle between two unit vectors, exact for the tiny angles acos can't resolve in float.
+    double AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        double dx = (double)a.x - b.x;
+        double dy = (double)a.y - b.y;
+        double dz = (double)a.z - b.z;
+        double chord = std::sqrt(dx * dx + dy * dy + dz * dz);
+        return 2.0 * std::asin(chord < 2.0 ? 0.5 * chord : 1.0);
+    }
+}
+
+PositionDecode VertexCompression::GetPositionDecode(const BoundingBox& bounds)
+{
+    PositionDecode decode;
+    decode.Scale = XMFLOAT3(2.0f * bounds.Extents.x, 2.0f * bounds.Extents.y, 2.0f * bounds.Extents.z);
+    decode.Offset = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y,
+        bounds.Center.z - bounds.Extents.z);
+    return decode;
+}
+
+XMFLOAT2 VertexCompression::OctEncode(const XMFLOAT3& n)
+{
+    // project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals.
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    XMFLOAT2 e(n.x / l1, n.y / l1);
+
+    if(n.z < 0.0f)
+    {
+        float x = e.x;
+        e.x = (1.0f - std::fabs(e.y)) * SignNotZero(x);
+        e.y = (1.0f - std::fabs(x)) * SignNotZero(e.y);
+    }
+
+    return e;
+}
+
+XMFLOAT3 VertexCompression::OctDecode(const XMFLOAT2& e)
+{
+    // same steps as OctDecode() in Shared.hlsl.
+    XMFLOAT3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = Clamp(-n.z, 0.0f, 1.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+
+    float length = std::sqrt(Dot(n, n));
+    return XMFLOAT3(n.x / length, n.y / length, n.z / length);
+}
+
+CompactVertex VertexCompression::Encode(const XMFLOAT3& pos, const XMFLOAT3& normal,
+    const XMFLOAT2& texC, const PositionDecode& decode)
+{
+    CompactVertex v;
+
+    const float p[3] = { pos.x, pos.y, pos.z };
+    const float scale[3] = { decode.Scale.x, decode.Scale.y, decode.Scale.z };
+    const float offset[3] = { decode.Offset.x, decode.Offset.y, decode.Offset.z };
+    for(int i = 0; i < 3; ++i)
+    {
+        // a flat axis decodes to its offset whatever is stored.
+        float q = scale[i] > 0.0f ? (p[i] - offset[i]) / scale[i] : 0.0f;
+        v.Pos[i] = (std::uint16_t)std::floor(Clamp(q, 0.0f, 1.0f) * UnormMax + 0.5f);
+    }
+    v.Pos[3] = 0;
+
+    // rounding each component on its own isn't always the closest code, pick the best of the
+    // four codes around the exact encoding.
+    XMFLOAT2 e = OctEncode(normal);
+    float bx = std::floor(Clamp(e.x, -1.0f, 1.0f) * SnormMax);
+    float by = std::floor(Clamp(e.y, -1.0f, 1.0f) * SnormMax);
+    double bestAngle = DBL_MAX;
+    for(int i = 0; i < 4; ++i)
+    {
+        std::int16_t cx = ToSnorm16((bx + (i & 1)) / SnormMax);
+        std::int16_t cy = ToSnorm16((by + (i >> 1)) / SnormMax);
+        double angle = AngleBetween(normal, OctDecode(XMFLOAT2(FromSnorm16(cx), FromSnorm16(cy))));
+        if(angle < bestAngle)
+        {
+            bestAngle = angle;
+            v.Normal[0] = cx;
+            v.Normal[1] = cy;
+        }
+    }
+
+    v.TexC[0] = XMConvertFloatToHalf(texC.x);
+    v.TexC[1] = XMConvertFloatToHalf(texC.y);
+
+    return v;
+}
+
+void VertexCompression::Decode(const CompactVertex& v, const PositionDecode& decode,
+    XMFLOAT3& pos, XMFLOAT3& normal, XMFLOAT2& texC)
+{
+    pos.x = v.Pos[0] / UnormMax * decode.Scale.x + decode.Offset.x;
+    pos.y = v.Pos[1] / UnormMax * decode.Scale.y + decode.Offset.y;
+    pos.z = v.Pos[2] / UnormMax * decode.Scale.z + decode.Offset.z;
+
+    normal = OctDecode(XMFLOAT2(FromSnorm16(v.Normal[0]), FromSnorm16(v.Normal[1])));
+
+    texC.x = XMConvertHalfToFloat(v.TexC[0]);
+    texC.y = XMConvertHalfToFloat(v.TexC[1]);
+}
+
+XMFLOAT3 VertexCompression::GetMaxPositionError(const PositionDecode& decode)
+{
+    // half a quantization step, plus the float rounding of the decode at the far end of the range.
+    const float s[3] = { decode.Scale.x, decode.Scale.y, decode.Scale.z };
+    const float o[3] = { decode.Offset.x, decode.Offset.y, decode.Offset.z };
+    float error[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        float magnitude = std::fabs(o[i]) + std::fabs(s[i]);
+        error[i] = 0.5f * s[i] / UnormMax + 4.0f * FLT_EPSILON * magnitude;
+    }
+    return XMFLOAT3(error[0], error[1], error[2]);
+}
+
+float VertexCompression::GetMaxTexCoordError(float texC)
+{
+    // halves keep 11 significant bits, below the smallest normal half the step is 2^-24.
+    float relative = std::fabs(texC) * std::ldexp(1.0f, -11);
+    float denormal = std::ldexp(1.0f, -25);
+    return relative > denormal ? relative : denormal;
+}
+
+bool VertexCompression::IsWithinErrorBounds(const CompactVertex& v, const PositionDecode& decode,
+    const XMFLOAT3& pos, const XMFLOAT3& normal, const XMFLOAT2& texC)
+{
+    XMFLOAT3 decodedPos;
+    XMFLOAT3 decodedNormal;
+    XMFLOAT2 decodedTexC;
+    Decode(v, decode, decodedPos, decodedNormal, decodedTexC);
+
+    XMFLOAT3 posError = GetMaxPositionError(decode);
+    if(std::fabs(decodedPos.x - pos.x) > posError.x ||
+        std::fabs(decodedPos.y - pos.y) > posError.y ||
+        std::fabs(decodedPos.z - pos.z) > posError.z)
+    {
+        return false;
+    }
+
+    // normal is expected to be unit length.
+    if(AngleBetween(normal, decodedNormal) > MaxNormalError)
+        return false;
+
+    return std::fabs(decodedTexC.x - texC.x) <= GetMaxTexCoordError(texC.x) &&
+        std::fabs(decodedTexC.y - texC.y) <= GetMaxTexCoordError(texC.y);
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// VertexCompression.h
+//
+// Compact 16 byte vertex for static meshes, half the size of a full float vertex:
+//  - position: 16-bit unorm per axis, relative to the bounds of the submesh.  The shader
+//    rebuilds it as q * Scale + Offset with the PositionDecode of the submesh.
+//  - normal: octahedral encoding in 2 x 16-bit snorm.
+//  - texture coordinates: half precision floats.
+// The Get*Error functions give the worst error the encoding may introduce, Encode() results
+// can be checked against them with IsWithinErrorBounds().
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <DirectXCollision.h>
+
+struct CompactVertex
+{
+    std::uint16_t Pos[4];                       // DXGI_FORMAT_R16G16B16A16_UNORM, w unused
+    std::int16_t Normal[2];                     // DXGI_FORMAT_R16G16_SNORM
+    DirectX::PackedVector::HALF TexC[2];        // DXGI_FORMAT_R16G16_FLOAT
+};
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay 16 bytes");
+
+// maps a quantized position in [0, 1]^3 back to local space: pos = q * Scale + Offset.
+struct PositionDecode
+{
+    DirectX::XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+    DirectX::XMFLOAT3 Offset = { 0.0f, 0.0f, 0.0f };
+};
+
+namespace VertexCompression
+{
+    // angle in radians between a unit normal and its decoded octahedral encoding.
+    const float MaxNormalError = 1.0e-4f;
+
+    PositionDecode GetPositionDecode(const DirectX::BoundingBox& bounds);
+
+    CompactVertex Encode(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& normal,
+        const DirectX::XMFLOAT2& texC, const PositionDecode& decode);
+
+    // Decodes like the COMPACT_VERTEX vertex shader does.
+    void Decode(const CompactVertex& v, const PositionDecode& decode,
+        DirectX::XMFLOAT3& pos, DirectX::XMFLOAT3& normal, DirectX::XMFLOAT2& texC);
+
+    // Octahedral mapping of a unit vector to [-1, 1]^2 and back.
+    DirectX::XMFLOAT2 OctEncode(const DirectX::XMFLOAT3& n);
+    DirectX::XMFLOAT3 OctDecode(const DirectX::XMFLOAT2& e);
+
+    // worst error per axis of a position inside the bounds of decode.
+    DirectX::XMFLOAT3 GetMaxPositionError(const PositionDecode& decode);
+
+    // worst error of a texture coordinate stored as a half.
+    float GetMaxTexCoordError(float texC);
+
+    bool IsWithinErrorBounds(const CompactVertex& v, const PositionDecode& decode,
+        const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& texC);
+}
@@ -91,6 +91,12 @@ int D3DApp::Run()
 			if( !mAppPaused )
 			{
 				CalculateFrameStats();
+
+				// simulate first, the frame then draws the state the steps left.
+				UINT steps = mStepLoop.Advance(mTimer.DeltaTime());
+				for(UINT i = 0; i < steps; ++i)
+					UpdateStep(mStepLoop.GetStepSeconds());
+
 				Update(mTimer);	
                 Draw(mTimer);
 			}
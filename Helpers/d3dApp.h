@@ -11,6 +11,7 @@
 
 #include "d3dUtil.h"
 #include "GameTimer.h"
+#include "FixedStepLoop.h"
 
 // Link necessary d3d12 libraries.
 #pragma comment(lib,"d3dcompiler.lib")
@@ -46,6 +47,9 @@ protected:
     virtual void CreateRtvAndDsvDescriptorHeaps();
 	virtual void OnResize(); 
 	virtual void Update(const GameTimer& gt)=0;
+	// Advances the simulation by dt seconds, before Update().  With a step rate set on mStepLoop
+	// it runs at that rate, zero or more times per frame, otherwise once per frame.
+	virtual void UpdateStep(float /*dt*/){ }
     virtual void Draw(const GameTimer& gt)=0;
 
 	// Convenience overrides for handling mouse input.
@@ -90,6 +94,9 @@ protected:
 
 	// Used to keep track of the Delta-time and game time (?.4).
 	GameTimer mTimer;
+
+	// Steps UpdateStep() runs per frame, derived classes can set a fixed step rate.
+	FixedStepLoop mStepLoop;
 	
     Microsoft::WRL::ComPtr<IDXGIFactory4> mdxgiFactory;
     Microsoft::WRL::ComPtr<IDXGISwapChain> mSwapChain;
@@ -1,8 +1,11 @@
  
 #include "d3dUtil.h"
+#include "ShaderCache.h"
 #include <comdef.h>
 #include <fstream>
 
+#pragma comment(lib, "version.lib")
+
 using Microsoft::WRL::ComPtr;
 
 DxException::DxException(HRESULT hr, const std::wstring& functionName, const std::wstring& filename, int lineNumber) :
@@ -73,11 +76,16 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
     // Schedule to copy the data to the default buffer resource.  At a high level, the helper function UpdateSubresources
     // will copy the CPU memory into the intermediate upload heap.  Then, using ID3D12CommandList::CopySubresourceRegion,
     // the intermediate upload heap data will be copied to mBuffer.
-    cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
-        D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
+    // On a copy queue the buffer stays in COMMON: the copy promotes it to COPY_DEST implicitly and
+    // buffers are promoted to whatever read state the direct queue uses them in.
+    const bool transition = cmdList->GetType() != D3D12_COMMAND_LIST_TYPE_COPY;
+    if(transition)
+        cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
     UpdateSubresources<1>(cmdList, defaultBuffer.Get(), uploadBuffer.Get(), 0, 0, 1, &subResourceData);
-    cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+    if(transition)
+        cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
 
     // Note: uploadBuffer has to be kept alive after the above function calls because
     // the command list has not been executed yet that performs the actual copy.
@@ -93,10 +101,7 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     const std::string& entrypoint,
     const std::string& target)
 {
-    UINT compileFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG)  
-    compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
+    UINT compileFlags = ShaderCompileFlags();
 
     HRESULT hr = S_OK;
 
@@ -113,6 +118,76 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     return byteCode;
 }
 
+ComPtr<ID3DBlob> d3dUtil::CompileShaderCached(
+    ShaderCache& cache,
+    const std::wstring& filename,
+    const D3D_SHADER_MACRO* defines,
+    const std::string& entrypoint,
+    const std::string& target)
+{
+    ShaderCache::Request request;
+    request.SourcePath = WStringToAnsi(filename);
+    for(const D3D_SHADER_MACRO* d = defines; d != nullptr && d->Name != nullptr; ++d)
+        request.Defines.push_back({ d->Name, d->Definition != nullptr ? d->Definition : "" });
+    request.EntryPoint = entrypoint;
+    request.Target = target;
+    request.Flags = ShaderCompileFlags();
+
+    // a hit is read straight into the blob, a miss returns the compiler's blob.
+    ComPtr<ID3DBlob> byteCode;
+    cache.GetOrCompileInto(request,
+        [&](const ShaderCache::Request&)
+        {
+            byteCode = CompileShader(filename, defines, entrypoint, target);
+            return ShaderCache::BytecodeView{ static_cast<const char*>(byteCode->GetBufferPointer()), byteCode->GetBufferSize() };
+        },
+        [&](std::size_t size)
+        {
+            byteCode = nullptr;
+            ThrowIfFailed(D3DCreateBlob(size, byteCode.GetAddressOf()));
+            return static_cast<char*>(byteCode->GetBufferPointer());
+        });
+
+    return byteCode;
+}
+
+std::string d3dUtil::ShaderCompilerId()
+{
+    std::string id = D3DCOMPILER_DLL_A;
+
+    // The DLL is loaded through the import library, its file version changes with every
+    // Windows SDK / redistributable update even though D3D_COMPILER_VERSION stays at 47.
+    HMODULE module = GetModuleHandleW(D3DCOMPILER_DLL_W);
+    wchar_t path[MAX_PATH];
+    if(module == nullptr || GetModuleFileNameW(module, path, MAX_PATH) == 0)
+        return id;
+
+    DWORD handle = 0;
+    DWORD size = GetFileVersionInfoSizeW(path, &handle);
+    std::vector<char> info(size);
+    VS_FIXEDFILEINFO* fixedInfo = nullptr;
+    UINT fixedInfoSize = 0;
+    if(size == 0 || !GetFileVersionInfoW(path, 0, size, info.data()) ||
+        !VerQueryValueW(info.data(), L"\\", reinterpret_cast<void**>(&fixedInfo), &fixedInfoSize) ||
+        fixedInfo == nullptr)
+        return id;
+
+    return id + " " +
+        std::to_string(HIWORD(fixedInfo->dwFileVersionMS)) + "." +
+        std::to_string(LOWORD(fixedInfo->dwFileVersionMS)) + "." +
+        std::to_string(HIWORD(fixedInfo->dwFileVersionLS)) + "." +
+        std::to_string(LOWORD(fixedInfo->dwFileVersionLS));
+}
+
+UINT d3dUtil::ShaderCompileFlags()
+{
+    UINT compileFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)  
+    compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+    return compileFlags;
+}
+
 std::wstring DxException::ToString()const
 {
     // Get the string description of the error code.
@@ -28,6 +28,9 @@
 #include "d3dx12.h"
 #include "DDSTextureLoader.h"
 #include "MathHelper.h"
+#include "CommonConstants.h"
+
+class ShaderCache;
 
 //extern const int gNumFrameResources;
 extern const int gNumFrameBuffers;
@@ -61,6 +64,13 @@ inline std::wstring AnsiToWString(const std::string& str)
     return std::wstring(buffer);
 }
 
+inline std::string WStringToAnsi(const std::wstring& str)
+{
+    CHAR buffer[512];
+    WideCharToMultiByte(CP_ACP, 0, str.c_str(), -1, buffer, 512, nullptr, nullptr);
+    return std::string(buffer);
+}
+
 /*
 #if defined(_DEBUG)
     #ifndef Assert
@@ -132,6 +142,21 @@ public:
 		const D3D_SHADER_MACRO* defines,
 		const std::string& entrypoint,
 		const std::string& target);
+
+    // Same as CompileShader, but the bytecode is taken from the on-disk shader cache when
+    // neither the sources (includes too) nor the compile parameters have changed since it was stored.
+    // Cache entries have a header and checksum in front of the bytecode, LoadBinary can't read them.
+	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShaderCached(
+		ShaderCache& cache,
+		const std::wstring& filename,
+		const D3D_SHADER_MACRO* defines,
+		const std::string& entrypoint,
+		const std::string& target);
+
+    // Name and file version of the d3dcompiler DLL in use, the compiler part of the shader cache key.
+    static std::string ShaderCompilerId();
+
+    static UINT ShaderCompileFlags();
 };
 
 class DxException
@@ -218,18 +243,6 @@ struct MeshGeometry
 	}
 };
 
-struct Light
-{
-    DirectX::XMFLOAT3 Strength = { 0.5f, 0.5f, 0.5f };
-    float FalloffStart = 1.0f;                          // point/spot light only
-    DirectX::XMFLOAT3 Direction = { 0.0f, -1.0f, 0.0f };// directional/spot light only
-    float FalloffEnd = 10.0f;                           // point/spot light only
-    DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };  // point/spot light only
-    float SpotPower = 64.0f;                            // spot light only
-};
-
-#define MaxLights   16
-
 struct MaterialConstants
 {
 	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -0,0 +1,178 @@
+// InputRecording.cpp
+
+#include "InputRecording.h"
+#include <cassert>
+#include <sstream>
+
+using namespace std;
+
+static_assert(sizeof(GameInput) == 1, "a recording stores a byte per step");
+
+// the file starts with the header, the input of each step follows. both platforms the game builds
+// for are little endian, the header is written as it is in memory.
+struct RecordingHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Seed;
+	uint32_t ShellCapacity;
+	uint32_t EnemyCapacity;
+	double TickRate;
+	uint64_t StepCount;			// written by Close()
+	uint64_t StateHash;			// written by Close()
+};
+
+static const uint32_t gRecordingMagic = 0x52494346;		// "FCIR"
+static const uint32_t gRecordingVersion = 2;		// 2: the world draws from RandomStream
+static const uint32_t gLegacyRecordingVersion = 1;	// 1: the world drew from std::mt19937, replayed with LegacyRandom
+
+RecordingOptions ParseRecordingOptions(const char* cmdLine, GameSettings& settings)
+{
+	RecordingOptions options;
+
+	istringstream args(cmdLine != nullptr ? cmdLine : "");
+	string option;
+	while (args >> option)
+	{
+		if (option == "-record")
+		{
+			args >> options.RecordPath;
+		}
+		else if (option == "-replay")
+		{
+			args >> options.ReplayPath;
+		}
+	}
+
+	if ((!options.RecordPath.empty() || !options.ReplayPath.empty()) && settings.TickRate <= 0.0)
+	{
+		settings.TickRate = 60.0;
+	}
+
+	return options;
+}
+
+InputRecorder::InputRecorder(uint32_t capacity)
+{
+	assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+	mRing.resize(capacity);
+}
+
+InputRecorder::~InputRecorder()
+{
+	if (IsOpen())
+	{
+		Close(0);
+	}
+}
+
+bool InputRecorder::Open(const string& path, const GameSettings& settings)
+{
+	assert(!IsOpen());
+	assert(settings.TickRate > 0.0);
+
+	mFile.open(path, ios::binary | ios::trunc);
+	if (!mFile)
+	{
+		return false;
+	}
+
+	mSettings = settings;
+	mStepCount = 0;
+	mWrittenCount = 0;
+
+	// the counts are not known yet, the header is written again by Close().
+	WriteHeader(0);
+	return true;
+}
+
+void InputRecorder::Record(GameInput input)
+{
+	assert(IsOpen());
+
+	const uint64_t half = mRing.size() / 2;
+	mRing[mStepCount & (mRing.size() - 1)] = input;
+	mStepCount++;
+
+	// a half just filled up, it is contiguous in the ring.
+	if (mStepCount % half == 0)
+	{
+		mFile.write((const char*)&mRing[mWrittenCount & (mRing.size() - 1)], half);
+		mWrittenCount += half;
+	}
+}
+
+void InputRecorder::Close(uint64_t stateHash)
+{
+	assert(IsOpen());
+
+	// the steps not written yet are in the half being filled.
+	mFile.write((const char*)&mRing[mWrittenCount & (mRing.size() - 1)], mStepCount - mWrittenCount);
+	mWrittenCount = mStepCount;
+
+	mFile.seekp(0);
+	WriteHeader(stateHash);
+	mFile.close();
+}
+
+void InputRecorder::WriteHeader(uint64_t stateHash)
+{
+	RecordingHeader header = {};
+	header.Magic = gRecordingMagic;
+	header.Version = mSettings.LegacyRandom ? gLegacyRecordingVersion : gRecordingVersion;
+	header.Seed = mSettings.Seed;
+	header.ShellCapacity = mSettings.ShellCapacity;
+	header.EnemyCapacity = mSettings.EnemyCapacity;
+	header.TickRate = mSettings.TickRate;
+	header.StepCount = mStepCount;
+	header.StateHash = stateHash;
+
+	mFile.write((const char*)&header, sizeof(header));
+}
+
+bool InputReplay::Open(const string& path)
+{
+	ifstream file(path, ios::binary | ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+
+	const uint64_t fileSize = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	RecordingHeader header = {};
+	if (!file.read((char*)&header, sizeof(header)) || header.Magic != gRecordingMagic ||
+		(header.Version != gRecordingVersion && header.Version != gLegacyRecordingVersion))
+	{
+		return false;
+	}
+
+	// a recording that wasn't closed has the steps it wrote, without a count.
+	uint64_t stepCount = header.StepCount;
+	if (stepCount == 0)
+	{
+		stepCount = fileSize - sizeof(header);
+	}
+
+	mInputs.resize((size_t)stepCount);
+	if (!file.read((char*)mInputs.data(), stepCount))
+	{
+		return false;
+	}
+
+	mSettings.Seed = header.Seed;
+	mSettings.ShellCapacity = header.ShellCapacity;
+	mSettings.EnemyCapacity = header.EnemyCapacity;
+	mSettings.TickRate = header.TickRate;
+	mSettings.LegacyRandom = header.Version == gLegacyRecordingVersion;
+	mStateHash = header.StateHash;
+	mNext = 0;
+	return true;
+}
+
+GameInput InputReplay::Next()
+{
+	assert(!IsOver());
+	return mInputs[mNext++];
+}
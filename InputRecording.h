@@ -0,0 +1,90 @@
+#pragma once
+// recording and replay of the input of a game session.
+// the GameWorld is deterministic: stepped with the same settings, the same dt and the same input
+// step after step, it plays the same game down to the bit. so a session is recorded as its settings
+// and the input of each step, one byte per step, and replayed by stepping a new world with them,
+// headless or rendered.
+// the input is sampled into a ring buffer once per step, and each half of the ring is written to the
+// file as soon as it fills: the file is written in large blocks and the memory stays the same however
+// long the session is.
+// the hash of the world at the end of the session is stored too, so a replay can tell whether it
+// played the same game.
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "GameWorld.h"
+
+// -record <file> and -replay <file> options of a command line, empty when not given.
+struct RecordingOptions
+{
+	std::string RecordPath;
+	std::string ReplayPath;
+};
+
+// a session is replayed with the dt it was recorded with, so sessions that are recorded or
+// replayed run at a fixed tick rate: 60 steps per second if settings don't give one.
+RecordingOptions ParseRecordingOptions(const char* cmdLine, GameSettings& settings);
+
+class InputRecorder
+{
+public:
+	// capacity in steps, a power of two.
+	explicit InputRecorder(std::uint32_t capacity = 4096);
+	InputRecorder(const InputRecorder& rhs) = delete;
+	InputRecorder& operator=(const InputRecorder& rhs) = delete;
+	~InputRecorder();
+
+	// starts recording a session of a world made with settings, false if the file can't be created.
+	bool Open(const std::string& path, const GameSettings& settings);
+
+	// records the input of the next step.
+	void Record(GameInput input);
+
+	// writes the rest of the input, stateHash is the hash of the world after the last step.
+	void Close(std::uint64_t stateHash);
+
+	bool IsOpen() const { return mFile.is_open(); }
+	std::uint64_t GetStepCount() const { return mStepCount; }
+
+private:
+	void WriteHeader(std::uint64_t stateHash);
+
+private:
+	std::ofstream mFile;
+	GameSettings mSettings;
+
+	std::vector<GameInput> mRing;
+	std::uint64_t mStepCount = 0;		// steps recorded
+	std::uint64_t mWrittenCount = 0;	// steps written to the file
+};
+
+class InputReplay
+{
+public:
+	InputReplay() = default;
+	InputReplay(const InputReplay& rhs) = delete;
+	InputReplay& operator=(const InputReplay& rhs) = delete;
+
+	// reads a recording, false if it can't be read.
+	bool Open(const std::string& path);
+
+	// settings the recorded session was played with, the world replaying it has to be made with them.
+	const GameSettings& GetSettings() const { return mSettings; }
+
+	// input of the next step.
+	GameInput Next();
+
+	bool IsOver() const { return mNext == mInputs.size(); }
+	std::uint64_t GetStepCount() const { return mInputs.size(); }
+
+	// hash of the world at the end of the recorded session, 0 if the recording wasn't closed.
+	std::uint64_t GetStateHash() const { return mStateHash; }
+
+private:
+	GameSettings mSettings;
+	std::vector<GameInput> mInputs;
+	size_t mNext = 0;
+	std::uint64_t mStateHash = 0;
+};
@@ -0,0 +1,38 @@
+//***************************************************************************************
+// sal.h
+//
+// Empty stand-ins for the source annotation macros of the Windows SDK, which DirectXMath
+// includes.  Only put on the include path of builds outside Windows.
+//***************************************************************************************
+
+#pragma once
+
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _In_reads_bytes_opt_(size)
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Inout_updates_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_opt_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_all_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Ret_maybenull_
+#define _Check_return_
+#define _Success_(expr)
+#define _Use_decl_annotations_
+#define _Analysis_assume_(expr)
+#define _Field_size_(size)
+#define _Field_size_bytes_(size)
+#define _Pre_satisfies_(expr)
+#define _When_(expr, annotation)
+#define _Printf_format_string_
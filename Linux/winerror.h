@@ -0,0 +1,28 @@
+//***************************************************************************************
+// winerror.h
+//
+// The HRESULT type and the few error codes the device independent parts of the DDS
+// loader return, which the Windows SDK otherwise provides.  Only put on the include path
+// of builds outside Windows.
+//***************************************************************************************
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int32_t HRESULT;
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+
+#define ERROR_INVALID_DATA 13L
+#define ERROR_HANDLE_EOF 38L
+#define ERROR_NOT_SUPPORTED 50L
+
+#define HRESULT_FROM_WIN32(x) \
+    ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000)))
@@ -2,12 +2,21 @@
 
 #include "Shared.hlsl"
 
+#ifdef COMPACT_VERTEX
+struct VertexIn
+{
+    float3 PosQ         :   POSITION;
+    float2 NormalOct    :   NORMAL;
+    float2 TexC         :   TEXCOORD;
+};
+#else
 struct VertexIn
 {
     float3 PosL         :   POSITION;
     float3 NormalL      :   NORMAL;
     float2 TexC         :   TEXCOORD;
 };
+#endif
 
 struct VertexOut
 {
@@ -21,14 +30,22 @@ VertexOut VS(VertexIn vin)
 {
     VertexOut vout = (VertexOut)0.0f;
 
+#ifdef COMPACT_VERTEX
+    float3 posL = DecodePosition(vin.PosQ);
+    float3 normalL = OctDecode(vin.NormalOct);
+#else
+    float3 posL = vin.PosL;
+    float3 normalL = vin.NormalL;
+#endif
+
     // transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
     vout.PosW = posW.xyz;
 
     // suppose the world matrix is orthogonal matrix
     // so that normal vector can easily be transformed into world space 
     // by simply Applying the world matrix
-    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    vout.NormalW = mul(normalL, (float3x3)gWorld);
 
     // transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
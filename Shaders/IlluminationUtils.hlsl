@@ -90,7 +90,7 @@ float3 ComputePointLight(LightProperty L, ObjectProperty obj, float3 pos, float3
 }
 
 // Spot Light
-float3 ComputeSpotLight(LightProperty L, ObjectProperty obj, float3 pos, float normal, float3 toEye)
+float3 ComputeSpotLight(LightProperty L, ObjectProperty obj, float3 pos, float3 normal, float3 toEye)
 {
     // vector from the illumination spot to the light
     float3 light = L.LightPosition - pos;
@@ -126,14 +126,14 @@ float4 ComputeLighting(LightProperty gLights[Lights], ObjectProperty obj, float3
 #if (DIR_LIGHTS > 0)
     for(i = 0; i < DIR_LIGHTS; ++i)
     {
-        getLux += shadowFactor[i] * ComputeDirectionalLight(gLights[i], obj, normal, toEye);
+        getLux += (i < 3 ? shadowFactor[i] : 1.0f) * ComputeDirectionalLight(gLights[i], obj, normal, toEye);
     }
 #endif
 
 #if (POINT_LIGHTS > 0)
     for(i = DIR_LIGHTS; i < DIR_LIGHTS + POINT_LIGHTS; ++i)
     {
-        getLux += ComputePointLight(gLights[i].obj, pos, normal, toEye);
+        getLux += ComputePointLight(gLights[i], obj, pos, normal, toEye);
     }
 #endif
 
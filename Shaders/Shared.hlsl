@@ -10,7 +10,7 @@
 #endif
 
 #ifndef SPOT_LIGHTS
-#define NUM_POST_LIGHTS 0
+#define SPOT_LIGHTS     0
 #endif
 
 #include "IlluminationUtils.hlsl"
@@ -31,6 +31,10 @@ cbuffer cbObject        :   register(b0)
 {
     float4x4 gWorld;
     float4x4 gTexTransform;
+    float3 gPosDecodeScale;
+    float cbObjectPad1;
+    float3 gPosDecodeOffset;
+    float cbObjectPad2;
 };
 
 cbuffer cbCommon        :   register(b1)
@@ -56,6 +60,21 @@ cbuffer cbCommon        :   register(b1)
     LightProperty gLights[Lights];
 };
 
+// COMPACT_VERTEX: positions are stored as unorm inside the bounds of the submesh.
+float3 DecodePosition(float3 posQ)
+{
+    return posQ * gPosDecodeScale + gPosDecodeOffset;
+}
+
+// COMPACT_VERTEX: normals are stored octahedrally encoded in two snorm components.
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
 // object(material)'s lighting characteristics
 cbuffer cbMaterial      :   register(b2)
 {
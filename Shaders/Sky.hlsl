@@ -2,12 +2,21 @@
 
 #include "Shared.hlsl"
 
+#ifdef COMPACT_VERTEX
+struct VertexIn
+{
+    float3 PosQ     :   POSITION;
+    float2 NormalOct:   NORMAL;
+    float2 TexC     :   TEXCOORD;
+};
+#else
 struct VertexIn
 {
     float3 PosL     :   POSITION;
     float3 NormalL  :   NORMAL;
     float2 TexC     :   TEXCOORD;
 };
+#endif
 
 struct VertexOut
 {
@@ -19,11 +28,17 @@ VertexOut VS(VertexIn vin)
 {
     VertexOut vout;
 
+#ifdef COMPACT_VERTEX
+    float3 posL = DecodePosition(vin.PosQ);
+#else
+    float3 posL = vin.PosL;
+#endif
+
     // use local vertex position as cubemap lookup vector.
-    vout.PosL = vin.PosL;
+    vout.PosL = posL;
 
     // transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
 
     // sky sphere is always centered at the camera position. (set camera position as the origin)
     posW.xyz += gCameraPosW;
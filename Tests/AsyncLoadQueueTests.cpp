@@ -0,0 +1,224 @@
+//***************************************************************************************
+// AsyncLoadQueueTests.cpp
+//
+// Load jobs run on the workers, and their results are delivered on the polling thread, which
+// creates resources on a stand-in device that fails the test when it is used from any other
+// thread.
+//***************************************************************************************
+
+#include "Helpers/AsyncLoadQueue.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // decoded texture, what a job hands back.
+    struct TextureData
+    {
+        std::string Name;
+        std::vector<std::uint8_t> Pixels;
+        std::thread::id DecodedOn;
+    };
+
+    // stands in for the device: resources may only be created on the thread that owns it.
+    class FakeDevice
+    {
+    public:
+        FakeDevice() : mOwner(std::this_thread::get_id()) {}
+
+        void CreateTexture(const TextureData& data)
+        {
+            EXPECT_EQ(mOwner, std::this_thread::get_id()) << data.Name << " created off the device thread";
+            mCreated.push_back(data.Name);
+            mCreatedBytes += data.Pixels.size();
+        }
+
+        const std::vector<std::string>& GetCreated()const { return mCreated; }
+        size_t GetCreatedBytes()const { return mCreatedBytes; }
+
+    private:
+        std::thread::id mOwner;
+        std::vector<std::string> mCreated;
+        size_t mCreatedBytes = 0;
+    };
+
+    using TextureQueue = AsyncLoadQueue<std::unique_ptr<TextureData>>;
+
+    TextureQueue::Job DecodeJob(const std::string& name, size_t size, int delayMs)
+    {
+        return [name, size, delayMs]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            std::unique_ptr<TextureData> data(new TextureData());
+            data->Name = name;
+            data->Pixels.assign(size, (std::uint8_t)size);
+            data->DecodedOn = std::this_thread::get_id();
+            return data;
+        };
+    }
+}
+
+TEST(AsyncLoadQueue, DeliversEveryResultOnceOnThePollingThread)
+{
+    FakeDevice device;
+    TextureQueue queue(4);
+    EXPECT_EQ(4u, queue.GetWorkerCount());
+
+    std::vector<std::string> names;
+    std::vector<TextureQueue::Ticket> tickets;
+    for(int i = 0; i < 32; ++i)
+    {
+        names.push_back("texture" + std::to_string(i));
+        tickets.push_back(queue.Submit(DecodeJob(names.back(), 64 + i, (i * 7) % 5)));
+    }
+
+    std::set<TextureQueue::Ticket> delivered;
+    std::set<std::thread::id> decodedOn;
+    queue.WaitAll([&](TextureQueue::Ticket ticket, std::unique_ptr<TextureData>& data)
+    {
+        ASSERT_TRUE(data);
+        EXPECT_TRUE(delivered.insert(ticket).second) << "ticket " << ticket << " delivered twice";
+
+        // the ticket tells which job the result belongs to.
+        ASSERT_LT(ticket, names.size());
+        EXPECT_EQ(names[ticket], data->Name);
+        EXPECT_NE(std::this_thread::get_id(), data->DecodedOn);
+        decodedOn.insert(data->DecodedOn);
+
+        device.CreateTexture(*data);
+    });
+
+    EXPECT_EQ(32u, delivered.size());
+    EXPECT_EQ(32u, device.GetCreated().size());
+    EXPECT_EQ(0u, queue.GetPendingCount());
+    EXPECT_GE(decodedOn.size(), 1u);
+    for(size_t i = 0; i < tickets.size(); ++i)
+        EXPECT_EQ((TextureQueue::Ticket)i, tickets[i]);
+}
+
+TEST(AsyncLoadQueue, PollDoesNotWaitForRunningJobs)
+{
+    FakeDevice device;
+    TextureQueue queue(1);
+
+    // the job waits until the test lets it finish.
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    queue.Submit([released]()
+    {
+        released.wait();
+        std::unique_ptr<TextureData> data(new TextureData());
+        data->Name = "held";
+        return data;
+    });
+
+    auto consume = [&](TextureQueue::Ticket, std::unique_ptr<TextureData>& data) { device.CreateTexture(*data); };
+    EXPECT_EQ(0u, queue.Poll(consume));
+    EXPECT_EQ(1u, queue.GetPendingCount());
+
+    release.set_value();
+    size_t polled = 0;
+    for(int i = 0; i < 1000 && polled == 0; ++i)
+    {
+        polled = queue.Poll(consume);
+        if(polled == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(1u, polled);
+    EXPECT_EQ(0u, queue.GetPendingCount());
+    ASSERT_EQ(1u, device.GetCreated().size());
+    EXPECT_EQ("held", device.GetCreated()[0]);
+}
+
+TEST(AsyncLoadQueue, RethrowsTheErrorOfAJobWhenDelivered)
+{
+    FakeDevice device;
+    TextureQueue queue(2);
+
+    queue.Submit(DecodeJob("good", 16, 0));
+    queue.Submit([]() -> std::unique_ptr<TextureData> { throw std::runtime_error("corrupt file"); });
+    queue.Submit(DecodeJob("also good", 16, 0));
+
+    auto consume = [&](TextureQueue::Ticket, std::unique_ptr<TextureData>& data) { device.CreateTexture(*data); };
+
+    // the error surfaces once, on the polling thread, and the other results still arrive.
+    int errors = 0;
+    for(;;)
+    {
+        try
+        {
+            queue.WaitAll(consume);
+            break;
+        }
+        catch(const std::runtime_error& e)
+        {
+            EXPECT_STREQ("corrupt file", e.what());
+            errors++;
+        }
+    }
+
+    EXPECT_EQ(1, errors);
+    EXPECT_EQ(2u, device.GetCreated().size());
+    EXPECT_EQ(0u, queue.GetPendingCount());
+}
+
+TEST(AsyncLoadQueue, DestructionDropsJobsNotStarted)
+{
+    std::atomic<int> ran(0);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> started;
+    std::thread unblock;
+
+    {
+        TextureQueue queue(1);
+        queue.Submit([&ran, released, &started]()
+        {
+            started.set_value();
+            released.wait();
+            ran++;
+            return std::unique_ptr<TextureData>();
+        });
+        for(int i = 0; i < 10; ++i)
+        {
+            queue.Submit([&ran]()
+            {
+                ran++;
+                return std::unique_ptr<TextureData>();
+            });
+        }
+
+        // the one worker is busy with the first job, the rest are still queued.
+        // the job is let go while the queue is being destroyed.
+        started.get_future().wait();
+        unblock = std::thread([&release]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            release.set_value();
+        });
+    }
+    unblock.join();
+
+    // the running job finished, the queued ones never ran.
+    EXPECT_EQ(1, ran.load());
+}
+
+TEST(AsyncLoadQueue, PicksAWorkerCount)
+{
+    TextureQueue queue;
+    EXPECT_GE(queue.GetWorkerCount(), 1u);
+    EXPECT_LE(queue.GetWorkerCount(), 8u);
+
+    // nothing submitted, nothing to wait for.
+    queue.WaitAll([](TextureQueue::Ticket, std::unique_ptr<TextureData>&) { FAIL(); });
+    EXPECT_EQ(0u, queue.GetPendingCount());
+}
@@ -0,0 +1,221 @@
+//***************************************************************************************
+// BuddyAllocatorTests.cpp
+//
+// Splitting and merging of blocks, alignment, running out of memory and the fragmentation
+// measure, and a random run checked for overlapping blocks.
+//***************************************************************************************
+
+#include "Helpers/BuddyAllocator.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace
+{
+    const std::uint64_t KB = 1024;
+    const std::uint64_t MB = 1024 * KB;
+}
+
+TEST(BuddyAllocator, StartsAsOneFreeBlock)
+{
+    BuddyAllocator allocator(4 * MB, 64 * KB);
+    BuddyAllocator::Stats stats = allocator.GetStats();
+
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(4 * MB, stats.TotalBytes);
+    EXPECT_EQ(4 * MB, stats.LargestFreeBlock);
+    EXPECT_EQ(1u, stats.FreeBlockCount);
+    EXPECT_EQ(0u, stats.AllocationCount);
+    EXPECT_EQ(0.0f, allocator.GetOccupancy());
+    EXPECT_EQ(0.0f, allocator.GetFragmentation());
+}
+
+TEST(BuddyAllocator, SplitsDownToTheSmallestFittingBlock)
+{
+    BuddyAllocator allocator(1 * MB, 64 * KB);
+
+    // 1 MB splits into 512, 256, 128 and two 64 KB blocks, the lowest is handed out.
+    EXPECT_EQ(0u, allocator.Allocate(64 * KB));
+    BuddyAllocator::Stats stats = allocator.GetStats();
+    EXPECT_EQ(4u, stats.FreeBlockCount);
+    EXPECT_EQ(512 * KB, stats.LargestFreeBlock);
+
+    // its buddy is next, then the 128 KB block is split.
+    EXPECT_EQ(64 * KB, allocator.Allocate(64 * KB));
+    EXPECT_EQ(128 * KB, allocator.Allocate(64 * KB));
+    EXPECT_EQ(256 * KB, allocator.Allocate(200 * KB));
+    EXPECT_EQ(4u, allocator.GetStats().AllocationCount);
+}
+
+TEST(BuddyAllocator, RoundsUpToAPowerOfTwo)
+{
+    BuddyAllocator allocator(1 * MB, 64 * KB);
+
+    // 65 KB needs a 128 KB block, 1 byte a 64 KB one.
+    allocator.Allocate(65 * KB);
+    allocator.Allocate(1);
+    BuddyAllocator::Stats stats = allocator.GetStats();
+    EXPECT_EQ(192 * KB, stats.AllocatedBytes);
+    EXPECT_EQ(65 * KB + 1, stats.RequestedBytes);
+    EXPECT_FLOAT_EQ(192.0f / 1024.0f, allocator.GetOccupancy());
+}
+
+TEST(BuddyAllocator, MergesFreedBuddies)
+{
+    BuddyAllocator allocator(1 * MB, 64 * KB);
+    std::uint64_t a = allocator.Allocate(64 * KB);
+    std::uint64_t b = allocator.Allocate(64 * KB);
+    std::uint64_t c = allocator.Allocate(128 * KB);
+
+    // 256 and 512 KB are free.  a's buddy b is still in use, nothing merges.
+    EXPECT_EQ(2u, allocator.GetStats().FreeBlockCount);
+    allocator.Free(a);
+    EXPECT_EQ(3u, allocator.GetStats().FreeBlockCount);
+
+    // a and b merge into a 128 KB block, whose buddy c is still in use.
+    allocator.Free(b);
+    EXPECT_EQ(3u, allocator.GetStats().FreeBlockCount);
+    EXPECT_EQ(512 * KB, allocator.GetStats().LargestFreeBlock);
+
+    // then everything merges back into one block.
+    allocator.Free(c);
+
+    BuddyAllocator::Stats stats = allocator.GetStats();
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(1u, stats.FreeBlockCount);
+    EXPECT_EQ(1 * MB, stats.LargestFreeBlock);
+    EXPECT_EQ(0u, stats.AllocatedBytes);
+    EXPECT_EQ(0u, stats.RequestedBytes);
+
+    // the whole range can be handed out again.
+    EXPECT_EQ(0u, allocator.Allocate(1 * MB));
+}
+
+TEST(BuddyAllocator, AlignsToTheAlignmentAsked)
+{
+    BuddyAllocator allocator(16 * MB, 64 * KB);
+
+    // a small resource that needs 4 MB alignment, e.g. an MSAA texture, takes a 4 MB block.
+    allocator.Allocate(64 * KB);
+    std::uint64_t msaa = allocator.Allocate(64 * KB, 4 * MB);
+    EXPECT_EQ(0u, msaa % (4 * MB));
+    EXPECT_NE(0u, msaa);
+
+    // every block is aligned to its own size.
+    for(std::uint64_t size : { 64 * KB, 128 * KB, 256 * KB, 1 * MB })
+    {
+        std::uint64_t offset = allocator.Allocate(size);
+        ASSERT_NE(BuddyAllocator::InvalidOffset, offset);
+        EXPECT_EQ(0u, offset % size);
+    }
+}
+
+TEST(BuddyAllocator, FailsWhenNoBlockIsLargeEnough)
+{
+    BuddyAllocator allocator(1 * MB, 64 * KB);
+
+    EXPECT_EQ(BuddyAllocator::InvalidOffset, allocator.Allocate(0));
+    EXPECT_EQ(BuddyAllocator::InvalidOffset, allocator.Allocate(1 * MB + 1));
+    EXPECT_EQ(BuddyAllocator::InvalidOffset, allocator.Allocate(64 * KB, 2 * MB));
+
+    for(int i = 0; i < 16; ++i)
+        ASSERT_NE(BuddyAllocator::InvalidOffset, allocator.Allocate(64 * KB));
+    EXPECT_EQ(BuddyAllocator::InvalidOffset, allocator.Allocate(1));
+    EXPECT_EQ(1.0f, allocator.GetOccupancy());
+    EXPECT_EQ(0.0f, allocator.GetFragmentation());
+
+    // failing leaves the state alone.
+    EXPECT_EQ(16u, allocator.GetStats().AllocationCount);
+    EXPECT_EQ(0u, allocator.GetStats().FreeBlockCount);
+}
+
+TEST(BuddyAllocator, FreeMemoryScatteredInSmallBlocksIsFragmented)
+{
+    BuddyAllocator allocator(1 * MB, 64 * KB);
+    std::uint64_t blocks[16];
+    for(std::uint64_t& block : blocks)
+        block = allocator.Allocate(64 * KB);
+
+    // every other block free: half the memory is free, but no block is larger than 64 KB.
+    for(int i = 0; i < 16; i += 2)
+        allocator.Free(blocks[i]);
+
+    EXPECT_EQ(64 * KB, allocator.GetStats().LargestFreeBlock);
+    EXPECT_FLOAT_EQ(1.0f - 1.0f / 8.0f, allocator.GetFragmentation());
+    EXPECT_EQ(BuddyAllocator::InvalidOffset, allocator.Allocate(128 * KB));
+
+    // freeing the rest merges everything back.
+    for(int i = 1; i < 16; i += 2)
+        allocator.Free(blocks[i]);
+    EXPECT_EQ(0.0f, allocator.GetFragmentation());
+    EXPECT_EQ(1u, allocator.GetStats().FreeBlockCount);
+}
+
+TEST(BuddyAllocator, RandomAllocationsNeverOverlap)
+{
+    const std::uint64_t total = 64 * MB;
+    BuddyAllocator allocator(total, 64 * KB);
+    RandomStream random(35);
+
+    // offset -> size of the block handed out, rounded up to a power of two.
+    std::map<std::uint64_t, std::uint64_t> live;
+    std::uint64_t requested = 0;
+
+    for(int i = 0; i < 20000; ++i)
+    {
+        if(live.empty() || random.NextBelow(100) < 55)
+        {
+            std::uint64_t size = 1 + random.NextBelow(4 * MB);
+            std::uint64_t alignment = 1ull << random.NextBelow(24);
+            std::uint64_t offset = allocator.Allocate(size, alignment);
+            if(offset == BuddyAllocator::InvalidOffset)
+                continue;
+
+            std::uint64_t block = 64 * KB;
+            while(block < std::max(size, alignment))
+                block <<= 1;
+
+            EXPECT_EQ(0u, offset % alignment);
+            EXPECT_EQ(0u, offset % block);
+            EXPECT_LE(offset + block, total);
+
+            // neither the block before nor the one after reaches into it.
+            auto next = live.lower_bound(offset);
+            if(next != live.end())
+            {
+                EXPECT_LE(offset + block, next->first);
+            }
+            if(next != live.begin())
+            {
+                auto prev = std::prev(next);
+                EXPECT_LE(prev->first + prev->second, offset);
+            }
+
+            live[offset] = block;
+            requested += size;
+        }
+        else
+        {
+            auto it = live.begin();
+            std::advance(it, random.NextBelow((std::uint32_t)live.size()));
+            allocator.Free(it->first);
+            live.erase(it);
+        }
+
+        BuddyAllocator::Stats stats = allocator.GetStats();
+        ASSERT_EQ(live.size(), stats.AllocationCount);
+    }
+
+    std::uint64_t allocated = 0;
+    for(const auto& block : live)
+        allocated += block.second;
+    EXPECT_EQ(allocated, allocator.GetStats().AllocatedBytes);
+
+    for(const auto& block : live)
+        allocator.Free(block.first);
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(total, allocator.GetStats().LargestFreeBlock);
+    EXPECT_EQ(1u, allocator.GetStats().FreeBlockCount);
+}
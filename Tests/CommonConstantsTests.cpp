@@ -0,0 +1,183 @@
+//***************************************************************************************
+// CommonConstantsTests.cpp
+//
+// Drives CommonConstantsCache the way FlyingCrates does, with plain memory standing in for
+// the common cbuffers of the frame buffers, and checks which byte ranges are copied, that
+// every frame buffer ends up with the current constants, and the inverse matrices against
+// XMMatrixInverse.
+//***************************************************************************************
+
+#include "Helpers/CommonConstants.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const int NumFrameBuffers = 3;
+
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    const Range CameraRange(offsetof(CommonConstants, View),
+        offsetof(CommonConstants, TotalTime) - offsetof(CommonConstants, View));
+    const Range TimeRange(offsetof(CommonConstants, TotalTime),
+        offsetof(CommonConstants, AmbientLight) - offsetof(CommonConstants, TotalTime));
+    const Range StaticRange(offsetof(CommonConstants, AmbientLight),
+        sizeof(CommonConstants) - offsetof(CommonConstants, AmbientLight));
+
+    XMMATRIX Projection()
+    {
+        return XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+    }
+
+    const XMFLOAT3 Origin = { 0.0f, 0.0f, 0.0f };
+    const XMFLOAT3 Up = { 0.0f, 1.0f, 0.0f };
+
+    // the ranges one Update() copies.
+    std::vector<Range> Update(CommonConstantsCache& cache, float totalTime = 0.0f)
+    {
+        std::vector<Range> ranges;
+        cache.Update(totalTime, 1.0f / 60.0f, [&](std::size_t offset, std::size_t size)
+        {
+            ranges.push_back(Range(offset, size));
+        });
+        return ranges;
+    }
+
+    void ExpectNear(const XMFLOAT4X4& expected, const XMFLOAT4X4& actual)
+    {
+        for(int i = 0; i < 4; ++i)
+        {
+            for(int j = 0; j < 4; ++j)
+                EXPECT_NEAR(expected.m[i][j], actual.m[i][j], 1e-4f * std::max(1.0f, std::abs(expected.m[i][j])))
+                    << i << ", " << j;
+        }
+    }
+}
+
+TEST(CommonConstantsCache, CopiesOnlyTheStaleRanges)
+{
+    CommonConstantsCache cache(NumFrameBuffers);
+    cache.SetProjection(Projection(), 1920.0f, 1080.0f, 1.0f, 1000.0f);
+    cache.LookAt(XMFLOAT3(0.0f, 100.0f, -300.0f), Origin, Up);
+
+    // every frame buffer gets everything once.
+    const std::vector<Range> all = { CameraRange, TimeRange, StaticRange };
+    for(int frame = 0; frame < NumFrameBuffers; ++frame)
+        EXPECT_EQ(all, Update(cache));
+
+    // then only the times, as long as the camera stays put.
+    const std::vector<Range> time = { TimeRange };
+    cache.LookAt(XMFLOAT3(0.0f, 100.0f, -300.0f), Origin, Up);
+    EXPECT_EQ(time, Update(cache));
+    EXPECT_EQ(time, Update(cache));
+
+    // a moved camera reaches every frame buffer.
+    const std::vector<Range> camera = { CameraRange, TimeRange };
+    cache.LookAt(XMFLOAT3(10.0f, 100.0f, -300.0f), Origin, Up);
+    for(int frame = 0; frame < NumFrameBuffers; ++frame)
+        EXPECT_EQ(camera, Update(cache));
+    EXPECT_EQ(time, Update(cache));
+
+    // so does a new target, a resize and new lights.
+    cache.LookAt(XMFLOAT3(10.0f, 100.0f, -300.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), Up);
+    for(int frame = 0; frame < NumFrameBuffers; ++frame)
+        EXPECT_EQ(camera, Update(cache));
+
+    cache.SetProjection(Projection(), 1280.0f, 720.0f, 1.0f, 1000.0f);
+    for(int frame = 0; frame < NumFrameBuffers; ++frame)
+        EXPECT_EQ(camera, Update(cache));
+    EXPECT_EQ(time, Update(cache));
+
+    Light lights[MaxLights];
+    cache.SetLights(XMFLOAT4(0.25f, 0.25f, 0.25f, 1.0f), lights);
+    const std::vector<Range> statics = { TimeRange, StaticRange };
+    for(int frame = 0; frame < NumFrameBuffers; ++frame)
+        EXPECT_EQ(statics, Update(cache));
+    EXPECT_EQ(time, Update(cache));
+}
+
+TEST(CommonConstantsCache, FrameBuffersReceiveTheCurrentConstants)
+{
+    CommonConstantsCache cache(NumFrameBuffers);
+    std::vector<CommonConstants> buffers(NumFrameBuffers);
+
+    Light lights[MaxLights];
+    lights[0].Direction = { 0.57735f, -0.77735f, 0.57735f };
+    lights[0].Strength = { 0.9f, 0.9f, 0.8f };
+    cache.SetLights(XMFLOAT4(0.25f, 0.25f, 0.25f, 1.0f), lights);
+    cache.SetProjection(Projection(), 1920.0f, 1080.0f, 1.0f, 1000.0f);
+
+    // the camera moves now and then, the frame buffers are written in turn.
+    int frame = 0;
+    for(int step = 0; step < 20; ++step)
+    {
+        const float theta = 0.1f * (float)(step / 4);
+        cache.LookAt(XMFLOAT3(300.0f * std::cos(theta), 100.0f, 300.0f * std::sin(theta)), Origin, Up);
+
+        CommonConstants& buffer = buffers[frame];
+        cache.Update((float)step, 1.0f / 60.0f, [&](std::size_t offset, std::size_t size)
+        {
+            std::memcpy((std::uint8_t*)&buffer + offset, (const std::uint8_t*)&cache.GetConstants() + offset, size);
+        });
+        ASSERT_EQ(0, std::memcmp(&cache.GetConstants(), &buffer, sizeof(CommonConstants))) << "step " << step;
+
+        frame = (frame + 1) % NumFrameBuffers;
+    }
+
+    EXPECT_EQ(0.25f, buffers[0].AmbientLight.x);
+    EXPECT_EQ(0.9f, buffers[1].Lights[0].Strength.x);
+    EXPECT_EQ(1920.0f, buffers[2].RenderTargetSize.x);
+    EXPECT_EQ(1.0f / 1080.0f, buffers[2].InvRenderTargetSize.y);
+}
+
+TEST(CommonConstantsCache, InversesMatchTheGeneralInverse)
+{
+    CommonConstantsCache cache(NumFrameBuffers);
+    const XMFLOAT3 position(-120.0f, 80.0f, 250.0f);
+    const XMFLOAT3 target(5.0f, 10.0f, -20.0f);
+    cache.SetProjection(Projection(), 1920.0f, 1080.0f, 1.0f, 1000.0f);
+    cache.LookAt(position, target, Up);
+    Update(cache);
+
+    XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&position), XMLoadFloat3(&target), XMLoadFloat3(&Up));
+    XMMATRIX proj = Projection();
+    XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+    XMVECTOR viewDet = XMMatrixDeterminant(view);
+    XMVECTOR projDet = XMMatrixDeterminant(proj);
+    XMVECTOR viewProjDet = XMMatrixDeterminant(viewProj);
+
+    // the constants are transposed for the shaders.
+    const XMMATRIX expected[] =
+    {
+        view, XMMatrixInverse(&viewDet, view), proj, XMMatrixInverse(&projDet, proj), viewProj,
+        XMMatrixInverse(&viewProjDet, viewProj),
+    };
+    const CommonConstants& constants = cache.GetConstants();
+    const XMFLOAT4X4* actual[] =
+    {
+        &constants.View, &constants.InvView, &constants.Proj, &constants.InvProj, &constants.ViewProj,
+        &constants.InvViewProj,
+    };
+    for(int i = 0; i < 6; ++i)
+    {
+        SCOPED_TRACE(i);
+        XMFLOAT4X4 transposed;
+        XMStoreFloat4x4(&transposed, XMMatrixTranspose(expected[i]));
+        ExpectNear(transposed, *actual[i]);
+    }
+
+    EXPECT_EQ(position.x, constants.CameraPosW.x);
+    EXPECT_EQ(position.y, constants.CameraPosW.y);
+    EXPECT_EQ(position.z, constants.CameraPosW.z);
+
+    XMFLOAT4X4 storedView;
+    XMStoreFloat4x4(&storedView, view);
+    ExpectNear(storedView, cache.GetView());
+}
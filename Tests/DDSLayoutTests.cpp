@@ -0,0 +1,261 @@
+//***************************************************************************************
+// DDSLayoutTests.cpp
+//
+// Parses every texture in Textures/ through a MappedFile the way LoadDDSTextureData12 does,
+// and checks the headers, the surface sizes and the subresource table against the files,
+// plus the rejection of truncated and malformed files.
+//***************************************************************************************
+
+#include "Helpers/DDSLayout.h"
+#include "Helpers/MappedFile.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    struct TextureInfo
+    {
+        const char* Name;
+        std::size_t FileSize;
+        std::size_t Width;
+        std::size_t Height;
+        std::size_t MipCount;
+        DXGI_FORMAT Format;
+    };
+
+    const TextureInfo Textures[] =
+    {
+        { "checkboard.dds",  131200, 512, 512,  1, DXGI_FORMAT_BC1_UNORM },
+        { "energyShell.dds",  80128, 400, 400,  1, DXGI_FORMAT_BC1_UNORM },
+        { "stone.dds",       131200, 512, 512,  1, DXGI_FORMAT_BC1_UNORM },
+        { "water3.dds",       43832, 256, 256,  9, DXGI_FORMAT_BC1_UNORM },
+        { "woodcrate1.dds",  349680, 512, 512, 10, DXGI_FORMAT_BC3_UNORM },
+    };
+
+    std::string TexturePath(const char* name)
+    {
+        return std::string("Textures/") + name;
+    }
+
+    class DDSFile : public ::testing::TestWithParam<TextureInfo>
+    {
+    protected:
+        void SetUp() override
+        {
+            ASSERT_TRUE(mFile.Open(TexturePath(GetParam().Name).c_str())) << "errno " << mFile.GetLastError();
+            ASSERT_EQ(S_OK, ParseDDSHeader(mFile.Data(), mFile.Size(), &mHeader, &mBitData, &mBitSize));
+        }
+
+        MappedFile mFile;
+        const DDS_HEADER* mHeader = nullptr;
+        const uint8_t* mBitData = nullptr;
+        std::size_t mBitSize = 0;
+    };
+}
+
+TEST_P(DDSFile, ParsesTheHeaderInPlace)
+{
+    const TextureInfo& info = GetParam();
+
+    EXPECT_EQ(info.FileSize, mFile.Size());
+    EXPECT_EQ((const void*)(mFile.Data() + sizeof(uint32_t)), (const void*)mHeader);
+    EXPECT_EQ(mFile.Data() + sizeof(uint32_t) + sizeof(DDS_HEADER), mBitData);
+    EXPECT_EQ(mFile.Size() - sizeof(uint32_t) - sizeof(DDS_HEADER), mBitSize);
+
+    EXPECT_EQ(info.Width, mHeader->width);
+    EXPECT_EQ(info.Height, mHeader->height);
+    EXPECT_EQ(info.MipCount, std::max<std::size_t>(1, mHeader->mipMapCount));
+    EXPECT_EQ(info.Format, GetDXGIFormat(mHeader->ddspf));
+}
+
+TEST_P(DDSFile, SubresourcesCoverTheTexelData)
+{
+    const TextureInfo& info = GetParam();
+
+    std::vector<DDSSubresourceData> initData(info.MipCount);
+    std::size_t twidth = 0, theight = 0, tdepth = 0, skipMip = 0;
+    ASSERT_EQ(S_OK, FillInitData12(info.Width, info.Height, 1, info.MipCount, 1, info.Format, 0,
+        mBitSize, mBitData, twidth, theight, tdepth, skipMip, initData.data()));
+
+    EXPECT_EQ(info.Width, twidth);
+    EXPECT_EQ(info.Height, theight);
+    EXPECT_EQ(1u, tdepth);
+    EXPECT_EQ(0u, skipMip);
+
+    // mips are stored back to back and the last one ends with the file.
+    const uint8_t* next = mBitData;
+    std::size_t w = info.Width, h = info.Height;
+    for(const DDSSubresourceData& subresource : initData)
+    {
+        std::size_t numBytes = 0, rowBytes = 0, numRows = 0;
+        GetSurfaceInfo(w, h, info.Format, &numBytes, &rowBytes, &numRows);
+
+        EXPECT_EQ((const void*)next, subresource.pData);
+        EXPECT_EQ((intptr_t)rowBytes, subresource.RowPitch);
+        EXPECT_EQ((intptr_t)numBytes, subresource.SlicePitch);
+        EXPECT_EQ(rowBytes * numRows, numBytes);
+
+        next += numBytes;
+        w = std::max<std::size_t>(1, w / 2);
+        h = std::max<std::size_t>(1, h / 2);
+    }
+    EXPECT_EQ(mFile.Data() + mFile.Size(), next);
+}
+
+TEST_P(DDSFile, SkipsMipsLargerThanMaxSize)
+{
+    const TextureInfo& info = GetParam();
+    if(info.MipCount < 3)
+        return;
+
+    std::vector<DDSSubresourceData> initData(info.MipCount);
+    std::size_t twidth = 0, theight = 0, tdepth = 0, skipMip = 0;
+    ASSERT_EQ(S_OK, FillInitData12(info.Width, info.Height, 1, info.MipCount, 1, info.Format,
+        info.Width / 4, mBitSize, mBitData, twidth, theight, tdepth, skipMip, initData.data()));
+
+    std::size_t mip0Bytes = 0, mip1Bytes = 0;
+    GetSurfaceInfo(info.Width, info.Height, info.Format, &mip0Bytes, nullptr, nullptr);
+    GetSurfaceInfo(info.Width / 2, info.Height / 2, info.Format, &mip1Bytes, nullptr, nullptr);
+
+    EXPECT_EQ(2u, skipMip);
+    EXPECT_EQ(info.Width / 4, twidth);
+    EXPECT_EQ(info.Height / 4, theight);
+    EXPECT_EQ((const void*)(mBitData + mip0Bytes + mip1Bytes), initData[0].pData);
+}
+
+TEST_P(DDSFile, RejectsTruncatedTexelData)
+{
+    const TextureInfo& info = GetParam();
+
+    std::vector<DDSSubresourceData> initData(info.MipCount);
+    std::size_t twidth = 0, theight = 0, tdepth = 0, skipMip = 0;
+    EXPECT_EQ(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), FillInitData12(info.Width, info.Height, 1, info.MipCount, 1,
+        info.Format, 0, mBitSize - 1, mBitData, twidth, theight, tdepth, skipMip, initData.data()));
+}
+
+#if !defined(_WIN32)
+TEST_P(DDSFile, PrefetchMakesTheTexelsResident)
+{
+    // drop the file from the file cache first, as far as the OS agrees to.
+    int fd = open(TexturePath(GetParam().Name).c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    // ranges outside the view are ignored, sizes past its end are clamped.
+    mFile.Prefetch(nullptr, 16);
+    mFile.Prefetch(mFile.Data() + mFile.Size(), 16);
+    mFile.Prefetch(mBitData, 0);
+    mFile.Prefetch(mBitData, mBitSize + (1u << 30));
+
+    const std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+    const std::size_t first = (std::size_t)(mBitData - mFile.Data()) / pageSize;
+    const std::size_t last = (mFile.Size() - 1) / pageSize;
+    std::vector<unsigned char> resident(last + 1);
+    ASSERT_EQ(0, mincore(const_cast<uint8_t*>(mFile.Data()), mFile.Size(), resident.data()));
+    for(std::size_t page = first; page <= last; ++page)
+        EXPECT_TRUE(resident[page] & 1) << "page " << page;
+}
+#endif
+
+INSTANTIATE_TEST_SUITE_P(Textures, DDSFile, ::testing::ValuesIn(Textures),
+    [](const ::testing::TestParamInfo<TextureInfo>& param)
+    {
+        std::string name = param.param.Name;
+        return name.substr(0, name.find('.'));
+    });
+
+#if !defined(_WIN32)
+TEST(DDSLayout, CoversEveryTexture)
+{
+    std::set<std::string> expected;
+    for(const TextureInfo& info : Textures)
+        expected.insert(info.Name);
+
+    std::set<std::string> found;
+    DIR* dir = opendir("Textures");
+    ASSERT_NE(nullptr, dir);
+    while(dirent* entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if(name.size() > 4 && name.compare(name.size() - 4, 4, ".dds") == 0)
+            found.insert(name);
+    }
+    closedir(dir);
+
+    EXPECT_EQ(expected, found);
+}
+#endif
+
+TEST(DDSLayout, RejectsMalformedHeaders)
+{
+    MappedFile file;
+    ASSERT_TRUE(file.Open(TexturePath("woodcrate1.dds").c_str()));
+    std::vector<uint8_t> bytes(file.Data(), file.Data() + file.Size());
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    std::size_t bitSize = 0;
+
+    // too short to hold the magic number and header.
+    EXPECT_EQ(E_FAIL, ParseDDSHeader(bytes.data(), sizeof(uint32_t) + sizeof(DDS_HEADER) - 1, &header, &bitData, &bitSize));
+    EXPECT_EQ(E_POINTER, ParseDDSHeader(bytes.data(), bytes.size(), nullptr, &bitData, &bitSize));
+
+    MappedFile temp;
+    ASSERT_TRUE(temp.Open(TexturePath("temp").c_str()));
+    EXPECT_EQ(E_FAIL, ParseDDSHeader(temp.Data(), temp.Size(), &header, &bitData, &bitSize));
+
+    std::vector<uint8_t> badMagic = bytes;
+    badMagic[0] = 'X';
+    EXPECT_EQ(E_FAIL, ParseDDSHeader(badMagic.data(), badMagic.size(), &header, &bitData, &bitSize));
+
+    std::vector<uint8_t> badSize = bytes;
+    badSize[sizeof(uint32_t)] = 0;
+    EXPECT_EQ(E_FAIL, ParseDDSHeader(badSize.data(), badSize.size(), &header, &bitData, &bitSize));
+
+    // a DX10 extension header that doesn't fit.
+    std::vector<uint8_t> dx10(bytes.begin(), bytes.begin() + sizeof(uint32_t) + sizeof(DDS_HEADER));
+    uint32_t fourCC = MAKEFOURCC('D', 'X', '1', '0');
+    std::memcpy(dx10.data() + sizeof(uint32_t) + offsetof(DDS_HEADER, ddspf) + offsetof(DDS_PIXELFORMAT, fourCC), &fourCC, sizeof(fourCC));
+    EXPECT_EQ(E_FAIL, ParseDDSHeader(dx10.data(), dx10.size(), &header, &bitData, &bitSize));
+}
+
+TEST(DDSLayout, SurfaceInfo)
+{
+    std::size_t numBytes = 0, rowBytes = 0, numRows = 0;
+
+    // block compressed sizes round up to whole 4x4 blocks.
+    GetSurfaceInfo(400, 400, DXGI_FORMAT_BC1_UNORM, &numBytes, &rowBytes, &numRows);
+    EXPECT_EQ(800u, rowBytes);
+    EXPECT_EQ(100u, numRows);
+    EXPECT_EQ(80000u, numBytes);
+
+    GetSurfaceInfo(1, 1, DXGI_FORMAT_BC3_UNORM, &numBytes, &rowBytes, &numRows);
+    EXPECT_EQ(16u, rowBytes);
+    EXPECT_EQ(1u, numRows);
+    EXPECT_EQ(16u, numBytes);
+
+    GetSurfaceInfo(3, 2, DXGI_FORMAT_R8G8B8A8_UNORM, &numBytes, &rowBytes, &numRows);
+    EXPECT_EQ(12u, rowBytes);
+    EXPECT_EQ(2u, numRows);
+    EXPECT_EQ(24u, numBytes);
+
+    EXPECT_EQ(32u, BitsPerPixel(DXGI_FORMAT_R8G8B8A8_UNORM));
+    EXPECT_EQ(4u, BitsPerPixel(DXGI_FORMAT_BC1_UNORM));
+    EXPECT_EQ(8u, BitsPerPixel(DXGI_FORMAT_BC3_UNORM));
+    EXPECT_EQ(0u, BitsPerPixel(DXGI_FORMAT_UNKNOWN));
+}
@@ -0,0 +1,241 @@
+//***************************************************************************************
+// EntityStoreTests.cpp
+//
+// Handles that survive swap-removal, generation bumps of reused slots, DestroyFlagged()
+// against a reference list, and Integrate() keeping the previous positions.
+//***************************************************************************************
+
+#include "EntityStore.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // entity i of a test has render handle i and every other column derived from i, so the
+    // columns of an entity can be checked wherever it was moved.
+    EntityHandle CreateNumbered(EntityStore& store, std::uint32_t i, std::uint32_t flags = 0)
+    {
+        float f = (float)i;
+        return store.Create(XMFLOAT3(f, f + 0.25f, f + 0.5f), XMFLOAT3(-f, 2.0f * f, 3.0f * f), f + 1.0f,
+            f + 2.0f, i, flags);
+    }
+
+    void ExpectNumberedAt(const EntityStore& store, std::uint32_t index, std::uint32_t i)
+    {
+        float f = (float)i;
+        ASSERT_EQ(i, store.RenderHandle()[index]);
+        EXPECT_EQ(f, store.PositionX()[index]);
+        EXPECT_EQ(f + 0.25f, store.PositionY()[index]);
+        EXPECT_EQ(f + 0.5f, store.PositionZ()[index]);
+        EXPECT_EQ(f, store.PrevPositionX()[index]);
+        EXPECT_EQ(f + 0.25f, store.PrevPositionY()[index]);
+        EXPECT_EQ(f + 0.5f, store.PrevPositionZ()[index]);
+        EXPECT_EQ(-f, store.VelocityX()[index]);
+        EXPECT_EQ(2.0f * f, store.VelocityY()[index]);
+        EXPECT_EQ(3.0f * f, store.VelocityZ()[index]);
+        EXPECT_EQ(f + 1.0f, store.Scale()[index]);
+        EXPECT_EQ(f + 2.0f, store.Radius()[index]);
+    }
+}
+
+TEST(EntityStore, CreateAppendsAndHandlesFindTheEntities)
+{
+    EntityStore store(8);
+    std::vector<EntityHandle> handles;
+    for(std::uint32_t i = 0; i < 5; ++i)
+        handles.push_back(CreateNumbered(store, i, i * 16));
+
+    ASSERT_EQ(5u, store.Size());
+    for(std::uint32_t i = 0; i < 5; ++i)
+    {
+        EXPECT_TRUE(store.IsAlive(handles[i]));
+        EXPECT_EQ(i, store.IndexOf(handles[i]));
+        EXPECT_EQ(handles[i].Slot, store.HandleAt(i).Slot);
+        EXPECT_EQ(handles[i].Generation, store.HandleAt(i).Generation);
+        EXPECT_EQ(i * 16, store.Flags()[i]);
+        ExpectNumberedAt(store, i, i);
+    }
+
+    EXPECT_FALSE(store.IsAlive(EntityHandle()));
+}
+
+TEST(EntityStore, SwapRemoveKeepsHandlesOfMovedEntities)
+{
+    EntityStore store;
+    std::vector<EntityHandle> handles;
+    for(std::uint32_t i = 0; i < 5; ++i)
+        handles.push_back(CreateNumbered(store, i));
+
+    // the last entity moves into the hole with every column.
+    store.Destroy(handles[1]);
+    ASSERT_EQ(4u, store.Size());
+    EXPECT_FALSE(store.IsAlive(handles[1]));
+    EXPECT_TRUE(store.IsAlive(handles[4]));
+    EXPECT_EQ(1u, store.IndexOf(handles[4]));
+    ExpectNumberedAt(store, 1, 4);
+
+    // the others didn't move.
+    for(std::uint32_t i : { 0u, 2u, 3u })
+    {
+        EXPECT_EQ(i, store.IndexOf(handles[i]));
+        ExpectNumberedAt(store, i, i);
+    }
+
+    // removing the last entity moves nothing.
+    store.DestroyAt(3);
+    EXPECT_FALSE(store.IsAlive(handles[3]));
+    EXPECT_EQ(1u, store.IndexOf(handles[4]));
+    EXPECT_EQ(2u, store.IndexOf(handles[2]));
+}
+
+TEST(EntityStore, ReusedSlotsBumpTheGeneration)
+{
+    EntityStore store;
+    EntityHandle first = CreateNumbered(store, 0);
+    store.Destroy(first);
+    EXPECT_TRUE(store.Empty());
+
+    EntityHandle second = CreateNumbered(store, 1);
+    EXPECT_EQ(first.Slot, second.Slot);
+    EXPECT_EQ(first.Generation + 1, second.Generation);
+    EXPECT_FALSE(store.IsAlive(first));
+    EXPECT_TRUE(store.IsAlive(second));
+
+    // Clear() destroys them all the same way.
+    EntityHandle third = CreateNumbered(store, 2);
+    store.Clear();
+    EXPECT_TRUE(store.Empty());
+    EXPECT_FALSE(store.IsAlive(second));
+    EXPECT_FALSE(store.IsAlive(third));
+}
+
+TEST(EntityStore, DestroyFlaggedRemovesExactlyTheFlagged)
+{
+    // flagged runs at the start, in the middle and at the end, so entities swapped in from the
+    // end are flagged themselves.
+    const std::uint32_t flagged[] = { 1, 1, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1 };
+    const std::uint32_t count = (std::uint32_t)(sizeof(flagged) / sizeof(flagged[0]));
+
+    EntityStore store;
+    std::vector<EntityHandle> handles;
+    for(std::uint32_t i = 0; i < count; ++i)
+        handles.push_back(CreateNumbered(store, i, flagged[i] ? 4u : 0u));
+
+    EXPECT_EQ(0u, store.DestroyFlagged(1 | 2));
+    EXPECT_EQ(8u, store.DestroyFlagged(4 | 8));
+    ASSERT_EQ(4u, store.Size());
+
+    for(std::uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(!flagged[i], store.IsAlive(handles[i])) << "entity " << i;
+        if(!flagged[i])
+            ExpectNumberedAt(store, store.IndexOf(handles[i]), i);
+    }
+}
+
+TEST(EntityStore, RandomRunMatchesReference)
+{
+    EntityStore store;
+    RandomStream random(41, "EntityStore");
+
+    // render handle -> handle, of every live entity, and handles destroyed since.
+    std::map<std::uint32_t, EntityHandle> live;
+    std::vector<EntityHandle> dead;
+    std::uint32_t next = 0;
+
+    for(int round = 0; round < 2000; ++round)
+    {
+        std::uint32_t creates = random.NextBelow(8);
+        for(std::uint32_t c = 0; c < creates; ++c)
+        {
+            std::uint32_t i = next++;
+            live[i] = CreateNumbered(store, i);
+        }
+
+        // flag some, destroy some by handle, and remove the flagged.
+        std::uint32_t* flags = store.Flags();
+        for(std::uint32_t index = 0; index < store.Size(); ++index)
+        {
+            if(random.NextBelow(4) == 0)
+                flags[index] |= 1;
+        }
+        for(auto it = live.begin(); it != live.end(); )
+        {
+            if(!(store.Flags()[store.IndexOf(it->second)] & 1) && random.NextBelow(8) == 0)
+            {
+                store.Destroy(it->second);
+                dead.push_back(it->second);
+                it = live.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        std::vector<std::uint32_t> flaggedHandles;
+        for(std::uint32_t index = 0; index < store.Size(); ++index)
+        {
+            if(store.Flags()[index] & 1)
+                flaggedHandles.push_back(store.RenderHandle()[index]);
+        }
+        ASSERT_EQ(flaggedHandles.size(), store.DestroyFlagged(1));
+        for(std::uint32_t i : flaggedHandles)
+        {
+            dead.push_back(live[i]);
+            live.erase(i);
+        }
+
+        ASSERT_EQ(live.size(), store.Size());
+        for(const auto& entry : live)
+        {
+            ASSERT_TRUE(store.IsAlive(entry.second));
+            std::uint32_t index = store.IndexOf(entry.second);
+            ASSERT_EQ(entry.first, store.RenderHandle()[index]);
+            ASSERT_EQ(entry.second.Slot, store.HandleAt(index).Slot);
+        }
+        for(const EntityHandle& handle : dead)
+            ASSERT_FALSE(store.IsAlive(handle));
+    }
+}
+
+TEST(EntityStore, IntegrateKeepsThePreviousPosition)
+{
+    EntityStore store;
+    for(std::uint32_t i = 0; i < 37; ++i)
+        CreateNumbered(store, i);
+
+    const float dt = 1.0f / 60.0f;
+    std::vector<float> x(store.PositionX(), store.PositionX() + store.Size());
+    std::vector<float> y(store.PositionY(), store.PositionY() + store.Size());
+    std::vector<float> z(store.PositionZ(), store.PositionZ() + store.Size());
+
+    for(int step = 0; step < 3; ++step)
+    {
+        store.Integrate(dt);
+        for(std::uint32_t i = 0; i < store.Size(); ++i)
+        {
+            ASSERT_EQ(x[i], store.PrevPositionX()[i]);
+            ASSERT_EQ(y[i], store.PrevPositionY()[i]);
+            ASSERT_EQ(z[i], store.PrevPositionZ()[i]);
+
+            // the same float operations as the scalar expression, bit for bit.
+            x[i] += store.VelocityX()[i] * dt;
+            y[i] += store.VelocityY()[i] * dt;
+            z[i] += store.VelocityZ()[i] * dt;
+            ASSERT_EQ(x[i], store.PositionX()[i]);
+            ASSERT_EQ(y[i], store.PositionY()[i]);
+            ASSERT_EQ(z[i], store.PositionZ()[i]);
+        }
+    }
+
+    // SetPosition() leaves the previous position alone.
+    store.SetPosition(0, XMFLOAT3(100.0f, 200.0f, 300.0f));
+    EXPECT_EQ(100.0f, store.GetPosition(0).x);
+    EXPECT_EQ(x[0], store.PrevPositionX()[0]);
+}
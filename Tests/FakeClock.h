@@ -0,0 +1,28 @@
+//***************************************************************************************
+// FakeClock.h
+//
+// Clock for tests of code driven by frame times.  Time only moves when the test moves it, so
+// frames of any length, and steps that take time themselves, are reproducible.
+//***************************************************************************************
+
+#pragma once
+
+class FakeClock
+{
+public:
+    double Now()const { return mNow; }
+
+    void Advance(double seconds) { mNow += seconds; }
+
+    // Seconds since the last call, like GameTimer::Tick() followed by DeltaTime().
+    double Tick()
+    {
+        double delta = mNow - mLastTick;
+        mLastTick = mNow;
+        return delta;
+    }
+
+private:
+    double mNow = 0.0;
+    double mLastTick = 0.0;
+};
@@ -0,0 +1,150 @@
+//***************************************************************************************
+// FixedStepLoopTests.cpp
+//
+// The accumulator, the MaxStepsPerFrame clamp that stops the spiral of death and the
+// interpolation alpha, driven by a FakeClock.
+//***************************************************************************************
+
+#include "Helpers/FixedStepLoop.h"
+#include "FakeClock.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+TEST(FixedStepLoop, WithoutStepRateRunsOneStepOfTheFrame)
+{
+    FixedStepLoop loop;
+    EXPECT_FALSE(loop.IsFixed());
+
+    for(double frame : { 0.016, 0.1, 0.0, 2.5 })
+    {
+        EXPECT_EQ(1u, loop.Advance(frame));
+        EXPECT_FLOAT_EQ((float)frame, loop.GetStepSeconds());
+        EXPECT_EQ(1.0f, loop.GetAlpha());
+    }
+    EXPECT_EQ(4u, loop.GetStepCount());
+    EXPECT_EQ(0.0, loop.GetDroppedSeconds());
+}
+
+TEST(FixedStepLoop, AccumulatesFramesShorterThanAStep)
+{
+    // 0.25 steps per frame: a step every fourth frame, the alpha climbing in between.
+    FixedStepLoop loop(16.0);
+    const std::uint32_t expectedSteps[] = { 0, 0, 0, 1, 0, 0, 0, 1 };
+    const float expectedAlpha[] = { 0.25f, 0.5f, 0.75f, 0.0f, 0.25f, 0.5f, 0.75f, 0.0f };
+
+    for(int frame = 0; frame < 8; ++frame)
+    {
+        EXPECT_EQ(expectedSteps[frame], loop.Advance(1.0 / 64.0)) << "frame " << frame;
+        EXPECT_FLOAT_EQ(expectedAlpha[frame], loop.GetAlpha()) << "frame " << frame;
+        EXPECT_FLOAT_EQ(1.0f / 16.0f, loop.GetStepSeconds());
+    }
+    EXPECT_EQ(2u, loop.GetStepCount());
+}
+
+TEST(FixedStepLoop, RunsSeveralStepsForALongFrame)
+{
+    FixedStepLoop loop(8.0);
+    EXPECT_EQ(2u, loop.Advance(0.3125));
+    EXPECT_FLOAT_EQ(0.5f, loop.GetAlpha());
+
+    // the half step left over completes with the next frame.
+    EXPECT_EQ(1u, loop.Advance(0.0625));
+    EXPECT_FLOAT_EQ(0.0f, loop.GetAlpha());
+    EXPECT_EQ(0.0, loop.GetDroppedSeconds());
+}
+
+TEST(FixedStepLoop, AlphaStaysBelowOne)
+{
+    FixedStepLoop loop(60.0);
+    FakeClock clock;
+    for(int frame = 0; frame < 1000; ++frame)
+    {
+        clock.Advance(0.001 + (frame % 37) * 0.0007);
+        loop.Advance(clock.Tick());
+        EXPECT_GE(loop.GetAlpha(), 0.0f);
+        EXPECT_LT(loop.GetAlpha(), 1.0f);
+    }
+}
+
+TEST(FixedStepLoop, StepsKeepUpWithTheClock)
+{
+    // 10 seconds of uneven frames around 144 Hz run 10 seconds of 60 Hz steps.
+    FixedStepLoop loop(60.0);
+    FakeClock clock;
+    std::uint64_t steps = 0;
+    while(clock.Now() < 10.0)
+    {
+        clock.Advance((clock.Now() < 5.0 ? 1.0 : 1.2) / 144.0);
+        steps += loop.Advance(clock.Tick());
+    }
+
+    const double simulated = steps / 60.0 + loop.GetAlpha() / 60.0;
+    EXPECT_NEAR(clock.Now(), simulated, 1e-6);
+    EXPECT_EQ(steps, loop.GetStepCount());
+    EXPECT_EQ(0.0, loop.GetDroppedSeconds());
+}
+
+TEST(FixedStepLoop, ClampsTheStepsOfAFrame)
+{
+    // a one second hitch at 60 Hz would need 60 steps.
+    FixedStepLoop loop(60.0, 4);
+    EXPECT_EQ(4u, loop.Advance(1.0));
+
+    // less than a step is kept, the rest is dropped.
+    EXPECT_LT(loop.GetAlpha(), 1.0f);
+    EXPECT_NEAR(1.0 - 4.0 / 60.0 - loop.GetAlpha() / 60.0, loop.GetDroppedSeconds(), 1e-6);
+
+    // the next short frame doesn't have to catch up.
+    EXPECT_LE(loop.Advance(1.0 / 60.0), 1u);
+}
+
+TEST(FixedStepLoop, ClampStopsTheSpiralOfDeath)
+{
+    // every step takes 1.5 steps of real time: without a clamp each frame would need more steps
+    // than the one before.  With it the frames stop growing and the simulation slows down.
+    const double step = 1.0 / 60.0;
+    const std::uint32_t maxSteps = 5;
+    FixedStepLoop loop(1.0 / step, maxSteps);
+    FakeClock clock;
+
+    std::uint32_t steps = 1;
+    double longestFrame = 0.0;
+    for(int frame = 0; frame < 200; ++frame)
+    {
+        clock.Advance(steps * 1.5 * step + 0.002);      // the steps, then rendering
+        double frameSeconds = clock.Tick();
+        longestFrame = std::max(longestFrame, frameSeconds);
+
+        steps = loop.Advance(frameSeconds);
+        EXPECT_LE(steps, maxSteps);
+    }
+
+    EXPECT_LE(longestFrame, maxSteps * 1.5 * step + 0.002 + 1e-9);
+    EXPECT_GT(loop.GetDroppedSeconds(), 0.0);
+
+    // the simulated time plus the dropped time is the time that passed.
+    const double simulated = loop.GetStepCount() * step + loop.GetAlpha() * step;
+    EXPECT_NEAR(clock.Now(), simulated + loop.GetDroppedSeconds(), 1e-6);
+}
+
+TEST(FixedStepLoop, NegativeFrameTimeCountsAsZero)
+{
+    FixedStepLoop loop(10.0);
+    EXPECT_EQ(0u, loop.Advance(0.05));
+    EXPECT_EQ(0u, loop.Advance(-1.0));
+    EXPECT_FLOAT_EQ(0.5f, loop.GetAlpha());
+}
+
+TEST(FixedStepLoop, ResetEmptiesTheAccumulator)
+{
+    FixedStepLoop loop(10.0);
+    loop.Advance(0.05);
+    loop.Reset();
+    EXPECT_EQ(0.0f, loop.GetAlpha());
+    EXPECT_EQ(0u, loop.Advance(0.05));
+
+    // so does changing the rate.
+    loop.SetStepRate(20.0);
+    EXPECT_EQ(0.0f, loop.GetAlpha());
+    EXPECT_EQ(1u, loop.Advance(0.05));
+}
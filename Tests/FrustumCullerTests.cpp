@@ -0,0 +1,225 @@
+//***************************************************************************************
+// FrustumCullerTests.cpp
+//
+// Boxes on either side of every frustum plane, transformed boxes, and random boxes checked
+// against a reference that tests the corners of each world space box in clip space.
+//***************************************************************************************
+
+#include "Helpers/FrustumCuller.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const float NearZ = 1.0f;
+    const float FarZ = 1000.0f;
+
+    // camera at the origin looking down +z, square view, 90 degrees field of view.
+    XMMATRIX View()
+    {
+        return XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    XMMATRIX Proj()
+    {
+        return XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, NearZ, FarZ);
+    }
+
+    class FrustumCullerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            mCuller.SetFrustum(View(), Proj());
+            mCuller.Clear();
+        }
+
+        bool IsVisible(const XMFLOAT3& center, const XMFLOAT3& extents, CXMMATRIX world = XMMatrixIdentity())
+        {
+            mCuller.Clear();
+            mCuller.AddBox(BoundingBox(center, extents), world);
+            mCuller.Cull(mVisible);
+            return mVisible[0] != 0;
+        }
+
+        FrustumCuller mCuller;
+        std::vector<std::uint8_t> mVisible;
+    };
+
+    // The world space AABB of a transformed box is outside when all its corners fail the same
+    // clip space condition (-w <= x <= w, -w <= y <= w, 0 <= z <= w), which is what the culler
+    // tests with the planes it extracts.
+    bool ReferenceVisible(const BoundingBox& local, CXMMATRIX world, CXMMATRIX viewProj)
+    {
+        XMFLOAT3 lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for(int corner = 0; corner < 8; ++corner)
+        {
+            XMFLOAT3 p(local.Center.x + ((corner & 1) ? local.Extents.x : -local.Extents.x),
+                local.Center.y + ((corner & 2) ? local.Extents.y : -local.Extents.y),
+                local.Center.z + ((corner & 4) ? local.Extents.z : -local.Extents.z));
+            XMFLOAT3 w;
+            XMStoreFloat3(&w, XMVector3Transform(XMLoadFloat3(&p), world));
+            lo = XMFLOAT3(std::min(lo.x, w.x), std::min(lo.y, w.y), std::min(lo.z, w.z));
+            hi = XMFLOAT3(std::max(hi.x, w.x), std::max(hi.y, w.y), std::max(hi.z, w.z));
+        }
+
+        XMFLOAT4X4 m;
+        XMStoreFloat4x4(&m, viewProj);
+
+        int outside[6] = {};
+        for(int corner = 0; corner < 8; ++corner)
+        {
+            const float x = (corner & 1) ? hi.x : lo.x;
+            const float y = (corner & 2) ? hi.y : lo.y;
+            const float z = (corner & 4) ? hi.z : lo.z;
+            const float cx = x * m._11 + y * m._21 + z * m._31 + m._41;
+            const float cy = x * m._12 + y * m._22 + z * m._32 + m._42;
+            const float cz = x * m._13 + y * m._23 + z * m._33 + m._43;
+            const float cw = x * m._14 + y * m._24 + z * m._34 + m._44;
+
+            outside[0] += cx < -cw;
+            outside[1] += cx > cw;
+            outside[2] += cy < -cw;
+            outside[3] += cy > cw;
+            outside[4] += cz < 0.0f;
+            outside[5] += cz > cw;
+        }
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            if(outside[plane] == 8)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_F(FrustumCullerTest, BoxInFrontIsVisible)
+{
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 0.0f, 50.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+}
+
+TEST_F(FrustumCullerTest, BoxesBeyondEachPlaneAreCulled)
+{
+    const XMFLOAT3 unit(1.0f, 1.0f, 1.0f);
+
+    // the side planes are at |x| = z and |y| = z, so at most 51 over the depth of these boxes.
+    EXPECT_FALSE(IsVisible(XMFLOAT3(-55.0f, 0.0f, 50.0f), unit));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(55.0f, 0.0f, 50.0f), unit));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(0.0f, -55.0f, 50.0f), unit));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(0.0f, 55.0f, 50.0f), unit));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(0.0f, 0.0f, -5.0f), unit));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(0.0f, 0.0f, FarZ + 2.0f), unit));
+}
+
+TEST_F(FrustumCullerTest, BoxesStraddlingAPlaneAreVisible)
+{
+    const XMFLOAT3 unit(1.0f, 1.0f, 1.0f);
+
+    EXPECT_TRUE(IsVisible(XMFLOAT3(-50.5f, 0.0f, 50.0f), unit));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(50.5f, 0.0f, 50.0f), unit));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, -50.5f, 50.0f), unit));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 50.5f, 50.0f), unit));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 0.0f, NearZ), unit));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 0.0f, FarZ), unit));
+}
+
+TEST_F(FrustumCullerTest, FlatBoxesAreCulledByHeight)
+{
+    // a box without height, as the water at rest, is only visible while its plane is in view.
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 0.0f, 50.0f), XMFLOAT3(10.0f, 0.0f, 10.0f)));
+    EXPECT_FALSE(IsVisible(XMFLOAT3(0.0f, 70.0f, 50.0f), XMFLOAT3(10.0f, 0.0f, 10.0f)));
+    EXPECT_TRUE(IsVisible(XMFLOAT3(0.0f, 70.0f, 50.0f), XMFLOAT3(10.0f, 15.0f, 10.0f)));
+}
+
+TEST_F(FrustumCullerTest, TransformsBoxesByTheWorldMatrix)
+{
+    const BoundingBox local(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+    // translated out of view, then scaled back into it.
+    EXPECT_FALSE(IsVisible(local.Center, local.Extents, XMMatrixTranslation(60.0f, 0.0f, 50.0f)));
+    EXPECT_TRUE(IsVisible(local.Center, local.Extents, XMMatrixScaling(15.0f, 15.0f, 15.0f) * XMMatrixTranslation(60.0f, 0.0f, 50.0f)));
+
+    // a long thin box rotated so its length reaches into view.
+    const XMFLOAT3 rod(20.0f, 0.5f, 0.5f);
+    EXPECT_FALSE(IsVisible(local.Center, rod, XMMatrixTranslation(-75.0f, 0.0f, 50.0f)));
+    EXPECT_TRUE(IsVisible(local.Center, rod, XMMatrixRotationY(XM_PIDIV4) * XMMatrixTranslation(-60.0f, 0.0f, 50.0f)));
+}
+
+TEST_F(FrustumCullerTest, KeepsIndicesAndCountsAcrossCalls)
+{
+    const XMFLOAT3 unit(1.0f, 1.0f, 1.0f);
+    const XMMATRIX identity = XMMatrixIdentity();
+
+    EXPECT_EQ(0u, mCuller.AddBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, 50.0f), unit), identity));
+    EXPECT_EQ(1u, mCuller.AddBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, -50.0f), unit), identity));
+    EXPECT_EQ(2u, mCuller.AddBox(BoundingBox(XMFLOAT3(10.0f, 0.0f, 50.0f), unit), identity));
+    mCuller.Cull(mVisible);
+
+    ASSERT_EQ(3u, mVisible.size());
+    EXPECT_EQ(1, mVisible[0]);
+    EXPECT_EQ(0, mVisible[1]);
+    EXPECT_EQ(1, mVisible[2]);
+    EXPECT_EQ(2u, mCuller.GetStats().Visible);
+    EXPECT_EQ(1u, mCuller.GetStats().Culled);
+
+    // the padding Cull() added doesn't shift boxes added after it.
+    EXPECT_EQ(3u, mCuller.AddBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, -60.0f), unit), identity));
+    EXPECT_EQ(4u, mCuller.AddBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, 60.0f), unit), identity));
+    mCuller.Cull(mVisible);
+
+    ASSERT_EQ(5u, mVisible.size());
+    EXPECT_EQ(0, mVisible[3]);
+    EXPECT_EQ(1, mVisible[4]);
+    EXPECT_EQ(3u, mCuller.GetStats().Visible);
+    EXPECT_EQ(2u, mCuller.GetStats().Culled);
+
+    mCuller.Clear();
+    EXPECT_EQ(0u, mCuller.GetBoxCount());
+    EXPECT_EQ(0u, mCuller.AddBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, 50.0f), unit), identity));
+}
+
+TEST_F(FrustumCullerTest, MatchesClipSpaceReference)
+{
+    // a camera looking down on the field as in the game.
+    const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 150.0f, -250.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, NearZ, FarZ);
+    mCuller.SetFrustum(view, proj);
+
+    RandomStream random(27);
+    std::vector<BoundingBox> boxes;
+    std::vector<XMFLOAT4X4> worlds;
+    for(int i = 0; i < 2001; ++i)
+    {
+        BoundingBox box(XMFLOAT3(random.NextFloat(-2.0f, 2.0f), random.NextFloat(-2.0f, 2.0f), random.NextFloat(-2.0f, 2.0f)),
+            XMFLOAT3(random.NextFloat(0.0f, 3.0f), random.NextFloat(0.0f, 3.0f), random.NextFloat(0.0f, 3.0f)));
+        XMMATRIX world = XMMatrixScaling(random.NextFloat(1.0f, 20.0f), random.NextFloat(1.0f, 20.0f), random.NextFloat(1.0f, 20.0f)) *
+            XMMatrixRotationY(random.NextFloat(0.0f, XM_2PI)) *
+            XMMatrixTranslation(random.NextFloat(-800.0f, 800.0f), random.NextFloat(-300.0f, 300.0f), random.NextFloat(-500.0f, 1200.0f));
+
+        boxes.push_back(box);
+        worlds.emplace_back();
+        XMStoreFloat4x4(&worlds.back(), world);
+        mCuller.AddBox(box, world);
+    }
+    mCuller.Cull(mVisible);
+
+    const XMMATRIX viewProj = view * proj;
+    std::uint32_t visible = 0;
+    for(size_t i = 0; i < boxes.size(); ++i)
+    {
+        const bool expected = ReferenceVisible(boxes[i], XMLoadFloat4x4(&worlds[i]), viewProj);
+        EXPECT_EQ(expected, mVisible[i] != 0) << "box " << i;
+        visible += expected;
+    }
+
+    EXPECT_EQ(visible, mCuller.GetStats().Visible);
+    EXPECT_EQ(boxes.size() - visible, mCuller.GetStats().Culled);
+
+    // the run has to exercise both outcomes.
+    EXPECT_GT(visible, 100u);
+    EXPECT_GT(boxes.size() - visible, 100u);
+}
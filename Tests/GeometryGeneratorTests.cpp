@@ -0,0 +1,396 @@
+//***************************************************************************************
+// GeometryGeneratorTests.cpp
+//
+// Subdivision shares the midpoint of every edge: the geosphere has its minimal vertex count
+// and each box face is a (2^n+1)^2 lattice, while the triangles are the ones the subdivision
+// that gave every triangle its own six vertices made, in the same order.  Every generator
+// emits the same mesh with uint16 and uint32 indices, appended to other meshes or not, and
+// the Get*Size functions predict its size.
+//***************************************************************************************
+
+#include "Helpers/GeometryGenerator.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Vertex = GeometryGenerator::Vertex;
+    using MeshData = GeometryGenerator::MeshData;
+
+    // GeometryGenerator::MidPoint and the Subdivide it had before midpoints were shared.
+    Vertex ReferenceMidPoint(const Vertex& v0, const Vertex& v1)
+    {
+        XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+        XMVECTOR p1 = XMLoadFloat3(&v1.Position);
+        XMVECTOR n0 = XMLoadFloat3(&v0.Normal);
+        XMVECTOR n1 = XMLoadFloat3(&v1.Normal);
+        XMVECTOR tan0 = XMLoadFloat3(&v0.TangentU);
+        XMVECTOR tan1 = XMLoadFloat3(&v1.TangentU);
+        XMVECTOR tex0 = XMLoadFloat2(&v0.TexC);
+        XMVECTOR tex1 = XMLoadFloat2(&v1.TexC);
+
+        Vertex v;
+        XMStoreFloat3(&v.Position, 0.5f*(p0 + p1));
+        XMStoreFloat3(&v.Normal, XMVector3Normalize(0.5f*(n0 + n1)));
+        XMStoreFloat3(&v.TangentU, XMVector3Normalize(0.5f*(tan0 + tan1)));
+        XMStoreFloat2(&v.TexC, 0.5f*(tex0 + tex1));
+        return v;
+    }
+
+    void ReferenceSubdivide(MeshData& meshData)
+    {
+        MeshData inputCopy = meshData;
+        meshData.Vertices.clear();
+        meshData.Indices32.clear();
+
+        std::uint32_t numTris = (std::uint32_t)inputCopy.Indices32.size()/3;
+        for(std::uint32_t i = 0; i < numTris; ++i)
+        {
+            Vertex v0 = inputCopy.Vertices[inputCopy.Indices32[i*3+0]];
+            Vertex v1 = inputCopy.Vertices[inputCopy.Indices32[i*3+1]];
+            Vertex v2 = inputCopy.Vertices[inputCopy.Indices32[i*3+2]];
+
+            meshData.Vertices.push_back(v0);
+            meshData.Vertices.push_back(v1);
+            meshData.Vertices.push_back(v2);
+            meshData.Vertices.push_back(ReferenceMidPoint(v0, v1));
+            meshData.Vertices.push_back(ReferenceMidPoint(v1, v2));
+            meshData.Vertices.push_back(ReferenceMidPoint(v0, v2));
+
+            const std::uint32_t corners[12] = { 0, 3, 5,  3, 4, 5,  5, 4, 2,  3, 1, 4 };
+            for(std::uint32_t corner : corners)
+                meshData.Indices32.push_back(i*6 + corner);
+        }
+    }
+
+    // the icosahedron CreateGeosphere starts from, before it is projected onto the sphere.
+    MeshData Icosahedron()
+    {
+        const float X = 0.525731f;
+        const float Z = 0.850651f;
+        const XMFLOAT3 pos[12] =
+        {
+            XMFLOAT3(-X, 0.0f, Z),  XMFLOAT3(X, 0.0f, Z),
+            XMFLOAT3(-X, 0.0f, -Z), XMFLOAT3(X, 0.0f, -Z),
+            XMFLOAT3(0.0f, Z, X),   XMFLOAT3(0.0f, Z, -X),
+            XMFLOAT3(0.0f, -Z, X),  XMFLOAT3(0.0f, -Z, -X),
+            XMFLOAT3(Z, X, 0.0f),   XMFLOAT3(-Z, X, 0.0f),
+            XMFLOAT3(Z, -X, 0.0f),  XMFLOAT3(-Z, -X, 0.0f)
+        };
+        const std::uint32_t k[60] =
+        {
+            1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+            1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+            3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+            10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+        };
+
+        MeshData mesh;
+        for(const XMFLOAT3& p : pos)
+        {
+            Vertex v;
+            v.Position = p;
+            mesh.Vertices.push_back(v);
+        }
+        mesh.Indices32.assign(k, k + 60);
+        return mesh;
+    }
+
+    using Position = std::tuple<float, float, float>;
+    using Triangle = std::array<Position, 3>;
+
+    Position ToTuple(const XMFLOAT3& p)
+    {
+        return Position(p.x, p.y, p.z);
+    }
+
+    // corners rotated so the smallest comes first, which keeps the winding.
+    std::vector<Triangle> SortedTriangles(const std::vector<Position>& corners)
+    {
+        std::vector<Triangle> triangles;
+        for(std::size_t i = 0; i < corners.size(); i += 3)
+        {
+            Triangle t = { { corners[i], corners[i + 1], corners[i + 2] } };
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            triangles.push_back(t);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    bool SameVertex(const Vertex& a, const Vertex& b)
+    {
+        return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+
+    // a generator and its parameters, all small enough for uint16 indices.
+    enum class Shape { Box, Sphere, Geosphere, Cylinder, Grid, Quad };
+
+    struct Case
+    {
+        Shape Kind;
+        std::uint32_t A;
+        std::uint32_t B;
+    };
+
+    const Case Cases[] =
+    {
+        { Shape::Box, 0, 0 }, { Shape::Box, 1, 0 }, { Shape::Box, 3, 0 }, { Shape::Box, 6, 0 },
+        { Shape::Sphere, 3, 2 }, { Shape::Sphere, 20, 20 }, { Shape::Sphere, 7, 13 },
+        { Shape::Geosphere, 0, 0 }, { Shape::Geosphere, 2, 0 }, { Shape::Geosphere, 6, 0 },
+        { Shape::Cylinder, 3, 1 }, { Shape::Cylinder, 20, 20 }, { Shape::Cylinder, 5, 9 },
+        { Shape::Grid, 2, 2 }, { Shape::Grid, 50, 50 }, { Shape::Grid, 3, 17 },
+        { Shape::Quad, 0, 0 },
+    };
+
+    const char* const ShapeNames[] = { "box", "sphere", "geosphere", "cylinder", "grid", "quad" };
+
+    std::string Describe(const Case& c)
+    {
+        return std::string(ShapeNames[(int)c.Kind]) + " " + std::to_string(c.A) + " " + std::to_string(c.B);
+    }
+
+    GeometryGenerator::MeshSize SizeOf(const Case& c)
+    {
+        switch(c.Kind)
+        {
+        case Shape::Box:       return GeometryGenerator::GetBoxSize(c.A);
+        case Shape::Sphere:    return GeometryGenerator::GetSphereSize(c.A, c.B);
+        case Shape::Geosphere: return GeometryGenerator::GetGeosphereSize(c.A);
+        case Shape::Cylinder:  return GeometryGenerator::GetCylinderSize(c.A, c.B);
+        case Shape::Grid:      return GeometryGenerator::GetGridSize(c.A, c.B);
+        default:               return GeometryGenerator::GetQuadSize();
+        }
+    }
+
+    template<typename IndexT>
+    GeometryGenerator::MeshRange Build(GeometryGenerator& geoGen, const Case& c, std::vector<Vertex>& vertices,
+        std::vector<IndexT>& indices)
+    {
+        switch(c.Kind)
+        {
+        case Shape::Box:       return geoGen.CreateBox(1.0f, 2.0f, 3.0f, c.A, vertices, indices);
+        case Shape::Sphere:    return geoGen.CreateSphere(1.5f, c.A, c.B, vertices, indices);
+        case Shape::Geosphere: return geoGen.CreateGeosphere(1.5f, c.A, vertices, indices);
+        case Shape::Cylinder:  return geoGen.CreateCylinder(1.0f, 0.5f, 3.0f, c.A, c.B, vertices, indices);
+        case Shape::Grid:      return geoGen.CreateGrid(10.0f, 20.0f, c.A, c.B, vertices, indices);
+        default:               return geoGen.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.5f, vertices, indices);
+        }
+    }
+
+    MeshData BuildMeshData(GeometryGenerator& geoGen, const Case& c)
+    {
+        switch(c.Kind)
+        {
+        case Shape::Box:       return geoGen.CreateBox(1.0f, 2.0f, 3.0f, c.A);
+        case Shape::Sphere:    return geoGen.CreateSphere(1.5f, c.A, c.B);
+        case Shape::Geosphere: return geoGen.CreateGeosphere(1.5f, c.A);
+        case Shape::Cylinder:  return geoGen.CreateCylinder(1.0f, 0.5f, 3.0f, c.A, c.B);
+        case Shape::Grid:      return geoGen.CreateGrid(10.0f, 20.0f, c.A, c.B);
+        default:               return geoGen.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.5f);
+        }
+    }
+
+    void ExpectSameVertices(const std::vector<Vertex>& expected, const Vertex* actual, const std::string& what)
+    {
+        for(std::size_t i = 0; i < expected.size(); ++i)
+            ASSERT_TRUE(SameVertex(expected[i], actual[i])) << what << ", vertex " << i;
+    }
+}
+
+TEST(GeometryGenerator, GeosphereHasMinimalVertexCount)
+{
+    GeometryGenerator geoGen;
+    for(std::uint32_t n = 0; n <= 6; ++n)
+    {
+        MeshData mesh = geoGen.CreateGeosphere(2.0f, n);
+        const std::size_t expected = 10 * ((std::size_t)1 << (2 * n)) + 2;
+        EXPECT_EQ(expected, mesh.Vertices.size()) << n << " subdivisions";
+        EXPECT_EQ(20 * ((std::size_t)1 << (2 * n)) * 3, mesh.Indices32.size());
+
+        // no two vertices share a position.
+        std::set<Position> positions;
+        for(const Vertex& v : mesh.Vertices)
+            positions.insert(ToTuple(v.Position));
+        EXPECT_EQ(mesh.Vertices.size(), positions.size());
+    }
+
+    // the subdivision count is capped at six.
+    EXPECT_EQ(40962u, geoGen.CreateGeosphere(1.0f, 9).Vertices.size());
+}
+
+TEST(GeometryGenerator, GeosphereMatchesDuplicatingSubdivision)
+{
+    GeometryGenerator geoGen;
+    const float radius = 2.5f;
+
+    MeshData reference = Icosahedron();
+    for(std::uint32_t n = 0; n <= 5; ++n)
+    {
+        if(n > 0)
+            ReferenceSubdivide(reference);
+
+        MeshData mesh = geoGen.CreateGeosphere(radius, n);
+        ASSERT_EQ(reference.Indices32.size(), mesh.Indices32.size());
+
+        // CreateGeosphere projects every vertex onto the sphere after subdividing.
+        std::vector<Position> expected, actual;
+        for(std::size_t i = 0; i < mesh.Indices32.size(); ++i)
+        {
+            XMFLOAT3 p;
+            XMStoreFloat3(&p, radius*XMVector3Normalize(XMLoadFloat3(&reference.Vertices[reference.Indices32[i]].Position)));
+            expected.push_back(ToTuple(p));
+            actual.push_back(ToTuple(mesh.Vertices[mesh.Indices32[i]].Position));
+        }
+
+        EXPECT_EQ(SortedTriangles(expected), SortedTriangles(actual)) << n << " subdivisions";
+
+        // and even in the same order.
+        EXPECT_EQ(expected, actual) << n << " subdivisions";
+    }
+}
+
+TEST(GeometryGenerator, BoxMatchesDuplicatingSubdivision)
+{
+    GeometryGenerator geoGen;
+    MeshData reference = geoGen.CreateBox(2.0f, 3.0f, 4.0f, 0);
+    for(std::uint32_t n = 1; n <= 4; ++n)
+    {
+        ReferenceSubdivide(reference);
+
+        MeshData mesh = geoGen.CreateBox(2.0f, 3.0f, 4.0f, n);
+        ASSERT_EQ(reference.Indices32.size(), mesh.Indices32.size());
+
+        std::vector<Position> expected, actual;
+        for(std::size_t i = 0; i < mesh.Indices32.size(); ++i)
+        {
+            // every attribute, not just the position.
+            const Vertex& a = reference.Vertices[reference.Indices32[i]];
+            const Vertex& b = mesh.Vertices[mesh.Indices32[i]];
+            ASSERT_TRUE(SameVertex(a, b)) << n << " subdivisions, index " << i;
+            expected.push_back(ToTuple(a.Position));
+            actual.push_back(ToTuple(b.Position));
+        }
+        EXPECT_EQ(SortedTriangles(expected), SortedTriangles(actual));
+    }
+}
+
+TEST(GeometryGenerator, BoxFacesAreLattices)
+{
+    GeometryGenerator geoGen;
+    for(std::uint32_t n = 0; n <= 6; ++n)
+    {
+        MeshData mesh = geoGen.CreateBox(1.0f, 1.0f, 1.0f, n);
+        const std::size_t side = ((std::size_t)1 << n) + 1;
+
+        // the faces don't share vertices, a face is told by the normal of its vertices.
+        std::map<Position, std::set<std::uint32_t>> faces;
+        for(std::uint32_t index : mesh.Indices32)
+            faces[ToTuple(mesh.Vertices[index].Normal)].insert(index);
+
+        ASSERT_EQ(6u, faces.size());
+        for(const auto& face : faces)
+            EXPECT_EQ(side * side, face.second.size()) << n << " subdivisions";
+        EXPECT_EQ(6 * side * side, mesh.Vertices.size());
+    }
+}
+
+TEST(GeometryGenerator, IndexTypesGiveTheSameMesh)
+{
+    GeometryGenerator geoGen;
+    for(const Case& c : Cases)
+    {
+        std::vector<Vertex> vertices16, vertices32;
+        std::vector<std::uint16_t> indices16;
+        std::vector<std::uint32_t> indices32;
+        GeometryGenerator::MeshRange range16 = Build(geoGen, c, vertices16, indices16);
+        GeometryGenerator::MeshRange range32 = Build(geoGen, c, vertices32, indices32);
+
+        EXPECT_EQ(range32.VertexCount, range16.VertexCount) << Describe(c);
+        EXPECT_EQ(range32.IndexCount, range16.IndexCount) << Describe(c);
+        ASSERT_EQ(vertices32.size(), vertices16.size()) << Describe(c);
+        ExpectSameVertices(vertices32, vertices16.data(), Describe(c));
+        ASSERT_TRUE(std::equal(indices32.begin(), indices32.end(), indices16.begin(), indices16.end())) << Describe(c);
+
+        // the MeshData version is the uint32 one, and so is its narrowing copy.
+        MeshData mesh = BuildMeshData(geoGen, c);
+        ASSERT_EQ(vertices32.size(), mesh.Vertices.size()) << Describe(c);
+        ExpectSameVertices(vertices32, mesh.Vertices.data(), Describe(c));
+        EXPECT_EQ(indices32, mesh.Indices32) << Describe(c);
+        EXPECT_EQ(indices16, mesh.GetIndices16()) << Describe(c);
+    }
+}
+
+TEST(GeometryGenerator, SizeFunctionsMatchTheOutput)
+{
+    GeometryGenerator geoGen;
+    for(const Case& c : Cases)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<std::uint32_t> indices;
+        GeometryGenerator::MeshRange range = Build(geoGen, c, vertices, indices);
+        GeometryGenerator::MeshSize size = SizeOf(c);
+
+        EXPECT_EQ(size.Vertices, range.VertexCount) << Describe(c);
+        EXPECT_EQ(size.Indices, range.IndexCount) << Describe(c);
+        EXPECT_EQ(size.Vertices, vertices.size()) << Describe(c);
+        EXPECT_EQ(size.Indices, indices.size()) << Describe(c);
+        EXPECT_LE(size.Vertices, GeometryGenerator::MaxVertexCount<std::uint16_t>()) << Describe(c);
+
+        // every vertex is used and no index points past the mesh.
+        std::set<std::uint32_t> used(indices.begin(), indices.end());
+        EXPECT_EQ(vertices.size(), used.size()) << Describe(c);
+        EXPECT_LT(*used.rbegin(), range.VertexCount) << Describe(c);
+    }
+
+    // a size usable at compile time.
+    static_assert(GeometryGenerator::GetGeosphereSize(6).Vertices <= GeometryGenerator::MaxVertexCount<std::uint16_t>(),
+        "the largest geosphere fits 16-bit indices");
+}
+
+TEST(GeometryGenerator, AppendedMeshesKeepTheirOffsets)
+{
+    GeometryGenerator geoGen;
+
+    // every case after the others in one pair of arrays, as the game combines its meshes.
+    std::vector<Vertex> vertices;
+    std::vector<std::uint16_t> indices;
+    std::vector<GeometryGenerator::MeshRange> ranges;
+    for(const Case& c : Cases)
+    {
+        const std::size_t vertexCount = vertices.size();
+        const std::size_t indexCount = indices.size();
+
+        GeometryGenerator::MeshRange range = Build(geoGen, c, vertices, indices);
+        EXPECT_EQ(vertexCount, range.BaseVertex) << Describe(c);
+        EXPECT_EQ(indexCount, range.StartIndex) << Describe(c);
+        EXPECT_EQ(vertices.size(), range.BaseVertex + range.VertexCount) << Describe(c);
+        EXPECT_EQ(indices.size(), range.StartIndex + range.IndexCount) << Describe(c);
+        ranges.push_back(range);
+    }
+
+    // each range holds the mesh built on its own, with indices relative to its base vertex, and
+    // the meshes appended later didn't touch it.
+    for(std::size_t m = 0; m < ranges.size(); ++m)
+    {
+        const Case& c = Cases[m];
+        std::vector<Vertex> aloneVertices;
+        std::vector<std::uint16_t> aloneIndices;
+        Build(geoGen, c, aloneVertices, aloneIndices);
+
+        const GeometryGenerator::MeshRange& range = ranges[m];
+        ASSERT_EQ(aloneVertices.size(), range.VertexCount) << Describe(c);
+        ASSERT_EQ(aloneIndices.size(), range.IndexCount) << Describe(c);
+        ExpectSameVertices(aloneVertices, &vertices[range.BaseVertex], Describe(c));
+        EXPECT_TRUE(std::equal(aloneIndices.begin(), aloneIndices.end(), indices.begin() + range.StartIndex)) << Describe(c);
+    }
+}
@@ -0,0 +1,175 @@
+//***************************************************************************************
+// GeometryPackerTests.cpp
+//
+// Where meshes land in the shared arrays, the alignment and zero padding of index ranges,
+// and geometric growth of the capacities.
+//***************************************************************************************
+
+#include "Helpers/GeometryPacker.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace
+{
+    struct Vertex
+    {
+        float Pos[3];
+        float TexC[2];
+    };
+
+    std::vector<Vertex> MakeVertices(std::uint32_t count, float tag)
+    {
+        std::vector<Vertex> vertices(count);
+        for(std::uint32_t i = 0; i < count; ++i)
+            vertices[i] = { { tag, (float)i, 0.0f }, { 0.0f, 0.0f } };
+        return vertices;
+    }
+
+    std::vector<std::uint16_t> MakeIndices(std::uint32_t count, std::uint32_t vertexCount)
+    {
+        std::vector<std::uint16_t> indices(count);
+        for(std::uint32_t i = 0; i < count; ++i)
+            indices[i] = (std::uint16_t)(i % vertexCount + 1) % vertexCount;
+        return indices;
+    }
+}
+
+TEST(GeometryPacker, PacksMeshesBackToBack)
+{
+    GeometryPacker packer(sizeof(Vertex));
+
+    std::vector<Vertex> v0 = MakeVertices(4, 0.0f), v1 = MakeVertices(3, 1.0f);
+    std::vector<std::uint16_t> i0 = MakeIndices(6, 4), i1 = MakeIndices(4, 3);
+
+    GeometryPacker::Range r0 = packer.Add(v0.data(), 4, i0.data(), 6);
+    GeometryPacker::Range r1 = packer.Add(v1.data(), 3, i1.data(), 4);
+
+    EXPECT_EQ(6u, r0.IndexCount);
+    EXPECT_EQ(0u, r0.StartIndexLocation);
+    EXPECT_EQ(0, r0.BaseVertexLocation);
+
+    EXPECT_EQ(4u, r1.IndexCount);
+    EXPECT_EQ(6u, r1.StartIndexLocation);
+    EXPECT_EQ(4, r1.BaseVertexLocation);
+
+    EXPECT_EQ(7u, packer.GetVertexCount());
+    EXPECT_EQ(10u, packer.GetIndexCount());
+
+    // vertices are copied byte for byte, indices stay local to their mesh.
+    EXPECT_EQ(0, std::memcmp(packer.GetVertexData(), v0.data(), 4 * sizeof(Vertex)));
+    EXPECT_EQ(0, std::memcmp(packer.GetVertexData() + 4 * sizeof(Vertex), v1.data(), 3 * sizeof(Vertex)));
+    EXPECT_EQ(0, std::memcmp(packer.GetIndexData(), i0.data(), 6 * sizeof(std::uint16_t)));
+    EXPECT_EQ(0, std::memcmp(packer.GetIndexData() + 6, i1.data(), 4 * sizeof(std::uint16_t)));
+}
+
+TEST(GeometryPacker, AlignsIndexRangesWithZeroPadding)
+{
+    GeometryPacker packer(sizeof(Vertex));
+
+    std::vector<Vertex> vertices = MakeVertices(3, 0.0f);
+    std::vector<std::uint16_t> indices = MakeIndices(3, 3);
+
+    GeometryPacker::Range r0 = packer.Add(vertices.data(), 3, indices.data(), 3);
+    GeometryPacker::Range r1 = packer.Add(vertices.data(), 3, indices.data(), 3);
+    GeometryPacker::Range r2 = packer.Add(vertices.data(), 3, indices.data(), 3);
+
+    EXPECT_EQ(0u, r0.StartIndexLocation);
+    EXPECT_EQ(4u, r1.StartIndexLocation);
+    EXPECT_EQ(8u, r2.StartIndexLocation);
+    EXPECT_EQ(0u, r1.StartIndexLocation % GeometryPacker::IndexAlignment);
+    EXPECT_EQ(0u, r2.StartIndexLocation % GeometryPacker::IndexAlignment);
+
+    EXPECT_EQ(0, r0.BaseVertexLocation);
+    EXPECT_EQ(3, r1.BaseVertexLocation);
+    EXPECT_EQ(6, r2.BaseVertexLocation);
+
+    // the trailing range isn't padded, the gaps hold a zero index.
+    EXPECT_EQ(11u, packer.GetIndexCount());
+    EXPECT_EQ(0u, packer.GetIndexData()[3]);
+    EXPECT_EQ(0u, packer.GetIndexData()[7]);
+}
+
+TEST(GeometryPacker, AcceptsAFull16BitMeshPerRange)
+{
+    GeometryPacker packer(sizeof(Vertex));
+
+    std::vector<Vertex> vertices = MakeVertices(0x10000, 0.0f);
+    std::vector<std::uint16_t> indices = MakeIndices(6, 0x10000);
+
+    packer.Add(vertices.data(), 0x10000, indices.data(), 6);
+    GeometryPacker::Range r1 = packer.Add(vertices.data(), 0x10000, indices.data(), 6);
+
+    // past 65536 vertices in total, each range still addresses its own with 16-bit indices.
+    EXPECT_EQ(0x10000, r1.BaseVertexLocation);
+    EXPECT_EQ(0x20000u, packer.GetVertexCount());
+}
+
+TEST(GeometryPacker, GrowCapacityDoublesFromTheMinimum)
+{
+    EXPECT_EQ(0u, GeometryPacker::GrowCapacity(0, 0));
+    EXPECT_EQ(GeometryPacker::MinCapacity, GeometryPacker::GrowCapacity(0, 1));
+    EXPECT_EQ(GeometryPacker::MinCapacity, GeometryPacker::GrowCapacity(0, GeometryPacker::MinCapacity));
+    EXPECT_EQ(2 * GeometryPacker::MinCapacity, GeometryPacker::GrowCapacity(0, GeometryPacker::MinCapacity + 1));
+
+    // enough capacity is kept as is, too little at least doubles.
+    EXPECT_EQ(1500u, GeometryPacker::GrowCapacity(1500, 1500));
+    EXPECT_EQ(3000u, GeometryPacker::GrowCapacity(1500, 1501));
+    EXPECT_EQ(12000u, GeometryPacker::GrowCapacity(1500, 10000));
+}
+
+TEST(GeometryPacker, GrowsGeometrically)
+{
+    GeometryPacker packer(sizeof(Vertex));
+
+    std::vector<Vertex> vertices = MakeVertices(24, 0.0f);
+    std::vector<std::uint16_t> indices = MakeIndices(36, 24);
+
+    std::uint32_t vertexCapacity = packer.GetVertexCapacity();
+    std::uint32_t indexCapacity = packer.GetIndexCapacity();
+    int vertexGrowths = 0, indexGrowths = 0;
+
+    for(int i = 0; i < 2000; ++i)
+    {
+        packer.Add(vertices.data(), 24, indices.data(), 36);
+
+        if(packer.GetVertexCapacity() != vertexCapacity)
+        {
+            EXPECT_EQ(GeometryPacker::GrowCapacity(vertexCapacity, packer.GetVertexCount()), packer.GetVertexCapacity());
+            vertexCapacity = packer.GetVertexCapacity();
+            ++vertexGrowths;
+        }
+        if(packer.GetIndexCapacity() != indexCapacity)
+        {
+            EXPECT_EQ(GeometryPacker::GrowCapacity(indexCapacity, packer.GetIndexCount()), packer.GetIndexCapacity());
+            indexCapacity = packer.GetIndexCapacity();
+            ++indexGrowths;
+        }
+    }
+
+    EXPECT_GE(packer.GetVertexCapacity(), packer.GetVertexCount());
+    EXPECT_GE(packer.GetIndexCapacity(), packer.GetIndexCount());
+
+    // 48000 vertices and 72000 indices: an empty packer grows to 1024, then doubles up to
+    // 65536 and 131072.
+    EXPECT_EQ(7, vertexGrowths);
+    EXPECT_EQ(8, indexGrowths);
+}
+
+TEST(GeometryPacker, ReserveAvoidsGrowth)
+{
+    GeometryPacker packer(sizeof(Vertex));
+    packer.Reserve(5000, 7000);
+
+    std::uint32_t vertexCapacity = packer.GetVertexCapacity();
+    std::uint32_t indexCapacity = packer.GetIndexCapacity();
+    EXPECT_GE(vertexCapacity, 5000u);
+    EXPECT_GE(indexCapacity, 7000u);
+
+    std::vector<Vertex> vertices = MakeVertices(50, 0.0f);
+    std::vector<std::uint16_t> indices = MakeIndices(70, 50);
+    for(int i = 0; i < 100; ++i)
+        packer.Add(vertices.data(), 50, indices.data(), 70);
+
+    EXPECT_EQ(vertexCapacity, packer.GetVertexCapacity());
+    EXPECT_EQ(indexCapacity, packer.GetIndexCapacity());
+}
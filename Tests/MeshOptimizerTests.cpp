@@ -0,0 +1,240 @@
+//***************************************************************************************
+// MeshOptimizerTests.cpp
+//
+// The passes only reorder: every triangle is kept with its winding.  The cache simulation is
+// checked on hand-computed index orders, and the optimized grid and sphere the game builds
+// have to transform fewer vertices per triangle than the generated orders.
+//***************************************************************************************
+
+#include "Helpers/MeshOptimizer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    using Triangle = std::array<std::uint32_t, 3>;
+
+    // rotated so the smallest index comes first, which keeps the winding.
+    Triangle Canonical(std::uint32_t a, std::uint32_t b, std::uint32_t c)
+    {
+        if(b < a && b < c)
+            return Triangle{ { b, c, a } };
+        if(c < a && c < b)
+            return Triangle{ { c, a, b } };
+        return Triangle{ { a, b, c } };
+    }
+
+    template<typename IndexT>
+    std::vector<Triangle> SortedTriangles(const IndexT* indices, std::size_t indexCount)
+    {
+        std::vector<Triangle> triangles;
+        for(std::size_t i = 0; i < indexCount; i += 3)
+            triangles.push_back(Canonical(indices[i], indices[i + 1], indices[i + 2]));
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    using Position = std::tuple<float, float, float>;
+    using PositionTriangle = std::array<Position, 3>;
+
+    // triangles by their vertex positions, for passes that renumber the vertices.  The vertices
+    // of the tested meshes have distinct positions, except at seams where it doesn't matter
+    // which copy a triangle uses.
+    std::vector<PositionTriangle> SortedPositionTriangles(const std::vector<GeometryGenerator::Vertex>& vertices,
+        const std::vector<std::uint32_t>& indices)
+    {
+        std::vector<PositionTriangle> triangles;
+        for(std::size_t i = 0; i < indices.size(); i += 3)
+        {
+            PositionTriangle t;
+            for(int k = 0; k < 3; ++k)
+            {
+                const DirectX::XMFLOAT3& p = vertices[indices[i + k]].Position;
+                t[k] = Position(p.x, p.y, p.z);
+            }
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            triangles.push_back(t);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void ExpectFirstUseOrder(const std::vector<std::uint32_t>& indices)
+    {
+        std::uint32_t next = 0;
+        for(std::uint32_t index : indices)
+        {
+            ASSERT_LE(index, next);
+            if(index == next)
+                next++;
+        }
+    }
+}
+
+TEST(MeshOptimizer, SimulatesAFifoCache)
+{
+    // a strip: every triangle after the first brings one new vertex.
+    const std::uint32_t strip[] = { 0, 1, 2,  2, 1, 3,  2, 3, 4,  4, 3, 5,  4, 5, 6 };
+    MeshOptimizer::CacheStats stats = MeshOptimizer::SimulateVertexCache(strip, 15, 7);
+    EXPECT_EQ(5u, stats.Triangles);
+    EXPECT_EQ(7u, stats.Vertices);
+    EXPECT_EQ(7u, stats.Misses);
+    EXPECT_FLOAT_EQ(7.0f / 5.0f, stats.Acmr);
+    EXPECT_FLOAT_EQ(1.0f, stats.Atvr);
+
+    // a 3 entry FIFO: the second triangle evicts the first one, which then misses again.
+    const std::uint16_t evicting[] = { 0, 1, 2,  3, 4, 5,  0, 1, 2 };
+    stats = MeshOptimizer::SimulateVertexCache(evicting, 9, 6, 3);
+    EXPECT_EQ(6u, stats.Vertices);
+    EXPECT_EQ(9u, stats.Misses);
+    EXPECT_FLOAT_EQ(3.0f, stats.Acmr);
+    EXPECT_FLOAT_EQ(1.5f, stats.Atvr);
+
+    // FIFO, not LRU: a hit doesn't keep 0 in the cache longer.
+    const std::uint16_t fifo[] = { 0, 1, 2,  0, 3, 1,  0, 4, 5 };
+    stats = MeshOptimizer::SimulateVertexCache(fifo, 9, 6, 3);
+    // 0 1 2 miss; 0 hits, 3 misses and evicts 0, 1 hits; 0 misses, 4 and 5 miss.
+    EXPECT_EQ(7u, stats.Misses);
+
+    // vertices that are never referenced don't count.
+    stats = MeshOptimizer::SimulateVertexCache(strip, 6, 100);
+    EXPECT_EQ(4u, stats.Vertices);
+    EXPECT_EQ(4u, stats.Misses);
+}
+
+TEST(MeshOptimizer, VertexCachePassKeepsTrianglesAndImprovesAcmr)
+{
+    GeometryGenerator geoGen;
+    GeometryGenerator::MeshData meshes[] =
+    {
+        geoGen.CreateGrid(400.0f, 400.0f, 50, 50),
+        geoGen.CreateSphere(3.0f, 20, 20),
+        geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3),
+        geoGen.CreateGeosphere(1.0f, 3),
+    };
+
+    for(GeometryGenerator::MeshData& mesh : meshes)
+    {
+        std::vector<std::uint32_t> indices = mesh.Indices32;
+        const std::size_t vertexCount = mesh.Vertices.size();
+        MeshOptimizer::CacheStats before = MeshOptimizer::SimulateVertexCache(indices.data(), indices.size(), vertexCount);
+
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+        EXPECT_EQ(SortedTriangles(mesh.Indices32.data(), mesh.Indices32.size()),
+            SortedTriangles(indices.data(), indices.size()));
+
+        MeshOptimizer::CacheStats after = MeshOptimizer::SimulateVertexCache(indices.data(), indices.size(), vertexCount);
+        EXPECT_LT(after.Acmr, before.Acmr) << vertexCount << " vertices";
+        EXPECT_GE(after.Atvr, 1.0f);
+
+        // the overdraw pass reorders whole triangles as well, and costs little.
+        std::vector<std::uint32_t> overdraw = indices;
+        MeshOptimizer::OptimizeOverdraw(overdraw.data(), overdraw.size(), &mesh.Vertices[0].Position.x, vertexCount,
+            sizeof(GeometryGenerator::Vertex));
+        EXPECT_EQ(SortedTriangles(indices.data(), indices.size()), SortedTriangles(overdraw.data(), overdraw.size()));
+        MeshOptimizer::CacheStats clustered = MeshOptimizer::SimulateVertexCache(overdraw.data(), overdraw.size(), vertexCount);
+        EXPECT_LE(clustered.Acmr, after.Acmr * 1.1f);
+    }
+}
+
+TEST(MeshOptimizer, VertexFetchPassRenumbersInFirstUseOrder)
+{
+    GeometryGenerator geoGen;
+    GeometryGenerator::MeshData mesh = geoGen.CreateSphere(3.0f, 20, 20);
+    std::vector<std::uint32_t> indices = mesh.Indices32;
+    MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), mesh.Vertices.size());
+
+    std::vector<std::uint32_t> original = indices;
+    std::vector<std::uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(),
+        mesh.Vertices.size());
+
+    ExpectFirstUseOrder(indices);
+    for(std::size_t i = 0; i < indices.size(); ++i)
+        ASSERT_EQ(remap[original[i]], indices[i]);
+
+    // remap is a permutation.
+    std::vector<std::uint32_t> sorted = remap;
+    std::sort(sorted.begin(), sorted.end());
+    for(std::uint32_t i = 0; i < sorted.size(); ++i)
+        ASSERT_EQ(i, sorted[i]);
+}
+
+TEST(MeshOptimizer, UnusedVerticesGoLast)
+{
+    // vertices 0 and 3 are never used.
+    std::uint16_t indices[] = { 4, 2, 1,  1, 2, 5 };
+    std::vector<std::uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(indices, 6, 6);
+
+    const std::uint16_t expected[] = { 0, 1, 2,  2, 1, 3 };
+    for(int i = 0; i < 6; ++i)
+        EXPECT_EQ(expected[i], indices[i]);
+    EXPECT_EQ(0u, remap[4]);
+    EXPECT_EQ(1u, remap[2]);
+    EXPECT_EQ(2u, remap[1]);
+    EXPECT_EQ(3u, remap[5]);
+    EXPECT_GE(remap[0], 4u);
+    EXPECT_GE(remap[3], 4u);
+}
+
+TEST(MeshOptimizer, OptimizeKeepsTheMeshesOfTheGame)
+{
+    // the terrain, the sphere and the box as SetTerrainGeometry and SetFiguresGeometry build them.
+    struct Case
+    {
+        const char* Name;
+        GeometryGenerator::MeshData Mesh;
+        bool ReduceOverdraw;
+        float MaxAcmr;
+    };
+
+    GeometryGenerator geoGen;
+    Case cases[] =
+    {
+        { "terrain", geoGen.CreateGrid(400.0f, 400.0f, 50, 50), false, 0.75f },
+        { "sphere", geoGen.CreateSphere(3.0f, 20, 20), true, 0.8f },
+        { "box", geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3), true, 0.8f },
+    };
+
+    for(Case& c : cases)
+    {
+        const std::vector<PositionTriangle> triangles = SortedPositionTriangles(c.Mesh.Vertices, c.Mesh.Indices32);
+        MeshOptimizer::Report report = MeshOptimizer::Optimize(c.Mesh, c.ReduceOverdraw);
+
+        EXPECT_EQ(triangles, SortedPositionTriangles(c.Mesh.Vertices, c.Mesh.Indices32)) << c.Name;
+        ExpectFirstUseOrder(c.Mesh.Indices32);
+
+        EXPECT_EQ(report.Before.Triangles, report.After.Triangles);
+        EXPECT_EQ(report.Before.Vertices, report.After.Vertices);
+        EXPECT_LT(report.After.Acmr, report.Before.Acmr) << c.Name;
+        EXPECT_LT(report.After.Acmr, c.MaxAcmr) << c.Name;
+    }
+}
+
+TEST(MeshOptimizer, OptimizeOnlyTouchesItsRange)
+{
+    GeometryGenerator geoGen;
+    std::vector<GeometryGenerator::Vertex> vertices;
+    std::vector<std::uint16_t> indices;
+    GeometryGenerator::MeshRange box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 2, vertices, indices);
+    GeometryGenerator::MeshRange sphere = geoGen.CreateSphere(3.0f, 12, 12, vertices, indices);
+
+    const std::vector<GeometryGenerator::Vertex> boxVertices(vertices.begin(), vertices.begin() + box.VertexCount);
+    const std::vector<std::uint16_t> boxIndices(indices.begin(), indices.begin() + box.IndexCount);
+    const std::vector<std::uint16_t> sphereIndices(indices.begin() + sphere.StartIndex, indices.end());
+
+    MeshOptimizer::Optimize(vertices, indices, sphere, true);
+
+    for(std::uint32_t i = 0; i < box.VertexCount; ++i)
+        ASSERT_EQ(0, std::memcmp(&boxVertices[i], &vertices[i], sizeof(GeometryGenerator::Vertex)));
+    ASSERT_TRUE(std::equal(boxIndices.begin(), boxIndices.end(), indices.begin()));
+
+    // the sphere indices stay relative to its base vertex.
+    EXPECT_EQ(SortedTriangles(sphereIndices.data(), sphereIndices.size()).size(), sphere.IndexCount / 3u);
+    for(std::uint32_t i = sphere.StartIndex; i < indices.size(); ++i)
+        ASSERT_LT(indices[i], sphere.VertexCount);
+}
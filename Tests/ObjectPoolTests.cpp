@@ -0,0 +1,198 @@
+//***************************************************************************************
+// ObjectPoolTests.cpp
+//
+// Handles, the packed live list and stale handle detection, including after Reset() and
+// when generations wrap, and a random run checked against a reference set.
+//***************************************************************************************
+
+#include "Helpers/ObjectPool.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace
+{
+    using Pool = ObjectPool<int>;
+
+    std::multiset<int> LiveValues(const Pool& pool)
+    {
+        std::multiset<int> values;
+        pool.ForEachLive([&](const int& value) { values.insert(value); });
+        return values;
+    }
+}
+
+TEST(ObjectPool, HandsOutLowestIndexFirst)
+{
+    Pool pool(4);
+
+    EXPECT_TRUE(pool.Empty());
+    for(std::uint32_t i = 0; i < 4; ++i)
+    {
+        Pool::Handle handle = pool.Acquire();
+        ASSERT_NE(Pool::InvalidHandle, handle);
+        EXPECT_EQ(i, Pool::IndexOf(handle));
+    }
+
+    EXPECT_TRUE(pool.Full());
+    EXPECT_EQ(4u, pool.Size());
+    EXPECT_EQ(Pool::InvalidHandle, pool.Acquire());
+}
+
+TEST(ObjectPool, ReleasedHandleIsStale)
+{
+    Pool pool(2);
+    Pool::Handle a = pool.Acquire();
+    Pool::Handle b = pool.Acquire();
+    pool.Get(a) = 1;
+    pool.Get(b) = 2;
+
+    pool.Release(a);
+    EXPECT_FALSE(pool.IsAlive(a));
+    EXPECT_TRUE(pool.IsAlive(b));
+    EXPECT_EQ(2, pool.Get(b));
+
+    // the same object again, under a new generation; it kept its state.
+    Pool::Handle c = pool.Acquire();
+    EXPECT_EQ(Pool::IndexOf(a), Pool::IndexOf(c));
+    EXPECT_NE(a, c);
+    EXPECT_FALSE(pool.IsAlive(a));
+    EXPECT_TRUE(pool.IsAlive(c));
+    EXPECT_EQ(1, pool.Get(c));
+}
+
+TEST(ObjectPool, InvalidHandleIsNeverAlive)
+{
+    Pool pool(Pool::MaxCapacity >> 8);
+    EXPECT_FALSE(pool.IsAlive(Pool::InvalidHandle));
+
+    while(!pool.Full())
+        pool.Acquire();
+    EXPECT_FALSE(pool.IsAlive(Pool::InvalidHandle));
+}
+
+TEST(ObjectPool, ResetMakesEveryOldHandleStale)
+{
+    Pool pool(3);
+    Pool::Handle live = pool.Acquire();
+    Pool::Handle released = pool.Acquire();
+    pool.Release(released);
+    pool.Get(live) = 7;
+
+    // the same capacity: the same indices come back, none of the old handles is alive.
+    pool.Reset(3);
+    EXPECT_TRUE(pool.Empty());
+    EXPECT_FALSE(pool.IsAlive(live));
+    EXPECT_FALSE(pool.IsAlive(released));
+
+    std::vector<Pool::Handle> handles;
+    while(!pool.Full())
+        handles.push_back(pool.Acquire());
+    for(Pool::Handle handle : handles)
+    {
+        EXPECT_NE(live, handle);
+        EXPECT_NE(released, handle);
+        EXPECT_FALSE(pool.IsAlive(live));
+        EXPECT_FALSE(pool.IsAlive(released));
+    }
+
+    // objects are constructed again.
+    EXPECT_EQ(0, pool.Get(handles[0]));
+
+    // shrinking and growing again keeps the generations of the indices that stayed.
+    Pool::Handle kept = handles[0];
+    pool.Reset(1);
+    pool.Reset(3);
+    EXPECT_FALSE(pool.IsAlive(kept));
+    EXPECT_NE(kept, pool.Acquire());
+}
+
+TEST(ObjectPool, GenerationsWrapAfterTheDocumentedCount)
+{
+    Pool pool(1);
+    Pool::Handle first = pool.Acquire();
+
+    const std::uint32_t generationCount = 1u << Pool::GenerationBits;
+    Pool::Handle handle = first;
+    for(std::uint32_t i = 1; i < generationCount; ++i)
+    {
+        pool.Release(handle);
+        handle = pool.Acquire();
+        ASSERT_NE(first, handle) << "after " << i << " releases";
+        ASSERT_FALSE(pool.IsAlive(first));
+    }
+
+    // one more and the first handle aliases the live object.
+    pool.Release(handle);
+    handle = pool.Acquire();
+    EXPECT_EQ(first, handle);
+    EXPECT_TRUE(pool.IsAlive(first));
+}
+
+TEST(ObjectPool, RandomRunMatchesReferenceSet)
+{
+    const std::uint32_t capacity = 64;
+    Pool pool(capacity);
+    RandomStream random(45, "ObjectPool");
+
+    // live handles and the value stored in their object, and handles released since.
+    std::map<Pool::Handle, int> live;
+    std::vector<Pool::Handle> stale;
+    int nextValue = 1;
+
+    for(int step = 0; step < 1000000; ++step)
+    {
+        // acquire more often while the pool is empty, release more often while it is full.
+        const bool acquire = random.NextBelow(capacity + 1) >= live.size();
+        if(acquire)
+        {
+            Pool::Handle handle = pool.Acquire();
+            if(live.size() == capacity)
+            {
+                ASSERT_EQ(Pool::InvalidHandle, handle);
+                continue;
+            }
+
+            ASSERT_NE(Pool::InvalidHandle, handle);
+            ASSERT_LT(Pool::IndexOf(handle), capacity);
+            ASSERT_EQ(0u, live.count(handle));
+            for(const auto& other : live)
+                ASSERT_NE(Pool::IndexOf(other.first), Pool::IndexOf(handle));
+
+            pool.Get(handle) = nextValue;
+            live[handle] = nextValue++;
+        }
+        else if(!live.empty())
+        {
+            auto it = live.begin();
+            std::advance(it, random.NextBelow((std::uint32_t)live.size()));
+            ASSERT_EQ(it->second, pool.Get(it->first));
+            pool.Release(it->first);
+            stale.push_back(it->first);
+            live.erase(it);
+        }
+
+        ASSERT_EQ(live.size(), pool.Size());
+
+        // spot checks, a full check is too slow for every step.
+        if(step % 1024 == 0)
+        {
+            std::multiset<int> expected;
+            for(const auto& entry : live)
+            {
+                ASSERT_TRUE(pool.IsAlive(entry.first));
+                expected.insert(entry.second);
+            }
+            ASSERT_EQ(expected, LiveValues(pool));
+
+            // a stale handle is dead unless its generation wrapped onto a live object, which
+            // takes 4096 releases of its index.
+            for(Pool::Handle handle : stale)
+                ASSERT_EQ(live.count(handle) != 0, pool.IsAlive(handle));
+            stale.clear();
+        }
+    }
+}
@@ -0,0 +1,282 @@
+//***************************************************************************************
+// RandomStreamTests.cpp
+//
+// The generator is pinned to reference xoshiro256** outputs, since recordings replay only as
+// long as it draws the same numbers.  Jump() is checked against the transition matrix of the
+// generator raised to 2^128, and the ranges, the named streams and the bulk floats of the SSE2
+// and scalar code are checked as well.
+//***************************************************************************************
+
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace
+{
+    // reference xoshiro256** step, as published by its authors.
+    using State = std::uint64_t[4];
+
+    std::uint64_t Rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t ReferenceNext(State s)
+    {
+        const std::uint64_t result = Rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+        return result;
+    }
+
+    // the state update is linear over GF(2): a 256x256 bit matrix, stored as the image of each
+    // basis vector.
+    struct Matrix
+    {
+        std::uint64_t Columns[256][4];
+    };
+
+    void Apply(const Matrix& m, const State in, State out)
+    {
+        std::uint64_t result[4] = { 0, 0, 0, 0 };
+        for(int bit = 0; bit < 256; ++bit)
+        {
+            if(in[bit / 64] & (1ull << (bit % 64)))
+            {
+                for(int w = 0; w < 4; ++w)
+                    result[w] ^= m.Columns[bit][w];
+            }
+        }
+        std::memcpy(out, result, sizeof(result));
+    }
+
+    void Square(Matrix& m)
+    {
+        static Matrix squared;
+        for(int bit = 0; bit < 256; ++bit)
+            Apply(m, m.Columns[bit], squared.Columns[bit]);
+        m = squared;
+    }
+
+    const std::uint64_t ReferenceSeed0[6] =
+    {
+        0x99ec5f36cb75f2b4ull, 0xbf6e1f784956452aull, 0x1a5f849d4933e6e0ull,
+        0x6aa594f1262d2d2cull, 0xbba5ad4a1f842e59ull, 0xffef8375d9ebcacaull
+    };
+
+    const std::uint64_t ReferenceSeed12345[6] =
+    {
+        0xbe6a36374160d49bull, 0x214aaa0637a688c6ull, 0xf69d16de9954d388ull,
+        0x0c60048c4e96e033ull, 0x8e2076aeed51c648ull, 0x02bbcc1c1fc50f84ull
+    };
+
+    // SplitMix64 of 0, the state RandomStream(0) starts from.
+    const State StateSeed0 =
+    {
+        0xe220a8397b1dcdafull, 0x6e789e6aa1b965f4ull, 0x06c45d188009454full, 0xf88bb8a8724c81ecull
+    };
+}
+
+TEST(RandomStream, MatchesReferenceOutputs)
+{
+    RandomStream zero(0);
+    for(std::uint64_t expected : ReferenceSeed0)
+        EXPECT_EQ(expected, zero.Next());
+
+    RandomStream other(12345);
+    for(std::uint64_t expected : ReferenceSeed12345)
+        EXPECT_EQ(expected, other.Next());
+
+    // the reference step from the SplitMix64 state gives the same numbers.
+    State state;
+    std::memcpy(state, StateSeed0, sizeof(state));
+    RandomStream stream(0);
+    for(int i = 0; i < 1000; ++i)
+        ASSERT_EQ(ReferenceNext(state), stream.Next());
+}
+
+TEST(RandomStream, JumpMovesTwoToThe128Ahead)
+{
+    Matrix step;
+    for(int bit = 0; bit < 256; ++bit)
+    {
+        State unit = { 0, 0, 0, 0 };
+        unit[bit / 64] = 1ull << (bit % 64);
+        ReferenceNext(unit);
+        std::memcpy(step.Columns[bit], unit, sizeof(unit));
+    }
+
+    // step^(2^128)
+    for(int i = 0; i < 128; ++i)
+        Square(step);
+
+    State jumped;
+    Apply(step, StateSeed0, jumped);
+
+    RandomStream stream(0);
+    stream.Jump();
+    for(int i = 0; i < 100; ++i)
+        ASSERT_EQ(ReferenceNext(jumped), stream.Next());
+}
+
+TEST(RandomStream, SplitReturnsTheStreamBeforeTheJump)
+{
+    RandomStream stream(7, "split");
+    stream.Next();
+
+    RandomStream before = stream;
+    RandomStream jumped = stream;
+    jumped.Jump();
+
+    RandomStream split = stream.Split();
+    for(int i = 0; i < 100; ++i)
+    {
+        ASSERT_EQ(before.Next(), split.Next());
+        ASSERT_EQ(jumped.Next(), stream.Next());
+    }
+}
+
+TEST(RandomStream, NextIntStaysInBounds)
+{
+    RandomStream stream(3);
+
+    const int ranges[][2] =
+    {
+        { 0, 0 }, { -1, 1 }, { 4, 195 }, { -1000, -990 }, { INT_MIN, INT_MIN + 2 }, { INT_MAX - 2, INT_MAX },
+        { INT_MIN, 0 }, { 0, INT_MAX }, { INT_MIN + 1, INT_MAX },
+    };
+
+    for(const auto& range : ranges)
+    {
+        std::set<int> seen;
+        for(int i = 0; i < 10000; ++i)
+        {
+            int value = stream.NextInt(range[0], range[1]);
+            ASSERT_GE(value, range[0]);
+            ASSERT_LE(value, range[1]);
+            seen.insert(value);
+        }
+
+        // small ranges are covered completely.
+        std::int64_t size = (std::int64_t)range[1] - range[0] + 1;
+        if(size <= 200)
+            EXPECT_EQ(size, (std::int64_t)seen.size()) << range[0] << ".." << range[1];
+    }
+
+    // the whole int range draws both signs and the extremes' neighbourhoods alike.
+    int negative = 0;
+    for(int i = 0; i < 100000; ++i)
+    {
+        if(stream.NextInt(INT_MIN, INT_MAX) < 0)
+            negative++;
+    }
+    EXPECT_NEAR(0.5, negative / 100000.0, 0.01);
+}
+
+TEST(RandomStream, NextBelowIsUnbiased)
+{
+    // 2^32 isn't a multiple of 3 * 2^30, a plain modulo or product without rejection draws the
+    // lowest third of the range twice as often as the rest.
+    const std::uint32_t bound = 3u << 30;
+    RandomStream stream(11);
+
+    const int count = 300000;
+    int lowThird = 0;
+    for(int i = 0; i < count; ++i)
+    {
+        std::uint32_t value = stream.NextBelow(bound);
+        ASSERT_LT(value, bound);
+        if(value < (1u << 30))
+            lowThird++;
+    }
+    EXPECT_NEAR(1.0 / 3.0, (double)lowThird / count, 0.005);
+
+    // and every value of a small bound comes about equally often.
+    int histogram[7] = {};
+    for(int i = 0; i < 70000; ++i)
+        histogram[stream.NextBelow(7)]++;
+    for(int n : histogram)
+        EXPECT_NEAR(10000, n, 400);
+}
+
+TEST(RandomStream, NamedStreamsAreIndependent)
+{
+    // a name gives the same stream whatever was created before it.
+    RandomStream enemies(1, "enemies");
+    RandomStream waves(1, "waves");
+    RandomStream enemiesAgain(1, "enemies");
+    for(int i = 0; i < 100; ++i)
+        ASSERT_EQ(enemies.Next(), enemiesAgain.Next());
+
+    // different names and seeds share no numbers and are uncorrelated.
+    RandomStream otherSeed(2, "enemies");
+    std::set<std::uint64_t> numbers;
+    const int count = 10000;
+    double sumA = 0.0, sumB = 0.0, sumAB = 0.0, sumAA = 0.0, sumBB = 0.0;
+    for(int i = 0; i < count; ++i)
+    {
+        numbers.insert(enemies.Next());
+        numbers.insert(waves.Next());
+        numbers.insert(otherSeed.Next());
+
+        double a = enemies.NextFloat();
+        double b = waves.NextFloat();
+        sumA += a;
+        sumB += b;
+        sumAB += a * b;
+        sumAA += a * a;
+        sumBB += b * b;
+    }
+    EXPECT_EQ((size_t)3 * count, numbers.size());
+
+    double covariance = sumAB / count - (sumA / count) * (sumB / count);
+    double varianceA = sumAA / count - (sumA / count) * (sumA / count);
+    double varianceB = sumBB / count - (sumB / count) * (sumB / count);
+    EXPECT_LT(std::fabs(covariance / std::sqrt(varianceA * varianceB)), 0.05);
+}
+
+TEST(RandomStream, FillFloatsMatchesScalarCode)
+{
+    for(std::size_t count : { 0, 1, 7, 8, 9, 31, 1000, 4099 })
+    {
+        RandomStream fast(5, "terrain");
+        RandomStream scalar(5, "terrain");
+
+        std::vector<float> a(count), b(count);
+        fast.FillFloats(a.data(), count, -2.0f, 2.0f);
+        scalar.FillFloatsScalar(b.data(), count, -2.0f, 2.0f);
+
+        ASSERT_EQ(0, std::memcmp(a.data(), b.data(), count * sizeof(float))) << count << " floats";
+        for(float f : a)
+        {
+            ASSERT_GE(f, -2.0f);
+            ASSERT_LT(f, 2.0f);
+        }
+
+        // both move the stream on alike.
+        ASSERT_EQ(fast.Next(), scalar.Next());
+    }
+}
+
+TEST(RandomStream, FillFloatsIsUniform)
+{
+    RandomStream stream(9);
+    std::vector<float> floats(80000);
+    stream.FillFloats(floats.data(), floats.size(), 0.0f, 1.0f);
+
+    int histogram[8] = {};
+    for(float f : floats)
+        histogram[(int)(f * 8.0f)]++;
+    for(int n : histogram)
+        EXPECT_NEAR(10000, n, 400);
+}
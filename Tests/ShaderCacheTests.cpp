@@ -0,0 +1,328 @@
+//***************************************************************************************
+// ShaderCacheTests.cpp
+//
+// Drives ShaderCache::GetOrCompile with a stand-in compiler that counts its invocations,
+// so hits, misses, key invalidation and damaged entries can be checked without d3dcompiler,
+// and hits read into a buffer of the caller's as d3dUtil::CompileShaderCached does.
+//***************************************************************************************
+
+#include "Helpers/ShaderCache.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // "Compiles" a request into bytes that depend on everything the real compiler would see,
+    // and throws for the "fail" target the way d3dUtil::CompileShader throws on errors.
+    struct FakeCompiler
+    {
+        int CallCount = 0;
+
+        ShaderCache::Bytecode operator()(const ShaderCache::Request& request)
+        {
+            CallCount++;
+            if(request.Target == "fail")
+                throw std::runtime_error("compile error");
+
+            std::ifstream fin(request.SourcePath, std::ios::binary);
+            std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+            std::ostringstream ss;
+            ss << request.EntryPoint << '|' << request.Target << '|' << request.Flags << '|' << text;
+            for(const ShaderCache::Define& define : request.Defines)
+                ss << '|' << define.Name << '=' << define.Definition;
+
+            std::string bytes = ss.str();
+            return ShaderCache::Bytecode(bytes.begin(), bytes.end());
+        }
+    };
+
+    class ShaderCacheTest : public ::testing::Test
+    {
+    protected:
+        void SetUp()override
+        {
+            const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+            mRoot = ::testing::TempDir() + "ShaderCacheTests_" + info->name() + "_" + std::to_string(getpid()) + "/";
+            MakeDirectory(mRoot);
+            mCacheDirectory = mRoot + "cache";
+        }
+
+        void TearDown()override
+        {
+            for(const std::string& path : mFiles)
+                std::remove(path.c_str());
+            RemoveDirectory(mCacheDirectory);
+            RemoveDirectory(mRoot);
+        }
+
+        std::string WriteSource(const std::string& name, const std::string& text)
+        {
+            std::string path = mRoot + name;
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+            mFiles.push_back(path);
+            return path;
+        }
+
+        ShaderCache::Request MakeRequest(const std::string& sourcePath)
+        {
+            ShaderCache::Request request;
+            request.SourcePath = sourcePath;
+            request.EntryPoint = "VS";
+            request.Target = "vs_5_0";
+            return request;
+        }
+
+        // Remembers the entry file so TearDown can delete it.
+        std::string TrackEntry(const ShaderCache& cache, const ShaderCache::Request& request)
+        {
+            std::string path = cache.GetEntryPath(cache.ComputeKey(request));
+            mFiles.push_back(path);
+            return path;
+        }
+
+        static std::string ToString(const ShaderCache::Bytecode& bytecode)
+        {
+            return std::string(bytecode.begin(), bytecode.end());
+        }
+
+        static void MakeDirectory(const std::string& path)
+        {
+#if defined(_WIN32)
+            _mkdir(path.c_str());
+#else
+            mkdir(path.c_str(), 0755);
+#endif
+        }
+
+        static void RemoveDirectory(const std::string& path)
+        {
+#if defined(_WIN32)
+            _rmdir(path.c_str());
+#else
+            rmdir(path.c_str());
+#endif
+        }
+
+        std::string mRoot;
+        std::string mCacheDirectory;
+        std::vector<std::string> mFiles;
+    };
+}
+
+TEST_F(ShaderCacheTest, SecondRequestIsHit)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+    TrackEntry(cache, request);
+
+    ShaderCache::Bytecode first = cache.GetOrCompile(request, std::ref(compiler));
+    ShaderCache::Bytecode second = cache.GetOrCompile(request, std::ref(compiler));
+
+    EXPECT_EQ(1, compiler.CallCount);
+    EXPECT_EQ(ToString(first), ToString(second));
+    EXPECT_EQ(1u, cache.GetMissCount());
+    EXPECT_EQ(1u, cache.GetHitCount());
+}
+
+TEST_F(ShaderCacheTest, EntriesOutliveTheCache)
+{
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+
+    ShaderCache::Bytecode first;
+    {
+        ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+        TrackEntry(cache, request);
+        first = cache.GetOrCompile(request, std::ref(compiler));
+    }
+
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    EXPECT_EQ(ToString(first), ToString(cache.GetOrCompile(request, std::ref(compiler))));
+    EXPECT_EQ(1, compiler.CallCount);
+    EXPECT_EQ(1u, cache.GetHitCount());
+}
+
+TEST_F(ShaderCacheTest, EditedIncludeIsMiss)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    FakeCompiler compiler;
+    WriteSource("Shared.hlsl", "#define SCALE 1\n");
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "#include \"Shared.hlsl\"\nfloat4 VS() : SV_POSITION { return SCALE; }"));
+    TrackEntry(cache, request);
+
+    cache.GetOrCompile(request, std::ref(compiler));
+
+    WriteSource("Shared.hlsl", "#define SCALE 2\n");
+    TrackEntry(cache, request);
+    cache.GetOrCompile(request, std::ref(compiler));
+    cache.GetOrCompile(request, std::ref(compiler));
+
+    EXPECT_EQ(2, compiler.CallCount);
+    EXPECT_EQ(2u, cache.GetMissCount());
+    EXPECT_EQ(1u, cache.GetHitCount());
+}
+
+TEST_F(ShaderCacheTest, KeyCoversCompileParameters)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    ShaderCache::Request base = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+
+    ShaderCache::Request defined = base;
+    defined.Defines.push_back({ "STATIC", "1" });
+    ShaderCache::Request redefined = base;
+    redefined.Defines.push_back({ "STATIC", "0" });
+    ShaderCache::Request entry = base;
+    entry.EntryPoint = "PS";
+    ShaderCache::Request target = base;
+    target.Target = "vs_5_1";
+    ShaderCache::Request flags = base;
+    flags.Flags = 1;
+
+    std::uint64_t key = cache.ComputeKey(base);
+    EXPECT_EQ(key, cache.ComputeKey(base));
+    EXPECT_NE(key, cache.ComputeKey(defined));
+    EXPECT_NE(cache.ComputeKey(defined), cache.ComputeKey(redefined));
+    EXPECT_NE(key, cache.ComputeKey(entry));
+    EXPECT_NE(key, cache.ComputeKey(target));
+    EXPECT_NE(key, cache.ComputeKey(flags));
+}
+
+TEST_F(ShaderCacheTest, OtherCompilerIsMiss)
+{
+    ShaderCache oldCache(mCacheDirectory, "FakeCompiler 1.0");
+    ShaderCache newCache(mCacheDirectory, "FakeCompiler 1.1");
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+    TrackEntry(oldCache, request);
+    TrackEntry(newCache, request);
+
+    EXPECT_NE(oldCache.ComputeKey(request), newCache.ComputeKey(request));
+
+    oldCache.GetOrCompile(request, std::ref(compiler));
+    newCache.GetOrCompile(request, std::ref(compiler));
+    EXPECT_EQ(2, compiler.CallCount);
+    EXPECT_EQ(1u, newCache.GetMissCount());
+
+    // Both entries live side by side.
+    oldCache.GetOrCompile(request, std::ref(compiler));
+    newCache.GetOrCompile(request, std::ref(compiler));
+    EXPECT_EQ(2, compiler.CallCount);
+}
+
+TEST_F(ShaderCacheTest, DamagedEntryIsMissAndReplaced)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+    std::string entryPath = TrackEntry(cache, request);
+
+    const std::string expected = ToString(cache.GetOrCompile(request, std::ref(compiler)));
+
+    std::ifstream fin(entryPath, std::ios::binary);
+    const std::string entry((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    fin.close();
+    ASSERT_GT(entry.size(), expected.size());
+
+    std::string flipped = entry;
+    flipped.back() ^= 0x20;
+
+    const std::string damaged[] =
+    {
+        std::string(),                              // empty
+        entry.substr(0, 8),                         // cut inside the header
+        entry.substr(0, entry.size() - 1),          // cut inside the payload
+        entry + "x",                                // trailing garbage
+        flipped,                                    // payload bit flip
+        std::string(entry.size(), 'x'),             // not an entry at all
+    };
+
+    int expectedCalls = 1;
+    for(const std::string& contents : damaged)
+    {
+        std::ofstream(entryPath, std::ios::binary | std::ios::trunc) << contents;
+
+        EXPECT_EQ(expected, ToString(cache.GetOrCompile(request, std::ref(compiler))));
+        EXPECT_EQ(++expectedCalls, compiler.CallCount);
+
+        // The rewritten entry is good again.
+        EXPECT_EQ(expected, ToString(cache.GetOrCompile(request, std::ref(compiler))));
+        EXPECT_EQ(expectedCalls, compiler.CallCount);
+    }
+}
+
+TEST_F(ShaderCacheTest, FailedCompileStoresNothing)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+    request.Target = "fail";
+    std::string entryPath = TrackEntry(cache, request);
+
+    EXPECT_THROW(cache.GetOrCompile(request, std::ref(compiler)), std::runtime_error);
+    EXPECT_FALSE(std::ifstream(entryPath).good());
+
+    EXPECT_THROW(cache.GetOrCompile(request, std::ref(compiler)), std::runtime_error);
+    EXPECT_EQ(2, compiler.CallCount);
+    EXPECT_EQ(0u, cache.GetHitCount());
+}
+
+TEST_F(ShaderCacheTest, HitIsReadIntoCallerBuffer)
+{
+    ShaderCache cache(mCacheDirectory, "FakeCompiler 1.0");
+    FakeCompiler compiler;
+    ShaderCache::Request request = MakeRequest(WriteSource("a.hlsl", "float4 VS() : SV_POSITION { return 0; }"));
+    TrackEntry(cache, request);
+
+    // the caller's buffer, as an ID3DBlob is for d3dUtil::CompileShaderCached.
+    std::vector<std::unique_ptr<char[]>> buffers;
+    std::vector<std::size_t> allocations;
+    ShaderCache::Bytecode compiled;
+    auto compileInto = [&](const ShaderCache::Request& r)
+    {
+        compiled = compiler(r);
+        return ShaderCache::BytecodeView{ compiled.data(), compiled.size() };
+    };
+    auto allocate = [&](std::size_t size)
+    {
+        buffers.emplace_back(new char[size]);
+        allocations.push_back(size);
+        return buffers.back().get();
+    };
+
+    // a miss leaves the bytecode in the compiler's buffer and allocates nothing.
+    cache.GetOrCompileInto(request, compileInto, allocate);
+    EXPECT_EQ(1, compiler.CallCount);
+    EXPECT_TRUE(allocations.empty());
+    const std::string expected = ToString(compiled);
+
+    // a hit allocates the exact size once and reads the bytecode into it.
+    cache.GetOrCompileInto(request, compileInto, allocate);
+    EXPECT_EQ(1, compiler.CallCount);
+    ASSERT_EQ(1u, allocations.size());
+    EXPECT_EQ(expected.size(), allocations[0]);
+    EXPECT_EQ(expected, std::string(buffers[0].get(), allocations[0]));
+    EXPECT_EQ(1u, cache.GetHitCount());
+
+    // and the vector version reads the same entry.
+    EXPECT_EQ(expected, ToString(cache.GetOrCompile(request, std::ref(compiler))));
+    EXPECT_EQ(1, compiler.CallCount);
+}
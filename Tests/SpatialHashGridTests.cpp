@@ -0,0 +1,169 @@
+//***************************************************************************************
+// SpatialHashGridTests.cpp
+//
+// The box broadphase must report exactly the overlapping pairs that testing every pair does,
+// each once, from 5 x 5 boxes up to 10000 x 10000.
+//***************************************************************************************
+
+#include "Helpers/SpatialHashGrid.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    using Box = SpatialHashGrid::Box;
+    using Pair = SpatialHashGrid::Pair;
+
+    // count boxes inside a cube of side extent centered on the origin, each side of a box in
+    // [minSize, maxSize).
+    std::vector<Box> MakeBoxes(RandomStream& random, std::uint32_t count, float extent, float minSize, float maxSize)
+    {
+        std::vector<Box> boxes(count);
+        for(Box& box : boxes)
+        {
+            box.MinX = random.NextFloat(-0.5f * extent, 0.5f * extent);
+            box.MinY = random.NextFloat(-0.5f * extent, 0.5f * extent);
+            box.MinZ = random.NextFloat(-0.5f * extent, 0.5f * extent);
+            box.MaxX = box.MinX + random.NextFloat(minSize, maxSize);
+            box.MaxY = box.MinY + random.NextFloat(minSize, maxSize);
+            box.MaxZ = box.MinZ + random.NextFloat(minSize, maxSize);
+        }
+        return boxes;
+    }
+
+    std::vector<Pair> BruteForcePairs(const std::vector<Box>& queries, const std::vector<Box>& boxes)
+    {
+        std::vector<Pair> pairs;
+        for(std::uint32_t i = 0; i < (std::uint32_t)queries.size(); ++i)
+        {
+            const Box& a = queries[i];
+            for(std::uint32_t j = 0; j < (std::uint32_t)boxes.size(); ++j)
+            {
+                const Box& b = boxes[j];
+                if(a.MinX <= b.MaxX && b.MinX <= a.MaxX && a.MinY <= b.MaxY && b.MinY <= a.MaxY &&
+                    a.MinZ <= b.MaxZ && b.MinZ <= a.MaxZ)
+                {
+                    Pair pair = { i, j };
+                    pairs.push_back(pair);
+                }
+            }
+        }
+        return pairs;
+    }
+
+    void SortPairs(std::vector<Pair>& pairs)
+    {
+        std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b)
+        {
+            return a.Query != b.Query ? a.Query < b.Query : a.Point < b.Point;
+        });
+    }
+
+    void ExpectSamePairs(std::vector<Pair> actual, std::vector<Pair> expected)
+    {
+        SortPairs(actual);
+        SortPairs(expected);
+        ASSERT_EQ(expected.size(), actual.size());
+        for(size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(expected[i].Query, actual[i].Query) << "pair " << i;
+            ASSERT_EQ(expected[i].Point, actual[i].Point) << "pair " << i;
+        }
+    }
+
+    struct GridCase
+    {
+        std::uint32_t QueryCount;
+        std::uint32_t BoxCount;
+    };
+
+    void PrintTo(const GridCase& c, std::ostream* os)
+    {
+        *os << c.QueryCount << " x " << c.BoxCount;
+    }
+
+    class SpatialHashGridSizes : public ::testing::TestWithParam<GridCase>
+    {
+    };
+}
+
+TEST_P(SpatialHashGridSizes, FindsThePairsOfBruteForce)
+{
+    const GridCase c = GetParam();
+
+    // boxes the size of the game's swept enemies, spread so each overlaps a few others.
+    RandomStream random(c.QueryCount * 31 + c.BoxCount);
+    const float extent = 40.0f * std::cbrt((float)std::max(c.QueryCount, c.BoxCount)) + 20.0f;
+    std::vector<Box> boxes = MakeBoxes(random, c.BoxCount, extent, 5.0f, 30.0f);
+    std::vector<Box> queries = MakeBoxes(random, c.QueryCount, extent, 5.0f, 30.0f);
+
+    SpatialHashGrid grid(15.0f);
+    grid.BuildBoxes(boxes.data(), (std::uint32_t)boxes.size());
+
+    std::vector<Pair> pairs;
+    grid.QueryBoxPairs(queries.data(), (std::uint32_t)queries.size(), pairs);
+
+    std::vector<Pair> expected = BruteForcePairs(queries, boxes);
+    EXPECT_FALSE(expected.empty());
+    ExpectSamePairs(pairs, expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(SpatialHashGrid, SpatialHashGridSizes, ::testing::Values(
+    GridCase{ 5, 5 }, GridCase{ 100, 100 }, GridCase{ 1000, 1000 }, GridCase{ 10000, 10000 },
+    GridCase{ 1, 10000 }, GridCase{ 10000, 1 }));
+
+TEST(SpatialHashGrid, ReportsBoxesSpanningManyCellsOnce)
+{
+    // the boxes share dozens of cells, the pair is still reported once.
+    std::vector<Box> boxes = { { -50.0f, -5.0f, -50.0f, 50.0f, 5.0f, 50.0f } };
+    std::vector<Box> queries = { { -40.0f, -1.0f, -40.0f, 45.0f, 1.0f, 45.0f }, { 60.0f, 0.0f, 0.0f, 70.0f, 1.0f, 1.0f } };
+
+    SpatialHashGrid grid(15.0f);
+    grid.BuildBoxes(boxes.data(), (std::uint32_t)boxes.size());
+
+    std::vector<Pair> pairs;
+    grid.QueryBoxPairs(queries.data(), (std::uint32_t)queries.size(), pairs);
+
+    ASSERT_EQ(1u, pairs.size());
+    EXPECT_EQ(0u, pairs[0].Query);
+    EXPECT_EQ(0u, pairs[0].Point);
+}
+
+TEST(SpatialHashGrid, CountsTouchingBoxesAsOverlapping)
+{
+    // the boxes share a face that lies on a cell boundary.
+    std::vector<Box> boxes = { { 0.0f, 0.0f, 0.0f, 15.0f, 1.0f, 1.0f } };
+    std::vector<Box> queries = { { 15.0f, 0.0f, 0.0f, 20.0f, 1.0f, 1.0f } };
+
+    SpatialHashGrid grid(15.0f);
+    grid.BuildBoxes(boxes.data(), (std::uint32_t)boxes.size());
+
+    std::vector<Pair> pairs;
+    grid.QueryBoxPairs(queries.data(), (std::uint32_t)queries.size(), pairs);
+
+    EXPECT_EQ(1u, pairs.size());
+}
+
+TEST(SpatialHashGrid, RebuildReplacesTheBoxes)
+{
+    RandomStream random(7);
+    std::vector<Box> first = MakeBoxes(random, 500, 300.0f, 5.0f, 30.0f);
+    std::vector<Box> second = MakeBoxes(random, 50, 300.0f, 5.0f, 30.0f);
+    std::vector<Box> queries = MakeBoxes(random, 200, 300.0f, 5.0f, 30.0f);
+
+    SpatialHashGrid grid(15.0f);
+    grid.BuildBoxes(first.data(), (std::uint32_t)first.size());
+    grid.BuildBoxes(second.data(), (std::uint32_t)second.size());
+
+    std::vector<Pair> pairs;
+    grid.QueryBoxPairs(queries.data(), (std::uint32_t)queries.size(), pairs);
+    ExpectSamePairs(pairs, BruteForcePairs(queries, second));
+
+    grid.BuildBoxes(nullptr, 0);
+    pairs.clear();
+    grid.QueryBoxPairs(queries.data(), (std::uint32_t)queries.size(), pairs);
+    EXPECT_TRUE(pairs.empty());
+}
@@ -0,0 +1,306 @@
+//***************************************************************************************
+// SphereOverlapTests.cpp
+//
+// Every narrowphase path against the scalar one, the sweep against known times of impact,
+// and the collision pipeline of the game (swept box broadphase, swept bounds, sweep) against
+// sweeping every pair, from 5 x 5 spheres up to 10000 x 10000.
+//***************************************************************************************
+
+#include "Helpers/SphereOverlap.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace SphereOverlap;
+
+namespace
+{
+    // separate arrays of spheres, and of moving spheres.
+    struct SphereArrays
+    {
+        std::vector<float> X, Y, Z, Radius;
+        std::vector<float> PrevX, PrevY, PrevZ;
+
+        Spheres Get()const
+        {
+            Spheres s = { X.data(), Y.data(), Z.data(), Radius.data() };
+            return s;
+        }
+
+        MovingSpheres GetMoving()const
+        {
+            MovingSpheres s = { PrevX.data(), PrevY.data(), PrevZ.data(), X.data(), Y.data(), Z.data(), Radius.data() };
+            return s;
+        }
+    };
+
+    // count spheres inside a cube of side extent, moving by up to travel along each axis.
+    SphereArrays MakeSpheres(RandomStream& random, std::uint32_t count, float extent, float minRadius, float maxRadius,
+        float travel = 0.0f)
+    {
+        SphereArrays s;
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            s.PrevX.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.PrevY.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.PrevZ.push_back(random.NextFloat(-0.5f * extent, 0.5f * extent));
+            s.X.push_back(s.PrevX.back() + random.NextFloat(-travel, travel));
+            s.Y.push_back(s.PrevY.back() + random.NextFloat(-travel, travel));
+            s.Z.push_back(s.PrevZ.back() + random.NextFloat(-travel, travel));
+            s.Radius.push_back(random.NextFloat(minRadius, maxRadius));
+        }
+        return s;
+    }
+
+    // paths this CPU can run.
+    std::vector<Path> GetPaths()
+    {
+        std::vector<Path> paths = { Path::Scalar };
+        if(GetSupportedPath() >= Path::Sse)
+            paths.push_back(Path::Sse);
+        if(GetSupportedPath() >= Path::Avx2)
+            paths.push_back(Path::Avx2);
+        return paths;
+    }
+
+    // puts the supported path back when a test ends.
+    class SphereOverlapTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override { SetPath(GetSupportedPath()); }
+    };
+
+    bool SameImpact(const Impact& a, const Impact& b)
+    {
+        return a.Query == b.Query && a.Point == b.Point && a.Time == b.Time;
+    }
+
+    void SortImpacts(std::vector<Impact>& impacts)
+    {
+        std::sort(impacts.begin(), impacts.end(), [](const Impact& a, const Impact& b)
+        {
+            return a.Query != b.Query ? a.Query < b.Query : a.Point < b.Point;
+        });
+    }
+}
+
+TEST_F(SphereOverlapTest, TestMatchesScalarOnEveryPath)
+{
+    RandomStream random(1);
+    // counts around the 4 and 8 wide blocks and the 32 bit mask words.
+    for(std::uint32_t count : { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 31u, 32u, 33u, 64u, 71u, 1000u })
+    {
+        SphereArrays s = MakeSpheres(random, count, 100.0f, 1.0f, 10.0f);
+
+        SetPath(Path::Scalar);
+        std::vector<std::uint32_t> expected(GetMaskWordCount(count) + 1, 0xdeadbeef);
+        std::uint32_t expectedHits = SphereOverlap::Test(1.0f, 2.0f, 3.0f, 20.0f, s.Get(), count, expected.data());
+
+        for(Path path : GetPaths())
+        {
+            SetPath(path);
+            std::vector<std::uint32_t> mask(GetMaskWordCount(count) + 1, 0xdeadbeef);
+            EXPECT_EQ(expectedHits, SphereOverlap::Test(1.0f, 2.0f, 3.0f, 20.0f, s.Get(), count, mask.data())) << GetPathName(path);
+            EXPECT_EQ(expected, mask) << GetPathName(path) << ", " << count << " spheres";
+
+            // the word past the mask is left alone.
+            EXPECT_EQ(0xdeadbeefu, mask.back());
+        }
+
+        std::uint32_t bruteHits = 0;
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            float dx = s.X[i] - 1.0f, dy = s.Y[i] - 2.0f, dz = s.Z[i] - 3.0f, r = 20.0f + s.Radius[i];
+            bool hit = dx * dx + dy * dy + dz * dz < r * r;
+            bruteHits += hit ? 1 : 0;
+            EXPECT_EQ(hit, ((expected[i / 32] >> (i % 32)) & 1) != 0);
+        }
+        EXPECT_EQ(bruteHits, expectedHits);
+    }
+}
+
+TEST_F(SphereOverlapTest, AppendHitsListsTheBitsInOrder)
+{
+    std::uint32_t mask[2] = { 0x80000005u, 0x2u };
+    std::vector<Pair> hits;
+    AppendHits(mask, 40, 3, hits);
+
+    ASSERT_EQ(4u, hits.size());
+    const std::uint32_t points[] = { 0, 2, 31, 33 };
+    for(size_t i = 0; i < hits.size(); ++i)
+    {
+        EXPECT_EQ(3u, hits[i].Query);
+        EXPECT_EQ(points[i], hits[i].Point);
+    }
+}
+
+TEST_F(SphereOverlapTest, TestPairsMatchesScalarOnEveryPath)
+{
+    RandomStream random(2);
+    SphereArrays queries = MakeSpheres(random, 300, 200.0f, 1.0f, 10.0f);
+    SphereArrays spheres = MakeSpheres(random, 500, 200.0f, 1.0f, 10.0f);
+
+    // counts that leave every remainder of the 4 and 8 wide blocks.
+    for(std::uint32_t count : { 0u, 1u, 5u, 8u, 13u, 4096u })
+    {
+        std::vector<Pair> pairs;
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            Pair pair = { random.NextBelow(300), random.NextBelow(500) };
+            pairs.push_back(pair);
+        }
+
+        SetPath(Path::Scalar);
+        std::vector<Pair> expected;
+        TestPairs(queries.Get(), spheres.Get(), pairs.data(), count, expected);
+
+        for(Path path : GetPaths())
+        {
+            SetPath(path);
+            std::vector<Pair> hits = { { 7, 7 } };
+            EXPECT_EQ((std::uint32_t)expected.size(), TestPairs(queries.Get(), spheres.Get(), pairs.data(), count, hits));
+
+            // appended after what hits held, in the order of the pairs.
+            ASSERT_EQ(expected.size() + 1, hits.size()) << GetPathName(path);
+            for(size_t i = 0; i < expected.size(); ++i)
+            {
+                EXPECT_EQ(expected[i].Query, hits[i + 1].Query) << GetPathName(path);
+                EXPECT_EQ(expected[i].Point, hits[i + 1].Point) << GetPathName(path);
+            }
+        }
+    }
+}
+
+TEST_F(SphereOverlapTest, TimeOfImpact)
+{
+    // a moves from x = 0 to 10 with radius 1 towards b at rest at x = 6 with radius 1: they
+    // meet when a reaches x = 4.
+    SphereArrays a, b;
+    a.PrevX = { 0.0f }; a.PrevY = { 0.0f }; a.PrevZ = { 0.0f };
+    a.X = { 10.0f }; a.Y = { 0.0f }; a.Z = { 0.0f }; a.Radius = { 1.0f };
+    b.PrevX = { 6.0f }; b.PrevY = { 0.0f }; b.PrevZ = { 0.0f };
+    b.X = { 6.0f }; b.Y = { 0.0f }; b.Z = { 0.0f }; b.Radius = { 1.0f };
+    EXPECT_FLOAT_EQ(0.4f, TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0));
+
+    // it passes right through b during the step, which a test at the end of the step misses.
+    b.PrevX = { 5.0f }; b.X = { 5.0f };
+    b.Radius = { 0.5f };
+    a.Radius = { 0.5f };
+    EXPECT_FLOAT_EQ(0.4f, TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0));
+
+    // b moving away as fast never gets hit.
+    b.X = { 15.0f };
+    EXPECT_LT(TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0), 0.0f);
+
+    // overlapping from the start.
+    b.PrevX = { 0.5f }; b.X = { 0.5f };
+    EXPECT_EQ(0.0f, TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0));
+
+    // too far to the side.
+    b.PrevX = { 5.0f }; b.X = { 5.0f };
+    b.PrevY = { 1.5f }; b.Y = { 1.5f };
+    EXPECT_LT(TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0), 0.0f);
+
+    // not reached within the step.
+    b.PrevY = { 0.0f }; b.Y = { 0.0f };
+    b.PrevX = { 20.0f }; b.X = { 20.0f };
+    EXPECT_LT(TimeOfImpact(a.GetMoving(), 0, b.GetMoving(), 0), 0.0f);
+}
+
+TEST_F(SphereOverlapTest, SweptBoundsHoldTheSweep)
+{
+    RandomStream random(3);
+    SphereArrays s = MakeSpheres(random, 1000, 100.0f, 0.5f, 10.0f, 40.0f);
+    SweptBounds bounds;
+    GetSweptBounds(s.GetMoving(), 1000, bounds);
+
+    for(std::uint32_t i = 0; i < 1000; ++i)
+    {
+        for(float t : { 0.0f, 0.25f, 0.5f, 1.0f })
+        {
+            float x = s.PrevX[i] + t * (s.X[i] - s.PrevX[i]) - bounds.X[i];
+            float y = s.PrevY[i] + t * (s.Y[i] - s.PrevY[i]) - bounds.Y[i];
+            float z = s.PrevZ[i] + t * (s.Z[i] - s.PrevZ[i]) - bounds.Z[i];
+            EXPECT_LE(std::sqrt(x * x + y * y + z * z) + s.Radius[i], bounds.Radius[i]);
+        }
+    }
+}
+
+namespace
+{
+    struct SweepCase
+    {
+        std::uint32_t QueryCount;
+        std::uint32_t SphereCount;
+    };
+
+    void PrintTo(const SweepCase& c, std::ostream* os)
+    {
+        *os << c.QueryCount << " x " << c.SphereCount;
+    }
+
+    class SphereSweepSizes : public SphereOverlapTest, public ::testing::WithParamInterface<SweepCase>
+    {
+    };
+}
+
+TEST_P(SphereSweepSizes, FindsTheImpactsOfBruteForce)
+{
+    const SweepCase c = GetParam();
+
+    // shells against enemies: small fast spheres against larger slow ones.
+    RandomStream random(c.QueryCount * 31 + c.SphereCount);
+    const float extent = 15.0f * std::cbrt((float)std::max(c.QueryCount, c.SphereCount));
+    SphereArrays queries = MakeSpheres(random, c.QueryCount, extent, 4.0f, 6.0f, 15.0f);
+    SphereArrays spheres = MakeSpheres(random, c.SphereCount, extent, 4.0f, 6.0f, 1.0f);
+
+    // every pair, one query at a time.
+    std::vector<Impact> expected;
+    std::vector<Pair> row(c.SphereCount);
+    for(std::uint32_t i = 0; i < c.QueryCount; ++i)
+    {
+        for(std::uint32_t j = 0; j < c.SphereCount; ++j)
+        {
+            row[j].Query = i;
+            row[j].Point = j;
+        }
+        SweepPairs(queries.GetMoving(), spheres.GetMoving(), row.data(), c.SphereCount, expected);
+    }
+    EXPECT_FALSE(expected.empty());
+    SortImpacts(expected);
+
+    for(Path path : GetPaths())
+    {
+        SetPath(path);
+
+        // as in GameWorld::CollisionProcessing().
+        std::vector<SpatialHashGrid::Box> sphereBoxes, queryBoxes;
+        GetSweptBoxes(spheres.GetMoving(), c.SphereCount, sphereBoxes);
+        GetSweptBoxes(queries.GetMoving(), c.QueryCount, queryBoxes);
+        SpatialHashGrid grid(15.0f);
+        grid.BuildBoxes(sphereBoxes.data(), c.SphereCount);
+        std::vector<Pair> candidates;
+        grid.QueryBoxPairs(queryBoxes.data(), c.QueryCount, candidates);
+
+        SweptBounds sphereBounds, queryBounds;
+        GetSweptBounds(spheres.GetMoving(), c.SphereCount, sphereBounds);
+        GetSweptBounds(queries.GetMoving(), c.QueryCount, queryBounds);
+        std::vector<Pair> overlaps;
+        TestPairs(queryBounds.GetSpheres(), sphereBounds.GetSpheres(), candidates.data(), (std::uint32_t)candidates.size(),
+            overlaps);
+        EXPECT_LE(overlaps.size(), candidates.size());
+
+        std::vector<Impact> impacts;
+        SweepPairs(queries.GetMoving(), spheres.GetMoving(), overlaps.data(), (std::uint32_t)overlaps.size(), impacts);
+        SortImpacts(impacts);
+
+        ASSERT_EQ(expected.size(), impacts.size()) << GetPathName(path);
+        for(size_t i = 0; i < expected.size(); ++i)
+            ASSERT_TRUE(SameImpact(expected[i], impacts[i])) << GetPathName(path) << ", impact " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(SphereOverlap, SphereSweepSizes, ::testing::Values(
+    SweepCase{ 5, 5 }, SweepCase{ 100, 100 }, SweepCase{ 1000, 1000 }, SweepCase{ 10000, 10000 }));
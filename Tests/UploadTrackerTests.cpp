@@ -0,0 +1,190 @@
+//***************************************************************************************
+// UploadTrackerTests.cpp
+//
+// Drives UploadTracker the way UploadManager does, with a plain number standing in for the
+// fence value of the copy queue and shared pointers standing in for staging memory, so
+// tickets, residency and staging lifetimes can be checked without a device.
+//***************************************************************************************
+
+#include "Helpers/UploadTracker.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using Tracker = UploadTracker<std::shared_ptr<int>>;
+
+    // distinct addresses for the destination resources.
+    int Resources[4];
+}
+
+TEST(UploadTracker, TicketsIncreaseByOnePerBatch)
+{
+    Tracker tracker;
+    EXPECT_EQ(1u, tracker.GetBatchTicket());
+    EXPECT_EQ(0u, tracker.GetLastSubmittedTicket());
+
+    for(Tracker::Ticket expected = 1; expected <= 5; ++expected)
+    {
+        EXPECT_EQ(expected, tracker.Track(&Resources[0]));
+        EXPECT_EQ(expected, tracker.GetTicket(&Resources[0]));
+        EXPECT_EQ(expected, tracker.Submit());
+        EXPECT_EQ(expected, tracker.GetLastSubmittedTicket());
+        EXPECT_EQ(expected + 1, tracker.GetBatchTicket());
+    }
+
+    // the first ticket can be chosen, e.g. to continue the values of an existing fence.
+    Tracker later(100);
+    EXPECT_EQ(99u, later.GetLastSubmittedTicket());
+    later.Track(&Resources[1]);
+    EXPECT_EQ(100u, later.Submit());
+    EXPECT_FALSE(later.IsResident(&Resources[1], 99));
+    EXPECT_TRUE(later.IsResident(&Resources[1], 100));
+}
+
+TEST(UploadTracker, EmptyBatchUsesNoTicket)
+{
+    Tracker tracker;
+    EXPECT_TRUE(tracker.IsBatchEmpty());
+    EXPECT_EQ(0u, tracker.Submit());
+    EXPECT_EQ(1u, tracker.GetBatchTicket());
+
+    tracker.Track(&Resources[0]);
+    EXPECT_FALSE(tracker.IsBatchEmpty());
+    EXPECT_EQ(1u, tracker.Submit());
+    EXPECT_TRUE(tracker.IsBatchEmpty());
+
+    // submitting again returns the batch already submitted, the fence waits for that.
+    EXPECT_EQ(1u, tracker.Submit());
+    EXPECT_EQ(1u, tracker.Submit());
+    EXPECT_EQ(2u, tracker.GetBatchTicket());
+
+    // held staging memory alone makes a batch worth submitting.
+    tracker.Hold(std::make_shared<int>(0));
+    EXPECT_FALSE(tracker.IsBatchEmpty());
+    EXPECT_EQ(2u, tracker.Submit());
+
+    // retiring nothing submitted is harmless.
+    Tracker idle;
+    idle.Retire(0);
+    idle.Retire(10);
+    EXPECT_EQ(0u, idle.GetPendingResourceCount());
+    EXPECT_EQ(0u, idle.GetHeldStagingCount());
+}
+
+TEST(UploadTracker, ResidentOnceTheFenceReachesTheTicket)
+{
+    Tracker tracker;
+    Tracker::Ticket completed = 0;
+
+    tracker.Track(&Resources[0]);
+    tracker.Track(&Resources[1]);
+    Tracker::Ticket first = tracker.Submit();
+    tracker.Track(&Resources[2]);
+    Tracker::Ticket second = tracker.Submit();
+
+    EXPECT_FALSE(tracker.IsResident(&Resources[0], completed));
+    EXPECT_FALSE(tracker.IsResident(&Resources[2], completed));
+
+    // unknown resources count as resident.
+    EXPECT_TRUE(tracker.IsResident(&Resources[3], completed));
+    EXPECT_EQ(0u, tracker.GetTicket(&Resources[3]));
+
+    // the fence passes the first batch.
+    completed = first;
+    EXPECT_TRUE(tracker.IsResident(&Resources[0], completed));
+    EXPECT_TRUE(tracker.IsResident(&Resources[1], completed));
+    EXPECT_FALSE(tracker.IsResident(&Resources[2], completed));
+
+    // retiring forgets the completed resources, which stay resident.
+    tracker.Retire(completed);
+    EXPECT_EQ(1u, tracker.GetPendingResourceCount());
+    EXPECT_EQ(0u, tracker.GetTicket(&Resources[0]));
+    EXPECT_TRUE(tracker.IsResident(&Resources[0], completed));
+    EXPECT_FALSE(tracker.IsResident(&Resources[2], completed));
+
+    completed = second;
+    EXPECT_TRUE(tracker.IsResident(&Resources[2], completed));
+    tracker.Retire(completed);
+    EXPECT_EQ(0u, tracker.GetPendingResourceCount());
+}
+
+TEST(UploadTracker, RetrackedResourceWaitsForItsLastUpload)
+{
+    Tracker tracker;
+    tracker.Track(&Resources[0]);
+    Tracker::Ticket first = tracker.Submit();
+
+    // written again by a later batch before the first one completed.
+    tracker.Track(&Resources[0]);
+    Tracker::Ticket second = tracker.Submit();
+    EXPECT_EQ(second, tracker.GetTicket(&Resources[0]));
+    EXPECT_EQ(1u, tracker.GetPendingResourceCount());
+
+    EXPECT_FALSE(tracker.IsResident(&Resources[0], first));
+    tracker.Retire(first);
+    EXPECT_EQ(second, tracker.GetTicket(&Resources[0]));
+    EXPECT_FALSE(tracker.IsResident(&Resources[0], first));
+
+    EXPECT_TRUE(tracker.IsResident(&Resources[0], second));
+
+    // tracking twice in one batch is the same as once.
+    tracker.Track(&Resources[1]);
+    tracker.Track(&Resources[1]);
+    Tracker::Ticket third = tracker.Submit();
+    EXPECT_EQ(third, tracker.GetTicket(&Resources[1]));
+    tracker.Retire(third);
+    EXPECT_EQ(0u, tracker.GetPendingResourceCount());
+}
+
+TEST(UploadTracker, StagingLivesUntilItsTicketCompletes)
+{
+    Tracker tracker;
+    std::vector<std::weak_ptr<int>> staging;
+
+    // two pages for the first batch, one for the second, one for the third.
+    const int pagesPerBatch[] = { 2, 1, 1 };
+    std::vector<Tracker::Ticket> tickets;
+    for(int pages : pagesPerBatch)
+    {
+        for(int i = 0; i < pages; ++i)
+        {
+            std::shared_ptr<int> page = std::make_shared<int>((int)staging.size());
+            staging.push_back(page);
+            tracker.Hold(std::move(page));
+        }
+        tickets.push_back(tracker.Submit());
+    }
+
+    // the tracker holds the only references.
+    EXPECT_EQ(4u, tracker.GetHeldStagingCount());
+    for(const std::weak_ptr<int>& page : staging)
+        EXPECT_FALSE(page.expired());
+
+    // a fence value before the first ticket releases nothing.
+    tracker.Retire(tickets[0] - 1);
+    EXPECT_EQ(4u, tracker.GetHeldStagingCount());
+
+    tracker.Retire(tickets[0]);
+    EXPECT_EQ(2u, tracker.GetHeldStagingCount());
+    EXPECT_TRUE(staging[0].expired());
+    EXPECT_TRUE(staging[1].expired());
+    EXPECT_FALSE(staging[2].expired());
+    EXPECT_FALSE(staging[3].expired());
+
+    // the fence can pass several batches between two retires.
+    tracker.Retire(tickets[2]);
+    EXPECT_EQ(0u, tracker.GetHeldStagingCount());
+    EXPECT_TRUE(staging[2].expired());
+    EXPECT_TRUE(staging[3].expired());
+
+    // staging held while a batch is recorded belongs to that batch, not to a completed one.
+    std::shared_ptr<int> page = std::make_shared<int>(4);
+    std::weak_ptr<int> watched = page;
+    tracker.Hold(std::move(page));
+    tracker.Retire(tickets[2]);
+    EXPECT_FALSE(watched.expired());
+    tracker.Retire(tracker.Submit());
+    EXPECT_TRUE(watched.expired());
+}
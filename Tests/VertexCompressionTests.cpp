@@ -0,0 +1,281 @@
+//***************************************************************************************
+// VertexCompressionTests.cpp
+//
+// Encode/decode round trips of the compact vertex: the worst position error against its
+// bound, normals on the axes and the seams of the octahedral mapping, texture coordinates
+// from denormals to large tiling values, and degenerate bounds.
+//***************************************************************************************
+
+#include "Helpers/VertexCompression.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const float Pi = 3.1415926535f;
+
+    struct Decoded
+    {
+        XMFLOAT3 Pos;
+        XMFLOAT3 Normal;
+        XMFLOAT2 TexC;
+    };
+
+    Decoded RoundTrip(const XMFLOAT3& pos, const XMFLOAT3& normal, const XMFLOAT2& texC, const PositionDecode& decode)
+    {
+        Decoded d;
+        CompactVertex v = VertexCompression::Encode(pos, normal, texC, decode);
+        VertexCompression::Decode(v, decode, d.Pos, d.Normal, d.TexC);
+        return d;
+    }
+
+    double Angle(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        double dx = (double)a.x - b.x, dy = (double)a.y - b.y, dz = (double)a.z - b.z;
+        return 2.0 * std::asin(std::min(1.0, 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz)));
+    }
+
+    XMFLOAT3 Normalize(float x, float y, float z)
+    {
+        float length = std::sqrt(x * x + y * y + z * z);
+        return XMFLOAT3(x / length, y / length, z / length);
+    }
+
+    // uniform on the unit sphere.
+    XMFLOAT3 RandomNormal(RandomStream& random)
+    {
+        float z = random.NextFloat(-1.0f, 1.0f);
+        float phi = random.NextFloat(0.0f, 2.0f * Pi);
+        float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        return Normalize(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    BoundingBox MakeBounds(const XMFLOAT3& center, const XMFLOAT3& extents)
+    {
+        BoundingBox bounds;
+        bounds.Center = center;
+        bounds.Extents = extents;
+        return bounds;
+    }
+}
+
+TEST(VertexCompression, PositionDecodeSpansTheBounds)
+{
+    PositionDecode decode = VertexCompression::GetPositionDecode(MakeBounds(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(4.0f, 5.0f, 6.0f)));
+    EXPECT_FLOAT_EQ(8.0f, decode.Scale.x);
+    EXPECT_FLOAT_EQ(10.0f, decode.Scale.y);
+    EXPECT_FLOAT_EQ(12.0f, decode.Scale.z);
+    EXPECT_FLOAT_EQ(-3.0f, decode.Offset.x);
+    EXPECT_FLOAT_EQ(-3.0f, decode.Offset.y);
+    EXPECT_FLOAT_EQ(-3.0f, decode.Offset.z);
+}
+
+TEST(VertexCompression, PositionErrorStaysWithinItsBound)
+{
+    RandomStream random(37);
+    const XMFLOAT3 normal(0.0f, 1.0f, 0.0f);
+    const XMFLOAT2 texC(0.0f, 0.0f);
+
+    // unit bounds, large bounds, and small bounds far from the origin where float rounding of
+    // the decode is as large as the quantization step.
+    const BoundingBox boundsList[] = {
+        MakeBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)),
+        MakeBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(500.0f, 20.0f, 500.0f)),
+        MakeBounds(XMFLOAT3(-4000.0f, 1000.0f, 2500.0f), XMFLOAT3(1.0f, 0.25f, 3.0f)),
+    };
+
+    for(const BoundingBox& bounds : boundsList)
+    {
+        PositionDecode decode = VertexCompression::GetPositionDecode(bounds);
+        XMFLOAT3 bound = VertexCompression::GetMaxPositionError(decode);
+
+        // half a quantization step, and not much more.
+        EXPECT_GE(bound.x, 0.5f * decode.Scale.x / 65535.0f);
+        EXPECT_LE(bound.x, 2.0f * (0.5f * decode.Scale.x / 65535.0f) + 1e-3f * std::fabs(decode.Offset.x));
+
+        float worst[3] = { 0.0f, 0.0f, 0.0f };
+        for(int i = 0; i < 20000; ++i)
+        {
+            // the corners are part of the range.
+            XMFLOAT3 pos(
+                i == 0 ? bounds.Center.x - bounds.Extents.x : random.NextFloat(bounds.Center.x - bounds.Extents.x, bounds.Center.x + bounds.Extents.x),
+                i == 0 ? bounds.Center.y - bounds.Extents.y : random.NextFloat(bounds.Center.y - bounds.Extents.y, bounds.Center.y + bounds.Extents.y),
+                i == 1 ? bounds.Center.z + bounds.Extents.z : random.NextFloat(bounds.Center.z - bounds.Extents.z, bounds.Center.z + bounds.Extents.z));
+
+            Decoded d = RoundTrip(pos, normal, texC, decode);
+            worst[0] = std::max(worst[0], std::fabs(d.Pos.x - pos.x));
+            worst[1] = std::max(worst[1], std::fabs(d.Pos.y - pos.y));
+            worst[2] = std::max(worst[2], std::fabs(d.Pos.z - pos.z));
+        }
+
+        EXPECT_LE(worst[0], bound.x);
+        EXPECT_LE(worst[1], bound.y);
+        EXPECT_LE(worst[2], bound.z);
+
+        // the random positions get close to the worst case of half a step, unless floats are
+        // coarser than the steps there.
+        if(std::fabs(decode.Offset.x) < 1000.0f)
+        {
+            EXPECT_GE(worst[0], 0.4f * decode.Scale.x / 65535.0f);
+        }
+    }
+}
+
+TEST(VertexCompression, FlatAxisDecodesToTheBounds)
+{
+    // a flat grid: the y extent is zero, whatever is stored decodes to the plane.
+    PositionDecode decode = VertexCompression::GetPositionDecode(MakeBounds(XMFLOAT3(0.0f, 7.0f, 0.0f), XMFLOAT3(10.0f, 0.0f, 10.0f)));
+    Decoded d = RoundTrip(XMFLOAT3(3.0f, 7.0f, -2.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.5f, 0.5f), decode);
+    EXPECT_EQ(7.0f, d.Pos.y);
+    EXPECT_NEAR(3.0f, d.Pos.x, VertexCompression::GetMaxPositionError(decode).x);
+
+    // so does a single point.
+    decode = VertexCompression::GetPositionDecode(MakeBounds(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)));
+    d = RoundTrip(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT2(0.0f, 0.0f), decode);
+    EXPECT_EQ(1.0f, d.Pos.x);
+    EXPECT_EQ(2.0f, d.Pos.y);
+    EXPECT_EQ(3.0f, d.Pos.z);
+}
+
+TEST(VertexCompression, PositionsOutsideTheBoundsAreClamped)
+{
+    PositionDecode decode = VertexCompression::GetPositionDecode(MakeBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+    Decoded d = RoundTrip(XMFLOAT3(-5.0f, 5.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f), decode);
+    EXPECT_EQ(-1.0f, d.Pos.x);
+    EXPECT_FLOAT_EQ(1.0f, d.Pos.y);
+}
+
+TEST(VertexCompression, AxisNormalsRoundTripExactly)
+{
+    PositionDecode decode;
+    const XMFLOAT3 axes[] = {
+        XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f),
+        XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+        XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f),
+        XMFLOAT3(-0.0f, -0.0f, -1.0f), XMFLOAT3(1.0f, -0.0f, 0.0f),
+    };
+
+    for(const XMFLOAT3& axis : axes)
+    {
+        Decoded d = RoundTrip(XMFLOAT3(0.0f, 0.0f, 0.0f), axis, XMFLOAT2(0.0f, 0.0f), decode);
+        EXPECT_EQ(axis.x, d.Normal.x) << axis.x << " " << axis.y << " " << axis.z;
+        EXPECT_EQ(axis.y, d.Normal.y) << axis.x << " " << axis.y << " " << axis.z;
+        EXPECT_EQ(axis.z, d.Normal.z) << axis.x << " " << axis.y << " " << axis.z;
+    }
+}
+
+TEST(VertexCompression, NormalErrorStaysWithinItsBound)
+{
+    RandomStream random(38);
+    PositionDecode decode;
+    double worst = 0.0;
+
+    auto check = [&](const XMFLOAT3& n)
+    {
+        Decoded d = RoundTrip(XMFLOAT3(0.0f, 0.0f, 0.0f), n, XMFLOAT2(0.0f, 0.0f), decode);
+        double angle = Angle(n, d.Normal);
+        worst = std::max(worst, angle);
+        EXPECT_LE(angle, VertexCompression::MaxNormalError) << n.x << " " << n.y << " " << n.z;
+
+        // the decoded normal is unit length.
+        float length = std::sqrt(d.Normal.x * d.Normal.x + d.Normal.y * d.Normal.y + d.Normal.z * d.Normal.z);
+        EXPECT_NEAR(1.0f, length, 1e-6f);
+    };
+
+    for(int i = 0; i < 100000; ++i)
+        check(RandomNormal(random));
+
+    // the seams of the mapping: the equator, where the lower half folds over, and the diagonals
+    // of the octahedron.
+    for(int i = 0; i < 3600; ++i)
+    {
+        float a = i * (2.0f * Pi / 3600.0f);
+        check(Normalize(std::cos(a), std::sin(a), 0.0f));
+        check(Normalize(std::cos(a), std::sin(a), -1e-7f));
+        check(Normalize(std::cos(a), std::sin(a), 1e-7f));
+    }
+    for(float sx : { -1.0f, 1.0f })
+    {
+        for(float sy : { -1.0f, 1.0f })
+        {
+            for(float sz : { -1.0f, 1.0f })
+                check(Normalize(sx, sy, sz));
+            check(Normalize(sx, sy, 0.0f));
+        }
+    }
+
+    // close to the bound, so it is a real bound and not a loose guess.
+    EXPECT_GT(worst, 0.25 * VertexCompression::MaxNormalError);
+}
+
+TEST(VertexCompression, OctahedralMappingIsInvertible)
+{
+    RandomStream random(39);
+    for(int i = 0; i < 10000; ++i)
+    {
+        XMFLOAT3 n = RandomNormal(random);
+        XMFLOAT2 e = VertexCompression::OctEncode(n);
+        EXPECT_LE(std::fabs(e.x), 1.0f);
+        EXPECT_LE(std::fabs(e.y), 1.0f);
+        EXPECT_LT(Angle(n, VertexCompression::OctDecode(e)), 1e-5);
+    }
+}
+
+TEST(VertexCompression, TexCoordErrorStaysWithinItsBound)
+{
+    RandomStream random(40);
+    PositionDecode decode;
+    const XMFLOAT3 normal(0.0f, 1.0f, 0.0f);
+
+    auto check = [&](float u, float v)
+    {
+        Decoded d = RoundTrip(XMFLOAT3(0.0f, 0.0f, 0.0f), normal, XMFLOAT2(u, v), decode);
+        EXPECT_LE(std::fabs(d.TexC.x - u), VertexCompression::GetMaxTexCoordError(u)) << u;
+        EXPECT_LE(std::fabs(d.TexC.y - v), VertexCompression::GetMaxTexCoordError(v)) << v;
+    };
+
+    // the usual [0, 1] range, tiling, and values far from it.
+    for(int i = 0; i < 20000; ++i)
+    {
+        check(random.NextFloat(), random.NextFloat());
+        check(random.NextFloat(-8.0f, 8.0f), random.NextFloat(-8.0f, 8.0f));
+        check(random.NextFloat(-2000.0f, 2000.0f), random.NextFloat(0.0f, 60000.0f));
+    }
+
+    // exact values, and halves too small to be normal.
+    check(0.0f, 1.0f);
+    check(0.5f, 0.25f);
+    check(-0.0f, -1.0f);
+    check(1e-6f, 3e-8f);
+    check(6.1e-5f, -1e-7f);
+    Decoded d = RoundTrip(XMFLOAT3(0.0f, 0.0f, 0.0f), normal, XMFLOAT2(1.0f, 0.5f), decode);
+    EXPECT_EQ(1.0f, d.TexC.x);
+    EXPECT_EQ(0.5f, d.TexC.y);
+}
+
+TEST(VertexCompression, IsWithinErrorBoundsCatchesACorruptVertex)
+{
+    PositionDecode decode = VertexCompression::GetPositionDecode(MakeBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+    const XMFLOAT3 pos(0.3f, -0.2f, 0.9f);
+    const XMFLOAT3 normal = Normalize(1.0f, 2.0f, -3.0f);
+    const XMFLOAT2 texC(0.75f, 0.125f);
+
+    CompactVertex v = VertexCompression::Encode(pos, normal, texC, decode);
+    EXPECT_TRUE(VertexCompression::IsWithinErrorBounds(v, decode, pos, normal, texC));
+
+    CompactVertex moved = v;
+    moved.Pos[0] += 2;
+    EXPECT_FALSE(VertexCompression::IsWithinErrorBounds(moved, decode, pos, normal, texC));
+
+    CompactVertex turned = v;
+    turned.Normal[1] += 8;
+    EXPECT_FALSE(VertexCompression::IsWithinErrorBounds(turned, decode, pos, normal, texC));
+
+    CompactVertex shifted = v;
+    shifted.TexC[0] += 1;
+    EXPECT_FALSE(VertexCompression::IsWithinErrorBounds(shifted, decode, pos, normal, texC));
+}
@@ -0,0 +1,51 @@
+//***************************************************************************************
+// WaterSurfaceTests.cpp
+//
+// The maximum amplitude the water bounds are sized by, against the vertex heights.
+//***************************************************************************************
+
+#include "WaterSurface.h"
+#include "Helpers/RandomStream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    float MaxHeight(const WaterSurface& surface)
+    {
+        float height = 0.0f;
+        for(int i = 0; i < surface.GetVertexCount(); ++i)
+            height = std::max(height, std::abs(surface.Position(i).y));
+        return height;
+    }
+}
+
+TEST(WaterSurface, StartsFlat)
+{
+    WaterSurface surface(50, 50, 2.0f, 0.03f, 5.0f, 0.1f);
+    EXPECT_EQ(0.0f, surface.GetMaxAmplitude());
+}
+
+TEST(WaterSurface, MaxAmplitudeIsTheHighestVertex)
+{
+    // the lattice and constants of GameWorld, disturbed as GameWorld does.
+    WaterSurface surface(200, 200, 2.0f, 0.03f, 5.0f, 0.1f);
+    RandomStream random(27);
+
+    for(int step = 0; step < 600; ++step)
+    {
+        if(step % 15 == 0)
+        {
+            const int i = random.NextInt(4, surface.GetRowCount() - 5);
+            const int j = random.NextInt(4, surface.GetColumnCount() - 5);
+            surface.AddFluctuationsAt(i, j, random.NextFloat(1.0f, 2.0f));
+            ASSERT_EQ(MaxHeight(surface), surface.GetMaxAmplitude()) << "step " << step;
+        }
+
+        surface.UpdateModelEquation(1.0f / 60.0f);
+        ASSERT_EQ(MaxHeight(surface), surface.GetMaxAmplitude()) << "step " << step;
+    }
+
+    EXPECT_GT(surface.GetMaxAmplitude(), 0.0f);
+}
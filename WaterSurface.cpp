@@ -1,13 +1,30 @@
 // WaterSurface.cpp
 
 #include "WaterSurface.h"
+#if defined(_MSC_VER)
 #include <ppl.h>
+#endif
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
 
 using namespace DirectX;
 
+// rows of the lattice are updated independently, in parallel where the concurrency runtime is available.
+template<typename Function>
+static void ForEachRow(int first, int last, const Function& function)
+{
+#if defined(_MSC_VER)
+	concurrency::parallel_for(first, last, function);
+#else
+	for (int i = first; i < last; ++i)
+	{
+		function(i);
+	}
+#endif
+}
+
 WaterSurface::WaterSurface(int row, int col, float ds, float dt, float v, float gamma)
 {
 	mRowCount = row;
@@ -30,6 +47,7 @@ WaterSurface::WaterSurface(int row, int col, float ds, float dt, float v, float
 	mCurrVertices.resize(row * col);
 	mNormals.resize(row * col);
 	mTangentX.resize(row * col);
+	mRowAmplitude.resize(row, 0.0f);
 
 	// set up water surface geometry as a 2D lattice in the host memroy
 	float halfWidth = (col - 1) * ds * 0.5f;
@@ -85,17 +103,22 @@ float WaterSurface::GetsurfDepth() const
 	return mRowCount * mDs;
 }
 
+float WaterSurface::GetMaxAmplitude() const
+{
+	return mMaxAmplitude;
+}
+
 void WaterSurface::UpdateModelEquation(float dt)
 {
-	static float t = 0;
-	t += dt;
+	mTime += dt;
 
 	// update the equation in every fixed time step
-	if (t >= mDt)
+	if (mTime >= mDt)
 	{
 		// use parallel_for and lambda function for faster update.
-		concurrency::parallel_for(1, mRowCount - 1, [this](int i)
+		ForEachRow(1, mRowCount - 1, [this](int i)
 			{
+				float amplitude = 0.0f;
 				for (int j = 1; j < mColCount - 1; ++j)
 				{
 					mPrevVertices[i * mColCount + j].y =
@@ -105,15 +128,20 @@ void WaterSurface::UpdateModelEquation(float dt)
 							mCurrVertices[(i - 1) * mColCount + j].y +
 							mCurrVertices[i * mColCount + j + 1].y + 
 							mCurrVertices[i * mColCount + j - 1].y);
+					amplitude = std::max(amplitude, std::abs(mPrevVertices[i * mColCount + j].y));
 				}
+				mRowAmplitude[i] = amplitude;
 			});
 
 		std::swap(mPrevVertices, mCurrVertices);
 
-		t = 0.0f;	// reset time for the next update
+		// boundary rows stay at rest, their entries are never written.
+		mMaxAmplitude = *std::max_element(mRowAmplitude.begin(), mRowAmplitude.end());
+
+		mTime = 0.0f;	// reset time for the next update
 
 		// update normal vectors 
-		concurrency::parallel_for(1, mRowCount - 1, [this](int i)
+		ForEachRow(1, mRowCount - 1, [this](int i)
 			{
 				for (int j = 1; j < mColCount - 1; ++j)
 				{
@@ -150,6 +178,11 @@ void WaterSurface::AddFluctuationsAt(int i, int j, float intensity)
 	mCurrVertices[i * mColCount + j - 1].y += intensity * 0.5f;
 	mCurrVertices[(i + 1) * mColCount + j].y += intensity * 0.5f;
 	mCurrVertices[(i - 1) * mColCount + j].y += intensity * 0.5f;
+
+	for (int k : { i * mColCount + j, i * mColCount + j + 1, i * mColCount + j - 1, (i + 1) * mColCount + j, (i - 1) * mColCount + j })
+	{
+		mMaxAmplitude = std::max(mMaxAmplitude, std::abs(mCurrVertices[k].y));
+	}
 }
 
 
@@ -22,6 +22,9 @@ public:
 	float GetsurfWidth() const;
 	float GetsurfDepth() const;
 
+	// largest height of any vertex above or below the rest plane, bounds the surface vertically.
+	float GetMaxAmplitude() const;
+
 	const DirectX::XMFLOAT3& Position(int i) const
 	{
 		return mCurrVertices[i];
@@ -54,11 +57,15 @@ private:
 
 	float mDs = 0.0f;	// a unit spatial step in both horizontal and vertical directions
 	float mDt = 0.0f;	// a unit temporal step between which the simulation updates.
+	float mTime = 0.0f;	// time passed since the last update.
 
 	std::vector<DirectX::XMFLOAT3> mCurrVertices;
 	std::vector<DirectX::XMFLOAT3> mPrevVertices;
 	std::vector<DirectX::XMFLOAT3> mNormals;
 	std::vector<DirectX::XMFLOAT3> mTangentX;
+
+	float mMaxAmplitude = 0.0f;
+	std::vector<float> mRowAmplitude;	// largest height per row of the last update, reduced into mMaxAmplitude
 };
 
 